@@ -0,0 +1,120 @@
+#include "BenchmarkReport.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+
+namespace vuren {
+
+namespace {
+
+std::string toJsonString(const std::string &text) {
+    std::string json = "\"";
+    for (char c: text) {
+        if (c == '"' || c == '\\')
+            json += '\\';
+        json += c;
+    }
+    return json + "\"";
+}
+
+// nearest rank on sorted samples
+double percentile(const std::vector<double> &sorted, double p) {
+    size_t rank = static_cast<size_t>(std::ceil(p * sorted.size()));
+    return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+} // namespace
+
+SampleStats computeSampleStats(std::vector<double> samples, uint32_t binCount) {
+    SampleStats stats;
+    if (samples.empty())
+        return stats;
+
+    std::sort(samples.begin(), samples.end());
+    size_t count = samples.size();
+
+    stats.count  = count;
+    stats.mean   = std::accumulate(samples.begin(), samples.end(), 0.0) / count;
+    stats.median = count % 2 ? samples[count / 2] : 0.5 * (samples[count / 2 - 1] + samples[count / 2]);
+    stats.p95    = percentile(samples, 0.95);
+    stats.p99    = percentile(samples, 0.99);
+    stats.min    = samples.front();
+    stats.max    = samples.back();
+
+    double variance = 0.0;
+    for (double sample: samples)
+        variance += (sample - stats.mean) * (sample - stats.mean);
+    stats.stddev = std::sqrt(variance / count);
+
+    stats.histogramMin = stats.min;
+    stats.binWidth     = (stats.max - stats.min) / binCount;
+    stats.histogram.assign(binCount, 0);
+    for (double sample: samples) {
+        uint32_t bin = stats.binWidth > 0.0 ? static_cast<uint32_t>((sample - stats.min) / stats.binWidth) : 0;
+        stats.histogram[std::min(bin, binCount - 1)]++;
+    }
+
+    return stats;
+}
+
+void BenchmarkReport::addInfo(const std::string &key, const std::string &value) {
+    m_info.push_back({ key, toJsonString(value) });
+}
+
+void BenchmarkReport::addInfo(const std::string &key, double value) {
+    std::ostringstream stream;
+    stream << std::setprecision(10) << value;
+    m_info.push_back({ key, stream.str() });
+}
+
+void BenchmarkReport::addSeries(const std::string &name, const std::vector<double> &samples) {
+    m_series.push_back({ name, computeSampleStats(samples) });
+}
+
+void BenchmarkReport::write(const std::string &filename) const {
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        throw std::runtime_error("failed to open " + filename + " for writing!");
+    }
+
+    file << "{\n";
+    for (auto &[key, value]: m_info)
+        file << "  " << toJsonString(key) << ": " << value << ",\n";
+
+    file << std::setprecision(6) << "  \"series\": {";
+    for (size_t i = 0; i < m_series.size(); ++i) {
+        const SampleStats &stats = m_series[i].second;
+
+        file << (i ? ",\n" : "\n") << "    " << toJsonString(m_series[i].first) << ": {\n";
+        file << "      \"unit\": \"ms\", \"count\": " << stats.count << ",\n";
+        file << "      \"mean\": " << stats.mean << ", \"median\": " << stats.median << ", \"p95\": " << stats.p95
+             << ", \"p99\": " << stats.p99 << ",\n";
+        file << "      \"min\": " << stats.min << ", \"max\": " << stats.max << ", \"stddev\": " << stats.stddev
+             << ",\n";
+        file << "      \"histogram\": { \"min\": " << stats.histogramMin << ", \"binWidth\": " << stats.binWidth
+             << ", \"counts\": [";
+        for (size_t b = 0; b < stats.histogram.size(); ++b)
+            file << (b ? ", " : "") << stats.histogram[b];
+        file << "] }\n    }";
+    }
+    file << "\n  }\n}\n";
+}
+
+void BenchmarkReport::print(std::ostream &out) const {
+    out << std::fixed << std::setprecision(3);
+    out << "  " << std::left << std::setw(28) << "ms" << std::right << std::setw(9) << "mean" << std::setw(9)
+        << "median" << std::setw(9) << "p95" << std::setw(9) << "p99" << std::setw(9) << "stddev" << std::endl;
+    for (auto &[name, stats]: m_series) {
+        out << "  " << std::left << std::setw(28) << name << std::right << std::setw(9) << stats.mean << std::setw(9)
+            << stats.median << std::setw(9) << stats.p95 << std::setw(9) << stats.p99 << std::setw(9)
+            << stats.stddev << std::endl;
+    }
+    out << std::defaultfloat;
+}
+
+} // namespace vuren
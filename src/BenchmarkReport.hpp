@@ -0,0 +1,53 @@
+#ifndef BENCHMARK_REPORT_HPP
+#define BENCHMARK_REPORT_HPP
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace vuren {
+
+// summary of one series of frame times, in ms
+struct SampleStats {
+    size_t count{ 0 };
+    double mean{ 0.0 };
+    double median{ 0.0 };
+    double p95{ 0.0 };
+    double p99{ 0.0 };
+    double min{ 0.0 };
+    double max{ 0.0 };
+    double stddev{ 0.0 };
+
+    // equal-width bins over [min, max]
+    double histogramMin{ 0.0 };
+    double binWidth{ 0.0 };
+    std::vector<uint32_t> histogram;
+};
+
+SampleStats computeSampleStats(std::vector<double> samples, uint32_t binCount = 32);
+
+// frame time statistics of a benchmark run, written as json so results can be compared across commits
+class BenchmarkReport {
+public:
+    BenchmarkReport() {}
+    ~BenchmarkReport() {}
+
+    // run description (device, resolution, ...), written as a flat object
+    void addInfo(const std::string &key, const std::string &value);
+    void addInfo(const std::string &key, double value);
+
+    void addSeries(const std::string &name, const std::vector<double> &samples);
+
+    void write(const std::string &filename) const;
+    void print(std::ostream &out) const;
+
+private:
+    std::vector<std::pair<std::string, std::string>> m_info; // values are json already
+    std::vector<std::pair<std::string, SampleStats>> m_series;
+};
+
+} // namespace vuren
+
+#endif // BENCHMARK_REPORT_HPP
@@ -0,0 +1,154 @@
+#include "BindlessTable.hpp"
+
+#include <algorithm>
+
+namespace vuren {
+
+void BindlessTable::init(VulkanContext *pContext, std::shared_ptr<ResourceManager> pResourceManager) {
+    m_pContext         = pContext;
+    m_pResourceManager = pResourceManager;
+
+    vk::PhysicalDeviceDescriptorIndexingProperties indexingProperties;
+    vk::PhysicalDeviceProperties2 prop2{ .pNext = &indexingProperties };
+    m_pContext->m_physicalDevice.getProperties2(&prop2);
+    m_maxTextures = std::min({ static_cast<uint32_t>(BINDLESS_MAX_TEXTURES),
+                               indexingProperties.maxPerStageDescriptorUpdateAfterBindSampledImages,
+                               indexingProperties.maxDescriptorSetUpdateAfterBindSampledImages });
+
+    std::array<vk::DescriptorSetLayoutBinding, 6> bindings = {
+        vk::DescriptorSetLayoutBinding{ .binding         = BINDLESS_TEXTURES_BINDING,
+                                        .descriptorType  = vk::DescriptorType::eCombinedImageSampler,
+                                        .descriptorCount = m_maxTextures,
+                                        .stageFlags      = vk::ShaderStageFlagBits::eAll },
+        vk::DescriptorSetLayoutBinding{ .binding         = BINDLESS_OBJECTS_BINDING,
+                                        .descriptorType  = vk::DescriptorType::eStorageBuffer,
+                                        .descriptorCount = 1,
+                                        .stageFlags      = vk::ShaderStageFlagBits::eAll },
+        vk::DescriptorSetLayoutBinding{ .binding         = BINDLESS_MATERIALS_BINDING,
+                                        .descriptorType  = vk::DescriptorType::eStorageBuffer,
+                                        .descriptorCount = 1,
+                                        .stageFlags      = vk::ShaderStageFlagBits::eAll },
+        vk::DescriptorSetLayoutBinding{ .binding         = BINDLESS_LIGHTS_BINDING,
+                                        .descriptorType  = vk::DescriptorType::eStorageBuffer,
+                                        .descriptorCount = 1,
+                                        .stageFlags      = vk::ShaderStageFlagBits::eAll },
+        vk::DescriptorSetLayoutBinding{ .binding         = BINDLESS_LIGHT_ALIAS_BINDING,
+                                        .descriptorType  = vk::DescriptorType::eStorageBuffer,
+                                        .descriptorCount = 1,
+                                        .stageFlags      = vk::ShaderStageFlagBits::eAll },
+        vk::DescriptorSetLayoutBinding{ .binding         = BINDLESS_LIGHT_BVH_BINDING,
+                                        .descriptorType  = vk::DescriptorType::eStorageBuffer,
+                                        .descriptorCount = 1,
+                                        .stageFlags      = vk::ShaderStageFlagBits::eAll }
+    };
+
+    // unwritten texture slots are fine as long as no shader reads them, and new ones can be written while
+    // submitted frames still use the set
+    vk::DescriptorBindingFlags textureFlags = vk::DescriptorBindingFlagBits::ePartiallyBound |
+                                              vk::DescriptorBindingFlagBits::eUpdateAfterBind |
+                                              vk::DescriptorBindingFlagBits::eUpdateUnusedWhilePending;
+    vk::DescriptorBindingFlags bufferFlags =
+        vk::DescriptorBindingFlagBits::ePartiallyBound | vk::DescriptorBindingFlagBits::eUpdateAfterBind;
+    std::array<vk::DescriptorBindingFlags, 6> bindingFlags = { textureFlags, bufferFlags, bufferFlags, bufferFlags,
+                                                               bufferFlags, bufferFlags };
+
+    vk::DescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{
+        .bindingCount  = static_cast<uint32_t>(bindingFlags.size()),
+        .pBindingFlags = bindingFlags.data()
+    };
+    vk::DescriptorSetLayoutCreateInfo layoutInfo{
+        .pNext        = &bindingFlagsInfo,
+        .flags        = vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool,
+        .bindingCount = static_cast<uint32_t>(bindings.size()),
+        .pBindings    = bindings.data()
+    };
+    if (m_pContext->m_device.createDescriptorSetLayout(&layoutInfo, nullptr, &m_descriptorSetLayout) !=
+        vk::Result::eSuccess) {
+        throw std::runtime_error("failed to create the bindless descriptor set layout!");
+    }
+
+    std::array<vk::DescriptorPoolSize, 2> poolSizes = {
+        vk::DescriptorPoolSize{ .type = vk::DescriptorType::eCombinedImageSampler, .descriptorCount = m_maxTextures },
+        vk::DescriptorPoolSize{ .type = vk::DescriptorType::eStorageBuffer, .descriptorCount = 5 }
+    };
+    vk::DescriptorPoolCreateInfo poolInfo{ .flags         = vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind,
+                                           .maxSets       = 1,
+                                           .poolSizeCount = static_cast<uint32_t>(poolSizes.size()),
+                                           .pPoolSizes    = poolSizes.data() };
+    if (m_pContext->m_device.createDescriptorPool(&poolInfo, nullptr, &m_descriptorPool) != vk::Result::eSuccess) {
+        throw std::runtime_error("failed to create the bindless descriptor pool!");
+    }
+
+    vk::DescriptorSetAllocateInfo allocInfo{ .descriptorPool     = m_descriptorPool,
+                                             .descriptorSetCount = 1,
+                                             .pSetLayouts        = &m_descriptorSetLayout };
+    if (m_pContext->m_device.allocateDescriptorSets(&allocInfo, &m_descriptorSet) != vk::Result::eSuccess) {
+        throw std::runtime_error("failed to allocate the bindless descriptor set!");
+    }
+
+    vk::PushConstantRange pushConstantRange = getPushConstantRange();
+    vk::PipelineLayoutCreateInfo pipelineLayoutInfo{ .setLayoutCount         = 1,
+                                                     .pSetLayouts            = &m_descriptorSetLayout,
+                                                     .pushConstantRangeCount = 1,
+                                                     .pPushConstantRanges    = &pushConstantRange };
+    if (m_pContext->m_device.createPipelineLayout(&pipelineLayoutInfo, nullptr, &m_pipelineLayout) !=
+        vk::Result::eSuccess) {
+        throw std::runtime_error("failed to create a pipeline layout!");
+    }
+}
+
+void BindlessTable::cleanup() {
+    if (m_pipelineLayout)
+        m_pContext->m_device.destroyPipelineLayout(m_pipelineLayout, nullptr);
+    if (m_descriptorPool)
+        m_pContext->m_device.destroyDescriptorPool(m_descriptorPool, nullptr);
+    if (m_descriptorSetLayout)
+        m_pContext->m_device.destroyDescriptorSetLayout(m_descriptorSetLayout, nullptr);
+}
+
+uint32_t BindlessTable::addTexture(std::shared_ptr<Texture> pTexture) {
+    if (m_textureCount >= m_maxTextures)
+        throw std::runtime_error("the bindless texture table is full!");
+
+    vk::DescriptorImageInfo imageInfo = pTexture->descriptorInfo;
+    imageInfo.imageLayout             = vk::ImageLayout::eShaderReadOnlyOptimal;
+
+    vk::WriteDescriptorSet write{ .dstSet          = m_descriptorSet,
+                                  .dstBinding      = BINDLESS_TEXTURES_BINDING,
+                                  .dstArrayElement = m_textureCount,
+                                  .descriptorCount = 1,
+                                  .descriptorType  = vk::DescriptorType::eCombinedImageSampler,
+                                  .pImageInfo      = &imageInfo };
+    m_pContext->m_device.updateDescriptorSets(1, &write, 0, nullptr);
+
+    return m_textureCount++;
+}
+
+void BindlessTable::setBuffer(uint32_t binding, const std::string &bufferName) {
+    if (binding != BINDLESS_OBJECTS_BINDING && binding != BINDLESS_MATERIALS_BINDING &&
+        binding != BINDLESS_LIGHTS_BINDING && binding != BINDLESS_LIGHT_ALIAS_BINDING &&
+        binding != BINDLESS_LIGHT_BVH_BINDING)
+        throw std::runtime_error("binding " + std::to_string(binding) + " of the bindless table is not a buffer!");
+
+    vk::DescriptorBufferInfo bufferInfo = m_pResourceManager->getBuffer(bufferName)->descriptorInfo;
+    vk::WriteDescriptorSet write{ .dstSet          = m_descriptorSet,
+                                  .dstBinding      = binding,
+                                  .dstArrayElement = 0,
+                                  .descriptorCount = 1,
+                                  .descriptorType  = vk::DescriptorType::eStorageBuffer,
+                                  .pBufferInfo     = &bufferInfo };
+    m_pContext->m_device.updateDescriptorSets(1, &write, 0, nullptr);
+}
+
+void BindlessTable::bind(vk::CommandBuffer commandBuffer, vk::PipelineBindPoint bindPoint) {
+    commandBuffer.bindDescriptorSets(bindPoint, m_pipelineLayout, BINDLESS_SET, 1, &m_descriptorSet, 0, nullptr);
+}
+
+vk::PushConstantRange BindlessTable::getPushConstantRange() {
+    return { .stageFlags = vk::ShaderStageFlagBits::eRaygenKHR | vk::ShaderStageFlagBits::eClosestHitKHR |
+                           vk::ShaderStageFlagBits::eMissKHR | vk::ShaderStageFlagBits::eCompute,
+             .offset     = 0,
+             .size       = sizeof(PushConstantRay) };
+}
+
+} // namespace vuren
@@ -0,0 +1,62 @@
+#ifndef BINDLESS_TABLE_HPP
+#define BINDLESS_TABLE_HPP
+
+#define VULKAN_HPP_NO_CONSTRUCTORS
+#define VULKAN_HPP_DISPATCH_LOADER_DYNAMIC 1
+#include <vulkan/vulkan.hpp>
+
+#include "Common.hpp"
+#include "CommonShaders/Bindless.h"
+#include "ResourceManager.hpp"
+
+#include <memory>
+#include <string>
+
+namespace vuren {
+
+// the global descriptor set of scene resources (Bindless.h), set 0 of every pipeline layout.
+// the texture array is partially bound and update-after-bind, so a texture added at runtime is one descriptor
+// write into the next free slot, and no pass rebuilds its own set. since every pipeline layout starts with this
+// set and shares the same push constant range, the set stays bound across pipelines: it is bound once per frame
+// for each bind point.
+class BindlessTable {
+public:
+    BindlessTable() {}
+    ~BindlessTable() {}
+
+    void init(VulkanContext *pContext, std::shared_ptr<ResourceManager> pResourceManager);
+    void cleanup();
+
+    // returns the texture's index into sceneTextures[]. the texture must be in eShaderReadOnlyOptimal.
+    // may be called while frames are in flight, as long as no frame reads the new slot yet.
+    uint32_t addTexture(std::shared_ptr<Texture> pTexture);
+
+    // binding is one of the buffer bindings: objects, materials, lights, the light alias table or the light bvh
+    void setBuffer(uint32_t binding, const std::string &bufferName);
+
+    // binds set 0 for every pipeline of bindPoint recorded after it in commandBuffer
+    void bind(vk::CommandBuffer commandBuffer, vk::PipelineBindPoint bindPoint);
+
+    vk::DescriptorSetLayout getLayout() const { return m_descriptorSetLayout; }
+    uint32_t getTextureCount() const { return m_textureCount; }
+
+    // the push constant range of every pipeline layout, a different one would make set 0 incompatible.
+    // compute passes push their own constants, at most sizeof(PushConstantRay) bytes.
+    static vk::PushConstantRange getPushConstantRange();
+
+private:
+    VulkanContext *m_pContext{ nullptr };
+    std::shared_ptr<ResourceManager> m_pResourceManager{ nullptr };
+
+    vk::DescriptorSetLayout m_descriptorSetLayout{ VK_NULL_HANDLE };
+    vk::DescriptorPool m_descriptorPool{ VK_NULL_HANDLE }; // created with the update-after-bind flag
+    vk::DescriptorSet m_descriptorSet{ VK_NULL_HANDLE };
+    vk::PipelineLayout m_pipelineLayout{ VK_NULL_HANDLE }; // set 0 only, used to bind it
+
+    uint32_t m_maxTextures{ 0 };
+    uint32_t m_textureCount{ 0 };
+};
+
+} // namespace vuren
+
+#endif // BINDLESS_TABLE_HPP
@@ -0,0 +1,805 @@
+#include "Bvh.hpp"
+#include "ThreadPool.hpp"
+#include "Timer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <future>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define VUREN_BVH_SSE2
+#endif
+
+namespace vuren {
+
+namespace {
+
+const int kBinCount              = 16;
+const uint32_t kMaxLeafTriangles = 4;
+// the traversal keeps at most one node per level on its fixed size stack, deeper nodes stay leaves
+const uint32_t kMaxDepth = 64;
+// spatial splits are only tried where the children of the best object split overlap by more than alpha times the
+// surface area of the root, and only while the references stay below the budget, in triangles
+const float kSpatialSplitAlpha = 1e-5f;
+const float kReferenceBudget   = 2.0f;
+// nodes with more references are binned in chunks on the thread pool
+const size_t kParallelBinningThreshold = 1 << 14;
+const size_t kBinningChunkSize         = 1 << 13;
+
+struct Aabb {
+    vec3 min{ std::numeric_limits<float>::max() };
+    vec3 max{ -std::numeric_limits<float>::max() };
+
+    void grow(const vec3 &p) {
+        min = glm::min(min, p);
+        max = glm::max(max, p);
+    }
+
+    void grow(const Aabb &other) {
+        min = glm::min(min, other.min);
+        max = glm::max(max, other.max);
+    }
+
+    bool isEmpty() const { return min.x > max.x || min.y > max.y || min.z > max.z; }
+
+    vec3 center() const { return (min + max) * 0.5f; }
+
+    float area() const {
+        if (isEmpty())
+            return 0.0f;
+        vec3 e = max - min;
+        return e.x * e.y + e.y * e.z + e.z * e.x;
+    }
+
+    // empty when the boxes do not overlap
+    Aabb intersection(const Aabb &other) const {
+        Aabb result{ glm::max(min, other.min), glm::min(max, other.max) };
+        return result.isEmpty() ? Aabb{} : result;
+    }
+};
+
+// 1 / direction, with zero components replaced by a tiny one of the same sign: an infinite inverse would make the slab
+// distance 0 * inf = NaN for an origin on the slab plane, and the min/max below would then depend on argument order
+vec3 safeInverse(const vec3 &direction) {
+    vec3 inverse;
+    for (int a = 0; a < 3; ++a)
+        inverse[a] = 1.0f / (std::abs(direction[a]) < 1e-20f ? std::copysign(1e-20f, direction[a]) : direction[a]);
+    return inverse;
+}
+
+// returns the entry distance, or float max when the box is missed
+float intersectAabb(const Ray &ray, const vec3 &invDir, const vec3 &boundsMin, const vec3 &boundsMax, float tMax) {
+    vec3 t0      = (boundsMin - ray.origin) * invDir;
+    vec3 t1      = (boundsMax - ray.origin) * invDir;
+    vec3 tNear   = glm::min(t0, t1);
+    vec3 tFar    = glm::max(t0, t1);
+    float tEnter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, ray.tMin));
+    float tExit  = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, tMax));
+    return tEnter <= tExit ? tEnter : std::numeric_limits<float>::max();
+}
+
+// möller-trumbore, two-sided like the opaque ray tracing pipeline. e1 and e2 are the edges from v0 to v1 and v2.
+bool intersectTriangle(const Ray &ray, const vec3 &v0, const vec3 &e1, const vec3 &e2, float tMax, float &t,
+                       vec2 &barycentrics) {
+    vec3 p    = glm::cross(ray.direction, e2);
+    float det = glm::dot(e1, p);
+    if (std::abs(det) < 1e-12f)
+        return false;
+
+    float invDet = 1.0f / det;
+    vec3 s       = ray.origin - v0;
+    float u      = glm::dot(s, p) * invDet;
+    if (u < 0.0f || u > 1.0f)
+        return false;
+
+    vec3 q  = glm::cross(s, e1);
+    float v = glm::dot(ray.direction, q) * invDet;
+    if (v < 0.0f || u + v > 1.0f)
+        return false;
+
+    t = glm::dot(e2, q) * invDet;
+    if (t < ray.tMin || t >= tMax)
+        return false;
+
+    barycentrics = vec2(u, v);
+    return true;
+}
+
+// the length of a quantization step, 2^exponent, for exponents of normal floats
+float quantizationStep(int8_t exponent) {
+    uint32_t bits = static_cast<uint32_t>(exponent + 127) << 23;
+    float step;
+    std::memcpy(&step, &bits, sizeof(step));
+    return step;
+}
+
+// entry distances of the children of a quantized node, returns the mask of the children the ray enters before tMax.
+// the bounds are decoded as origin + q * step on both sides, the quantization rounds them outwards with the same
+// arithmetic.
+uint32_t intersectChildren(const BvhNode4 &node, const Ray &ray, const vec3 &invDir, float tMax, float distances[4]) {
+#ifdef VUREN_BVH_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    __m128 tEnter      = _mm_set1_ps(ray.tMin);
+    __m128 tExit       = _mm_set1_ps(tMax);
+    for (int a = 0; a < 3; ++a) {
+        int32_t packedMin, packedMax;
+        std::memcpy(&packedMin, node.boundsMin[a], sizeof(packedMin));
+        std::memcpy(&packedMax, node.boundsMax[a], sizeof(packedMax));
+        // widen the four 8 bit steps of each side to 32 bit lanes
+        __m128i qMin = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packedMin), zero), zero);
+        __m128i qMax = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packedMax), zero), zero);
+
+        __m128 origin    = _mm_set1_ps(node.origin[a]);
+        __m128 step      = _mm_set1_ps(quantizationStep(node.exponents[a]));
+        __m128 rayOrigin = _mm_set1_ps(ray.origin[a]);
+        __m128 inv       = _mm_set1_ps(invDir[a]);
+        __m128 boundsMin = _mm_add_ps(origin, _mm_mul_ps(_mm_cvtepi32_ps(qMin), step));
+        __m128 boundsMax = _mm_add_ps(origin, _mm_mul_ps(_mm_cvtepi32_ps(qMax), step));
+        __m128 t0        = _mm_mul_ps(_mm_sub_ps(boundsMin, rayOrigin), inv);
+        __m128 t1        = _mm_mul_ps(_mm_sub_ps(boundsMax, rayOrigin), inv);
+        tEnter           = _mm_max_ps(tEnter, _mm_min_ps(t0, t1));
+        tExit            = _mm_min_ps(tExit, _mm_max_ps(t0, t1));
+    }
+    _mm_storeu_ps(distances, tEnter);
+    uint32_t mask = static_cast<uint32_t>(_mm_movemask_ps(_mm_cmple_ps(tEnter, tExit)));
+#else
+    uint32_t mask = 0;
+    for (uint32_t i = 0; i < 4; ++i) {
+        float tEnter = ray.tMin;
+        float tExit  = tMax;
+        for (int a = 0; a < 3; ++a) {
+            float step      = quantizationStep(node.exponents[a]);
+            float boundsMin = node.origin[a] + static_cast<float>(node.boundsMin[a][i]) * step;
+            float boundsMax = node.origin[a] + static_cast<float>(node.boundsMax[a][i]) * step;
+            float t0        = (boundsMin - ray.origin[a]) * invDir[a];
+            float t1        = (boundsMax - ray.origin[a]) * invDir[a];
+            tEnter          = std::max(tEnter, std::min(t0, t1));
+            tExit           = std::min(tExit, std::max(t0, t1));
+        }
+        distances[i] = tEnter;
+        mask |= tEnter <= tExit ? 1u << i : 0u;
+    }
+#endif
+    // the unused slots decode to boxes as well
+    return mask & ((1u << node.childCount) - 1);
+}
+
+// the smallest exponent whose 255 steps from the minimum of the frame reach its maximum along an axis
+int8_t quantizationExponent(float boundsMin, float boundsMax) {
+    float extent = boundsMax - boundsMin;
+    int exponent = extent > 0.0f ? static_cast<int>(std::ceil(std::log2(extent / 255.0f))) : -126;
+    exponent     = std::clamp(exponent, -126, 127);
+    while (exponent < 127 && boundsMin + 255.0f * quantizationStep(static_cast<int8_t>(exponent)) < boundsMax)
+        ++exponent;
+    return static_cast<int8_t>(exponent);
+}
+
+// a triangle, or the part of it within bounds once spatial splits have clipped it
+struct Reference {
+    Aabb bounds;
+    uint32_t triangle;
+};
+
+// the best split of a node found so far, and the boxes and references of its children
+struct Split {
+    float cost{ std::numeric_limits<float>::max() };
+    int axis{ -1 };
+    int bin{ 0 }; // the last bin of the left child
+    Aabb leftBounds;
+    Aabb rightBounds;
+    uint32_t leftCount{ 0 };
+    uint32_t rightCount{ 0 };
+};
+
+// object bins by reference centroid, and spatial bins the references are clipped into, along the three axes.
+// large nodes fill one per chunk of references on the thread pool, and merge them.
+struct Bins {
+    std::array<std::array<Aabb, kBinCount>, 3> bounds;
+    std::array<std::array<uint32_t, kBinCount>, 3> counts{}; // object bins: the references, spatial: the entries
+    std::array<std::array<uint32_t, kBinCount>, 3> exits{};  // spatial bins only
+
+    void merge(const Bins &other) {
+        for (int a = 0; a < 3; ++a) {
+            for (int b = 0; b < kBinCount; ++b) {
+                bounds[a][b].grow(other.bounds[a][b]);
+                counts[a][b] += other.counts[a][b];
+                exits[a][b] += other.exits[a][b];
+            }
+        }
+    }
+};
+
+// binned sah builder of the binary node array, optionally with spatial splits (sbvh, Stich et al. 2009)
+class BvhBuilder {
+public:
+    BvhBuilder(const std::vector<vec3> &positions, bool spatialSplits, ThreadPool *pThreadPool)
+        : m_positions(positions), m_spatialSplits(spatialSplits), m_pThreadPool(pThreadPool) {}
+
+    void build(std::vector<BvhNode> &nodes, std::vector<uint32_t> &triangleIndices) {
+        uint32_t triangleCount = static_cast<uint32_t>(m_positions.size() / 3);
+
+        std::vector<Reference> references(triangleCount);
+        for (uint32_t i = 0; i < triangleCount; ++i) {
+            references[i].triangle = i;
+            for (int k = 0; k < 3; ++k)
+                references[i].bounds.grow(m_positions[i * 3 + k]);
+        }
+        m_referenceBudget = static_cast<size_t>(triangleCount * kReferenceBudget);
+        m_referenceCount  = triangleCount;
+
+        nodes.clear();
+        nodes.reserve(std::max(1u, triangleCount * 2));
+        nodes.push_back({});
+        triangleIndices.clear();
+        triangleIndices.reserve(triangleCount);
+
+        // explicit stack, deep bvhs on large meshes would overflow the call stack otherwise.
+        // every task owns the references of its node, the spatial splits duplicate some of them.
+        struct Task {
+            uint32_t node;
+            uint32_t depth;
+            std::vector<Reference> references;
+        };
+        std::vector<Task> stack;
+        stack.push_back({ 0, 1, std::move(references) });
+
+        while (!stack.empty()) {
+            Task task = std::move(stack.back());
+            stack.pop_back();
+
+            Aabb bounds, centroidBounds;
+            computeBounds(task.references, bounds, centroidBounds);
+            nodes[task.node].boundsMin = bounds.min;
+            nodes[task.node].boundsMax = bounds.max;
+            if (task.node == 0)
+                m_rootArea = bounds.area();
+
+            std::vector<Reference> left, right;
+            if (task.references.size() <= kMaxLeafTriangles || task.depth >= kMaxDepth ||
+                !split(task.references, bounds, centroidBounds, left, right)) {
+                nodes[task.node].leftOrFirst   = static_cast<uint32_t>(triangleIndices.size());
+                nodes[task.node].triangleCount = static_cast<uint32_t>(task.references.size());
+                for (auto &reference: task.references)
+                    triangleIndices.push_back(reference.triangle);
+                continue;
+            }
+
+            uint32_t leftIndex             = static_cast<uint32_t>(nodes.size());
+            nodes[task.node].leftOrFirst   = leftIndex;
+            nodes[task.node].triangleCount = 0;
+            nodes.push_back({});
+            nodes.push_back({});
+
+            task.references.clear();
+            task.references.shrink_to_fit();
+            stack.push_back({ leftIndex, task.depth + 1, std::move(left) });
+            stack.push_back({ leftIndex + 1, task.depth + 1, std::move(right) });
+        }
+
+        nodes.shrink_to_fit();
+    }
+
+private:
+    // the number of chunks job(begin, end, chunk) runs over, one unless the range is worth the thread pool
+    size_t getChunkCount(size_t count) const {
+        if (!m_pThreadPool || count < kParallelBinningThreshold)
+            return 1;
+        return (count + kBinningChunkSize - 1) / kBinningChunkSize;
+    }
+
+    template <typename Job> void forEachChunk(size_t count, const Job &job) const {
+        size_t chunkCount = getChunkCount(count);
+        if (chunkCount == 1) {
+            job(0, count, 0);
+            return;
+        }
+
+        std::vector<std::future<void>> chunks;
+        chunks.reserve(chunkCount);
+        for (size_t c = 0; c < chunkCount; ++c) {
+            size_t begin = c * kBinningChunkSize;
+            size_t end   = std::min(begin + kBinningChunkSize, count);
+            chunks.push_back(m_pThreadPool->submit([&job, begin, end, c] { job(begin, end, c); }));
+        }
+        for (auto &chunk: chunks)
+            chunk.get();
+    }
+
+    void computeBounds(const std::vector<Reference> &references, Aabb &bounds, Aabb &centroidBounds) const {
+        size_t chunkCount = getChunkCount(references.size());
+        std::vector<Aabb> chunkBounds(chunkCount), chunkCentroids(chunkCount);
+        forEachChunk(references.size(), [&](size_t begin, size_t end, size_t c) {
+            for (size_t i = begin; i < end; ++i) {
+                chunkBounds[c].grow(references[i].bounds);
+                chunkCentroids[c].grow(references[i].bounds.center());
+            }
+        });
+        for (size_t c = 0; c < chunkCount; ++c) {
+            bounds.grow(chunkBounds[c]);
+            centroidBounds.grow(chunkCentroids[c]);
+        }
+    }
+
+    static int getObjectBin(const Reference &reference, const Aabb &centroidBounds, int axis) {
+        float scale = kBinCount / (centroidBounds.max[axis] - centroidBounds.min[axis]);
+        int bin     = static_cast<int>((reference.bounds.center()[axis] - centroidBounds.min[axis]) * scale);
+        return std::clamp(bin, 0, kBinCount - 1);
+    }
+
+    static int getSpatialBin(float position, const Aabb &bounds, int axis) {
+        float scale = kBinCount / (bounds.max[axis] - bounds.min[axis]);
+        return std::clamp(static_cast<int>((position - bounds.min[axis]) * scale), 0, kBinCount - 1);
+    }
+
+    static float getSpatialPlane(const Aabb &bounds, int axis, int bin) {
+        return bounds.min[axis] + (bounds.max[axis] - bounds.min[axis]) * (bin + 1) / kBinCount;
+    }
+
+    Bins binReferences(const std::vector<Reference> &references, const Aabb &bounds, const Aabb &centroidBounds,
+                       bool spatial) const {
+        std::vector<Bins> chunkBins(getChunkCount(references.size()));
+        forEachChunk(references.size(), [&](size_t begin, size_t end, size_t c) {
+            Bins &bins = chunkBins[c];
+            for (size_t i = begin; i < end; ++i) {
+                const Reference &reference = references[i];
+                for (int a = 0; a < 3; ++a) {
+                    if (!spatial) {
+                        if (centroidBounds.max[a] == centroidBounds.min[a])
+                            continue;
+                        int bin = getObjectBin(reference, centroidBounds, a);
+                        bins.bounds[a][bin].grow(reference.bounds);
+                        bins.counts[a][bin]++;
+                        continue;
+                    }
+
+                    if (bounds.max[a] == bounds.min[a])
+                        continue;
+                    // the reference enters its first bin and exits its last one, with its clipped part in every bin
+                    int first = getSpatialBin(reference.bounds.min[a], bounds, a);
+                    int last  = std::max(first, getSpatialBin(reference.bounds.max[a], bounds, a));
+                    Reference remaining = reference;
+                    for (int b = first; b < last; ++b) {
+                        Reference leftPart, rightPart;
+                        splitReference(remaining, a, getSpatialPlane(bounds, a, b), leftPart, rightPart);
+                        bins.bounds[a][b].grow(leftPart.bounds);
+                        remaining = rightPart;
+                    }
+                    bins.bounds[a][last].grow(remaining.bounds);
+                    bins.counts[a][first]++;
+                    bins.exits[a][last]++;
+                }
+            }
+        });
+
+        for (size_t c = 1; c < chunkBins.size(); ++c)
+            chunkBins[0].merge(chunkBins[c]);
+        return chunkBins[0];
+    }
+
+    // sweeps from both sides to evaluate every bin boundary in linear time
+    static void findBestSplit(const Bins &bins, bool spatial, Split &best) {
+        for (int a = 0; a < 3; ++a) {
+            std::array<Aabb, kBinCount - 1> leftBox, rightBox;
+            std::array<uint32_t, kBinCount - 1> leftCount, rightCount;
+            Aabb leftSweep, rightSweep;
+            uint32_t leftSum = 0, rightSum = 0;
+            for (int i = 0; i < kBinCount - 1; ++i) {
+                leftSum += bins.counts[a][i];
+                leftCount[i] = leftSum;
+                leftSweep.grow(bins.bounds[a][i]);
+                leftBox[i] = leftSweep;
+
+                int j = kBinCount - 1 - i;
+                rightSum += spatial ? bins.exits[a][j] : bins.counts[a][j];
+                rightCount[j - 1] = rightSum;
+                rightSweep.grow(bins.bounds[a][j]);
+                rightBox[j - 1] = rightSweep;
+            }
+
+            for (int i = 0; i < kBinCount - 1; ++i) {
+                float cost = leftCount[i] * leftBox[i].area() + rightCount[i] * rightBox[i].area();
+                if (leftCount[i] > 0 && rightCount[i] > 0 && cost < best.cost) {
+                    best = { .cost        = cost,
+                             .axis        = a,
+                             .bin         = i,
+                             .leftBounds  = leftBox[i],
+                             .rightBounds = rightBox[i],
+                             .leftCount   = leftCount[i],
+                             .rightCount  = rightCount[i] };
+                }
+            }
+        }
+    }
+
+    // the parts of a reference on both sides of an axis aligned plane, from the triangle clipped against it
+    void splitReference(const Reference &reference, int axis, float plane, Reference &left, Reference &right) const {
+        Aabb leftBox, rightBox;
+        for (int k = 0; k < 3; ++k) {
+            const vec3 &v0 = m_positions[reference.triangle * 3 + k];
+            const vec3 &v1 = m_positions[reference.triangle * 3 + (k + 1) % 3];
+            if (v0[axis] <= plane)
+                leftBox.grow(v0);
+            if (v0[axis] >= plane)
+                rightBox.grow(v0);
+
+            // the edge crosses the plane
+            if ((v0[axis] < plane && v1[axis] > plane) || (v0[axis] > plane && v1[axis] < plane)) {
+                vec3 p = glm::mix(v0, v1, std::clamp((plane - v0[axis]) / (v1[axis] - v0[axis]), 0.0f, 1.0f));
+                p[axis] = plane;
+                leftBox.grow(p);
+                rightBox.grow(p);
+            }
+        }
+
+        left  = { leftBox.intersection(reference.bounds), reference.triangle };
+        right = { rightBox.intersection(reference.bounds), reference.triangle };
+    }
+
+    // fills left and right, false when the node is better off as a leaf
+    bool split(const std::vector<Reference> &references, const Aabb &bounds, const Aabb &centroidBounds,
+               std::vector<Reference> &left, std::vector<Reference> &right) {
+        float leafCost = references.size() * bounds.area();
+
+        Split objectSplit;
+        findBestSplit(binReferences(references, bounds, centroidBounds, false), false, objectSplit);
+
+        // the spatial splits only pay off where the children of the object split overlap, and they are only tried
+        // there so that the references do not grow much beyond the triangles
+        Split spatialSplit;
+        if (m_spatialSplits && m_referenceCount < m_referenceBudget &&
+            (objectSplit.axis < 0 ||
+             objectSplit.leftBounds.intersection(objectSplit.rightBounds).area() > kSpatialSplitAlpha * m_rootArea))
+            findBestSplit(binReferences(references, bounds, centroidBounds, true), true, spatialSplit);
+
+        if (spatialSplit.cost < objectSplit.cost && spatialSplit.cost < leafCost &&
+            partitionSpatial(references, bounds, spatialSplit, left, right))
+            return true;
+
+        if (objectSplit.axis < 0 || objectSplit.cost >= leafCost)
+            return false;
+
+        left.clear();
+        right.clear();
+        for (auto &reference: references) {
+            if (getObjectBin(reference, centroidBounds, objectSplit.axis) <= objectSplit.bin)
+                left.push_back(reference);
+            else
+                right.push_back(reference);
+        }
+        return !left.empty() && !right.empty();
+    }
+
+    bool partitionSpatial(const std::vector<Reference> &references, const Aabb &bounds, const Split &split,
+                          std::vector<Reference> &left, std::vector<Reference> &right) {
+        int axis    = split.axis;
+        float plane = getSpatialPlane(bounds, axis, split.bin);
+
+        float leftArea  = split.leftBounds.area();
+        float rightArea = split.rightBounds.area();
+        float splitCost = leftArea * split.leftCount + rightArea * split.rightCount;
+
+        for (auto &reference: references) {
+            if (reference.bounds.max[axis] <= plane) {
+                left.push_back(reference);
+            } else if (reference.bounds.min[axis] >= plane) {
+                right.push_back(reference);
+            } else {
+                // a straddling reference is kept whole on one side when that is cheaper than splitting it
+                Aabb leftUnsplit = split.leftBounds, rightUnsplit = split.rightBounds;
+                leftUnsplit.grow(reference.bounds);
+                rightUnsplit.grow(reference.bounds);
+                float leftCost  = leftUnsplit.area() * split.leftCount + rightArea * (split.rightCount - 1);
+                float rightCost = leftArea * (split.leftCount - 1) + rightUnsplit.area() * split.rightCount;
+
+                Reference leftPart, rightPart;
+                splitReference(reference, axis, plane, leftPart, rightPart);
+                if (leftCost < splitCost && leftCost <= rightCost) {
+                    left.push_back(reference);
+                } else if (rightCost < splitCost) {
+                    right.push_back(reference);
+                } else if (leftPart.bounds.isEmpty()) {
+                    right.push_back(reference);
+                } else if (rightPart.bounds.isEmpty()) {
+                    left.push_back(reference);
+                } else {
+                    left.push_back(leftPart);
+                    right.push_back(rightPart);
+                }
+            }
+        }
+
+        // a split that leaves a child with every reference would not get any smaller
+        if (left.empty() || right.empty() || left.size() == references.size() ||
+            right.size() == references.size()) {
+            left.clear();
+            right.clear();
+            return false;
+        }
+        m_referenceCount += left.size() + right.size() - references.size();
+        return true;
+    }
+
+    const std::vector<vec3> &m_positions;
+    bool m_spatialSplits;
+    ThreadPool *m_pThreadPool;
+
+    float m_rootArea{ 0.0f };
+    size_t m_referenceCount{ 0 };
+    size_t m_referenceBudget{ 0 };
+};
+
+} // namespace
+
+void Bvh::build(const std::vector<vec3> &positions, Builder builder, Layout layout, ThreadPool *pThreadPool) {
+    Timer timer;
+    m_positions = positions;
+    m_quantizedNodes.clear();
+    m_triangleBlocks.clear();
+
+    BvhBuilder(m_positions, builder == eSpatialSplits, pThreadPool).build(m_nodes, m_triangleIndices);
+
+    // expected intersection tests of a ray through the root: one per node and leaf triangle, weighted by the
+    // probability of entering it, its surface area relative to the root's
+    float rootArea = Aabb{ m_nodes[0].boundsMin, m_nodes[0].boundsMax }.area();
+    float sahCost  = 0.0f;
+    if (rootArea > 0.0f) {
+        for (auto &node: m_nodes) {
+            float area = Aabb{ node.boundsMin, node.boundsMax }.area() / rootArea;
+            sahCost += area * (node.triangleCount > 0 ? node.triangleCount : 1);
+        }
+    }
+
+    size_t floatBytes = m_nodes.size() * sizeof(BvhNode) + m_triangleIndices.size() * sizeof(uint32_t) +
+                        m_positions.size() * sizeof(vec3);
+    m_buildStats      = { .triangleCount  = static_cast<uint32_t>(m_positions.size() / 3),
+                          .referenceCount = static_cast<uint32_t>(m_triangleIndices.size()),
+                          .nodeCount      = static_cast<uint32_t>(m_nodes.size()),
+                          .sahCost        = sahCost,
+                          .floatBytes     = floatBytes };
+
+    if (layout == eQuantizedNodes) {
+        quantize();
+        m_buildStats.quantizedNodeCount = static_cast<uint32_t>(m_quantizedNodes.size());
+        m_buildStats.quantizedBytes =
+            m_quantizedNodes.size() * sizeof(BvhNode4) + m_triangleBlocks.size() * sizeof(BvhTriangleBlock);
+    }
+    m_buildStats.buildMs = timer.elapsed();
+}
+
+void Bvh::quantize() {
+    // an empty tree has nothing to traverse, see traverse()
+    if (m_triangleIndices.empty())
+        return;
+
+    // binary node to collapse, and the quantized node it becomes
+    std::vector<std::pair<uint32_t, uint32_t>> stack{ { 0, 0 } };
+    m_quantizedNodes.resize(1);
+
+    while (!stack.empty()) {
+        auto [binaryIndex, quantizedIndex] = stack.back();
+        stack.pop_back();
+
+        // open the inner child with the largest surface area until there are four children, which gives the
+        // traversal the children it would most likely have visited next. a leaf at the root is its only child.
+        const BvhNode &parent = m_nodes[binaryIndex];
+        std::array<uint32_t, 4> children;
+        uint32_t childCount = 0;
+        if (parent.triangleCount > 0) {
+            children[childCount++] = binaryIndex;
+        } else {
+            children[childCount++] = parent.leftOrFirst;
+            children[childCount++] = parent.leftOrFirst + 1;
+        }
+        while (childCount < 4) {
+            int largest       = -1;
+            float largestArea = -1.0f;
+            for (uint32_t i = 0; i < childCount; ++i) {
+                const BvhNode &child = m_nodes[children[i]];
+                float area           = Aabb{ child.boundsMin, child.boundsMax }.area();
+                if (child.triangleCount == 0 && area > largestArea) {
+                    largest     = static_cast<int>(i);
+                    largestArea = area;
+                }
+            }
+            if (largest < 0)
+                break;
+            uint32_t first         = m_nodes[children[largest]].leftOrFirst;
+            children[largest]      = first;
+            children[childCount++] = first + 1;
+        }
+
+        BvhNode4 node{};
+        node.origin     = parent.boundsMin;
+        node.childCount = static_cast<uint8_t>(childCount);
+        for (int a = 0; a < 3; ++a)
+            node.exponents[a] = quantizationExponent(parent.boundsMin[a], parent.boundsMax[a]);
+
+        for (uint32_t i = 0; i < childCount; ++i) {
+            const BvhNode &child = m_nodes[children[i]];
+
+            // round outwards, then step further out where the decoded bound still misses the float one
+            for (int a = 0; a < 3; ++a) {
+                float step   = quantizationStep(node.exponents[a]);
+                float origin = node.origin[a];
+                int qMin     = std::clamp(static_cast<int>(std::floor((child.boundsMin[a] - origin) / step)), 0, 255);
+                int qMax     = std::clamp(static_cast<int>(std::ceil((child.boundsMax[a] - origin) / step)), 0, 255);
+                while (qMin > 0 && origin + static_cast<float>(qMin) * step > child.boundsMin[a])
+                    --qMin;
+                while (qMax < 255 && origin + static_cast<float>(qMax) * step < child.boundsMax[a])
+                    ++qMax;
+                node.boundsMin[a][i] = static_cast<uint8_t>(qMin);
+                node.boundsMax[a][i] = static_cast<uint8_t>(qMax);
+            }
+
+            if (child.triangleCount > 0) {
+                node.children[i] = static_cast<uint32_t>(m_triangleBlocks.size());
+                node.leafMask |= static_cast<uint8_t>(1u << i);
+                for (uint32_t t = 0; t < child.triangleCount; ++t) {
+                    uint32_t tri   = m_triangleIndices[child.leftOrFirst + t];
+                    const vec3 &v0 = m_positions[tri * 3];
+                    uint32_t last  = t + 1 == child.triangleCount ? BvhTriangleBlock::kLastInLeaf : 0u;
+                    m_triangleBlocks.push_back({ .v0            = v0,
+                                                 .e1            = m_positions[tri * 3 + 1] - v0,
+                                                 .e2            = m_positions[tri * 3 + 2] - v0,
+                                                 .triangleIndex = tri | last });
+                }
+            } else {
+                node.children[i] = static_cast<uint32_t>(m_quantizedNodes.size());
+                stack.push_back({ children[i], node.children[i] });
+                m_quantizedNodes.emplace_back();
+            }
+        }
+        m_quantizedNodes[quantizedIndex] = node;
+    }
+
+    // the triangle blocks hold everything the traversal reads
+    m_nodes           = {};
+    m_triangleIndices = {};
+    m_positions       = {};
+}
+
+bool Bvh::intersect(const Ray &ray, RayHit &hit) const {
+    return m_triangleBlocks.empty() ? traverse(ray, hit, false) : traverseQuantized(ray, hit, false);
+}
+
+bool Bvh::occluded(const Ray &ray) const {
+    RayHit hit;
+    return m_triangleBlocks.empty() ? traverse(ray, hit, true) : traverseQuantized(ray, hit, true);
+}
+
+bool Bvh::traverse(const Ray &ray, RayHit &hit, bool terminateOnFirstHit) const {
+    // an empty root is a leaf without triangles, its bounds are inverted and not safe to test
+    if (m_triangleIndices.empty())
+        return false;
+
+    vec3 invDir = safeInverse(ray.direction);
+    float tMax  = std::min(ray.tMax, hit.t);
+
+    // build() stops at kMaxDepth levels, and every inner node on the current path pushes at most one child
+    std::array<uint32_t, kMaxDepth> stack;
+    int stackSize    = 0;
+    uint32_t current = 0;
+
+    if (intersectAabb(ray, invDir, m_nodes[0].boundsMin, m_nodes[0].boundsMax, tMax) ==
+        std::numeric_limits<float>::max())
+        return false;
+
+    while (true) {
+        const BvhNode &node = m_nodes[current];
+
+        if (node.triangleCount > 0) {
+            for (uint32_t i = 0; i < node.triangleCount; ++i) {
+                uint32_t tri = m_triangleIndices[node.leftOrFirst + i];
+                float t;
+                vec2 barycentrics;
+                const vec3 &v0 = m_positions[tri * 3];
+                if (intersectTriangle(ray, v0, m_positions[tri * 3 + 1] - v0, m_positions[tri * 3 + 2] - v0, tMax, t,
+                                      barycentrics)) {
+                    tMax              = t;
+                    hit.t             = t;
+                    hit.barycentrics  = barycentrics;
+                    hit.triangleIndex = tri;
+                    if (terminateOnFirstHit)
+                        return true;
+                }
+            }
+        } else {
+            // visit the nearer child first and keep the other one for later
+            uint32_t nearChild      = node.leftOrFirst;
+            uint32_t farChild       = node.leftOrFirst + 1;
+            const BvhNode &nearNode = m_nodes[nearChild];
+            const BvhNode &farNode  = m_nodes[farChild];
+            float nearDist          = intersectAabb(ray, invDir, nearNode.boundsMin, nearNode.boundsMax, tMax);
+            float farDist           = intersectAabb(ray, invDir, farNode.boundsMin, farNode.boundsMax, tMax);
+            if (nearDist > farDist) {
+                std::swap(nearChild, farChild);
+                std::swap(nearDist, farDist);
+            }
+
+            if (nearDist != std::numeric_limits<float>::max()) {
+                if (farDist != std::numeric_limits<float>::max())
+                    stack[stackSize++] = farChild;
+                current = nearChild;
+                continue;
+            }
+        }
+
+        // pop the next node that can still contain a closer hit
+        if (stackSize == 0)
+            break;
+        current = stack[--stackSize];
+    }
+
+    return hit.isHit();
+}
+
+bool Bvh::traverseQuantized(const Ray &ray, RayHit &hit, bool terminateOnFirstHit) const {
+    // leaves are pushed as their first triangle block with the top bit set
+    const uint32_t kLeafBit = 1u << 31;
+
+    vec3 invDir = safeInverse(ray.direction);
+    float tMax  = std::min(ray.tMax, hit.t);
+
+    // a quantized node is at least one level below its parent in the binary tree, and pushes at most three children
+    std::array<uint32_t, kMaxDepth * 3> stack;
+    int stackSize    = 0;
+    uint32_t current = 0;
+
+    while (true) {
+        if (current & kLeafBit) {
+            for (uint32_t i = current & ~kLeafBit;; ++i) {
+                const BvhTriangleBlock &block = m_triangleBlocks[i];
+                float t;
+                vec2 barycentrics;
+                if (intersectTriangle(ray, block.v0, block.e1, block.e2, tMax, t, barycentrics)) {
+                    tMax              = t;
+                    hit.t             = t;
+                    hit.barycentrics  = barycentrics;
+                    hit.triangleIndex = block.triangleIndex & ~BvhTriangleBlock::kLastInLeaf;
+                    if (terminateOnFirstHit)
+                        return true;
+                }
+                if (block.triangleIndex & BvhTriangleBlock::kLastInLeaf)
+                    break;
+            }
+        } else {
+            const BvhNode4 &node = m_quantizedNodes[current];
+            float distances[4];
+            uint32_t mask = intersectChildren(node, ray, invDir, tMax, distances);
+
+            // sort the children the ray enters by distance, visit the nearest one and push the others farthest first
+            std::array<uint32_t, 4> order;
+            uint32_t hitCount = 0;
+            for (uint32_t i = 0; i < 4; ++i) {
+                if (!(mask & (1u << i)))
+                    continue;
+                uint32_t j = hitCount++;
+                for (; j > 0 && distances[order[j - 1]] > distances[i]; --j)
+                    order[j] = order[j - 1];
+                order[j] = i;
+            }
+
+            if (hitCount > 0) {
+                for (uint32_t j = hitCount - 1; j > 0; --j) {
+                    uint32_t i         = order[j];
+                    stack[stackSize++] = node.children[i] | (node.leafMask & (1u << i) ? kLeafBit : 0u);
+                }
+                uint32_t i = order[0];
+                current    = node.children[i] | (node.leafMask & (1u << i) ? kLeafBit : 0u);
+                continue;
+            }
+        }
+
+        if (stackSize == 0)
+            break;
+        current = stack[--stackSize];
+    }
+
+    return hit.isHit();
+}
+
+} // namespace vuren
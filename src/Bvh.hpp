@@ -0,0 +1,120 @@
+#ifndef BVH_HPP
+#define BVH_HPP
+
+#include "Common.hpp"
+
+#include <limits>
+#include <vector>
+
+namespace vuren {
+
+struct Ray {
+    vec3 origin;
+    vec3 direction;
+    float tMin{ 0.0f };
+    float tMax{ std::numeric_limits<float>::max() };
+};
+
+struct RayHit {
+    static constexpr uint32_t kMiss = ~0u;
+
+    float t{ std::numeric_limits<float>::max() };
+    vec2 barycentrics{ 0.0f }; // weights of v1 and v2, same convention as the ray tracing hit attributes
+    uint32_t triangleIndex{ kMiss };
+
+    bool isHit() const { return triangleIndex != kMiss; }
+};
+
+// 32 bytes, two nodes per cache line
+struct BvhNode {
+    vec3 boundsMin;
+    uint32_t leftOrFirst;   // first child index for inner nodes, first triangle slot for leaves
+    vec3 boundsMax;
+    uint32_t triangleCount; // zero for inner nodes
+};
+
+// 64 bytes, one cache line: up to four children with their bounds quantized to 8 bits in the frame of the node
+// (Ylitie et al. 2017), rounded outwards so they still enclose the children
+struct alignas(64) BvhNode4 {
+    vec3 origin;             // minimum corner of the frame
+    int8_t exponents[3];     // a quantization step along each axis is 2^exponent
+    uint8_t childCount;
+    uint32_t children[4];    // node index, or the first triangle block for the children in leafMask
+    uint8_t boundsMin[3][4]; // per axis and child, in steps from the origin
+    uint8_t boundsMax[3][4];
+    uint8_t leafMask;
+    uint8_t pad[7];
+};
+
+// 40 bytes: a triangle as the intersection test reads it, the blocks of a leaf are packed one after the other
+struct BvhTriangleBlock {
+    static constexpr uint32_t kLastInLeaf = 1u << 31;
+
+    vec3 v0;
+    vec3 e1;                // v1 - v0
+    vec3 e2;                // v2 - v0
+    uint32_t triangleIndex; // kLastInLeaf is set on the last block of a leaf
+};
+
+class ThreadPool;
+
+// triangle bvh for the cpu renderer, built with binned sah.
+// triangles are referenced by their index in the position list given to build(), so per-triangle
+// shading data can stay with the caller.
+class Bvh {
+public:
+    // object splits only, or spatial splits as well (sbvh, Stich et al. 2009): long, thin triangles that make the
+    // children of object splits overlap are clipped at the split plane and referenced by both children
+    enum Builder { eBinned, eSpatialSplits };
+
+    // the binary tree with float bounds as built, or collapsed into quantized 4-wide nodes and triangle blocks, which
+    // replace the positions and the triangle indices
+    enum Layout { eFloatNodes, eQuantizedNodes };
+
+    struct BuildStats {
+        double buildMs{ 0.0 };
+        uint32_t triangleCount{ 0 };
+        uint32_t referenceCount{ 0 }; // triangle slots in the leaves, more than the triangles with spatial splits
+        uint32_t nodeCount{ 0 };
+        // expected node and triangle tests of a ray through the root, from the surface areas of the nodes
+        float sahCost{ 0.0f };
+        uint32_t quantizedNodeCount{ 0 };
+        // nodes and triangle data read by the traversal in either layout, the quantized one only when built
+        size_t floatBytes{ 0 };
+        size_t quantizedBytes{ 0 };
+    };
+
+    Bvh() {}
+    ~Bvh() {}
+
+    // three world space positions per triangle. the thread pool, when given, bins the large nodes in parallel.
+    void build(const std::vector<vec3> &positions, Builder builder = eBinned, Layout layout = eFloatNodes,
+               ThreadPool *pThreadPool = nullptr);
+
+    // closest hit along the ray
+    bool intersect(const Ray &ray, RayHit &hit) const;
+
+    // any hit along the ray, for shadow rays: the traversal stops at the first one
+    bool occluded(const Ray &ray) const;
+
+    size_t getNodeCount() const { return m_quantizedNodes.empty() ? m_nodes.size() : m_quantizedNodes.size(); }
+    const BuildStats &getBuildStats() const { return m_buildStats; }
+
+private:
+    // collapse the binary tree into m_quantizedNodes and m_triangleBlocks, then release it
+    void quantize();
+
+    bool traverse(const Ray &ray, RayHit &hit, bool terminateOnFirstHit) const;
+    bool traverseQuantized(const Ray &ray, RayHit &hit, bool terminateOnFirstHit) const;
+
+    std::vector<vec3> m_positions;
+    std::vector<uint32_t> m_triangleIndices;
+    std::vector<BvhNode> m_nodes;
+    std::vector<BvhNode4> m_quantizedNodes;
+    std::vector<BvhTriangleBlock> m_triangleBlocks;
+    BuildStats m_buildStats;
+};
+
+} // namespace vuren
+
+#endif // BVH_HPP
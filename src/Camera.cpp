@@ -7,6 +7,14 @@ void Camera::init() {
     m_center = glm::vec3(0.0f, 0.0f, 0.0f);
     m_up     = glm::vec3(0.0f, 1.0f, 0.0f);
     updateCamera();
+    beginFrame();
+}
+
+void Camera::setLookAt(const glm::vec3 &eye, const glm::vec3 &center, const glm::vec3 &up) {
+    m_eye    = eye;
+    m_center = center;
+    m_up     = up;
+    updateCamera();
 }
 
 // to-fix: accurate camera manipulation
@@ -52,28 +60,32 @@ void Camera::releaseLeftMouse(float oldX, float oldY) {
 
 void Camera::updateCamera() {
     m_data.view = glm::lookAt(m_eye, m_center, m_up);
-    m_data.proj = glm::perspective(glm::radians(45.0f), m_extent.width / (float) m_extent.height, 0.1f, 100.0f);
+    m_data.proj = glm::perspective(glm::radians(m_fovY), m_extent.width / (float) m_extent.height, 0.1f, 100.0f);
     m_data.proj[1][1] *= -1;
 
     // precompute inverse matrices for camera ray generation
     m_data.invView = glm::inverse(m_data.view);
     m_data.invProj = glm::inverse(m_data.proj);
 
-    memcpy(m_pMappedBuffer, &m_data, sizeof(m_data));
+    if (m_pMappedBuffer)
+        memcpy(m_pMappedBuffer, &m_data, sizeof(m_data));
 }
 
-void Camera::exampleRotationalCamera() {
-    static auto startTime = std::chrono::high_resolution_clock::now();
+void Camera::beginFrame() {
+    m_data.prevView = m_data.view;
+    m_data.prevProj = m_data.proj;
 
-    auto currentTime = std::chrono::high_resolution_clock::now();
-    float time       = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - startTime).count();
+    if (m_pMappedBuffer)
+        memcpy(m_pMappedBuffer, &m_data, sizeof(m_data));
+}
 
+void Camera::exampleRotationalCamera(float time) {
     m_eye    = glm::vec3(3.0 * glm::cos(time * glm::radians(90.0f)), 3.0 * glm::sin(time * glm::radians(90.0f)), 2.0f);
     m_center = glm::vec3(0.0f, 0.0f, 0.0f);
     m_up     = glm::vec3(0.0f, 0.0f, 1.0f);
 
     m_data.view = glm::lookAt(m_eye, m_center, m_up);
-    m_data.proj = glm::perspective(glm::radians(45.0f), m_extent.width / (float) m_extent.height, 0.1f, 100.0f);
+    m_data.proj = glm::perspective(glm::radians(m_fovY), m_extent.width / (float) m_extent.height, 0.1f, 100.0f);
 
     // GLM's Y coordinate of the clip coordinates is inverted
     // To compensate this, flip the sign on the scaling factor of the Y axis in the proj matrix.
@@ -84,7 +96,8 @@ void Camera::exampleRotationalCamera() {
     m_data.invProj = glm::inverse(m_data.proj);
 
     // m_pScene->setCamera(camera);
-    memcpy(m_pMappedBuffer, &m_data, sizeof(m_data));
+    if (m_pMappedBuffer)
+        memcpy(m_pMappedBuffer, &m_data, sizeof(m_data));
 }
 
 } // namespace vuren
\ No newline at end of file
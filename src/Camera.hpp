@@ -2,7 +2,6 @@
 #define CAMERA_HPP
 
 #include "Common.hpp"
-#include <chrono>
 
 namespace vuren {
 
@@ -27,15 +26,30 @@ public:
 
     void setExtent(vk::Extent2D extent) { m_extent = extent; }
 
+    void setLookAt(const glm::vec3 &eye, const glm::vec3 &center, const glm::vec3 &up);
+
+    void setFovY(float fovY) { m_fovY = fovY; }
+
+    const glm::vec3 &getEye() const { return m_eye; }
+    const glm::vec3 &getCenter() const { return m_center; }
+    const glm::vec3 &getUp() const { return m_up; }
+    float getFovY() const { return m_fovY; }
+
     void updateCamera();
 
-    void exampleRotationalCamera();
+    // makes the current matrices the previous frame's (CameraData::prevView/prevProj). call once per frame, before
+    // the camera is moved for the new frame.
+    void beginFrame();
+
+    // orbits the origin by 90 degrees per second. time is given by the caller, so that a path can be replayed
+    void exampleRotationalCamera(float time);
 
 private:
     glm::vec3 m_eye, m_center, m_up;
     CameraData m_data;
-    void *m_pMappedBuffer;
+    void *m_pMappedBuffer{ nullptr }; // stays null for the cpu renderer
     vk::Extent2D m_extent;
+    float m_fovY{ 45.0f };            // vertical field of view in degrees
 
     bool m_pressedLeftMouse{ false };
     float m_oldMouseX;
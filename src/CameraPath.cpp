@@ -0,0 +1,103 @@
+#include "CameraPath.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace vuren {
+
+void CameraPath::load(const std::string &filename) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        throw std::runtime_error("failed to open camera path " + filename + "!");
+    }
+
+    m_keyframes.clear();
+
+    std::string line;
+    uint32_t lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        line = line.substr(0, line.find('#'));
+
+        std::istringstream stream(line);
+        std::vector<float> values;
+        float value;
+        while (stream >> value)
+            values.push_back(value);
+
+        if (values.empty() && stream.eof())
+            continue;
+        if (!stream.eof() || (values.size() != 7 && values.size() != 10 && values.size() != 11)) {
+            throw std::runtime_error(filename + ":" + std::to_string(lineNumber) +
+                                     ": expected time eye.xyz center.xyz [up.xyz [fovY]]");
+        }
+
+        CameraKeyframe keyframe = { .time   = values[0],
+                                    .eye    = glm::vec3(values[1], values[2], values[3]),
+                                    .center = glm::vec3(values[4], values[5], values[6]) };
+        if (values.size() >= 10)
+            keyframe.up = glm::vec3(values[7], values[8], values[9]);
+        if (values.size() == 11)
+            keyframe.fovY = values[10];
+
+        if (!m_keyframes.empty() && keyframe.time < m_keyframes.back().time) {
+            throw std::runtime_error(filename + ":" + std::to_string(lineNumber) + ": keyframes are not in time order");
+        }
+        m_keyframes.push_back(keyframe);
+    }
+
+    if (m_keyframes.empty()) {
+        throw std::runtime_error("camera path " + filename + " has no keyframes!");
+    }
+}
+
+void CameraPath::save(const std::string &filename) const {
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        throw std::runtime_error("failed to open " + filename + " for writing!");
+    }
+
+    file << "# vuren camera path\n# time eye.xyz center.xyz up.xyz fovY\n";
+    for (auto &keyframe: m_keyframes) {
+        file << keyframe.time << "  " << keyframe.eye.x << " " << keyframe.eye.y << " " << keyframe.eye.z << "  "
+             << keyframe.center.x << " " << keyframe.center.y << " " << keyframe.center.z << "  " << keyframe.up.x
+             << " " << keyframe.up.y << " " << keyframe.up.z << "  " << keyframe.fovY << "\n";
+    }
+}
+
+void CameraPath::addKeyframe(const CameraKeyframe &keyframe) { m_keyframes.push_back(keyframe); }
+
+CameraKeyframe CameraPath::evaluate(float time) const {
+    if (m_keyframes.empty()) {
+        throw std::runtime_error("cannot evaluate an empty camera path!");
+    }
+
+    if (time <= m_keyframes.front().time)
+        return m_keyframes.front();
+    if (time >= m_keyframes.back().time)
+        return m_keyframes.back();
+
+    // first keyframe after time
+    auto next = std::upper_bound(m_keyframes.begin(), m_keyframes.end(), time,
+                                 [](float t, const CameraKeyframe &keyframe) { return t < keyframe.time; });
+    auto prev = next - 1;
+
+    float span = next->time - prev->time;
+    float t    = span > 0.0f ? (time - prev->time) / span : 1.0f;
+
+    return { .time   = time,
+             .eye    = glm::mix(prev->eye, next->eye, t),
+             .center = glm::mix(prev->center, next->center, t),
+             .up     = glm::normalize(glm::mix(prev->up, next->up, t)),
+             .fovY   = glm::mix(prev->fovY, next->fovY, t) };
+}
+
+void CameraPath::apply(Camera &camera, float time) const {
+    CameraKeyframe keyframe = evaluate(time);
+    camera.setFovY(keyframe.fovY);
+    camera.setLookAt(keyframe.eye, keyframe.center, keyframe.up);
+}
+
+} // namespace vuren
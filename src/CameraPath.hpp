@@ -0,0 +1,48 @@
+#ifndef CAMERA_PATH_HPP
+#define CAMERA_PATH_HPP
+
+#include "Common.hpp"
+#include "Camera.hpp"
+
+#include <string>
+#include <vector>
+
+namespace vuren {
+
+struct CameraKeyframe {
+    float time; // seconds
+    glm::vec3 eye;
+    glm::vec3 center;
+    glm::vec3 up{ 0.0f, 1.0f, 0.0f };
+    float fovY{ 45.0f };
+};
+
+// a recorded camera path, replayed by the benchmark mode.
+// the file is plain text with one keyframe per line: time eye.xyz center.xyz [up.xyz [fovY]], '#' starts a comment.
+class CameraPath {
+public:
+    CameraPath() {}
+    ~CameraPath() {}
+
+    void load(const std::string &filename);
+    void save(const std::string &filename) const;
+
+    // keyframes must be added in time order
+    void addKeyframe(const CameraKeyframe &keyframe);
+
+    bool empty() const { return m_keyframes.empty(); }
+    size_t size() const { return m_keyframes.size(); }
+    float getDuration() const { return m_keyframes.empty() ? 0.0f : m_keyframes.back().time; }
+
+    // linear interpolation between the surrounding keyframes, clamped to the ends of the path
+    CameraKeyframe evaluate(float time) const;
+
+    void apply(Camera &camera, float time) const;
+
+private:
+    std::vector<CameraKeyframe> m_keyframes;
+};
+
+} // namespace vuren
+
+#endif // CAMERA_PATH_HPP
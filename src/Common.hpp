@@ -63,10 +63,36 @@ struct SceneGlobalData {
     uint lightCount;
 };
 
+#define LIGHT_TYPE_POINT 0
+
+// 32 bytes in std430 and in c++
 struct Light {
-    uint type;
     vec3 pos;
-    vec3 intensity;
+    uint type;      // LIGHT_TYPE_POINT
+    vec3 intensity; // radiant intensity (per steradian)
+    float pad;
+};
+
+// a bucket of the alias table of the scene's lights (Scene::buildLightAliasTable), one per light.
+// a uniform bucket keeps its own light with probability threshold, else it picks alias.
+struct LightAliasEntry {
+    float threshold;
+    uint alias;
+    float pmf; // selection probability of the light with the bucket's index
+    float pad;
+};
+
+// set in LightBvhNode::childOrLight for a leaf, which holds a single light
+#define LIGHT_BVH_LEAF 0x80000000u
+
+// 48 bytes in std430 and in c++. an inner node's first child is the next node (depth-first order).
+struct LightBvhNode {
+    vec3 boundsMin;
+    float power;       // summed luminance of the intensities
+    vec3 boundsMax;
+    uint childOrLight; // the second child of an inner node, LIGHT_BVH_LEAF | light index for a leaf
+    vec3 axis;         // the cone bounding every emission direction, the falloff past it is pi / 2
+    float cosThetaO;   // -1 for lights emitting everywhere, like point lights
 };
 
 struct Material {
@@ -145,6 +171,10 @@ struct CameraData {
     mat4 proj;
     mat4 invView;
     mat4 invProj;
+
+    // the matrices of the previous frame, for motion vectors and reprojection
+    mat4 prevView;
+    mat4 prevProj;
 };
 
 struct PushConstantRay {
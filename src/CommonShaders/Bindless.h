@@ -0,0 +1,51 @@
+#ifndef BINDLESS_H
+#define BINDLESS_H
+
+#include "Common.hpp"
+
+// set 0 of every pipeline is the global table of scene resources, bound once per frame.
+// the resources of a pass are in set 1.
+#define BINDLESS_SET 0
+#define PASS_SET 1
+
+#define BINDLESS_TEXTURES_BINDING 0
+#define BINDLESS_OBJECTS_BINDING 1
+#define BINDLESS_MATERIALS_BINDING 2
+#define BINDLESS_LIGHTS_BINDING 3
+#define BINDLESS_LIGHT_ALIAS_BINDING 4
+#define BINDLESS_LIGHT_BVH_BINDING 5
+
+// capacity of the texture array, only the slots of added textures are written (partially bound)
+#define BINDLESS_MAX_TEXTURES 1024
+
+#ifndef __cplusplus
+
+// the includer enables GL_EXT_nonuniform_qualifier and indexes the textures with nonuniformEXT()
+layout(set = BINDLESS_SET, binding = BINDLESS_TEXTURES_BINDING) uniform sampler2D sceneTextures[];
+
+layout(set = BINDLESS_SET, binding = BINDLESS_OBJECTS_BINDING) readonly buffer _SceneObjects {
+    SceneObjectDevice data[];
+} sceneObjects;
+
+layout(set = BINDLESS_SET, binding = BINDLESS_MATERIALS_BINDING) readonly buffer _SceneMaterials {
+    Material data[];
+} sceneMaterials;
+
+// the scene has at least one light
+layout(set = BINDLESS_SET, binding = BINDLESS_LIGHTS_BINDING) readonly buffer _SceneLights {
+    Light data[];
+} sceneLights;
+
+// one bucket per light, see Scene.hpp
+layout(set = BINDLESS_SET, binding = BINDLESS_LIGHT_ALIAS_BINDING) readonly buffer _SceneLightAliasTable {
+    LightAliasEntry data[];
+} sceneLightAliasTable;
+
+// the hierarchy over the lights in depth-first order, the root first (LightBvh.hpp)
+layout(set = BINDLESS_SET, binding = BINDLESS_LIGHT_BVH_BINDING) readonly buffer _SceneLightBvh {
+    LightBvhNode data[];
+} sceneLightBvh;
+
+#endif // __cplusplus
+
+#endif // BINDLESS_H
@@ -3,6 +3,8 @@
 
 const float PI = 3.1415926535897932384626433832795;
 const float INV_PI = 1.0 / 3.1415926535897932384626433832795;
+// the largest float below 1
+const float ONE_MINUS_EPSILON = 0.99999994;
 
 // calculate an orthonormal basis vectors where the z-axis is an arbitrary vector n.
 void computeOrthonormalBasis(in vec3 n, out vec3 b1, out vec3 b2) {
@@ -41,7 +43,8 @@ uint jenkinsHash(uint x) {
 }
 
 uint initRNG(uvec2 pixel, uvec2 resolution, uint frame) {
-    uint rngState = uint(dot(vec2(pixel), vec2(1, resolution.x))) ^ jenkinsHash(frame);
+    // the pixel index in integers, a float loses it above 2^24 pixels
+    uint rngState = (pixel.y * resolution.x + pixel.x) ^ jenkinsHash(frame);
     return jenkinsHash(rngState);
 }
 
@@ -0,0 +1,72 @@
+#ifndef RAY_STATS_H
+#define RAY_STATS_H
+
+#include "Common.hpp"
+
+#ifdef __cplusplus
+namespace vuren {
+#endif
+
+#define RAY_STATS_MAX_BOUNCES 8
+
+// specialization constants of the instrumented ray generation shaders
+#define RAY_STATS_ENABLED_CONSTANT_ID 0
+#define RAY_STATS_SUBGROUP_CONSTANT_ID 1
+
+// ray counters of one frame, zeroed before the pass and read back after it
+struct RayStats {
+    uint raysPerBounce[RAY_STATS_MAX_BOUNCES]; // traced rays, [0] is the first ray leaving the primary hit
+    uint hits;
+    uint misses;
+    uint paths;      // pixels whose primary hit is a surface
+    uint shadowRays; // next-event estimation visibility rays, not part of the path
+};
+
+#ifdef __cplusplus
+} // namespace vuren
+#else
+
+// define RAY_STATS_BINDING before including this header to get the counters at (set 1, RAY_STATS_BINDING).
+// the includer enables GL_KHR_shader_subgroup_arithmetic. when the counters are disabled every addRayStats()
+// call is compiled out.
+#ifdef RAY_STATS_BINDING
+
+layout(constant_id = RAY_STATS_ENABLED_CONSTANT_ID) const bool kRayStatsEnabled = false;
+layout(constant_id = RAY_STATS_SUBGROUP_CONSTANT_ID) const bool kRayStatsSubgroupReduce = false;
+
+layout(std430, set = 1, binding = RAY_STATS_BINDING) buffer _RayStats {
+    RayStats rayStats;
+};
+
+// one atomic per subgroup instead of one per invocation, since every invocation adds to the same few words.
+// a macro because the atomic needs the buffer member itself, not a copy of it.
+#define RAY_STATS_ADD(counter, value)                          \
+    {                                                          \
+        uint rayStatsValue = (value);                          \
+        if (kRayStatsSubgroupReduce) {                         \
+            uint rayStatsSum = subgroupAdd(rayStatsValue);     \
+            if (subgroupElect() && rayStatsSum > 0)            \
+                atomicAdd(counter, rayStatsSum);               \
+        } else if (rayStatsValue > 0) {                        \
+            atomicAdd(counter, rayStatsValue);                 \
+        }                                                      \
+    }
+
+// the rays of one path: tracedRays bounces, hits of them ended on a surface, and shadowRays towards lights
+void addRayStats(uint tracedRays, uint hits, uint shadowRays, bool pathStarted) {
+    if (!kRayStatsEnabled)
+        return;
+
+    for (uint bounce = 0; bounce < RAY_STATS_MAX_BOUNCES; ++bounce)
+        RAY_STATS_ADD(rayStats.raysPerBounce[bounce], bounce < tracedRays ? 1 : 0);
+    RAY_STATS_ADD(rayStats.hits, hits);
+    RAY_STATS_ADD(rayStats.misses, tracedRays - hits);
+    RAY_STATS_ADD(rayStats.paths, pathStarted ? 1 : 0);
+    RAY_STATS_ADD(rayStats.shadowRays, shadowRays);
+}
+
+#endif // RAY_STATS_BINDING
+
+#endif // __cplusplus
+
+#endif // RAY_STATS_H
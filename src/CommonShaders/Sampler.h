@@ -0,0 +1,141 @@
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include "Common.hpp"
+
+// sample points indexed by pixel, sample index and dimension, without any state carried between the samples.
+// this file compiles both as glsl and as c++ and draws the same numbers on either side, so the cpu renderer still
+// mirrors the path tracer: only 32-bit unsigned integer math, and the float conversion is exact.
+
+#ifdef __cplusplus
+namespace vuren {
+
+#define SAMPLER_FUNCTION inline
+#define SAMPLER_INOUT(type) type &
+
+// the glsl builtin
+SAMPLER_FUNCTION uint bitfieldReverse(uint x) {
+    x = ((x >> 1u) & 0x55555555u) | ((x & 0x55555555u) << 1u);
+    x = ((x >> 2u) & 0x33333333u) | ((x & 0x33333333u) << 2u);
+    x = ((x >> 4u) & 0x0f0f0f0fu) | ((x & 0x0f0f0f0fu) << 4u);
+    x = ((x >> 8u) & 0x00ff00ffu) | ((x & 0x00ff00ffu) << 8u);
+    return (x >> 16u) | (x << 16u);
+}
+
+#else
+
+#define SAMPLER_FUNCTION
+#define SAMPLER_INOUT(type) inout type
+
+#endif // __cplusplus
+
+// sequences of SamplerState::type
+#define SAMPLER_INDEPENDENT 0u // white noise, hashed from the pixel, sample index and dimension
+#define SAMPLER_SOBOL 1u       // Owen-scrambled Sobol points, shuffled and scrambled per pixel and dimension pair
+#define SAMPLER_RANK1 2u       // the R2 rank-1 lattice, shifted per pixel by a blue-noise dither mask
+
+struct SamplerState {
+    uint type;
+    uint seed;        // decorrelates the passes drawing samples for the same pixels
+    uint pixelSeed;   // hash of the seed and the pixel
+    uint ditherX;     // the pixel's offsets of the rank-1 lattice, 0.32 fixed point
+    uint ditherY;
+    uint sampleIndex; // from 0, e.g. the accumulated frames
+    uint dimension;   // the next dimension pair
+};
+
+// PCG hash (Jarzynski and Olano 2020, "Hash functions for GPU rendering")
+SAMPLER_FUNCTION uint pcgHash(uint v) {
+    uint state = v * 747796405u + 2891336453u;
+    uint word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    return (word >> 22u) ^ word;
+}
+
+SAMPLER_FUNCTION uint hashCombine(uint seed, uint v) {
+    return seed ^ (pcgHash(v) + 0x9e3779b9u + (seed << 6u) + (seed >> 2u));
+}
+
+// Burley 2020, "Practical hash-based Owen scrambling": a hash where every bit only depends on the bits below it.
+// applied to the reversed bits it is a nested uniform (Owen) scramble, every bit is flipped depending on the ones
+// above it.
+SAMPLER_FUNCTION uint laineKarrasPermutation(uint x, uint seed) {
+    x += seed;
+    x ^= x * 0x6c50b47cu;
+    x ^= x * 0xb82f1e52u;
+    x ^= x * 0xc7afe638u;
+    x ^= x * 0x8d22f6e6u;
+    return x;
+}
+
+SAMPLER_FUNCTION uint nestedUniformScramble(uint x, uint seed) {
+    return bitfieldReverse(laineKarrasPermutation(bitfieldReverse(x), seed));
+}
+
+// the second dimension of the Sobol sequence (primitive polynomial x + 1), the first is the van der Corput sequence
+// bitfieldReverse(index). both together make every aligned block of 2^k points a (0, k, 2)-net.
+SAMPLER_FUNCTION uint sobolSecond(uint index) {
+    uint x = 0u;
+    uint direction = 0x80000000u;
+    while (index != 0u) {
+        if ((index & 1u) != 0u)
+            x ^= direction;
+        direction ^= direction >> 1u;
+        index >>= 1u;
+    }
+    return x;
+}
+
+// the top 24 bits, in [0, 1)
+SAMPLER_FUNCTION float fixedToFloat(uint x) {
+    return float(x >> 8u) / 16777216.0f;
+}
+
+SAMPLER_FUNCTION SamplerState initSampler(uint type, uint pixelX, uint pixelY, uint sampleIndex, uint seed) {
+    SamplerState state;
+    state.type = type;
+    state.seed = seed;
+    state.pixelSeed = hashCombine(hashCombine(seed, pixelX), pixelY);
+    // two rank-1 lattices over the pixels (the R2 sequence, Roberts 2018), whose values are spread like blue noise
+    state.ditherX = pixelX * 0xc13fa9a9u + pixelY * 0x91e10da5u;
+    state.ditherY = pixelX * 0x91e10da5u + pixelY * 0xc13fa9a9u;
+    state.sampleIndex = sampleIndex;
+    state.dimension = 0u;
+    return state;
+}
+
+// takes the next dimension pair, whatever the type, so that a pair consumed by a branch not taken does not shift
+// the following ones
+SAMPLER_FUNCTION vec2 sample2D(SAMPLER_INOUT(SamplerState) state) {
+    uint dimensionSeed = hashCombine(state.pixelSeed, state.dimension);
+    uint x;
+    uint y;
+    if (state.type == SAMPLER_SOBOL) {
+        // shuffling the index keeps every aligned block of 2^k indices together, so any 2^k consecutive frames from
+        // the first one are still a net. the pairs are padded: each has its own shuffle.
+        uint index = nestedUniformScramble(state.sampleIndex, dimensionSeed);
+        x = nestedUniformScramble(bitfieldReverse(index), hashCombine(dimensionSeed, 1u));
+        y = nestedUniformScramble(sobolSecond(index), hashCombine(dimensionSeed, 2u));
+    } else if (state.type == SAMPLER_RANK1) {
+        // the lattice of the pair is shifted alike in every pixel but for the dither, so that the error is made of
+        // high frequencies only. the generator is the R2 one, (1 / g, 1 / g^2) for the plastic number g.
+        uint shift = pcgHash(hashCombine(state.seed, state.dimension));
+        x = state.ditherX + shift + state.sampleIndex * 0xc13fa9a9u;
+        y = state.ditherY + pcgHash(shift) + state.sampleIndex * 0x91e10da5u;
+    } else {
+        x = pcgHash(hashCombine(dimensionSeed, state.sampleIndex));
+        y = pcgHash(x);
+    }
+    state.dimension++;
+    return vec2(fixedToFloat(x), fixedToFloat(y));
+}
+
+// the first dimension of the next pair
+SAMPLER_FUNCTION float sample1D(SAMPLER_INOUT(SamplerState) state) {
+    return sample2D(state).x;
+}
+
+#ifdef __cplusplus
+} // namespace vuren
+#endif
+
+#endif // SAMPLER_H
@@ -0,0 +1,214 @@
+#include "CpuDenoiser.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <future>
+#include <stdexcept>
+
+#if defined(VUREN_ENABLE_AVX2) && defined(_MSC_VER)
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+namespace vuren {
+
+#ifdef VUREN_ENABLE_AVX2
+
+namespace {
+
+// only CpuDenoiserAvx2.cpp is built with avx2, so the check itself must run on any x86 cpu
+bool cpuSupportsAvx2() {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return false;
+    // the os has to save the ymm registers as well: osxsave, then the sse and avx state bits of xcr0
+    __cpuid(info, 1);
+    if ((info[2] & (1 << 27)) == 0 || (_xgetbv(0) & 6) != 6)
+        return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+} // namespace
+
+#endif
+
+void CpuDenoiser::denoise(const CameraData &camera, uint32_t width, uint32_t height, const std::vector<float> &color,
+                          const std::vector<float> &worldPos, const std::vector<float> &worldNormal,
+                          ThreadPool &threadPool) {
+    size_t pixelCount = static_cast<size_t>(width) * height;
+    if (color.size() < pixelCount * 4 || worldPos.size() < pixelCount * 4 || worldNormal.size() < pixelCount * 4)
+        throw std::invalid_argument("denoiser input is smaller than width * height * 4!");
+    if (m_settings.iterations > kMaxIterations)
+        throw std::invalid_argument("too many denoiser iterations!");
+
+    m_width  = width;
+    m_height = height;
+    // the rows are filtered in groups of 8 pixels, the last group reaches into the right border
+    m_stride          = kPadding + ((width + 7) & ~7u) + kPadding;
+    size_t paddedSize = m_stride * (height + 2 * kPadding);
+
+    for (auto &plane: m_planes)
+        plane.assign(paddedSize, 0.0f);
+    for (auto &image: m_color)
+        for (auto &plane: image)
+            plane.assign(paddedSize, 0.0f);
+
+    // the world space size of a pixel at the view depth of a surface, as in the svgf pass
+    float footprintScale = 2.0f / (static_cast<float>(height) * std::abs(camera.proj[1][1]));
+
+    for (uint32_t y = 0; y < height; ++y) {
+        for (uint32_t x = 0; x < width; ++x) {
+            size_t src = (static_cast<size_t>(y) * width + x) * 4;
+            size_t dst = index(x, y);
+
+            for (uint32_t c = 0; c < 3; ++c)
+                m_color[0][c][dst] = color[src + c];
+
+            if (worldPos[src + 3] == 0.0f)
+                continue;
+
+            vec3 position(worldPos[src], worldPos[src + 1], worldPos[src + 2]);
+            float depth     = -(camera.view * vec4(position, 1.0f)).z;
+            float footprint = std::max(depth * footprintScale * m_settings.phiPosition, 1e-6f);
+
+            m_planes[ePosX][dst]          = position.x;
+            m_planes[ePosY][dst]          = position.y;
+            m_planes[ePosZ][dst]          = position.z;
+            m_planes[eNormalX][dst]       = worldNormal[src];
+            m_planes[eNormalY][dst]       = worldNormal[src + 1];
+            m_planes[eNormalZ][dst]       = worldNormal[src + 2];
+            m_planes[eValid][dst]         = 1.0f;
+            m_planes[ePositionScale][dst] = 1.0f / (footprint * footprint);
+        }
+    }
+
+    uint32_t current = 0;
+    for (uint32_t i = 0; i < m_settings.iterations; ++i) {
+        Iteration iteration;
+        for (uint32_t c = 0; c < 3; ++c) {
+            iteration.src[c] = m_color[current][c].data();
+            iteration.dst[c] = m_color[current ^ 1][c].data();
+        }
+        iteration.step = 1u << i;
+        // the color deviation halves with every iteration, as the coarser levels average out more noise
+        float colorScale      = m_settings.phiColor / static_cast<float>(1u << (2 * i));
+        iteration.invColor    = 1.0f / colorScale;
+        iteration.invPosition = 1.0f / static_cast<float>(iteration.step * iteration.step);
+
+        // every tile reads a 2 * step wide apron of the source, so the iterations need a barrier in between
+        std::vector<std::future<void>> tiles;
+        for (uint32_t y0 = 0; y0 < height; y0 += kTileHeight) {
+            for (uint32_t x0 = 0; x0 < width; x0 += kTileWidth) {
+                uint32_t x1 = std::min(x0 + kTileWidth, width);
+                uint32_t y1 = std::min(y0 + kTileHeight, height);
+                tiles.push_back(threadPool.submit(
+                    [this, &iteration, x0, y0, x1, y1] { filterTile(iteration, x0, y0, x1, y1); }));
+            }
+        }
+        for (auto &tile: tiles)
+            tile.get();
+
+        current ^= 1;
+    }
+
+    m_output.resize(pixelCount * 4);
+    for (uint32_t y = 0; y < height; ++y) {
+        for (uint32_t x = 0; x < width; ++x) {
+            size_t dst = (static_cast<size_t>(y) * width + x) * 4;
+            size_t src = index(x, y);
+            for (uint32_t c = 0; c < 3; ++c)
+                m_output[dst + c] = m_color[current][c][src];
+            m_output[dst + 3] = color[dst + 3];
+        }
+    }
+}
+
+void CpuDenoiser::filterTile(const Iteration &iteration, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1) const {
+#ifdef VUREN_ENABLE_AVX2
+    static const bool hasAvx2 = cpuSupportsAvx2();
+    if (hasAvx2) {
+        filterTileAvx2(iteration, x0, y0, x1, y1);
+        return;
+    }
+#endif
+
+    const float *posX       = m_planes[ePosX].data();
+    const float *posY       = m_planes[ePosY].data();
+    const float *posZ       = m_planes[ePosZ].data();
+    const float *normalX    = m_planes[eNormalX].data();
+    const float *normalY    = m_planes[eNormalY].data();
+    const float *normalZ    = m_planes[eNormalZ].data();
+    const float *valid      = m_planes[eValid].data();
+    const float *posScale   = m_planes[ePositionScale].data();
+    const float *const *src = iteration.src;
+    float *const *dst       = iteration.dst;
+
+    int64_t step      = iteration.step;
+    int64_t rowStride = static_cast<int64_t>(m_stride) * step;
+
+    for (uint32_t y = y0; y < y1; ++y) {
+        for (uint32_t x = x0; x < x1; ++x) {
+            size_t p = index(x, y);
+            if (valid[p] == 0.0f) {
+                for (uint32_t c = 0; c < 3; ++c)
+                    dst[c][p] = src[c][p];
+                continue;
+            }
+
+            float positionScale = posScale[p] * iteration.invPosition;
+            float sum[3]        = { 0.0f, 0.0f, 0.0f };
+            float weightSum     = 0.0f;
+
+            for (int dy = -2; dy <= 2; ++dy) {
+                for (int dx = -2; dx <= 2; ++dx) {
+                    size_t q = p + dy * rowStride + dx * step;
+                    if (valid[q] == 0.0f)
+                        continue;
+
+                    float colorDist = 0.0f;
+                    for (uint32_t c = 0; c < 3; ++c)
+                        colorDist += (src[c][q] - src[c][p]) * (src[c][q] - src[c][p]);
+                    float cosNormal = normalX[p] * normalX[q] + normalY[p] * normalY[q] + normalZ[p] * normalZ[q];
+                    float plane     = normalX[p] * (posX[q] - posX[p]) + normalY[p] * (posY[q] - posY[p]) +
+                                      normalZ[p] * (posZ[q] - posZ[p]);
+
+                    float exponent = colorDist * iteration.invColor +
+                                     std::max(1.0f - cosNormal, 0.0f) * m_settings.phiNormal +
+                                     plane * plane * positionScale;
+                    float w = std::exp(-exponent) * kKernel[std::abs(dx)] * kKernel[std::abs(dy)];
+
+                    for (uint32_t c = 0; c < 3; ++c)
+                        sum[c] += w * src[c][q];
+                    weightSum += w;
+                }
+            }
+
+            for (uint32_t c = 0; c < 3; ++c)
+                dst[c][p] = sum[c] / weightSum;
+        }
+    }
+}
+
+double computeRmse(uint32_t width, uint32_t height, const std::vector<float> &rgba,
+                   const std::vector<float> &reference) {
+    size_t pixelCount = static_cast<size_t>(width) * height;
+    if (rgba.size() < pixelCount * 4 || reference.size() < pixelCount * 4)
+        throw std::invalid_argument("image buffer is smaller than width * height * 4!");
+
+    double sum = 0.0;
+    for (size_t i = 0; i < pixelCount; ++i) {
+        for (uint32_t c = 0; c < 3; ++c) {
+            double d = static_cast<double>(rgba[i * 4 + c]) - static_cast<double>(reference[i * 4 + c]);
+            sum += d * d;
+        }
+    }
+    return std::sqrt(sum / static_cast<double>(pixelCount * 3));
+}
+
+} // namespace vuren
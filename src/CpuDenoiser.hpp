@@ -0,0 +1,97 @@
+#ifndef CPU_DENOISER_HPP
+#define CPU_DENOISER_HPP
+
+#include "Common.hpp"
+#include "ThreadPool.hpp"
+
+#include <vector>
+
+namespace vuren {
+
+// edge-avoiding a-trous wavelet filter (Dammertz et al. 2010) for the cpu renderer output.
+// every iteration is a 5x5 B3 spline kernel with holes, weighted by the color, normal and position distance to the
+// center pixel, and the step size doubles each time. the images are split into planes of one channel each with a
+// border of invalid pixels, so eight neighboring pixels are filtered at once (avx2) without any bounds checks.
+class CpuDenoiser {
+public:
+    static constexpr uint32_t kMaxIterations = 5;
+
+    struct Settings {
+        uint32_t iterations{ kMaxIterations };
+        // scale of the squared rgb distance (a variance), quartered every iteration
+        float phiColor{ 0.6f };
+        // 1 - cos of the normal angle scale
+        float phiNormal{ 64.0f };
+        // distance to the tangent plane of the center, in pixel footprints
+        float phiPosition{ 1.0f };
+    };
+
+    CpuDenoiser() {}
+    ~CpuDenoiser() {}
+
+    Settings &getSettings() { return m_settings; }
+
+    // color, worldPos and worldNormal are RGBA32 float images, top row first, as returned by the CpuRenderer.
+    // pixels with worldPos.w == 0 (background) are kept as they are and never used as neighbors.
+    void denoise(const CameraData &camera, uint32_t width, uint32_t height, const std::vector<float> &color,
+                 const std::vector<float> &worldPos, const std::vector<float> &worldNormal, ThreadPool &threadPool);
+
+    // RGBA32 float image, top row first
+    const std::vector<float> &getOutput() const { return m_output; }
+
+private:
+    // the border holds the widest kernel: 2 taps of the last step size
+    static constexpr uint32_t kPadding = 2u << (kMaxIterations - 1);
+
+    // pixels filtered by one job, 64 floats per row of a plane stay within a few cache lines
+    static constexpr uint32_t kTileWidth  = 64;
+    static constexpr uint32_t kTileHeight = 32;
+
+    enum Plane : uint32_t {
+        ePosX,
+        ePosY,
+        ePosZ,
+        eNormalX,
+        eNormalY,
+        eNormalZ,
+        eValid,         // 1 for a surface, 0 for the background and the border
+        ePositionScale, // 1 / (phiPosition * pixel footprint)^2
+        ePlaneCount
+    };
+
+    struct Iteration {
+        const float *src[3]; // rgb planes
+        float *dst[3];
+        uint32_t step;
+        float invColor;    // 1 / color scale of this iteration
+        float invPosition; // 1 / step^2
+    };
+
+    // the B3 spline kernel
+    static constexpr float kKernel[3] = { 3.0f / 8.0f, 1.0f / 4.0f, 1.0f / 16.0f };
+
+    size_t index(uint32_t x, uint32_t y) const { return (y + kPadding) * m_stride + x + kPadding; }
+    // picks the avx2 path at runtime when the cpu has it
+    void filterTile(const Iteration &iteration, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1) const;
+    // CpuDenoiserAvx2.cpp, the only file built with avx2
+    void filterTileAvx2(const Iteration &iteration, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1) const;
+
+    Settings m_settings;
+
+    uint32_t m_width{ 0 };
+    uint32_t m_height{ 0 };
+    size_t m_stride{ 0 };
+
+    std::vector<float> m_planes[ePlaneCount];
+    std::vector<float> m_color[2][3]; // ping-pong rgb planes
+
+    std::vector<float> m_output;
+};
+
+// root mean squared error of the rgb channels, to compare a render against a converged reference
+double computeRmse(uint32_t width, uint32_t height, const std::vector<float> &rgba,
+                   const std::vector<float> &reference);
+
+} // namespace vuren
+
+#endif // CPU_DENOISER_HPP
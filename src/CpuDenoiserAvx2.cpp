@@ -0,0 +1,133 @@
+#include "CpuDenoiser.hpp"
+
+#ifdef VUREN_ENABLE_AVX2
+
+#include <cmath>
+#include <cstdlib>
+
+#include <immintrin.h>
+
+// this file alone is compiled with avx2 (see CMakeLists.txt), CpuDenoiser::filterTile only calls into it when the
+// cpu supports it. inline functions of shared headers are avoided here, the linker could otherwise keep their avx2
+// copies for the other files as well.
+
+namespace vuren {
+
+namespace {
+
+// exp(x) for x <= 0: 2^(x * log2(e)) split into an exponent and a degree 5 polynomial of the fraction.
+// the relative error is below 1e-6, far less than the filter can tell apart.
+__m256 exp256(__m256 x) {
+    x               = _mm256_max_ps(x, _mm256_set1_ps(-87.0f));
+    __m256 t        = _mm256_mul_ps(x, _mm256_set1_ps(1.44269504f));
+    __m256 integer  = _mm256_floor_ps(t);
+    __m256 fraction = _mm256_sub_ps(t, integer);
+
+    __m256 p = _mm256_set1_ps(1.33335581e-3f);
+    p        = _mm256_add_ps(_mm256_mul_ps(p, fraction), _mm256_set1_ps(9.61812911e-3f));
+    p        = _mm256_add_ps(_mm256_mul_ps(p, fraction), _mm256_set1_ps(5.55041087e-2f));
+    p        = _mm256_add_ps(_mm256_mul_ps(p, fraction), _mm256_set1_ps(2.40226507e-1f));
+    p        = _mm256_add_ps(_mm256_mul_ps(p, fraction), _mm256_set1_ps(6.93147182e-1f));
+    p        = _mm256_add_ps(_mm256_mul_ps(p, fraction), _mm256_set1_ps(1.0f));
+
+    __m256i exponent = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(integer), _mm256_set1_epi32(127)), 23);
+    return _mm256_mul_ps(p, _mm256_castsi256_ps(exponent));
+}
+
+} // namespace
+
+void CpuDenoiser::filterTileAvx2(const Iteration &iteration, uint32_t x0, uint32_t y0, uint32_t x1,
+                                 uint32_t y1) const {
+    const float *posX       = m_planes[ePosX].data();
+    const float *posY       = m_planes[ePosY].data();
+    const float *posZ       = m_planes[ePosZ].data();
+    const float *normalX    = m_planes[eNormalX].data();
+    const float *normalY    = m_planes[eNormalY].data();
+    const float *normalZ    = m_planes[eNormalZ].data();
+    const float *valid      = m_planes[eValid].data();
+    const float *posScale   = m_planes[ePositionScale].data();
+    const float *const *src = iteration.src;
+    float *const *dst       = iteration.dst;
+
+    int64_t step      = iteration.step;
+    int64_t rowStride = static_cast<int64_t>(m_stride) * step;
+
+    const __m256 zero        = _mm256_setzero_ps();
+    const __m256 one         = _mm256_set1_ps(1.0f);
+    const __m256 invColor    = _mm256_set1_ps(iteration.invColor);
+    const __m256 phiNormal   = _mm256_set1_ps(m_settings.phiNormal);
+    const __m256 invPosition = _mm256_set1_ps(iteration.invPosition);
+
+    for (uint32_t y = y0; y < y1; ++y) {
+        // the last group of a row may cover a few pixels of the right border, which are never read back as valid
+        for (uint32_t x = x0; x < x1; x += 8) {
+            size_t p = (y + kPadding) * m_stride + x + kPadding;
+
+            __m256 r             = _mm256_loadu_ps(src[0] + p);
+            __m256 g             = _mm256_loadu_ps(src[1] + p);
+            __m256 b             = _mm256_loadu_ps(src[2] + p);
+            __m256 px            = _mm256_loadu_ps(posX + p);
+            __m256 py            = _mm256_loadu_ps(posY + p);
+            __m256 pz            = _mm256_loadu_ps(posZ + p);
+            __m256 nx            = _mm256_loadu_ps(normalX + p);
+            __m256 ny            = _mm256_loadu_ps(normalY + p);
+            __m256 nz            = _mm256_loadu_ps(normalZ + p);
+            __m256 positionScale = _mm256_mul_ps(_mm256_loadu_ps(posScale + p), invPosition);
+
+            __m256 sumR      = zero;
+            __m256 sumG      = zero;
+            __m256 sumB      = zero;
+            __m256 weightSum = zero;
+
+            for (int dy = -2; dy <= 2; ++dy) {
+                for (int dx = -2; dx <= 2; ++dx) {
+                    size_t q = p + dy * rowStride + dx * step;
+
+                    __m256 qr = _mm256_loadu_ps(src[0] + q);
+                    __m256 qg = _mm256_loadu_ps(src[1] + q);
+                    __m256 qb = _mm256_loadu_ps(src[2] + q);
+
+                    __m256 d         = _mm256_sub_ps(qr, r);
+                    __m256 colorDist = _mm256_mul_ps(d, d);
+                    d                = _mm256_sub_ps(qg, g);
+                    colorDist        = _mm256_add_ps(colorDist, _mm256_mul_ps(d, d));
+                    d                = _mm256_sub_ps(qb, b);
+                    colorDist        = _mm256_add_ps(colorDist, _mm256_mul_ps(d, d));
+
+                    __m256 cosNormal  = _mm256_mul_ps(nx, _mm256_loadu_ps(normalX + q));
+                    cosNormal         = _mm256_add_ps(cosNormal, _mm256_mul_ps(ny, _mm256_loadu_ps(normalY + q)));
+                    cosNormal         = _mm256_add_ps(cosNormal, _mm256_mul_ps(nz, _mm256_loadu_ps(normalZ + q)));
+                    __m256 normalDist = _mm256_max_ps(_mm256_sub_ps(one, cosNormal), zero);
+
+                    __m256 plane = _mm256_mul_ps(nx, _mm256_sub_ps(_mm256_loadu_ps(posX + q), px));
+                    plane = _mm256_add_ps(plane, _mm256_mul_ps(ny, _mm256_sub_ps(_mm256_loadu_ps(posY + q), py)));
+                    plane = _mm256_add_ps(plane, _mm256_mul_ps(nz, _mm256_sub_ps(_mm256_loadu_ps(posZ + q), pz)));
+
+                    // the three gaussian edge-stopping weights share one exp
+                    __m256 exponent = _mm256_mul_ps(colorDist, invColor);
+                    exponent        = _mm256_add_ps(exponent, _mm256_mul_ps(normalDist, phiNormal));
+                    exponent = _mm256_add_ps(exponent, _mm256_mul_ps(_mm256_mul_ps(plane, plane), positionScale));
+
+                    __m256 w = _mm256_mul_ps(exp256(_mm256_sub_ps(zero, exponent)), _mm256_loadu_ps(valid + q));
+                    w        = _mm256_mul_ps(w, _mm256_set1_ps(kKernel[std::abs(dx)] * kKernel[std::abs(dy)]));
+
+                    sumR      = _mm256_add_ps(sumR, _mm256_mul_ps(w, qr));
+                    sumG      = _mm256_add_ps(sumG, _mm256_mul_ps(w, qg));
+                    sumB      = _mm256_add_ps(sumB, _mm256_mul_ps(w, qb));
+                    weightSum = _mm256_add_ps(weightSum, w);
+                }
+            }
+
+            // the background keeps its color, a surface always has the weight of its own center tap
+            __m256 surface   = _mm256_cmp_ps(_mm256_loadu_ps(valid + p), zero, _CMP_NEQ_OQ);
+            __m256 invWeight = _mm256_div_ps(one, _mm256_blendv_ps(one, weightSum, surface));
+            _mm256_storeu_ps(dst[0] + p, _mm256_blendv_ps(r, _mm256_mul_ps(sumR, invWeight), surface));
+            _mm256_storeu_ps(dst[1] + p, _mm256_blendv_ps(g, _mm256_mul_ps(sumG, invWeight), surface));
+            _mm256_storeu_ps(dst[2] + p, _mm256_blendv_ps(b, _mm256_mul_ps(sumB, invWeight), surface));
+        }
+    }
+}
+
+} // namespace vuren
+
+#endif // VUREN_ENABLE_AVX2
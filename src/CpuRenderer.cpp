@@ -0,0 +1,207 @@
+#include "CpuRenderer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <future>
+
+namespace vuren {
+
+namespace {
+
+// host versions of CommonShaders/Random.h, the samples themselves come from the shared CommonShaders/Sampler.h
+
+const float kPi    = 3.1415926535897932384626433832795f;
+const float kInvPi = 1.0f / kPi;
+
+// rays traced by the current thread, summed per row so the workers do not share a counter
+thread_local uint64_t tRayCount = 0;
+
+vec3 getCosHemisphereSample(const vec2 &uv, const vec3 &normal) {
+    vec3 b1 = normal.x > 0.9f ? vec3(0, 1, 0) : vec3(1, 0, 0);
+    b1 -= normal * glm::dot(b1, normal);
+    b1 = glm::normalize(b1);
+
+    vec3 b2 = glm::normalize(glm::cross(normal, b1));
+
+    float r     = std::sqrt(uv.x);
+    float theta = 2.0f * kPi * uv.y;
+    vec3 v      = vec3(r * std::cos(theta), r * std::sin(theta), std::sqrt(std::max(0.0f, 1.0f - uv.x * uv.x)));
+    return glm::normalize(b1 * v.x + b2 * v.y + normal * v.z);
+}
+
+// the light's contribution to a surface, without the throughput and visibility (pt.rgen)
+vec3 evaluateLight(const Light &light, const vec3 &position, const vec3 &normal) {
+    vec3 ldir    = light.pos - position;
+    float ldist2 = glm::dot(ldir, ldir);
+    float NdotL  = glm::clamp(glm::dot(normal, ldir / std::sqrt(ldist2)), 0.0f, 1.0f);
+    return light.intensity * NdotL / ldist2;
+}
+
+} // namespace
+
+uint32_t CpuRenderer::addMesh(const std::vector<Vertex> &vertices, const std::vector<uint32_t> &indices,
+                              uint32_t materialId) {
+    m_meshes.push_back({ vertices, indices, materialId });
+    return static_cast<uint32_t>(m_meshes.size() - 1);
+}
+
+void CpuRenderer::build(const std::vector<ObjectInstance> &instances, ThreadPool &threadPool) {
+    std::vector<vec3> positions;
+    m_shading.clear();
+
+    for (auto &instance: instances) {
+        const Mesh &mesh = m_meshes.at(instance.objectId);
+        for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+            TriangleShading shading;
+            shading.materialId = mesh.materialId;
+            for (int k = 0; k < 3; ++k) {
+                const Vertex &vertex = mesh.vertices[mesh.indices[i + k]];
+                positions.push_back(vec3(instance.world * vec4(vertex.pos, 1.0f)));
+                shading.normals[k] = vec3(instance.invTransposeWorld * vec4(vertex.normal, 0.0f));
+            }
+            m_shading.push_back(shading);
+        }
+    }
+
+    m_bvh.build(positions, m_bvhBuilder, m_bvhLayout, &threadPool);
+}
+
+CpuRenderer::SurfacePoint CpuRenderer::trace(const Ray &ray) const {
+    SurfacePoint point{ .worldPos = vec4(0.0f), .worldNormal = vec3(0.0f), .diffuse = vec3(0.0f) };
+
+    RayHit hit;
+    ++tRayCount;
+    if (!m_bvh.intersect(ray, hit))
+        return point;
+
+    const TriangleShading &shading = m_shading[hit.triangleIndex];
+    vec3 barycentrics = vec3(1.0f - hit.barycentrics.x - hit.barycentrics.y, hit.barycentrics.x, hit.barycentrics.y);
+
+    point.worldPos    = vec4(ray.origin + ray.direction * hit.t, 1.0f);
+    point.worldNormal = glm::normalize(shading.normals[0] * barycentrics.x + shading.normals[1] * barycentrics.y +
+                                       shading.normals[2] * barycentrics.z);
+    point.diffuse     = m_materials.at(shading.materialId).diffuse;
+    return point;
+}
+
+vec3 CpuRenderer::sampleDirectLight(const vec3 &position, const vec3 &normal, SamplerState &samples) const {
+    const float tMin = 0.00001f;
+
+    // the light bvh walk or the alias table lookup of pt.rgen
+    uint32_t lightIndex;
+    float pmf;
+    if (m_directLighting == PT_DIRECT_LIGHTING_LIGHT_BVH) {
+        if (!m_lightBvh.sample(position, normal, sample1D(samples), lightIndex, pmf))
+            return vec3(0.0f);
+    } else {
+        uint32_t lightCount = static_cast<uint32_t>(m_lightAliasTable.size());
+        float u             = sample1D(samples) * static_cast<float>(lightCount);
+        uint32_t bucket     = std::min(static_cast<uint32_t>(u), lightCount - 1);
+        const auto &entry   = m_lightAliasTable[bucket];
+        lightIndex          = u - static_cast<float>(bucket) < entry.threshold ? bucket : entry.alias;
+        pmf                 = m_lightAliasTable[lightIndex].pmf;
+    }
+
+    const Light &light = m_lights[lightIndex];
+    vec3 contribution  = evaluateLight(light, position, normal);
+    if (contribution == vec3(0.0f))
+        return vec3(0.0f);
+
+    vec3 ldir   = light.pos - position;
+    float ldist = glm::length(ldir);
+    ++tRayCount;
+    if (m_bvh.occluded({ .origin = position, .direction = ldir / ldist, .tMin = tMin, .tMax = ldist }))
+        return vec3(0.0f);
+    return contribution / pmf;
+}
+
+uint64_t CpuRenderer::renderRow(const CameraData &camera, uint32_t y, uint32_t width, uint32_t height, uint32_t spp) {
+    const float tMin = 0.00001f; // bias to avoid self-intersection
+    const float tMax = 10000.0f;
+
+    tRayCount = 0;
+
+    for (uint32_t x = 0; x < width; ++x) {
+        size_t pixel = (static_cast<size_t>(y) * width + x) * 4;
+
+        // primary hit, what the g-buffer pass stores for this pixel
+        vec2 inUV   = (vec2(x, y) + vec2(0.5f)) / vec2(width, height);
+        vec2 ndc    = inUV * 2.0f - 1.0f;
+        vec4 origin = camera.invView * vec4(0, 0, 0, 1);
+        vec4 target = camera.invProj * vec4(ndc.x, ndc.y, 1, 1);
+        vec4 dir    = camera.invView * vec4(glm::normalize(vec3(target)), 0);
+
+        SurfacePoint primary = trace({ .origin = vec3(origin), .direction = vec3(dir), .tMin = 0.0f, .tMax = tMax });
+
+        std::memcpy(&m_worldPos[pixel], &primary.worldPos, sizeof(vec4));
+        vec4 normal = vec4(primary.worldNormal, 1.0f);
+        std::memcpy(&m_worldNormal[pixel], &normal, sizeof(vec4));
+
+        vec3 sum(0.0f);
+        for (uint32_t s = 0; s < spp; ++s) {
+            // the path tracing pass's sample index is its frame count - 1
+            SamplerState samples = initSampler(m_sampler, x, y, s, 0u);
+
+            vec3 radiance(0.0f);
+            vec3 throughput(1.0f);
+
+            vec4 pos      = primary.worldPos;
+            vec3 n        = primary.worldNormal;
+            vec2 uv       = sample2D(samples);
+            vec3 worldDir = getCosHemisphereSample(uv, n);
+
+            for (int depth = 1; depth <= m_maxDepth; ++depth) {
+                if (depth > 1) {
+                    Ray ray          = { .origin = vec3(pos), .direction = worldDir, .tMin = tMin, .tMax = tMax };
+                    SurfacePoint hit = trace(ray);
+                    pos              = hit.worldPos;
+                    n                = hit.worldNormal;
+                    throughput *= hit.diffuse * kInvPi;
+                }
+
+                if (pos.w == 0.0f)
+                    break;
+
+                if (m_directLighting == PT_DIRECT_LIGHTING_UNSHADOWED) {
+                    for (auto &light: m_lights)
+                        radiance += throughput * evaluateLight(light, vec3(pos), n);
+                } else {
+                    radiance += throughput * sampleDirectLight(vec3(pos), n, samples);
+                }
+
+                uv       = sample2D(samples);
+                worldDir = getCosHemisphereSample(uv, n);
+            }
+
+            sum += radiance;
+        }
+
+        vec4 color = vec4(sum / static_cast<float>(spp), 0.0f);
+        std::memcpy(&m_output[pixel], &color, sizeof(vec4));
+    }
+
+    return tRayCount;
+}
+
+void CpuRenderer::render(const CameraData &camera, uint32_t width, uint32_t height, uint32_t spp,
+                         ThreadPool &threadPool) {
+    size_t size = static_cast<size_t>(width) * height * 4;
+    m_output.assign(size, 0.0f);
+    m_worldPos.assign(size, 0.0f);
+    m_worldNormal.assign(size, 0.0f);
+
+    // one job per scanline keeps the load balanced without any tiling logic
+    std::vector<std::future<uint64_t>> rows;
+    rows.reserve(height);
+    for (uint32_t y = 0; y < height; ++y)
+        rows.push_back(threadPool.submit([this, &camera, y, width, height, spp] {
+            return renderRow(camera, y, width, height, spp);
+        }));
+
+    m_rayCount = 0;
+    for (auto &row: rows)
+        m_rayCount += row.get();
+}
+
+} // namespace vuren
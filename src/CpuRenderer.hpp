@@ -0,0 +1,112 @@
+#ifndef CPU_RENDERER_HPP
+#define CPU_RENDERER_HPP
+
+#include "Bvh.hpp"
+#include "Common.hpp"
+#include "LightBvh.hpp"
+#include "Scene.hpp"
+#include "ThreadPool.hpp"
+#include "CommonShaders/Sampler.h"
+#include "RenderPasses/PathTracingPass/PtCommon.h"
+
+#include <vector>
+
+namespace vuren {
+
+// reference path tracer running on the host.
+// it mirrors the rasterized g-buffer pass + path tracing pass + accumulation pass chain
+// (same camera rays, light, brdf and random number sequence), so headless renders still work
+// on devices without ray tracing support, e.g. software vulkan implementations.
+class CpuRenderer {
+public:
+    CpuRenderer() {}
+    ~CpuRenderer() {}
+
+    // returns the object id used by ObjectInstance::objectId
+    uint32_t addMesh(const std::vector<Vertex> &vertices, const std::vector<uint32_t> &indices, uint32_t materialId);
+
+    void setMaterials(const std::vector<Material> &materials) { m_materials = materials; }
+
+    // at least one light, as in the bindless table
+    void setLights(const std::vector<Light> &lights) {
+        m_lights          = lights;
+        m_lightAliasTable = buildLightAliasTable(lights);
+        m_lightBvh.build(lights);
+    }
+
+    // PT_DIRECT_LIGHTING_UNSHADOWED, PT_DIRECT_LIGHTING_NEE or PT_DIRECT_LIGHTING_LIGHT_BVH
+    void setDirectLighting(uint32_t directLighting) { m_directLighting = directLighting; }
+
+    // path vertices, as in the path tracing pass
+    void setMaxDepth(uint32_t maxDepth) { m_maxDepth = static_cast<int>(maxDepth); }
+
+    // SAMPLER_INDEPENDENT, SAMPLER_SOBOL or SAMPLER_RANK1, the sample index is the accumulated sample
+    void setSampler(uint32_t sampler) { m_sampler = sampler; }
+
+    // Bvh::eBinned or Bvh::eSpatialSplits
+    void setBvhBuilder(Bvh::Builder builder) { m_bvhBuilder = builder; }
+    // Bvh::eFloatNodes or Bvh::eQuantizedNodes
+    void setBvhLayout(Bvh::Layout layout) { m_bvhLayout = layout; }
+
+    // flatten every instance into world space triangles and build the bvh, binning its large nodes on the pool
+    void build(const std::vector<ObjectInstance> &instances, ThreadPool &threadPool);
+
+    const Bvh::BuildStats &getBvhStats() const { return m_bvh.getBuildStats(); }
+
+    // accumulate spp frames of one path per pixel each
+    void render(const CameraData &camera, uint32_t width, uint32_t height, uint32_t spp, ThreadPool &threadPool);
+
+    // closest hit and shadow rays traced by the last render
+    uint64_t getRayCount() const { return m_rayCount; }
+
+    // RGBA32 float images, top row first (the same layout as a texture readback)
+    const std::vector<float> &getOutput() const { return m_output; }
+    const std::vector<float> &getWorldPos() const { return m_worldPos; }
+    const std::vector<float> &getWorldNormal() const { return m_worldNormal; }
+
+private:
+    struct Mesh {
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        uint32_t materialId;
+    };
+
+    // per-triangle shading data, indexed like the bvh input
+    struct TriangleShading {
+        vec3 normals[3]; // world space vertex normals
+        uint32_t materialId;
+    };
+
+    struct SurfacePoint {
+        vec4 worldPos; // w == 0 on a miss, as in the g-buffer
+        vec3 worldNormal;
+        vec3 diffuse;
+    };
+
+    SurfacePoint trace(const Ray &ray) const;
+    vec3 sampleDirectLight(const vec3 &position, const vec3 &normal, SamplerState &samples) const;
+    // returns the rays traced for the row
+    uint64_t renderRow(const CameraData &camera, uint32_t y, uint32_t width, uint32_t height, uint32_t spp);
+
+    std::vector<Mesh> m_meshes;
+    std::vector<Material> m_materials;
+    std::vector<Light> m_lights;
+    std::vector<LightAliasEntry> m_lightAliasTable;
+    LightBvh m_lightBvh;
+    uint32_t m_directLighting{ PT_DIRECT_LIGHTING_NEE };
+    int m_maxDepth{ 4 };
+    uint32_t m_sampler{ SAMPLER_SOBOL };
+    std::vector<TriangleShading> m_shading;
+    Bvh::Builder m_bvhBuilder{ Bvh::eBinned };
+    Bvh::Layout m_bvhLayout{ Bvh::eFloatNodes };
+    Bvh m_bvh;
+    uint64_t m_rayCount{ 0 };
+
+    std::vector<float> m_output;
+    std::vector<float> m_worldPos;
+    std::vector<float> m_worldNormal;
+};
+
+} // namespace vuren
+
+#endif // CPU_RENDERER_HPP
@@ -0,0 +1,182 @@
+#include "DescriptorCache.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <iostream>
+
+namespace vuren {
+
+namespace {
+
+// descriptors per set a new pool is sized for, on top of what the set that triggered it needs
+const std::vector<vk::DescriptorPoolSize> kDescriptorsPerSet = {
+    { vk::DescriptorType::eUniformBuffer, 2 },        { vk::DescriptorType::eStorageBuffer, 4 },
+    { vk::DescriptorType::eCombinedImageSampler, 8 }, { vk::DescriptorType::eStorageImage, 2 },
+    { vk::DescriptorType::eAccelerationStructureKHR, 1 }
+};
+
+void addPoolSize(std::vector<vk::DescriptorPoolSize> &poolSizes, vk::DescriptorType type, uint32_t count) {
+    if (count == 0)
+        return;
+    auto it = std::find_if(poolSizes.begin(), poolSizes.end(),
+                           [&](const vk::DescriptorPoolSize &size) { return size.type == type; });
+    if (it == poolSizes.end())
+        poolSizes.push_back({ type, count });
+    else
+        it->descriptorCount += count;
+}
+
+} // namespace
+
+void DescriptorCache::init(VulkanContext *pContext) {
+    m_pContext = pContext;
+}
+
+void DescriptorCache::cleanup() {
+    uint32_t layoutCount = 0;
+    for (auto &[hash, entries]: m_layouts) {
+        for (auto &entry: entries)
+            m_pContext->m_device.destroyDescriptorSetLayout(entry.layout, nullptr);
+        layoutCount += static_cast<uint32_t>(entries.size());
+    }
+    for (auto &pool: m_pools)
+        m_pContext->m_device.destroyDescriptorPool(pool, nullptr);
+
+    if (m_layoutRequests > 0) {
+        std::cout << "descriptor cache: " << layoutCount << " layouts for " << m_layoutRequests << " requests, "
+                  << m_allocatedSets << " sets in " << m_pools.size() << " pools, " << m_reusedSets
+                  << " released sets reused" << std::endl;
+    }
+
+    m_layouts.clear();
+    m_pools.clear();
+    m_layoutRequests  = 0;
+    m_allocatedSets   = 0;
+    m_reusedSets      = 0;
+    m_nextSetsPerPool = kInitialSetsPerPool;
+}
+
+size_t DescriptorCache::hashBindings(const std::vector<vk::DescriptorSetLayoutBinding> &bindings) {
+    size_t seed  = bindings.size();
+    auto combine = [&](uint32_t value) {
+        seed ^= std::hash<uint32_t>()(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    };
+    for (auto &binding: bindings) {
+        combine(binding.binding);
+        combine(static_cast<uint32_t>(binding.descriptorType));
+        combine(binding.descriptorCount);
+        combine(static_cast<uint32_t>(binding.stageFlags));
+    }
+    return seed;
+}
+
+bool DescriptorCache::equalBindings(const std::vector<vk::DescriptorSetLayoutBinding> &a,
+                                    const std::vector<vk::DescriptorSetLayoutBinding> &b) {
+    return std::equal(a.begin(), a.end(), b.begin(), b.end(),
+                      [](const vk::DescriptorSetLayoutBinding &x, const vk::DescriptorSetLayoutBinding &y) {
+                          return x.binding == y.binding && x.descriptorType == y.descriptorType &&
+                                 x.descriptorCount == y.descriptorCount && x.stageFlags == y.stageFlags;
+                      });
+}
+
+vk::DescriptorSetLayout DescriptorCache::getLayout(const std::vector<vk::DescriptorSetLayoutBinding> &bindings) {
+    m_layoutRequests++;
+
+    // bindings are compared in order, so sort them to make the order they were declared in irrelevant
+    std::vector<vk::DescriptorSetLayoutBinding> sorted = bindings;
+    std::sort(sorted.begin(), sorted.end(),
+              [](const vk::DescriptorSetLayoutBinding &a, const vk::DescriptorSetLayoutBinding &b) {
+                  return a.binding < b.binding;
+              });
+
+    auto &entries = m_layouts[hashBindings(sorted)];
+    for (auto &entry: entries) {
+        if (equalBindings(entry.bindings, sorted))
+            return entry.layout;
+    }
+
+    LayoutEntry entry{ .bindings = sorted };
+    vk::DescriptorSetLayoutCreateInfo layoutInfo{ .bindingCount = static_cast<uint32_t>(sorted.size()),
+                                                  .pBindings    = sorted.data() };
+    if (m_pContext->m_device.createDescriptorSetLayout(&layoutInfo, nullptr, &entry.layout) !=
+        vk::Result::eSuccess) {
+        throw std::runtime_error("failed to create a descriptor set layout!");
+    }
+
+    for (auto &binding: sorted)
+        addPoolSize(entry.poolSizes, binding.descriptorType, binding.descriptorCount);
+
+    entries.push_back(entry);
+    return entry.layout;
+}
+
+DescriptorCache::LayoutEntry &DescriptorCache::findEntry(vk::DescriptorSetLayout layout) {
+    for (auto &[hash, entries]: m_layouts) {
+        for (auto &entry: entries) {
+            if (entry.layout == layout)
+                return entry;
+        }
+    }
+    throw std::runtime_error("the descriptor set layout does not come from the descriptor cache!");
+}
+
+void DescriptorCache::addPool(const std::vector<vk::DescriptorPoolSize> &requiredSizes) {
+    uint32_t setCount = m_nextSetsPerPool;
+    m_nextSetsPerPool *= 2;
+
+    std::vector<vk::DescriptorPoolSize> poolSizes;
+    for (auto &size: kDescriptorsPerSet)
+        addPoolSize(poolSizes, size.type, size.descriptorCount * setCount);
+    for (auto &size: requiredSizes)
+        addPoolSize(poolSizes, size.type, size.descriptorCount);
+
+    vk::DescriptorPoolCreateInfo poolInfo{ .maxSets       = setCount,
+                                           .poolSizeCount = static_cast<uint32_t>(poolSizes.size()),
+                                           .pPoolSizes    = poolSizes.data() };
+
+    vk::DescriptorPool pool;
+    if (m_pContext->m_device.createDescriptorPool(&poolInfo, nullptr, &pool) != vk::Result::eSuccess) {
+        throw std::runtime_error("failed to create a descriptor pool!");
+    }
+    m_pools.push_back(pool);
+}
+
+vk::DescriptorSet DescriptorCache::allocate(vk::DescriptorSetLayout layout) {
+    LayoutEntry &entry = findEntry(layout);
+    if (!entry.freeSets.empty()) {
+        vk::DescriptorSet descriptorSet = entry.freeSets.back();
+        entry.freeSets.pop_back();
+        m_reusedSets++;
+        return descriptorSet;
+    }
+
+    if (m_pools.empty())
+        addPool(entry.poolSizes);
+
+    vk::DescriptorSetAllocateInfo allocInfo{ .descriptorPool     = m_pools.back(),
+                                             .descriptorSetCount = 1,
+                                             .pSetLayouts        = &layout };
+
+    vk::DescriptorSet descriptorSet;
+    vk::Result result = m_pContext->m_device.allocateDescriptorSets(&allocInfo, &descriptorSet);
+
+    // the current pool is full, continue with a larger one
+    if (result == vk::Result::eErrorOutOfPoolMemory || result == vk::Result::eErrorFragmentedPool) {
+        addPool(entry.poolSizes);
+        allocInfo.descriptorPool = m_pools.back();
+        result                   = m_pContext->m_device.allocateDescriptorSets(&allocInfo, &descriptorSet);
+    }
+
+    if (result != vk::Result::eSuccess) {
+        throw std::runtime_error("failed to allocate a descriptor set!");
+    }
+
+    m_allocatedSets++;
+    return descriptorSet;
+}
+
+void DescriptorCache::release(vk::DescriptorSet set, vk::DescriptorSetLayout layout) {
+    findEntry(layout).freeSets.push_back(set);
+}
+
+} // namespace vuren
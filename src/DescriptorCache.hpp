@@ -0,0 +1,72 @@
+#ifndef DESCRIPTOR_CACHE_HPP
+#define DESCRIPTOR_CACHE_HPP
+
+#define VULKAN_HPP_NO_CONSTRUCTORS
+#define VULKAN_HPP_DISPATCH_LOADER_DYNAMIC 1
+#include <vulkan/vulkan.hpp>
+
+#include "Common.hpp"
+#include "VulkanContext.hpp"
+
+#include <unordered_map>
+#include <vector>
+
+namespace vuren {
+
+// descriptor set layouts and descriptor sets shared by every render pass.
+// layouts are hashed by their bindings, so passes declaring the same bindings get the same layout. sets come from
+// a list of pools: when the current one is full, a new one twice as large is added. a set a pass no longer uses is
+// kept on a free list of its layout and handed out again, the layouts and pools live until cleanup(), which destroys
+// them all at once. only used from the main thread.
+class DescriptorCache {
+public:
+    static constexpr uint32_t kInitialSetsPerPool = 8;
+
+    DescriptorCache() {}
+    ~DescriptorCache() {}
+
+    void init(VulkanContext *pContext);
+
+    // destroys every layout and pool, and with them every set
+    void cleanup();
+
+    vk::DescriptorSetLayout getLayout(const std::vector<vk::DescriptorSetLayoutBinding> &bindings);
+
+    // layout must come from getLayout(). a released set of the same layout is reused first, with the descriptors it
+    // had, so every binding must be written again.
+    vk::DescriptorSet allocate(vk::DescriptorSetLayout layout);
+
+    // the set must come from allocate() with this layout and no pending command buffer may use it anymore, e.g. the
+    // set a pass replaced when its reloaded shaders changed the bindings. the pools are not created with
+    // eFreeDescriptorSet, so it is kept for the next allocation with the layout instead.
+    void release(vk::DescriptorSet set, vk::DescriptorSetLayout layout);
+
+private:
+    struct LayoutEntry {
+        std::vector<vk::DescriptorSetLayoutBinding> bindings;
+        vk::DescriptorSetLayout layout;
+        std::vector<vk::DescriptorPoolSize> poolSizes; // descriptors of one set
+        std::vector<vk::DescriptorSet> freeSets;
+    };
+
+    static size_t hashBindings(const std::vector<vk::DescriptorSetLayoutBinding> &bindings);
+    static bool equalBindings(const std::vector<vk::DescriptorSetLayoutBinding> &a,
+                              const std::vector<vk::DescriptorSetLayoutBinding> &b);
+
+    LayoutEntry &findEntry(vk::DescriptorSetLayout layout);
+    void addPool(const std::vector<vk::DescriptorPoolSize> &requiredSizes);
+
+    VulkanContext *m_pContext{ nullptr };
+
+    std::unordered_map<size_t, std::vector<LayoutEntry>> m_layouts;
+    uint32_t m_layoutRequests{ 0 };
+
+    std::vector<vk::DescriptorPool> m_pools; // sets are allocated from the last one
+    uint32_t m_nextSetsPerPool{ kInitialSetsPerPool };
+    uint32_t m_allocatedSets{ 0 };
+    uint32_t m_reusedSets{ 0 };
+};
+
+} // namespace vuren
+
+#endif // DESCRIPTOR_CACHE_HPP
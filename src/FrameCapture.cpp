@@ -0,0 +1,178 @@
+#include "FrameCapture.hpp"
+#include "ImageWriter.hpp"
+#include "Profiler.hpp"
+
+#include <imgui/imgui.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+namespace vuren {
+
+void FrameCapture::init(VulkanContext *pContext, std::shared_ptr<ResourceManager> pResourceManager,
+                        const std::string &directory, const std::string &format, uint32_t ringSize) {
+    m_pContext         = pContext;
+    m_pResourceManager = pResourceManager;
+    m_extent           = pResourceManager->getExtent();
+    m_directory        = directory;
+    m_format           = format;
+
+    std::filesystem::create_directories(m_directory);
+
+    // cached memory makes the cpu-side copy out of the ring much faster, but not every device offers it
+    vk::MemoryPropertyFlags memoryProperties =
+        vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent;
+    auto deviceMemoryProperties = m_pContext->m_physicalDevice.getMemoryProperties();
+    for (uint32_t i = 0; i < deviceMemoryProperties.memoryTypeCount; ++i) {
+        if ((deviceMemoryProperties.memoryTypes[i].propertyFlags &
+             (memoryProperties | vk::MemoryPropertyFlagBits::eHostCached)) ==
+            (memoryProperties | vk::MemoryPropertyFlagBits::eHostCached)) {
+            memoryProperties |= vk::MemoryPropertyFlagBits::eHostCached;
+            break;
+        }
+    }
+
+    vk::DeviceSize bufferSize = static_cast<vk::DeviceSize>(m_extent.width) * m_extent.height * 4 * sizeof(float);
+    for (uint32_t i = 0; i < ringSize; ++i) {
+        auto pSlot     = std::make_unique<Slot>();
+        pSlot->buffer  = m_pResourceManager->createBuffer(bufferSize, vk::BufferUsageFlagBits::eTransferDst,
+                                                          memoryProperties);
+        pSlot->pMapped = m_pContext->m_device.mapMemory(pSlot->buffer.memory, 0, bufferSize);
+        m_slots.push_back(std::move(pSlot));
+    }
+
+    // one encoder per slot is enough to keep the ring drained
+    m_encoderCount = std::min(ringSize, std::max(1u, std::thread::hardware_concurrency()));
+    m_pThreadPool  = std::make_unique<ThreadPool>(m_encoderCount);
+}
+
+void FrameCapture::cleanup() {
+    if (!isEnabled())
+        return;
+
+    // the pool drains its queue before joining
+    m_pThreadPool.reset();
+    printStats();
+
+    for (auto &pSlot: m_slots) {
+        m_pContext->m_device.unmapMemory(pSlot->buffer.memory);
+        m_pResourceManager->destroyBuffer(pSlot->buffer);
+    }
+    m_slots.clear();
+}
+
+void FrameCapture::recordCopy(vk::CommandBuffer commandBuffer, const std::string &textureName,
+                              vk::ImageLayout currentLayout, uint64_t frameSerial) {
+    auto start = std::chrono::steady_clock::now();
+    if (!m_started) {
+        m_startTime = start;
+        m_started   = true;
+    }
+
+    auto it = std::find_if(m_slots.begin(), m_slots.end(),
+                           [](const std::unique_ptr<Slot> &pSlot) { return pSlot->state == SlotState::eFree; });
+    if (it == m_slots.end()) {
+        m_droppedFrames++;
+        return;
+    }
+
+    Slot &slot       = **it;
+    slot.state       = SlotState::eInFlight;
+    slot.frameSerial = frameSerial;
+
+    char frameNumber[16];
+    std::snprintf(frameNumber, sizeof(frameNumber), "%06llu", static_cast<unsigned long long>(m_recordedFrames));
+    slot.filename = m_directory + "/" + textureName + "_" + frameNumber + "." + m_format;
+    m_recordedFrames++;
+
+    m_pResourceManager->recordTextureReadback(commandBuffer, textureName, slot.buffer.descriptorInfo.buffer,
+                                              currentLayout);
+
+    m_renderThreadMs +=
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void FrameCapture::retire(uint64_t completedSerial) {
+    auto start = std::chrono::steady_clock::now();
+
+    for (auto &pSlot: m_slots) {
+        if (pSlot->state != SlotState::eInFlight || pSlot->frameSerial > completedSerial)
+            continue;
+
+        pSlot->state = SlotState::eEncoding;
+        Slot *pReady = pSlot.get();
+        m_pThreadPool->submit([this, pReady] { encode(*pReady); });
+    }
+
+    m_renderThreadMs +=
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void FrameCapture::encode(Slot &slot) {
+    VUREN_PROFILE_ZONE("FrameCapture::encode");
+    auto start = std::chrono::steady_clock::now();
+
+    // copy out first so the slot goes back to the ring before the (slower) encoding starts
+    std::vector<float> pixels(static_cast<size_t>(m_extent.width) * m_extent.height * 4);
+    std::memcpy(pixels.data(), slot.pMapped, pixels.size() * sizeof(float));
+    std::string filename = slot.filename;
+    slot.state           = SlotState::eFree;
+
+    try {
+        writeImage(filename, m_extent.width, m_extent.height, pixels);
+    } catch (const std::exception &e) {
+        std::cerr << "frame capture: " << e.what() << std::endl;
+        return;
+    }
+
+    m_encodeMicroseconds += std::chrono::duration_cast<std::chrono::microseconds>(
+                                std::chrono::steady_clock::now() - start)
+                                .count();
+    m_capturedFrames++;
+}
+
+double FrameCapture::getElapsedSeconds() const {
+    if (!m_started)
+        return 0.0;
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_startTime).count();
+}
+
+void FrameCapture::updateGui() {
+    if (!isEnabled() || !ImGui::CollapsingHeader("Frame Capture"))
+        return;
+
+    uint64_t captured = m_capturedFrames;
+    double seconds    = getElapsedSeconds();
+
+    ImGui::Text(" %ux%u %s, %d slots", m_extent.width, m_extent.height, m_format.c_str(),
+                static_cast<int>(m_slots.size()));
+    ImGui::Text(" %llu captured, %llu dropped", static_cast<unsigned long long>(captured),
+                static_cast<unsigned long long>(m_droppedFrames));
+    ImGui::Text(" %.1f frames/s", seconds > 0.0 ? captured / seconds : 0.0);
+    ImGui::Text(" %.3f ms/frame on the render thread",
+                m_recordedFrames > 0 ? m_renderThreadMs / m_recordedFrames : 0.0);
+}
+
+void FrameCapture::printStats() {
+    if (!isEnabled())
+        return;
+
+    uint64_t captured = m_capturedFrames;
+    double seconds    = getElapsedSeconds();
+    double frameMb    = static_cast<double>(m_extent.width) * m_extent.height * 4 * sizeof(float) / (1024.0 * 1024.0);
+
+    std::cout << "frame capture: " << captured << " frames at " << m_extent.width << "x" << m_extent.height << " ("
+              << m_format << "), " << m_droppedFrames << " dropped" << std::endl;
+    if (captured > 0 && seconds > 0.0) {
+        std::cout << "  " << captured / seconds << " frames/s, " << captured * frameMb / seconds
+                  << " MB/s read back, " << m_encodeMicroseconds / 1000.0 / captured << " ms encode per frame ("
+                  << m_encoderCount << " threads), "
+                  << (m_recordedFrames > 0 ? m_renderThreadMs / m_recordedFrames : 0.0)
+                  << " ms/frame on the render thread" << std::endl;
+    }
+}
+
+} // namespace vuren
@@ -0,0 +1,85 @@
+#ifndef FRAME_CAPTURE_HPP
+#define FRAME_CAPTURE_HPP
+
+#define VULKAN_HPP_NO_CONSTRUCTORS
+#define VULKAN_HPP_DISPATCH_LOADER_DYNAMIC 1
+#include <vulkan/vulkan.hpp>
+
+#include "Common.hpp"
+#include "ResourceManager.hpp"
+#include "ThreadPool.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace vuren {
+
+// continuous frame dumping without stalling the render loop.
+// a copy of the captured texture is recorded into the frame's own command buffer, targeting one of a ring of
+// host-visible buffers. once the frame's fence has signaled the slot is retired to worker threads, which copy
+// the pixels out and encode them while the gpu keeps rendering. if every slot is still busy the frame is
+// dropped instead of waiting.
+class FrameCapture {
+public:
+    FrameCapture() {}
+    ~FrameCapture() {}
+
+    // format is an ImageWriter file extension: png, exr, pfm or raw
+    void init(VulkanContext *pContext, std::shared_ptr<ResourceManager> pResourceManager, const std::string &directory,
+              const std::string &format, uint32_t ringSize = 4);
+
+    // finishes the pending encodes and reports the capture throughput before releasing the ring
+    void cleanup();
+
+    bool isEnabled() const { return !m_slots.empty(); }
+
+    // the texture must be an RGBA32 float texture currently in currentLayout
+    void recordCopy(vk::CommandBuffer commandBuffer, const std::string &textureName, vk::ImageLayout currentLayout,
+                    uint64_t frameSerial);
+
+    // hand every slot of a frame up to completedSerial over to the encoders
+    void retire(uint64_t completedSerial);
+
+    void updateGui();
+
+private:
+    enum class SlotState { eFree, eInFlight, eEncoding };
+
+    struct Slot {
+        Buffer buffer;
+        void *pMapped{ nullptr };
+        std::atomic<SlotState> state{ SlotState::eFree };
+        uint64_t frameSerial{ 0 };
+        std::string filename;
+    };
+
+    void encode(Slot &slot);
+    double getElapsedSeconds() const;
+    void printStats();
+
+    VulkanContext *m_pContext{ nullptr };
+    std::shared_ptr<ResourceManager> m_pResourceManager{ nullptr };
+    std::unique_ptr<ThreadPool> m_pThreadPool{ nullptr };
+    uint32_t m_encoderCount{ 0 };
+
+    std::vector<std::unique_ptr<Slot>> m_slots;
+    vk::Extent2D m_extent;
+    std::string m_directory;
+    std::string m_format;
+
+    // statistics
+    std::atomic<uint64_t> m_capturedFrames{ 0 };
+    std::atomic<uint64_t> m_encodeMicroseconds{ 0 };
+    uint64_t m_droppedFrames{ 0 };
+    uint64_t m_recordedFrames{ 0 };
+    double m_renderThreadMs{ 0.0 }; // time spent in recordCopy() and retire()
+    bool m_started{ false };
+    std::chrono::steady_clock::time_point m_startTime;
+};
+
+} // namespace vuren
+
+#endif // FRAME_CAPTURE_HPP
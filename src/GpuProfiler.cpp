@@ -0,0 +1,300 @@
+#include "GpuProfiler.hpp"
+#include "ResourceManager.hpp"
+
+#include <imgui/imgui.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+
+namespace vuren {
+
+namespace {
+
+// 1M events is about an hour of frames at 60 fps, far more than a trace viewer copes with anyway
+const size_t kMaxTraceEvents = 1 << 20;
+
+} // namespace
+
+void GpuProfiler::init(VulkanContext *pContext, vk::CommandPool commandPool) {
+    m_pContext = pContext;
+
+    QueueFamilyIndices indices = m_pContext->findQueueFamilies(m_pContext->m_physicalDevice);
+    auto queueFamilies         = m_pContext->m_physicalDevice.getQueueFamilyProperties();
+    uint32_t validBits         = queueFamilies[indices.graphicsFamily.value()].timestampValidBits;
+    if (validBits == 0) {
+        std::cerr << "gpu profiler: the graphics queue does not support timestamps, profiling disabled" << std::endl;
+        return;
+    }
+
+    m_timestampMask   = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+    m_timestampPeriod = m_pContext->m_physicalDevice.getProperties().limits.timestampPeriod;
+
+    vk::QueryPoolCreateInfo poolCreateInfo = { .queryType = vk::QueryType::eTimestamp, .queryCount = m_maxQueries };
+
+    m_frames.resize(kFrameLatency);
+    for (auto &frame: m_frames) {
+        if (m_pContext->m_device.createQueryPool(&poolCreateInfo, nullptr, &frame.queryPool) != vk::Result::eSuccess) {
+            throw std::runtime_error("failed to create timestamp query pool!");
+        }
+        frame.scopes.reserve(kMaxScopes);
+    }
+    m_timestamps.resize(m_maxQueries);
+
+    calibrate(commandPool);
+}
+
+// without VK_EXT_calibrated_timestamps the best we can do is reading a timestamp back right after it is written.
+// the cpu time is taken after the wait, so gpu events appear a little (a submission latency) early in the trace.
+void GpuProfiler::calibrate(vk::CommandPool commandPool) {
+    vk::QueryPool queryPool = m_frames[0].queryPool;
+
+    vk::CommandBuffer commandBuffer = beginSingleTimeCommands(*m_pContext, commandPool);
+    commandBuffer.resetQueryPool(queryPool, 0, 1);
+    commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, queryPool, 0);
+    endSingleTimeCommands(*m_pContext, commandPool, commandBuffer);
+    m_calibrationCpuNs = Profiler::now();
+
+    uint64_t timestamp = 0;
+    if (m_pContext->m_device.getQueryPoolResults(queryPool, 0, 1, sizeof(uint64_t), &timestamp, sizeof(uint64_t),
+                                                 vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWait) !=
+        vk::Result::eSuccess) {
+        throw std::runtime_error("failed to read the calibration timestamp!");
+    }
+    m_calibrationGpuTicks = timestamp & m_timestampMask;
+}
+
+void GpuProfiler::cleanup() {
+    if (!isEnabled())
+        return;
+
+    resolvePending();
+    for (auto &frame: m_frames)
+        m_pContext->m_device.destroyQueryPool(frame.queryPool, nullptr);
+    m_frames.clear();
+
+    if (m_resolvedFrames == 0)
+        return;
+
+    std::cout << "gpu profiler: " << m_resolvedFrames << " frames, ms over the last "
+              << std::min<uint64_t>(m_resolvedFrames, kHistorySize) << std::endl;
+    std::cout << std::fixed << std::setprecision(3);
+    for (auto &history: m_histories) {
+        ScopeStats stats = getStats(history);
+        std::cout << "  " << std::string(history.depth * 2, ' ') << std::left << std::setw(24 - history.depth * 2)
+                  << history.name << std::right << " avg " << std::setw(8) << stats.avg << "  min " << std::setw(8)
+                  << stats.min << "  p99 " << std::setw(8) << stats.p99 << std::endl;
+    }
+    std::cout << std::defaultfloat;
+    if (m_unavailableFrames > 0 || m_droppedScopes > 0) {
+        std::cout << "  " << m_unavailableFrames << " frames without results, " << m_droppedScopes
+                  << " scopes over the query budget" << std::endl;
+    }
+    if (m_droppedTraceEvents > 0)
+        std::cout << "  " << m_droppedTraceEvents << " gpu trace events dropped" << std::endl;
+}
+
+void GpuProfiler::resolvePending() {
+    if (!isEnabled())
+        return;
+
+    // oldest first, so that the frame timings stay in order
+    for (uint32_t i = 0; i < kFrameLatency; ++i)
+        resolveFrame(m_frames[(m_frameNumber + i) % kFrameLatency]);
+}
+
+std::vector<std::string> GpuProfiler::getScopeNames() const {
+    std::vector<std::string> names;
+    for (auto &history: m_histories)
+        names.push_back(history.name);
+    return names;
+}
+
+float GpuProfiler::getAverageMs(const std::string &name) const {
+    auto it = m_historyIndices.find(name);
+    if (it == m_historyIndices.end() || m_histories[it->second].count == 0)
+        return 0.0f;
+    return getStats(m_histories[it->second]).avg;
+}
+
+void GpuProfiler::beginFrame(vk::CommandBuffer commandBuffer) {
+    if (!isEnabled())
+        return;
+
+    FrameQueries &frame = m_frames[m_frameNumber % kFrameLatency];
+    resolveFrame(frame);
+
+    commandBuffer.resetQueryPool(frame.queryPool, 0, m_maxQueries);
+    frame.scopes.clear();
+    frame.queryCount  = 0;
+    frame.frameNumber = m_frameNumber;
+    m_openScopes.clear();
+}
+
+void GpuProfiler::endFrame() {
+    if (!isEnabled())
+        return;
+
+    m_frames[m_frameNumber % kFrameLatency].pending = true;
+    m_frameNumber++;
+}
+
+void GpuProfiler::beginScope(vk::CommandBuffer commandBuffer, const char *name) {
+    if (!isEnabled())
+        return;
+
+    FrameQueries &frame = m_frames[m_frameNumber % kFrameLatency];
+    if (frame.queryCount + 2 > m_maxQueries) {
+        // keep the scope stack balanced, endScope() skips it
+        m_openScopes.push_back(UINT32_MAX);
+        m_droppedScopes++;
+        return;
+    }
+
+    ScopeQuery scope = { .name       = name,
+                         .beginQuery = frame.queryCount++,
+                         .endQuery   = frame.queryCount++,
+                         .depth      = static_cast<uint32_t>(m_openScopes.size()) };
+    // top of pipe: the scope starts once the commands before it have been fetched, so a pass overlapping the
+    // tail of the previous one is charged for the overlap
+    commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, frame.queryPool, scope.beginQuery);
+
+    m_openScopes.push_back(static_cast<uint32_t>(frame.scopes.size()));
+    frame.scopes.push_back(scope);
+}
+
+void GpuProfiler::endScope(vk::CommandBuffer commandBuffer) {
+    if (!isEnabled() || m_openScopes.empty())
+        return;
+
+    uint32_t scopeIndex = m_openScopes.back();
+    m_openScopes.pop_back();
+    if (scopeIndex == UINT32_MAX)
+        return;
+
+    FrameQueries &frame = m_frames[m_frameNumber % kFrameLatency];
+    commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, frame.queryPool,
+                                 frame.scopes[scopeIndex].endQuery);
+}
+
+void GpuProfiler::resolveFrame(FrameQueries &frame) {
+    if (!frame.pending)
+        return;
+    frame.pending = false;
+    if (frame.queryCount == 0)
+        return;
+
+    // no eWait: the frame has retired by the time its pool is reused, if not, drop it rather than stall
+    vk::Result result = m_pContext->m_device.getQueryPoolResults(
+        frame.queryPool, 0, frame.queryCount, frame.queryCount * sizeof(uint64_t), m_timestamps.data(),
+        sizeof(uint64_t), vk::QueryResultFlagBits::e64);
+    if (result != vk::Result::eSuccess) {
+        m_unavailableFrames++;
+        return;
+    }
+
+    FrameTimings timings = { .frameNumber = frame.frameNumber };
+
+    for (auto &scope: frame.scopes) {
+        uint64_t begin = m_timestamps[scope.beginQuery] & m_timestampMask;
+        uint64_t ticks = ((m_timestamps[scope.endQuery] & m_timestampMask) - begin) & m_timestampMask;
+        double ns      = static_cast<double>(ticks) * m_timestampPeriod;
+        float ms       = static_cast<float>(ns * 1e-6);
+
+        size_t historyIndex = addSample(scope.name, scope.depth, ms);
+        if (m_frameTimingsEnabled) {
+            if (timings.scopeMs.size() <= historyIndex)
+                timings.scopeMs.resize(historyIndex + 1, -1.0f);
+            timings.scopeMs[historyIndex] = ms;
+        }
+
+        if (m_traceEnabled) {
+            addTraceEvent({ .name       = scope.name,
+                            .startNs    = getGpuTimeNs(begin),
+                            .durationNs = static_cast<uint64_t>(ns),
+                            .pid        = 1,
+                            .tid        = 0 });
+        }
+    }
+    m_resolvedFrames++;
+
+    if (m_frameTimingsEnabled)
+        m_frameTimings.push_back(std::move(timings));
+}
+
+size_t GpuProfiler::addSample(const char *name, uint32_t depth, float ms) {
+    auto it = m_historyIndices.find(name);
+    if (it == m_historyIndices.end()) {
+        it = m_historyIndices.emplace(name, m_histories.size()).first;
+        m_histories.push_back({ .name = name, .depth = depth });
+    }
+
+    ScopeHistory &history         = m_histories[it->second];
+    history.samples[history.next] = ms;
+    history.next                  = (history.next + 1) % kHistorySize;
+    history.count                 = std::min(history.count + 1, kHistorySize);
+    return it->second;
+}
+
+GpuProfiler::ScopeStats GpuProfiler::getStats(const ScopeHistory &history) const {
+    ScopeStats stats = {};
+    if (history.count == 0)
+        return stats;
+
+    std::array<float, kHistorySize> sorted;
+    std::copy(history.samples.begin(), history.samples.begin() + history.count, sorted.begin());
+    std::sort(sorted.begin(), sorted.begin() + history.count);
+
+    float sum = 0.0f;
+    for (uint32_t i = 0; i < history.count; ++i)
+        sum += sorted[i];
+
+    stats.last = history.samples[(history.next + kHistorySize - 1) % kHistorySize];
+    stats.min  = sorted[0];
+    stats.avg  = sum / history.count;
+    stats.p99  = sorted[std::min(history.count - 1, (history.count * 99) / 100)];
+    return stats;
+}
+
+uint64_t GpuProfiler::getGpuTimeNs(uint64_t timestamp) const {
+    uint64_t ticks = (timestamp - m_calibrationGpuTicks) & m_timestampMask;
+    return m_calibrationCpuNs + static_cast<uint64_t>(static_cast<double>(ticks) * m_timestampPeriod);
+}
+
+void GpuProfiler::addTraceEvent(const TraceEvent &event) {
+    if (m_traceEvents.size() >= kMaxTraceEvents) {
+        m_droppedTraceEvents++;
+        return;
+    }
+    m_traceEvents.push_back(event);
+}
+
+void GpuProfiler::updateGui() {
+    if (!isEnabled() || !ImGui::CollapsingHeader("GPU Profiler"))
+        return;
+
+    ImGui::Text(" %-22s %7s %7s %7s %7s", "ms", "last", "min", "avg", "p99");
+    for (auto &history: m_histories) {
+        ScopeStats stats = getStats(history);
+        ImGui::Text(" %*s%-*s %7.3f %7.3f %7.3f %7.3f", history.depth * 2, "", 22 - history.depth * 2,
+                    history.name.c_str(), stats.last, stats.min, stats.avg, stats.p99);
+    }
+
+    // the outermost scope is the whole frame
+    if (!m_histories.empty() && m_histories[0].count > 0) {
+        const ScopeHistory &frame = m_histories[0];
+        uint32_t offset           = frame.count < kHistorySize ? 0 : frame.next;
+        ImGui::PlotLines("##GpuFrameTime", frame.samples.data(), static_cast<int>(frame.count),
+                         static_cast<int>(offset), nullptr, 0.0f, FLT_MAX, ImVec2(0.0f, 40.0f));
+    }
+
+    if (m_unavailableFrames > 0 || m_droppedScopes > 0) {
+        ImGui::Text(" %llu frames without results, %llu scopes dropped",
+                    static_cast<unsigned long long>(m_unavailableFrames),
+                    static_cast<unsigned long long>(m_droppedScopes));
+    }
+}
+
+} // namespace vuren
@@ -0,0 +1,142 @@
+#ifndef GPU_PROFILER_HPP
+#define GPU_PROFILER_HPP
+
+#define VULKAN_HPP_NO_CONSTRUCTORS
+#define VULKAN_HPP_DISPATCH_LOADER_DYNAMIC 1
+#include <vulkan/vulkan.hpp>
+
+#include "Common.hpp"
+#include "Profiler.hpp"
+#include "VulkanContext.hpp"
+
+#include <array>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace vuren {
+
+// per-pass gpu timings from timestamp queries.
+// every frame writes its timestamps into its own query pool. a pool is only read back when it comes around
+// again, kFrameLatency frames later, so its frame has long completed and reading the results never stalls.
+// the timings are shown in the gui (last, min, average and 99th percentile over a rolling window) and can be
+// exported, on the Profiler clock, into the chrome trace of the cpu zones (chrome://tracing, perfetto).
+class GpuProfiler {
+public:
+    static constexpr uint32_t kFrameLatency = 3;
+    static constexpr uint32_t kMaxScopes    = 32;
+    static constexpr uint32_t kHistorySize  = 256;
+
+    GpuProfiler() {}
+    ~GpuProfiler() {}
+
+    // the profiler stays disabled if the graphics queue does not support timestamps
+    void init(VulkanContext *pContext, vk::CommandPool commandPool);
+
+    // resolves the frames still pending (the device must be idle) and prints a summary
+    void cleanup();
+
+    bool isEnabled() const { return !m_frames.empty(); }
+
+    // keep the scopes in memory for getTraceEvents()
+    void setTraceEnabled(bool enabled) { m_traceEnabled = enabled; }
+
+    // must be recorded outside of a render pass instance, before any scope of the frame
+    void beginFrame(vk::CommandBuffer commandBuffer);
+    void endFrame();
+
+    // scope names must outlive the profiler (string literals)
+    void beginScope(vk::CommandBuffer commandBuffer, const char *name);
+    void endScope(vk::CommandBuffer commandBuffer);
+
+    const std::vector<TraceEvent> &getTraceEvents() const { return m_traceEvents; }
+
+    // every resolved frame's scope timings, indexed like getScopeNames()
+    struct FrameTimings {
+        uint64_t frameNumber;
+        std::vector<float> scopeMs;
+    };
+
+    void setFrameTimingsEnabled(bool enabled) { m_frameTimingsEnabled = enabled; }
+    const std::vector<FrameTimings> &getFrameTimings() const { return m_frameTimings; }
+    std::vector<std::string> getScopeNames() const;
+
+    // rolling average of a scope in ms, 0 if the scope has not been resolved yet
+    float getAverageMs(const std::string &name) const;
+
+    // reads back the frames still pending, the device must be idle
+    void resolvePending();
+
+    void updateGui();
+
+private:
+    struct ScopeQuery {
+        const char *name;
+        uint32_t beginQuery;
+        uint32_t endQuery;
+        uint32_t depth;
+    };
+
+    struct FrameQueries {
+        vk::QueryPool queryPool;
+        std::vector<ScopeQuery> scopes;
+        uint32_t queryCount{ 0 };
+        uint64_t frameNumber{ 0 };
+        bool pending{ false };
+    };
+
+    struct ScopeHistory {
+        std::string name;
+        uint32_t depth{ 0 };
+        std::array<float, kHistorySize> samples{}; // ms
+        uint32_t count{ 0 };
+        uint32_t next{ 0 };
+    };
+
+    struct ScopeStats {
+        float last;
+        float min;
+        float avg;
+        float p99;
+    };
+
+    void calibrate(vk::CommandPool commandPool);
+    void resolveFrame(FrameQueries &frame);
+    size_t addSample(const char *name, uint32_t depth, float ms);
+    ScopeStats getStats(const ScopeHistory &history) const;
+    uint64_t getGpuTimeNs(uint64_t timestamp) const;
+    void addTraceEvent(const TraceEvent &event);
+
+    VulkanContext *m_pContext{ nullptr };
+
+    std::vector<FrameQueries> m_frames;
+    uint32_t m_maxQueries{ kMaxScopes * 2 };
+    uint64_t m_frameNumber{ 0 };
+    std::vector<uint32_t> m_openScopes; // indices into the current frame's scopes
+    std::vector<uint64_t> m_timestamps;
+
+    float m_timestampPeriod{ 1.0f }; // ns per tick
+    uint64_t m_timestampMask{ ~0ull };
+
+    // one gpu timestamp taken together with a cpu time, to put both timelines on the same clock
+    uint64_t m_calibrationGpuTicks{ 0 };
+    uint64_t m_calibrationCpuNs{ 0 };
+
+    // rolling timings, in the order the scopes first showed up
+    std::vector<ScopeHistory> m_histories;
+    std::unordered_map<std::string, size_t> m_historyIndices;
+    uint64_t m_resolvedFrames{ 0 };
+    uint64_t m_unavailableFrames{ 0 };
+    uint64_t m_droppedScopes{ 0 };
+
+    bool m_frameTimingsEnabled{ false };
+    std::vector<FrameTimings> m_frameTimings;
+
+    bool m_traceEnabled{ false };
+    std::vector<TraceEvent> m_traceEvents;
+    uint64_t m_droppedTraceEvents{ 0 };
+};
+
+} // namespace vuren
+
+#endif // GPU_PROFILER_HPP
@@ -0,0 +1,279 @@
+#include "ImageWriter.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace vuren {
+
+static std::ofstream openOutputFile(const std::string &filename) {
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("failed to open " + filename + " for writing!");
+    }
+    return file;
+}
+
+template <typename T> static void writeLittleEndian(std::ofstream &file, T value) {
+    uint8_t bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    // all the platforms we build for are little-endian
+    file.write(reinterpret_cast<const char *>(bytes), sizeof(T));
+}
+
+static void writeBigEndian32(std::vector<uint8_t> &out, uint32_t value) {
+    out.push_back(static_cast<uint8_t>(value >> 24));
+    out.push_back(static_cast<uint8_t>(value >> 16));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+static void checkSize(uint32_t width, uint32_t height, const std::vector<float> &rgba) {
+    if (rgba.size() < static_cast<size_t>(width) * height * 4) {
+        throw std::invalid_argument("image buffer is smaller than width * height * 4!");
+    }
+}
+
+void writePfm(const std::string &filename, uint32_t width, uint32_t height, const std::vector<float> &rgba) {
+    checkSize(width, height, rgba);
+    std::ofstream file = openOutputFile(filename);
+
+    // a negative scale means little-endian data
+    file << "PF\n" << width << " " << height << "\n-1.0\n";
+
+    // pfm stores the bottom row first
+    std::vector<float> row(static_cast<size_t>(width) * 3);
+    for (uint32_t y = height; y-- > 0;) {
+        for (uint32_t x = 0; x < width; ++x) {
+            const float *pixel = &rgba[(static_cast<size_t>(y) * width + x) * 4];
+            row[x * 3 + 0]     = pixel[0];
+            row[x * 3 + 1]     = pixel[1];
+            row[x * 3 + 2]     = pixel[2];
+        }
+        file.write(reinterpret_cast<const char *>(row.data()), row.size() * sizeof(float));
+    }
+}
+
+std::vector<float> readPfm(const std::string &filename, uint32_t &width, uint32_t &height) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("failed to open " + filename + "!");
+    }
+
+    std::string magic;
+    float scale = 0.0f;
+    file >> magic >> width >> height >> scale;
+    if (!file || magic != "PF" || scale >= 0.0f) {
+        throw std::runtime_error(filename + " is not a little-endian color pfm!");
+    }
+    // a single whitespace character ends the header
+    file.get();
+
+    std::vector<float> rgba(static_cast<size_t>(width) * height * 4, 1.0f);
+    std::vector<float> row(static_cast<size_t>(width) * 3);
+    for (uint32_t y = height; y-- > 0;) {
+        file.read(reinterpret_cast<char *>(row.data()), row.size() * sizeof(float));
+        if (!file) {
+            throw std::runtime_error("unexpected end of " + filename + "!");
+        }
+        for (uint32_t x = 0; x < width; ++x) {
+            float *pixel = &rgba[(static_cast<size_t>(y) * width + x) * 4];
+            pixel[0]     = row[x * 3 + 0];
+            pixel[1]     = row[x * 3 + 1];
+            pixel[2]     = row[x * 3 + 2];
+        }
+    }
+    return rgba;
+}
+
+void writeExr(const std::string &filename, uint32_t width, uint32_t height, const std::vector<float> &rgba) {
+    checkSize(width, height, rgba);
+    std::ofstream file = openOutputFile(filename);
+
+    auto writeAttribute = [&file](const char *name, const char *type, const std::vector<uint8_t> &value) {
+        file.write(name, std::strlen(name) + 1);
+        file.write(type, std::strlen(type) + 1);
+        writeLittleEndian<int32_t>(file, static_cast<int32_t>(value.size()));
+        file.write(reinterpret_cast<const char *>(value.data()), value.size());
+    };
+
+    auto toBytes = [](std::initializer_list<int32_t> values) {
+        std::vector<uint8_t> bytes(values.size() * sizeof(int32_t));
+        std::memcpy(bytes.data(), values.begin(), bytes.size());
+        return bytes;
+    };
+
+    const float one = 1.0f;
+    int32_t oneBits;
+    std::memcpy(&oneBits, &one, sizeof(float));
+
+    // magic number and version 2, single-part scanline image
+    writeLittleEndian<uint32_t>(file, 20000630);
+    writeLittleEndian<uint32_t>(file, 2);
+
+    // channel list, which must be sorted by name
+    const std::array<char, 3> channelNames = { 'B', 'G', 'R' };
+    std::vector<uint8_t> channels;
+    for (char channelName: channelNames) {
+        channels.push_back(static_cast<uint8_t>(channelName));
+        channels.push_back(0);
+        std::vector<uint8_t> desc = toBytes({ 2, 0, 1, 1 }); // FLOAT, pLinear + reserved, xSampling, ySampling
+        channels.insert(channels.end(), desc.begin(), desc.end());
+    }
+    channels.push_back(0);
+
+    const int32_t xMax = static_cast<int32_t>(width) - 1;
+    const int32_t yMax = static_cast<int32_t>(height) - 1;
+
+    writeAttribute("channels", "chlist", channels);
+    writeAttribute("compression", "compression", { 0 }); // NO_COMPRESSION
+    writeAttribute("dataWindow", "box2i", toBytes({ 0, 0, xMax, yMax }));
+    writeAttribute("displayWindow", "box2i", toBytes({ 0, 0, xMax, yMax }));
+    writeAttribute("lineOrder", "lineOrder", { 0 }); // INCREASING_Y
+    writeAttribute("pixelAspectRatio", "float", toBytes({ oneBits }));
+    writeAttribute("screenWindowCenter", "v2f", toBytes({ 0, 0 }));
+    writeAttribute("screenWindowWidth", "float", toBytes({ oneBits }));
+    file.put(0); // end of header
+
+    // line offset table, one uncompressed scanline per chunk
+    const uint64_t lineDataSize = static_cast<uint64_t>(width) * channelNames.size() * sizeof(float);
+    const uint64_t chunkSize    = 2 * sizeof(int32_t) + lineDataSize;
+    const uint64_t offsetTable  = static_cast<uint64_t>(height) * sizeof(uint64_t);
+    const uint64_t firstChunk   = static_cast<uint64_t>(file.tellp()) + offsetTable;
+    for (uint32_t y = 0; y < height; ++y) {
+        writeLittleEndian<uint64_t>(file, firstChunk + y * chunkSize);
+    }
+
+    // scanlines: y, data size, then each channel's samples for the whole line
+    std::vector<float> line(static_cast<size_t>(width) * channelNames.size());
+    for (uint32_t y = 0; y < height; ++y) {
+        for (uint32_t x = 0; x < width; ++x) {
+            const float *pixel = &rgba[(static_cast<size_t>(y) * width + x) * 4];
+            line[0 * width + x] = pixel[2]; // B
+            line[1 * width + x] = pixel[1]; // G
+            line[2 * width + x] = pixel[0]; // R
+        }
+        writeLittleEndian<int32_t>(file, static_cast<int32_t>(y));
+        writeLittleEndian<int32_t>(file, static_cast<int32_t>(lineDataSize));
+        file.write(reinterpret_cast<const char *>(line.data()), lineDataSize);
+    }
+}
+
+static uint32_t crc32(const uint8_t *data, size_t size, uint32_t crc = 0) {
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> t{};
+        for (uint32_t n = 0; n < 256; ++n) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; ++k)
+                c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+            t[n] = c;
+        }
+        return t;
+    }();
+
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i)
+        crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    return ~crc;
+}
+
+static uint8_t linearToSrgb8(float value) {
+    value = std::clamp(value, 0.0f, 1.0f);
+    value = value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+    return static_cast<uint8_t>(value * 255.0f + 0.5f);
+}
+
+void writePng(const std::string &filename, uint32_t width, uint32_t height, const std::vector<float> &rgba) {
+    checkSize(width, height, rgba);
+    std::ofstream file = openOutputFile(filename);
+
+    auto writeChunk = [&file](const char *type, const std::vector<uint8_t> &data) {
+        std::vector<uint8_t> chunk;
+        writeBigEndian32(chunk, static_cast<uint32_t>(data.size()));
+        chunk.insert(chunk.end(), type, type + 4);
+        chunk.insert(chunk.end(), data.begin(), data.end());
+        writeBigEndian32(chunk, crc32(chunk.data() + 4, chunk.size() - 4));
+        file.write(reinterpret_cast<const char *>(chunk.data()), chunk.size());
+    };
+
+    const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+    file.write(reinterpret_cast<const char *>(signature), sizeof(signature));
+
+    // 8-bit truecolor, no interlacing
+    std::vector<uint8_t> header;
+    writeBigEndian32(header, width);
+    writeBigEndian32(header, height);
+    header.insert(header.end(), { 8, 2, 0, 0, 0 });
+    writeChunk("IHDR", header);
+
+    // filter type 0 (none) in front of every row
+    std::vector<uint8_t> raw;
+    raw.reserve(static_cast<size_t>(width * 3 + 1) * height);
+    for (uint32_t y = 0; y < height; ++y) {
+        raw.push_back(0);
+        for (uint32_t x = 0; x < width; ++x) {
+            const float *pixel = &rgba[(static_cast<size_t>(y) * width + x) * 4];
+            raw.push_back(linearToSrgb8(pixel[0]));
+            raw.push_back(linearToSrgb8(pixel[1]));
+            raw.push_back(linearToSrgb8(pixel[2]));
+        }
+    }
+
+    // zlib stream made of stored (uncompressed) deflate blocks; size over speed is not a concern here
+    std::vector<uint8_t> zlib = { 0x78, 0x01 };
+    const size_t kMaxBlockSize = 65535;
+    for (size_t offset = 0; offset < raw.size() || offset == 0; offset += kMaxBlockSize) {
+        size_t blockSize = std::min(kMaxBlockSize, raw.size() - offset);
+        bool isFinal     = offset + blockSize >= raw.size();
+        zlib.push_back(isFinal ? 1 : 0);
+        zlib.push_back(static_cast<uint8_t>(blockSize));
+        zlib.push_back(static_cast<uint8_t>(blockSize >> 8));
+        zlib.push_back(static_cast<uint8_t>(~blockSize));
+        zlib.push_back(static_cast<uint8_t>(~blockSize >> 8));
+        zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + blockSize);
+        if (isFinal)
+            break;
+    }
+
+    uint32_t a = 1, b = 0;
+    for (uint8_t byte: raw) {
+        a = (a + byte) % 65521;
+        b = (b + a) % 65521;
+    }
+    writeBigEndian32(zlib, (b << 16) | a);
+
+    writeChunk("IDAT", zlib);
+    writeChunk("IEND", {});
+}
+
+void writeRaw(const std::string &filename, uint32_t width, uint32_t height, const std::vector<float> &rgba) {
+    checkSize(width, height, rgba);
+    std::ofstream file = openOutputFile(filename);
+    file.write(reinterpret_cast<const char *>(rgba.data()), static_cast<size_t>(width) * height * 4 * sizeof(float));
+}
+
+void writeImage(const std::string &filename, uint32_t width, uint32_t height, const std::vector<float> &rgba) {
+    auto hasExtension = [&filename](const std::string &extension) {
+        if (filename.size() < extension.size())
+            return false;
+        std::string tail = filename.substr(filename.size() - extension.size());
+        std::transform(tail.begin(), tail.end(), tail.begin(), [](unsigned char c) { return std::tolower(c); });
+        return tail == extension;
+    };
+
+    if (hasExtension(".pfm"))
+        writePfm(filename, width, height, rgba);
+    else if (hasExtension(".exr"))
+        writeExr(filename, width, height, rgba);
+    else if (hasExtension(".png"))
+        writePng(filename, width, height, rgba);
+    else if (hasExtension(".raw"))
+        writeRaw(filename, width, height, rgba);
+    else
+        throw std::runtime_error("unsupported image format: " + filename + " (use .png, .pfm, .exr or .raw)");
+}
+
+} // namespace vuren
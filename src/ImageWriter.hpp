@@ -0,0 +1,33 @@
+#ifndef IMAGE_WRITER_HPP
+#define IMAGE_WRITER_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace vuren {
+
+// writers for linear RGBA32 float images (e.g. a "AccumOutput" readback), top row first.
+// except for raw dumps, only the rgb channels are stored.
+
+// portable float map, linear radiance
+void writePfm(const std::string &filename, uint32_t width, uint32_t height, const std::vector<float> &rgba);
+
+// reads back a color pfm (e.g. a high spp reference render) as RGBA32 float with alpha 1, top row first
+std::vector<float> readPfm(const std::string &filename, uint32_t &width, uint32_t &height);
+
+// uncompressed OpenEXR scanline image with 32-bit float channels, linear radiance
+void writeExr(const std::string &filename, uint32_t width, uint32_t height, const std::vector<float> &rgba);
+
+// 8-bit png, clamped to [0, 1] and sRGB encoded (what the swap chain would display)
+void writePng(const std::string &filename, uint32_t width, uint32_t height, const std::vector<float> &rgba);
+
+// headerless dump of the rgba floats, the cheapest format to write
+void writeRaw(const std::string &filename, uint32_t width, uint32_t height, const std::vector<float> &rgba);
+
+// pick the format from the file extension
+void writeImage(const std::string &filename, uint32_t width, uint32_t height, const std::vector<float> &rgba);
+
+} // namespace vuren
+
+#endif // IMAGE_WRITER_HPP
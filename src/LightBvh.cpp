@@ -0,0 +1,370 @@
+#include "LightBvh.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace vuren {
+
+namespace {
+
+const int kBinCount = 12;
+// a refit tree costing more than this times the built one is rebuilt
+const double kRebuildCostRatio = 1.5;
+// the largest float below 1, the rescaled random number stays in [0, 1)
+const float kOneMinusEpsilon = 0x1.fffffep-1f;
+const float kPi              = 3.1415926535897932384626433832795f;
+
+float luminance(const vec3 &color) { return glm::dot(color, vec3(0.2126f, 0.7152f, 0.0722f)); }
+
+float safeSqrt(float x) { return std::sqrt(std::max(x, 0.0f)); }
+
+// cos(max(a - b, 0)) and sin(max(a - b, 0)) from the sines and cosines of the angles
+float cosSubClamped(float sinA, float cosA, float sinB, float cosB) {
+    return cosA > cosB ? 1.0f : cosA * cosB + sinA * sinB;
+}
+
+float sinSubClamped(float sinA, float cosA, float sinB, float cosB) {
+    return cosA > cosB ? 0.0f : sinA * cosB - cosA * sinB;
+}
+
+struct Aabb {
+    vec3 min{ std::numeric_limits<float>::max() };
+    vec3 max{ -std::numeric_limits<float>::max() };
+
+    void grow(const vec3 &p) {
+        min = glm::min(min, p);
+        max = glm::max(max, p);
+    }
+
+    void grow(const Aabb &other) {
+        min = glm::min(min, other.min);
+        max = glm::max(max, other.max);
+    }
+
+    float area() const {
+        vec3 e = max - min;
+        return e.x * e.y + e.y * e.z + e.z * e.x;
+    }
+};
+
+// the directions within thetaO of axis
+struct Cone {
+    vec3 axis{ 0.0f, 0.0f, 1.0f };
+    float thetaO{ 0.0f };
+};
+
+// the smallest cone containing both (Conty Estevez and Kulla, algorithm 1)
+Cone mergeCones(Cone a, Cone b) {
+    if (b.thetaO > a.thetaO)
+        std::swap(a, b);
+    if (a.thetaO >= kPi)
+        return a;
+
+    float thetaD = std::acos(glm::clamp(glm::dot(a.axis, b.axis), -1.0f, 1.0f));
+    if (std::min(thetaD + b.thetaO, kPi) <= a.thetaO)
+        return a;
+
+    float thetaO = (a.thetaO + thetaD + b.thetaO) * 0.5f;
+    if (thetaO >= kPi)
+        return { a.axis, kPi };
+
+    // rotate a's axis towards b's by the growth of the angle
+    vec3 rotationAxis = glm::cross(a.axis, b.axis);
+    if (glm::dot(rotationAxis, rotationAxis) < 1e-12f)
+        return { a.axis, kPi };
+    float thetaR = thetaO - a.thetaO;
+    vec3 k       = glm::normalize(rotationAxis);
+    vec3 axis    = a.axis * std::cos(thetaR) + glm::cross(k, a.axis) * std::sin(thetaR);
+    return { glm::normalize(axis), thetaO };
+}
+
+// the solid angle measure of a cone of directions with the pi / 2 emission falloff of every light type so far
+float orientationMeasure(float thetaO) {
+    // every direction, as soon as a point light is below
+    if (thetaO >= kPi)
+        return 4.0f * kPi;
+
+    float thetaW = std::min(thetaO + kPi * 0.5f, kPi);
+    float sinO   = std::sin(thetaO);
+    float cosO   = std::cos(thetaO);
+    return 2.0f * kPi * (1.0f - cosO) +
+           kPi * 0.5f * (2.0f * thetaW * sinO - std::cos(thetaO - 2.0f * thetaW) - 2.0f * thetaO * sinO + cosO);
+}
+
+struct LightBounds {
+    Aabb bounds;
+    float power{ 0.0f };
+    Cone cone;
+    bool empty{ true };
+
+    void grow(const LightBounds &other) {
+        if (other.empty)
+            return;
+        bounds.grow(other.bounds);
+        power += other.power;
+        cone  = empty ? other.cone : mergeCones(cone, other.cone);
+        empty = false;
+    }
+
+    // surface area orientation heuristic
+    float cost() const { return empty ? 0.0f : power * orientationMeasure(cone.thetaO) * bounds.area(); }
+};
+
+LightBounds getLightBounds(const Light &light) {
+    LightBounds bounds;
+    bounds.bounds.grow(light.pos);
+    bounds.power = std::max(luminance(light.intensity), 0.0f);
+    bounds.cone  = { vec3(0.0f, 0.0f, 1.0f), kPi }; // LIGHT_TYPE_POINT
+    bounds.empty = false;
+    return bounds;
+}
+
+// sorts the range of lights into two and returns the size of the first part
+uint32_t splitLights(const std::vector<LightBounds> &lightBounds, std::vector<uint32_t> &order, uint32_t first,
+                     uint32_t count) {
+    Aabb centroidBounds;
+    for (uint32_t i = first; i < first + count; ++i)
+        centroidBounds.grow(lightBounds[order[i]].bounds.min);
+
+    float bestCost = std::numeric_limits<float>::max();
+    int bestAxis   = -1;
+    int bestBin    = 0;
+    for (int a = 0; a < 3; ++a) {
+        if (centroidBounds.min[a] == centroidBounds.max[a])
+            continue;
+
+        std::array<LightBounds, kBinCount> bins;
+        float scale = kBinCount / (centroidBounds.max[a] - centroidBounds.min[a]);
+        for (uint32_t i = first; i < first + count; ++i) {
+            const LightBounds &light = lightBounds[order[i]];
+            int bin = std::min(kBinCount - 1, static_cast<int>((light.bounds.min[a] - centroidBounds.min[a]) * scale));
+            bins[bin].grow(light);
+        }
+
+        // sweep from both sides to evaluate every bin boundary in linear time
+        std::array<float, kBinCount - 1> leftCost, rightCost;
+        LightBounds left, right;
+        for (int i = 0; i < kBinCount - 1; ++i) {
+            left.grow(bins[i]);
+            leftCost[i] = left.empty ? -1.0f : left.cost();
+
+            right.grow(bins[kBinCount - 1 - i]);
+            rightCost[kBinCount - 2 - i] = right.empty ? -1.0f : right.cost();
+        }
+
+        for (int i = 0; i < kBinCount - 1; ++i) {
+            if (leftCost[i] < 0.0f || rightCost[i] < 0.0f)
+                continue;
+            float cost = leftCost[i] + rightCost[i];
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestAxis = a;
+                bestBin  = i;
+            }
+        }
+    }
+
+    // every light at the same position: any split is as good
+    if (bestAxis < 0)
+        return count / 2;
+
+    float scale = kBinCount / (centroidBounds.max[bestAxis] - centroidBounds.min[bestAxis]);
+    auto middle = std::partition(order.begin() + first, order.begin() + first + count, [&](uint32_t light) {
+        float c = lightBounds[light].bounds.min[bestAxis];
+        return std::min(kBinCount - 1, static_cast<int>((c - centroidBounds.min[bestAxis]) * scale)) <= bestBin;
+    });
+    uint32_t leftCount = static_cast<uint32_t>(middle - (order.begin() + first));
+    return leftCount == 0 || leftCount == count ? count / 2 : leftCount;
+}
+
+} // namespace
+
+void LightBvh::build(const std::vector<Light> &lights) {
+    uint32_t lightCount = static_cast<uint32_t>(lights.size());
+    m_nodes.clear();
+    m_parents.clear();
+    m_lightLeaves.assign(lightCount, 0);
+    m_cost      = 0.0;
+    m_builtCost = 0.0;
+    if (lightCount == 0)
+        return;
+
+    std::vector<LightBounds> lightBounds(lightCount);
+    for (uint32_t i = 0; i < lightCount; ++i)
+        lightBounds[i] = getLightBounds(lights[i]);
+
+    std::vector<uint32_t> order(lightCount);
+    std::iota(order.begin(), order.end(), 0);
+
+    m_nodes.reserve(lightCount * 2 - 1);
+    m_parents.reserve(lightCount * 2 - 1);
+
+    // explicit stack, a skewed split sequence over many lights would overflow the call stack otherwise.
+    // the first child is popped right after its parent, which gives the depth-first order.
+    struct Range {
+        uint32_t first;
+        uint32_t count;
+        uint32_t parent;
+    };
+    std::vector<Range> stack = { { 0, lightCount, kNoParent } };
+    while (!stack.empty()) {
+        Range range = stack.back();
+        stack.pop_back();
+
+        uint32_t nodeIndex = static_cast<uint32_t>(m_nodes.size());
+        m_nodes.push_back({});
+        m_parents.push_back(range.parent);
+        if (range.parent != kNoParent && nodeIndex != range.parent + 1)
+            m_nodes[range.parent].childOrLight = nodeIndex;
+
+        if (range.count == 1) {
+            setLeaf(nodeIndex, lights[order[range.first]], order[range.first]);
+            continue;
+        }
+
+        uint32_t leftCount = splitLights(lightBounds, order, range.first, range.count);
+        stack.push_back({ range.first + leftCount, range.count - leftCount, nodeIndex });
+        stack.push_back({ range.first, leftCount, nodeIndex });
+    }
+
+    // the children of a node come after it
+    m_nodeCosts.assign(m_nodes.size(), 0.0f);
+    for (uint32_t i = static_cast<uint32_t>(m_nodes.size()); i-- > 0;) {
+        if ((m_nodes[i].childOrLight & LIGHT_BVH_LEAF) == 0) {
+            mergeChildren(i);
+            m_cost += m_nodeCosts[i];
+        }
+    }
+    m_builtCost = m_cost;
+}
+
+bool LightBvh::refit(const std::vector<Light> &lights, const std::vector<uint32_t> &movedLights,
+                     std::vector<uint32_t> &updatedNodes) {
+    size_t firstUpdated = updatedNodes.size();
+    for (auto light: movedLights) {
+        uint32_t node = m_lightLeaves[light];
+        setLeaf(node, lights[light], light);
+        for (; node != kNoParent; node = m_parents[node])
+            updatedNodes.push_back(node);
+    }
+
+    // children before their parents
+    std::sort(updatedNodes.begin() + firstUpdated, updatedNodes.end(), std::greater<uint32_t>());
+    updatedNodes.erase(std::unique(updatedNodes.begin() + firstUpdated, updatedNodes.end()), updatedNodes.end());
+    for (size_t i = firstUpdated; i < updatedNodes.size(); ++i) {
+        uint32_t node = updatedNodes[i];
+        if ((m_nodes[node].childOrLight & LIGHT_BVH_LEAF) != 0)
+            continue;
+        m_cost -= m_nodeCosts[node];
+        mergeChildren(node);
+        m_cost += m_nodeCosts[node];
+    }
+
+    if (m_cost <= m_builtCost * kRebuildCostRatio)
+        return false;
+
+    build(lights);
+    m_rebuildCount++;
+    return true;
+}
+
+void LightBvh::setLeaf(uint32_t nodeIndex, const Light &light, uint32_t lightIndex) {
+    LightBounds bounds = getLightBounds(light);
+
+    m_nodes[nodeIndex] = { .boundsMin    = bounds.bounds.min,
+                           .power        = bounds.power,
+                           .boundsMax    = bounds.bounds.max,
+                           .childOrLight = LIGHT_BVH_LEAF | lightIndex,
+                           .axis         = bounds.cone.axis,
+                           .cosThetaO    = std::cos(bounds.cone.thetaO) };
+    m_lightLeaves[lightIndex] = nodeIndex;
+}
+
+void LightBvh::mergeChildren(uint32_t nodeIndex) {
+    LightBounds merged;
+    for (uint32_t child: { nodeIndex + 1, m_nodes[nodeIndex].childOrLight }) {
+        const LightBvhNode &node = m_nodes[child];
+        LightBounds bounds;
+        bounds.bounds.grow(node.boundsMin);
+        bounds.bounds.grow(node.boundsMax);
+        bounds.power = node.power;
+        bounds.cone  = { node.axis, std::acos(glm::clamp(node.cosThetaO, -1.0f, 1.0f)) };
+        bounds.empty = false;
+        merged.grow(bounds);
+    }
+
+    LightBvhNode &node = m_nodes[nodeIndex];
+    node.boundsMin     = merged.bounds.min;
+    node.power         = merged.power;
+    node.boundsMax     = merged.bounds.max;
+    node.axis          = merged.cone.axis;
+    node.cosThetaO     = std::cos(merged.cone.thetaO);
+
+    m_nodeCosts[nodeIndex] = merged.cost();
+}
+
+float LightBvh::importance(const LightBvhNode &node, const vec3 &position, const vec3 &normal) {
+    vec3 center      = (node.boundsMin + node.boundsMax) * 0.5f;
+    vec3 halfExtent  = (node.boundsMax - node.boundsMin) * 0.5f;
+    float radius2    = glm::dot(halfExtent, halfExtent);
+    vec3 toPosition  = position - center;
+    float dist2      = glm::dot(toPosition, toPosition);
+    vec3 wi          = dist2 > 0.0f ? toPosition / std::sqrt(dist2) : vec3(0.0f, 0.0f, 1.0f);
+    float clampDist2 = std::max(std::max(dist2, radius2), 1e-8f);
+
+    // the directions from the position to the bounding sphere, every direction from inside
+    float cosThetaB = dist2 > radius2 ? safeSqrt(1.0f - radius2 / dist2) : -1.0f;
+    float sinThetaB = safeSqrt(1.0f - cosThetaB * cosThetaB);
+
+    // the smallest angle between the emission cone and the direction to the position, past the falloff nothing
+    // is emitted towards it
+    float cosThetaW = glm::dot(node.axis, wi);
+    float sinThetaW = safeSqrt(1.0f - cosThetaW * cosThetaW);
+    float sinThetaO = safeSqrt(1.0f - node.cosThetaO * node.cosThetaO);
+    float cosThetaX = cosSubClamped(sinThetaW, cosThetaW, sinThetaO, node.cosThetaO);
+    float sinThetaX = sinSubClamped(sinThetaW, cosThetaW, sinThetaO, node.cosThetaO);
+    float cosThetaP = cosSubClamped(sinThetaX, cosThetaX, sinThetaB, cosThetaB);
+    if (cosThetaP <= 0.0f)
+        return 0.0f;
+
+    // the smallest angle between the normal and a direction to the bounds, one-sided like the lighting
+    float cosThetaI  = -glm::dot(normal, wi);
+    float sinThetaI  = safeSqrt(1.0f - cosThetaI * cosThetaI);
+    float cosThetaIP = cosSubClamped(sinThetaI, cosThetaI, sinThetaB, cosThetaB);
+    if (cosThetaIP <= 0.0f)
+        return 0.0f;
+
+    return node.power * cosThetaP * cosThetaIP / clampDist2;
+}
+
+bool LightBvh::sample(const vec3 &position, const vec3 &normal, float u, uint32_t &lightIndex, float &pmf) const {
+    uint32_t nodeIndex = 0;
+    pmf                = 1.0f;
+    while ((m_nodes[nodeIndex].childOrLight & LIGHT_BVH_LEAF) == 0) {
+        uint32_t left     = nodeIndex + 1;
+        uint32_t right    = m_nodes[nodeIndex].childOrLight;
+        float leftWeight  = importance(m_nodes[left], position, normal);
+        float rightWeight = importance(m_nodes[right], position, normal);
+        if (leftWeight + rightWeight <= 0.0f)
+            return false;
+
+        float pLeft = leftWeight / (leftWeight + rightWeight);
+        if (u < pLeft) {
+            nodeIndex = left;
+            pmf *= pLeft;
+            u = std::min(u / pLeft, kOneMinusEpsilon);
+        } else {
+            nodeIndex = right;
+            pmf *= 1.0f - pLeft;
+            u = std::min((u - pLeft) / (1.0f - pLeft), kOneMinusEpsilon);
+        }
+    }
+
+    lightIndex = m_nodes[nodeIndex].childOrLight & ~LIGHT_BVH_LEAF;
+    return true;
+}
+
+} // namespace vuren
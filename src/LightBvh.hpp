@@ -0,0 +1,57 @@
+#ifndef LIGHT_BVH_HPP
+#define LIGHT_BVH_HPP
+
+#include "Common.hpp"
+
+#include <vector>
+
+namespace vuren {
+
+// hierarchy over the scene's lights for sampling one of many (Conty Estevez and Kulla 2018, "Importance sampling of
+// many lights with adaptive tree splitting"). every node bounds the positions, power and emission directions of its
+// lights. a shading point walks down from the root and picks each child in proportion to an upper bound of its
+// contribution (importance), rescaling a single random number at every level, so a sample costs O(log n).
+// built on the cpu with a binned surface area orientation heuristic, one light per leaf.
+class LightBvh {
+public:
+    LightBvh() {}
+    ~LightBvh() {}
+
+    void build(const std::vector<Light> &lights);
+
+    // refits the leaves of the moved lights and their ancestors, keeping the topology, and appends the updated node
+    // indices to updatedNodes. returns true when the refit has made the tree too much worse than a fresh build, the
+    // tree is then rebuilt and every node has changed.
+    bool refit(const std::vector<Light> &lights, const std::vector<uint32_t> &movedLights,
+               std::vector<uint32_t> &updatedNodes);
+
+    const std::vector<LightBvhNode> &getNodes() const { return m_nodes; }
+    uint32_t getRebuildCount() const { return m_rebuildCount; }
+
+    // an upper bound of the lights' contribution to a surface at position facing normal, 0 when none can reach it.
+    // mirrors pt.rgen
+    static float importance(const LightBvhNode &node, const vec3 &position, const vec3 &normal);
+
+    // walks down the tree with u in [0, 1). returns false when no light can reach the surface.
+    bool sample(const vec3 &position, const vec3 &normal, float u, uint32_t &lightIndex, float &pmf) const;
+
+private:
+    static constexpr uint32_t kNoParent = ~0u;
+
+    void setLeaf(uint32_t nodeIndex, const Light &light, uint32_t lightIndex);
+    void mergeChildren(uint32_t nodeIndex);
+
+    std::vector<LightBvhNode> m_nodes;
+    std::vector<uint32_t> m_parents;     // kNoParent for the root
+    std::vector<uint32_t> m_lightLeaves; // the leaf of every light
+
+    // surface area orientation cost of every inner node (0 for leaves), the tree's cost is their sum
+    std::vector<float> m_nodeCosts;
+    double m_cost{ 0.0 };
+    double m_builtCost{ 0.0 };
+    uint32_t m_rebuildCount{ 0 };
+};
+
+} // namespace vuren
+
+#endif // LIGHT_BVH_HPP
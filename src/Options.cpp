@@ -0,0 +1,296 @@
+#include "Options.hpp"
+#include "CommonShaders/RayStats.h"
+
+#include <cctype>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+
+namespace vuren {
+
+static const char *nextArgument(int argc, char *argv[], int &i) {
+    if (i + 1 >= argc)
+        throw std::runtime_error(std::string("missing value for option ") + argv[i]);
+    return argv[++i];
+}
+
+static uint32_t parseUint(const char *value, const char *option, bool allowZero = false) {
+    try {
+        // stoul skips whitespace and wraps negative numbers around, so only plain digits are accepted
+        if (!std::isdigit(static_cast<unsigned char>(value[0])))
+            throw std::invalid_argument(option);
+        size_t length        = 0;
+        unsigned long parsed = std::stoul(value, &length);
+        if (value[length] != '\0' || parsed > std::numeric_limits<uint32_t>::max() || (parsed == 0 && !allowZero))
+            throw std::out_of_range(option);
+        return static_cast<uint32_t>(parsed);
+    } catch (const std::exception &) {
+        throw std::runtime_error(std::string("invalid value for option ") + option + ": " + value);
+    }
+}
+
+static float parseFloat(const char *value, const char *option) {
+    try {
+        return std::stof(value);
+    } catch (const std::exception &) {
+        throw std::runtime_error(std::string("invalid value for option ") + option + ": " + value);
+    }
+}
+
+Options parseOptions(int argc, char *argv[]) {
+    Options options;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+
+        if (arg == "-h" || arg == "--help") {
+            options.help = true;
+        } else if (arg == "--headless") {
+            options.headless = true;
+        } else if (arg == "--cpu") {
+            options.headless = true;
+            options.cpu      = true;
+        } else if (arg == "--width") {
+            options.width = parseUint(nextArgument(argc, argv, i), "--width");
+        } else if (arg == "--height") {
+            options.height = parseUint(nextArgument(argc, argv, i), "--height");
+        } else if (arg == "--spp") {
+            options.spp = parseUint(nextArgument(argc, argv, i), "--spp");
+        } else if (arg == "--denoise") {
+            options.denoise = true;
+        } else if (arg == "--reference") {
+            options.referencePath = nextArgument(argc, argv, i);
+        } else if (arg == "--convergence") {
+            options.convergencePath = nextArgument(argc, argv, i);
+        } else if (arg == "--direct-lighting") {
+            options.directLighting = nextArgument(argc, argv, i);
+            if (options.directLighting != "nee" && options.directLighting != "unshadowed" &&
+                options.directLighting != "light-bvh")
+                throw std::runtime_error("invalid value for option --direct-lighting: " + options.directLighting);
+        } else if (arg == "--light") {
+            // position.xyz intensity
+            float values[4];
+            for (int c = 0; c < 4; ++c)
+                values[c] = parseFloat(nextArgument(argc, argv, i), "--light");
+            options.lights.push_back({ .pos       = glm::vec3(values[0], values[1], values[2]),
+                                       .type      = LIGHT_TYPE_POINT,
+                                       .intensity = glm::vec3(values[3]),
+                                       .pad       = 0.0f });
+        } else if (arg == "--random-lights") {
+            options.randomLights = parseUint(nextArgument(argc, argv, i), "--random-lights");
+        } else if (arg == "--animate-lights") {
+            options.animateLights = true;
+        } else if (arg == "--bvh-builder") {
+            options.bvhBuilder = nextArgument(argc, argv, i);
+            if (options.bvhBuilder != "binned" && options.bvhBuilder != "sbvh")
+                throw std::runtime_error("invalid value for option --bvh-builder: " + options.bvhBuilder);
+        } else if (arg == "--bvh-layout") {
+            options.bvhLayout = nextArgument(argc, argv, i);
+            if (options.bvhLayout != "float" && options.bvhLayout != "quantized")
+                throw std::runtime_error("invalid value for option --bvh-layout: " + options.bvhLayout);
+        } else if (arg == "--max-depth") {
+            options.maxDepth = parseUint(nextArgument(argc, argv, i), "--max-depth");
+            if (options.maxDepth > RAY_STATS_MAX_BOUNCES)
+                throw std::runtime_error("invalid value for option --max-depth: at most " +
+                                         std::to_string(RAY_STATS_MAX_BOUNCES));
+        } else if (arg == "--sampler") {
+            options.sampler = nextArgument(argc, argv, i);
+            if (options.sampler != "sobol" && options.sampler != "rank1" && options.sampler != "independent")
+                throw std::runtime_error("invalid value for option --sampler: " + options.sampler);
+        } else if (arg == "--adaptive") {
+            options.adaptiveThreshold = parseFloat(nextArgument(argc, argv, i), "--adaptive");
+            if (options.adaptiveThreshold <= 0.0f)
+                throw std::runtime_error("invalid value for option --adaptive: the error threshold must be positive");
+        } else if (arg == "--adaptive-min-spp") {
+            options.adaptiveMinSpp = parseUint(nextArgument(argc, argv, i), "--adaptive-min-spp");
+            if (options.adaptiveMinSpp < 2)
+                throw std::runtime_error("invalid value for option --adaptive-min-spp: the variance needs 2 samples");
+        } else if (arg == "--restir") {
+            options.restir = true;
+        } else if (arg == "--scene") {
+            options.scenePath = nextArgument(argc, argv, i);
+        } else if (arg == "-o" || arg == "--output") {
+            options.outputPath = nextArgument(argc, argv, i);
+        } else if (arg == "--capture") {
+            options.captureDirectory = nextArgument(argc, argv, i);
+        } else if (arg == "--capture-format") {
+            options.captureFormat = nextArgument(argc, argv, i);
+            if (options.captureFormat != "png" && options.captureFormat != "exr" && options.captureFormat != "pfm" &&
+                options.captureFormat != "raw")
+                throw std::runtime_error("invalid value for option --capture-format: " + options.captureFormat);
+        } else if (arg == "--capture-texture") {
+            options.captureTexture = nextArgument(argc, argv, i);
+        } else if (arg == "--capture-ring") {
+            options.captureRingSize = parseUint(nextArgument(argc, argv, i), "--capture-ring");
+        } else if (arg == "--video") {
+            options.videoPath = nextArgument(argc, argv, i);
+        } else if (arg == "--video-format") {
+            options.videoFormat = nextArgument(argc, argv, i);
+            if (options.videoFormat != "y4m" && options.videoFormat != "rgb")
+                throw std::runtime_error("invalid value for option --video-format: " + options.videoFormat);
+        } else if (arg == "--video-texture") {
+            options.videoTexture = nextArgument(argc, argv, i);
+        } else if (arg == "--video-fps") {
+            options.videoFps = parseUint(nextArgument(argc, argv, i), "--video-fps");
+        } else if (arg == "--benchmark") {
+            options.benchmarkPath = nextArgument(argc, argv, i);
+            options.headless      = true;
+        } else if (arg == "--camera-path") {
+            options.cameraPathFile = nextArgument(argc, argv, i);
+        } else if (arg == "--warmup") {
+            options.warmupFrames = parseUint(nextArgument(argc, argv, i), "--warmup", true);
+        } else if (arg == "--frames") {
+            options.benchmarkFrames = parseUint(nextArgument(argc, argv, i), "--frames");
+        } else if (arg == "--record-camera") {
+            options.recordCameraPath = nextArgument(argc, argv, i);
+        } else if (arg == "--seed") {
+            options.seed    = parseUint(nextArgument(argc, argv, i), "--seed", true);
+            options.hasSeed = true;
+        } else if (arg == "--trace") {
+            options.tracePath = nextArgument(argc, argv, i);
+        } else if (arg == "--pipeline-cache") {
+            options.pipelineCachePath = nextArgument(argc, argv, i);
+        } else if (arg == "--no-pipeline-cache") {
+            options.pipelineCachePath.clear();
+        } else if (arg == "--serial-pipelines") {
+            options.serialPipelines = true;
+        } else if (arg == "--hot-reload") {
+            options.hotReload = true;
+        } else if (arg == "--fused-present") {
+            options.fusedPresent = true;
+        } else if (arg == "--blas-build") {
+            options.blasBuild = nextArgument(argc, argv, i);
+            if (options.blasBuild != "fast-trace" && options.blasBuild != "fast-build")
+                throw std::runtime_error("invalid value for option --blas-build: " + options.blasBuild);
+        } else if (arg == "--ray-stats") {
+            options.rayStats = true;
+        } else if (arg == "--camera") {
+            // eye.xyz center.xyz
+            float values[6];
+            for (int c = 0; c < 6; ++c)
+                values[c] = parseFloat(nextArgument(argc, argv, i), "--camera");
+            options.eye       = glm::vec3(values[0], values[1], values[2]);
+            options.center    = glm::vec3(values[3], values[4], values[5]);
+            options.hasCamera = true;
+        } else if (arg == "--up") {
+            float values[3];
+            for (int c = 0; c < 3; ++c)
+                values[c] = parseFloat(nextArgument(argc, argv, i), "--up");
+            options.up = glm::vec3(values[0], values[1], values[2]);
+        } else if (arg == "--fov") {
+            options.fovY = parseFloat(nextArgument(argc, argv, i), "--fov");
+        } else {
+            throw std::runtime_error("unknown option: " + arg + " (see --help)");
+        }
+    }
+
+    if (!options.benchmarkPath.empty() && options.cpu)
+        throw std::runtime_error("--benchmark measures the vulkan renderer and cannot be combined with --cpu");
+
+    if (options.denoise && !options.cpu)
+        throw std::runtime_error("--denoise applies to the cpu renderer and needs --cpu");
+
+    if (options.bvhBuilder != "binned" && !options.cpu)
+        throw std::runtime_error("--bvh-builder applies to the cpu renderer and needs --cpu");
+
+    if (options.bvhLayout != "float" && !options.cpu)
+        throw std::runtime_error("--bvh-layout applies to the cpu renderer and needs --cpu");
+
+    if (!options.referencePath.empty() && (!options.headless || !options.benchmarkPath.empty()))
+        throw std::runtime_error("--reference compares the headless render and needs --headless or --cpu");
+
+    if (!options.convergencePath.empty() && options.referencePath.empty())
+        throw std::runtime_error("--convergence measures the rmse against a reference and needs --reference");
+
+    if (options.restir && options.cpu)
+        throw std::runtime_error("--restir has no cpu renderer and cannot be combined with --cpu");
+
+    if (options.adaptiveThreshold > 0.0f && (options.cpu || options.restir))
+        throw std::runtime_error("--adaptive samples the gpu path tracer and cannot be combined with --cpu or "
+                                 "--restir");
+
+    if (options.restir && options.rayStats)
+        throw std::runtime_error("--ray-stats counts the path tracer's rays and cannot be combined with --restir");
+
+    if (options.fusedPresent && (options.headless || !options.benchmarkPath.empty()))
+        throw std::runtime_error("--fused-present writes to the swap chain and needs the interactive mode, which "
+                                 "prints its present time on exit");
+
+    if (options.animateLights && (options.headless || !options.benchmarkPath.empty()))
+        throw std::runtime_error("--animate-lights needs the interactive mode");
+
+    return options;
+}
+
+void printUsage() {
+    std::cout << "usage: vuren [options]\n"
+                 "\n"
+                 "  -h, --help                 show this message\n"
+                 "  --headless                 render offscreen without a window and write the result to a file\n"
+                 "  --cpu                      headless rendering with the cpu reference renderer\n"
+                 "  --width <n>                image width (default: "
+              << kWidth
+              << ")\n"
+                 "  --height <n>               image height (default: "
+              << kHeight
+              << ")\n"
+                 "  --spp <n>                  samples per pixel in headless mode (default: 64)\n"
+                 "  --denoise                  filter the cpu render with an edge-avoiding a-trous denoiser\n"
+                 "  --reference <file.pfm>     print the rmse of the headless render against a converged reference\n"
+                 "  --convergence <file.csv>   write the rmse against --reference after 1, 2, 4... samples per pixel\n"
+                 "                             and after spp, with the render time\n"
+                 "  --direct-lighting <mode>   nee (one light by power, shadowed), light-bvh (one light from the\n"
+                 "                             light hierarchy, shadowed) or unshadowed (every light, no visibility\n"
+                 "                             test) (default: nee)\n"
+                 "  --light <x> <y> <z> <i>    add a point light of intensity i, the scene's lights are replaced\n"
+                 "  --random-lights <n>        replace the scene's lights by n dim ones scattered around it, the\n"
+                 "                             --light ones are kept\n"
+                 "  --animate-lights           move every eighth light and refit the light bvh each frame\n"
+                 "                             (interactive mode)\n"
+                 "  --bvh-builder <type>       bvh of the cpu renderer: binned (object splits) or sbvh (spatial\n"
+                 "                             splits of long, thin triangles as well) (default: binned)\n"
+                 "  --bvh-layout <type>        bvh nodes of the cpu renderer: float (binary) or quantized (4-wide,\n"
+                 "                             8 bit child bounds, packed triangles) (default: float)\n"
+                 "  --max-depth <n>            path vertices of the path tracers, 1 for direct lighting only\n"
+                 "                             (default: 4)\n"
+                 "  --sampler <type>           sobol (Owen-scrambled), rank1 (lattice dithered by a blue-noise\n"
+                 "                             mask) or independent (white noise) (default: sobol)\n"
+                 "  --adaptive <error>         adaptive sampling of the gpu path tracer: pixels stop getting paths\n"
+                 "                             once the standard error of their mean is below this fraction of it,\n"
+                 "                             e.g. 0.02. headless renders stop once every pixel is there\n"
+                 "  --adaptive-min-spp <n>     samples of every pixel before its error is trusted (default: 16)\n"
+                 "  --restir                   replace the path traced frame by the direct lighting resampled\n"
+                 "                             spatiotemporally from per-pixel reservoirs (ReSTIR, gpu only)\n"
+                 "  --scene <file.obj>         render an obj model instead of the default scene\n"
+                 "  -o, --output <file>        output image, .png/.pfm/.exr (default: output.png)\n"
+                 "  --camera <eye> <center>    camera position and target, 6 floats\n"
+                 "  --up <x> <y> <z>           camera up vector (default: 0 1 0)\n"
+                 "  --fov <degrees>            vertical field of view (default: 45)\n"
+                 "  --capture <dir>            write every rendered frame into dir (gpu only)\n"
+                 "  --capture-format <ext>     png, exr, pfm or raw (default: png)\n"
+                 "  --capture-texture <name>   offscreen output texture to capture (default: AccumOutput)\n"
+                 "  --capture-ring <n>         readback buffers in flight before frames are dropped (default: 4)\n"
+                 "  --video <path>             stream frames as 8-bit video to a file or named pipe, - for stdout\n"
+                 "  --video-format <fmt>       y4m or rgb (raw rgb24) (default: y4m)\n"
+                 "  --video-texture <name>     offscreen output texture to stream (default: AccumOutput)\n"
+                 "  --video-fps <n>            frame rate stored in the y4m header (default: 60)\n"
+                 "  --benchmark <file.json>    replay a camera path offscreen and write frame time statistics\n"
+                 "  --camera-path <file>       keyframes replayed by --benchmark (default: an orbit)\n"
+                 "  --warmup <n>               frames rendered before measuring (default: 60)\n"
+                 "  --frames <n>               frames measured by --benchmark (default: 600)\n"
+                 "  --record-camera <file>     press k to add a camera keyframe, the path is saved on exit\n"
+                 "  --seed <n>                 seed of the instance placement (default: 0 when headless, else random)\n"
+                 "  --trace <file.json>        write a chrome trace of cpu zones and gpu passes on exit\n"
+                 "  --pipeline-cache <file>    pipeline cache loaded at startup and saved on exit\n"
+                 "                             (default: pipeline_cache.bin)\n"
+                 "  --no-pipeline-cache        compile every pipeline from scratch and keep nothing\n"
+                 "  --serial-pipelines         create the pipelines one after another, as a startup baseline\n"
+                 "  --hot-reload               recompile edited glsl sources and rebuild the affected pipelines\n"
+                 "  --fused-present            accumulate, tone map and present in one compute dispatch, the gui is\n"
+                 "                             drawn over the copied image (shows the accumulation only)\n"
+                 "  --blas-build <mode>        BLAS builder preference, fast-trace (higher quality tree) or\n"
+                 "                             fast-build (shorter build) (default: fast-trace)\n"
+                 "  --ray-stats                count traced rays in the path tracer, shows Mrays/s and path length\n";
+}
+
+} // namespace vuren
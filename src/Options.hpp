@@ -0,0 +1,123 @@
+#ifndef OPTIONS_HPP
+#define OPTIONS_HPP
+
+#include "Common.hpp"
+
+#include <string>
+#include <vector>
+
+namespace vuren {
+
+// command-line options of the vuren executable
+struct Options {
+    bool help{ false };
+
+    // render offscreen without glfw, a surface or a swap chain, then write the accumulated image to a file
+    bool headless{ false };
+    // use the cpu reference renderer instead of the vulkan pass chain (headless only)
+    bool cpu{ false };
+
+    uint32_t width{ kWidth };
+    uint32_t height{ kHeight };
+    uint32_t spp{ 64 }; // frames to accumulate in headless mode, one path per pixel each
+
+    // filter the cpu render with the edge-avoiding a-trous denoiser before writing it
+    bool denoise{ false };
+    // pfm rendered with many more samples, the rmse of the output against it is printed (headless only)
+    std::string referencePath;
+    // csv of the rmse against the reference after 1, 2, 4... samples per pixel and spp, with the render time so far
+    std::string convergencePath;
+
+    // direct lighting of both path tracers: "nee" picks one light by power and traces a shadow ray towards it,
+    // "light-bvh" picks it by its bound contribution from the light bvh, "unshadowed" adds every light without any
+    // visibility test
+    std::string directLighting{ "nee" };
+    // point lights replacing the scene's
+    std::vector<Light> lights;
+    // point lights with the same total power scattered around the scene, replacing the scene's (not the ones above)
+    uint32_t randomLights{ 0 };
+    // move a part of the lights every frame and refit the light bvh (interactive mode)
+    bool animateLights{ false };
+    // builder of the cpu renderer's bvh: "binned" (object splits) or "sbvh" (spatial splits as well)
+    std::string bvhBuilder{ "binned" };
+    // node layout of the cpu renderer's bvh: "float" (binary, float bounds) or "quantized" (4-wide, 8 bit bounds)
+    std::string bvhLayout{ "float" };
+    // path vertices of both path tracers, 1 for the direct lighting only
+    uint32_t maxDepth{ 4 };
+    // sample points of both path tracers: "sobol" (Owen-scrambled), "rank1" (a lattice dithered by a blue-noise mask)
+    // or "independent" (white noise)
+    std::string sampler{ "sobol" };
+    // adaptive sampling of the gpu path tracer, disabled while 0: while the view is still, a pixel only gets paths
+    // until the standard error of its mean luminance is below this fraction of it, after at least adaptiveMinSpp.
+    // headless renders stop once every pixel is there, spp is the most any pixel gets.
+    float adaptiveThreshold{ 0.0f };
+    uint32_t adaptiveMinSpp{ 16 };
+    // the direct lighting resampled from the reservoirs of the last frame and of the neighbors (ReSTIR) in place of
+    // the path tracer's frame (gpu only)
+    bool restir{ false };
+
+    std::string scenePath;                 // obj file to render instead of the default scene
+    std::string outputPath{ "output.png" }; // .png, .pfm or .exr
+
+    // continuous frame capture, disabled while captureDirectory is empty
+    std::string captureDirectory;
+    std::string captureFormat{ "png" };          // png, exr, pfm or raw
+    std::string captureTexture{ "AccumOutput" }; // any offscreen output texture
+    uint32_t captureRingSize{ 4 };               // readback buffers in flight before frames get dropped
+
+    // raw video stream, disabled while videoPath is empty
+    std::string videoPath;                     // "-" for stdout, or a file / named pipe
+    std::string videoFormat{ "y4m" };          // y4m or rgb
+    std::string videoTexture{ "AccumOutput" }; // any offscreen output texture
+    uint32_t videoFps{ 60 };                   // frame rate written into the y4m header
+
+    // replay a camera path offscreen and write frame time statistics, disabled while benchmarkPath is empty
+    std::string benchmarkPath;  // json report
+    std::string cameraPathFile; // keyframes to replay, the example orbit when empty
+    uint32_t warmupFrames{ 60 };
+    uint32_t benchmarkFrames{ 600 };
+
+    // append a keyframe with the k key and save the path on exit (interactive mode)
+    std::string recordCameraPath;
+
+    // instance placement, fixed for headless and benchmark runs
+    bool hasSeed{ false };
+    uint32_t seed{ 0 };
+
+    // pipeline cache kept between launches, disabled while empty
+    std::string pipelineCachePath{ "pipeline_cache.bin" };
+
+    // create the pipelines one after another on the main thread instead of overlapping them with the rest of startup
+    bool serialPipelines{ false };
+
+    // chrome trace json of the cpu profiler zones and per-pass gpu timings, written on exit
+    std::string tracePath;
+
+    // recompile the shaders edited in the source tree and swap the pipelines in while running (interactive mode)
+    bool hotReload{ false };
+
+    // accumulate, tone map and encode in one compute dispatch and copy the result to the swap chain, in place of the
+    // fullscreen final pass (interactive mode, the displayed output is fixed to the accumulation)
+    bool fusedPresent{ false };
+
+    // builder preference of the BLAS (gpu only): "fast-trace" for a higher quality tree, "fast-build" for a
+    // shorter build
+    std::string blasBuild{ "fast-trace" };
+
+    // instrumented path tracing shaders counting rays per bounce (fixed at startup, the pipeline is built once)
+    bool rayStats{ false };
+
+    bool hasCamera{ false };
+    glm::vec3 eye{ 0.0f, 2.0f, 2.0f };
+    glm::vec3 center{ 0.0f, 0.0f, 0.0f };
+    glm::vec3 up{ 0.0f, 1.0f, 0.0f };
+    float fovY{ 45.0f };
+};
+
+Options parseOptions(int argc, char *argv[]);
+
+void printUsage();
+
+} // namespace vuren
+
+#endif // OPTIONS_HPP
@@ -0,0 +1,134 @@
+#include "PipelineCache.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+namespace vuren {
+
+void PipelineCache::init(VulkanContext *pContext, const std::string &filename) {
+    m_pContext = pContext;
+    m_filename = filename;
+
+    std::vector<char> initialData;
+    if (!m_filename.empty())
+        initialData = loadValidated();
+    m_warm = !initialData.empty();
+
+    vk::PipelineCacheCreateInfo createInfo{ .initialDataSize = initialData.size(),
+                                            .pInitialData    = initialData.data() };
+    if (m_pContext->m_device.createPipelineCache(&createInfo, nullptr, &m_pipelineCache) != vk::Result::eSuccess) {
+        throw std::runtime_error("failed to create pipeline cache!");
+    }
+}
+
+void PipelineCache::cleanup() {
+    if (!m_pipelineCache)
+        return;
+
+    if (!m_filename.empty())
+        save();
+    m_pContext->m_device.destroyPipelineCache(m_pipelineCache, nullptr);
+    m_pipelineCache = VK_NULL_HANDLE;
+
+    if (m_creationTimes.empty())
+        return;
+
+    double totalMs = 0.0;
+    std::cout << "pipeline creation (" << (m_warm ? "warm" : "cold") << " cache), ms" << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+    for (auto &[name, ms]: m_creationTimes) {
+        std::cout << "  " << std::setw(10) << ms << "  " << name << std::endl;
+        totalMs += ms;
+    }
+    std::cout << "  " << std::setw(10) << totalMs << "  total" << std::endl;
+    std::cout << std::defaultfloat;
+}
+
+void PipelineCache::addCreationTime(const std::string &pipelineName, double ms) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_creationTimes.push_back({ pipelineName, ms });
+}
+
+// the data starts with VkPipelineCacheHeaderVersionOne. the driver checks it too, but silently ignores a
+// mismatch, and we want to know why a cache was thrown away.
+std::vector<char> PipelineCache::loadValidated() {
+    std::ifstream file(m_filename, std::ios::ate | std::ios::binary);
+    if (!file.is_open()) {
+        std::cout << "pipeline cache: " << m_filename << " not found, starting cold" << std::endl;
+        return {};
+    }
+
+    std::vector<char> data(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(data.data(), data.size());
+
+    VkPipelineCacheHeaderVersionOne header;
+    if (!file || data.size() < sizeof(header)) {
+        std::cerr << "pipeline cache: " << m_filename << " is truncated, starting cold" << std::endl;
+        return {};
+    }
+    std::memcpy(&header, data.data(), sizeof(header));
+
+    vk::PhysicalDeviceProperties properties = m_pContext->m_physicalDevice.getProperties();
+    const char *mismatch                    = nullptr;
+    if (header.headerSize < sizeof(header) || header.headerSize > data.size())
+        mismatch = "header size";
+    else if (header.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE)
+        mismatch = "header version";
+    else if (header.vendorID != properties.vendorID)
+        mismatch = "vendor";
+    else if (header.deviceID != properties.deviceID)
+        mismatch = "device";
+    else if (std::memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID.data(), VK_UUID_SIZE) != 0)
+        mismatch = "cache uuid (driver version)";
+
+    if (mismatch) {
+        std::cout << "pipeline cache: " << m_filename << " does not match this device (" << mismatch
+                  << "), starting cold" << std::endl;
+        return {};
+    }
+
+    std::cout << "pipeline cache: loaded " << data.size() << " bytes from " << m_filename << std::endl;
+    return data;
+}
+
+void PipelineCache::save() {
+    size_t dataSize = 0;
+    if (m_pContext->m_device.getPipelineCacheData(m_pipelineCache, &dataSize, nullptr) != vk::Result::eSuccess) {
+        std::cerr << "pipeline cache: failed to query the cache size, not saved" << std::endl;
+        return;
+    }
+
+    std::vector<char> data(dataSize);
+    if (m_pContext->m_device.getPipelineCacheData(m_pipelineCache, &dataSize, data.data()) != vk::Result::eSuccess) {
+        std::cerr << "pipeline cache: failed to read the cache, not saved" << std::endl;
+        return;
+    }
+    data.resize(dataSize);
+
+    std::string tempFilename = m_filename + ".tmp";
+    {
+        std::ofstream file(tempFilename, std::ios::binary | std::ios::trunc);
+        file.write(data.data(), data.size());
+        if (!file) {
+            std::cerr << "pipeline cache: failed to write " << tempFilename << std::endl;
+            return;
+        }
+    }
+
+    // rename replaces the old cache in one step
+    std::error_code error;
+    std::filesystem::rename(tempFilename, m_filename, error);
+    if (error) {
+        std::cerr << "pipeline cache: failed to replace " << m_filename << ": " << error.message() << std::endl;
+        std::filesystem::remove(tempFilename, error);
+        return;
+    }
+
+    std::cout << "pipeline cache: saved " << data.size() << " bytes to " << m_filename << std::endl;
+}
+
+} // namespace vuren
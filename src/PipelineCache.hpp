@@ -0,0 +1,55 @@
+#ifndef PIPELINE_CACHE_HPP
+#define PIPELINE_CACHE_HPP
+
+#define VULKAN_HPP_NO_CONSTRUCTORS
+#define VULKAN_HPP_DISPATCH_LOADER_DYNAMIC 1
+#include <vulkan/vulkan.hpp>
+
+#include "Common.hpp"
+#include "VulkanContext.hpp"
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace vuren {
+
+// a VkPipelineCache shared by every pipeline creation and kept on disk between launches.
+// the file is only used if its header matches the current device (vendor, device and cache uuid), since a driver
+// update or another gpu makes the data useless. it is written to a temporary file first and then renamed over
+// the old one, so a crash while saving never leaves a truncated cache behind.
+class PipelineCache {
+public:
+    PipelineCache() {}
+    ~PipelineCache() {}
+
+    // an empty filename gives an in-memory cache that is never saved
+    void init(VulkanContext *pContext, const std::string &filename);
+
+    // saves the cache and prints the pipeline creation times
+    void cleanup();
+
+    vk::PipelineCache get() const { return m_pipelineCache; }
+
+    // whether the cache was loaded from disk, i.e. the creation times are warm
+    bool isWarm() const { return m_warm; }
+
+    // called by the render passes, may be called from several threads
+    void addCreationTime(const std::string &pipelineName, double ms);
+
+private:
+    std::vector<char> loadValidated();
+    void save();
+
+    VulkanContext *m_pContext{ nullptr };
+    vk::PipelineCache m_pipelineCache{ VK_NULL_HANDLE };
+    std::string m_filename;
+    bool m_warm{ false };
+
+    std::mutex m_mutex;
+    std::vector<std::pair<std::string, double>> m_creationTimes;
+};
+
+} // namespace vuren
+
+#endif // PIPELINE_CACHE_HPP
@@ -0,0 +1,225 @@
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace vuren {
+
+namespace {
+
+struct Zone {
+    const char *name;
+    uint64_t startNs;
+    uint64_t endNs;
+    uint32_t depth;
+};
+
+struct ThreadBuffer {
+    uint32_t tid{ 0 };
+    std::string name;
+    std::unique_ptr<Zone[]> zones;
+    std::atomic<uint64_t> written{ 0 };
+    uint32_t depth{ 0 };
+};
+
+const std::chrono::steady_clock::time_point kEpoch = std::chrono::steady_clock::now();
+
+// buffers are shared with the registry, so the zones of a finished thread can still be dumped
+std::mutex gRegistryMutex;
+std::vector<std::shared_ptr<ThreadBuffer>> gThreadBuffers;
+thread_local ThreadBuffer *tThreadBuffer = nullptr;
+
+ThreadBuffer &getThreadBuffer() {
+    if (!tThreadBuffer) {
+        auto pBuffer   = std::make_shared<ThreadBuffer>();
+        pBuffer->zones = std::make_unique<Zone[]>(Profiler::kRingSize);
+
+        std::lock_guard<std::mutex> lock(gRegistryMutex);
+        pBuffer->tid  = static_cast<uint32_t>(gThreadBuffers.size());
+        pBuffer->name = "thread " + std::to_string(pBuffer->tid);
+        gThreadBuffers.push_back(pBuffer);
+        tThreadBuffer = pBuffer.get();
+    }
+    return *tThreadBuffer;
+}
+
+// the zones still in a thread's ring, oldest first
+std::vector<Zone> readZones(const ThreadBuffer &buffer, uint64_t fromNs, uint64_t toNs) {
+    uint64_t written = buffer.written.load(std::memory_order_acquire);
+    uint64_t first   = written > Profiler::kRingSize ? written - Profiler::kRingSize : 0;
+
+    std::vector<Zone> zones;
+    for (uint64_t i = first; i < written; ++i) {
+        const Zone &zone = buffer.zones[i % Profiler::kRingSize];
+        if (zone.startNs >= fromNs && zone.endNs <= toNs)
+            zones.push_back(zone);
+    }
+    return zones;
+}
+
+void writeJsonString(std::ostream &out, const std::string &text) {
+    out << '"';
+    for (char c: text) {
+        if (c == '"' || c == '\\')
+            out << '\\';
+        out << c;
+    }
+    out << '"';
+}
+
+} // namespace
+
+uint64_t Profiler::now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - kEpoch).count();
+}
+
+void Profiler::setThreadName(const std::string &name) {
+    ThreadBuffer &buffer = getThreadBuffer();
+    std::lock_guard<std::mutex> lock(gRegistryMutex);
+    buffer.name = name;
+}
+
+uint32_t Profiler::enterZone() { return getThreadBuffer().depth++; }
+
+void Profiler::leaveZone(const char *name, uint64_t startNs, uint32_t depth) {
+    uint64_t endNs       = now();
+    ThreadBuffer &buffer = getThreadBuffer();
+    buffer.depth         = depth;
+
+    // single writer: only the reader needs the ordering
+    uint64_t index                  = buffer.written.load(std::memory_order_relaxed);
+    buffer.zones[index % kRingSize] = { name, startNs, endNs, depth };
+    buffer.written.store(index + 1, std::memory_order_release);
+}
+
+void Profiler::printBreakdown(std::ostream &out, const std::string &title, uint64_t fromNs, uint64_t toNs) {
+    struct PathStats {
+        std::string name;
+        uint32_t depth;
+        uint64_t totalNs{ 0 };
+        uint64_t childNs{ 0 };
+        uint32_t calls{ 0 };
+    };
+
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    {
+        std::lock_guard<std::mutex> lock(gRegistryMutex);
+        buffers = gThreadBuffers;
+    }
+
+    double windowMs = (toNs - fromNs) * 1e-6;
+    bool printed    = false;
+
+    for (auto &pBuffer: buffers) {
+        std::vector<Zone> zones = readZones(*pBuffer, fromNs, toNs);
+        if (zones.empty())
+            continue;
+
+        // zones are recorded when they close, children first. sorted by start, a parent comes before its children.
+        std::sort(zones.begin(), zones.end(), [](const Zone &a, const Zone &b) {
+            return a.startNs != b.startNs ? a.startNs < b.startNs : a.depth < b.depth;
+        });
+
+        std::vector<PathStats> paths;
+        std::unordered_map<std::string, size_t> pathIndices;
+        std::vector<std::pair<uint32_t, size_t>> stack; // depth, path index
+
+        for (auto &zone: zones) {
+            while (!stack.empty() && stack.back().first >= zone.depth)
+                stack.pop_back();
+
+            std::string path = stack.empty() ? zone.name : paths[stack.back().second].name + "/" + zone.name;
+            auto it          = pathIndices.find(path);
+            if (it == pathIndices.end()) {
+                it = pathIndices.emplace(path, paths.size()).first;
+                paths.push_back({ .name = path, .depth = static_cast<uint32_t>(stack.size()) });
+            }
+
+            uint64_t durationNs = zone.endNs - zone.startNs;
+            paths[it->second].totalNs += durationNs;
+            paths[it->second].calls++;
+            if (!stack.empty())
+                paths[stack.back().second].childNs += durationNs;
+
+            stack.push_back({ zone.depth, it->second });
+        }
+
+        if (!printed) {
+            out << title << " breakdown, " << std::fixed << std::setprecision(1) << windowMs << " ms" << std::endl;
+            printed = true;
+        }
+        out << "  [" << pBuffer->name << "]" << std::endl;
+        out << "  " << std::setw(10) << "total ms" << std::setw(10) << "self ms" << std::setw(8) << "%"
+            << std::setw(8) << "calls" << "  zone" << std::endl;
+
+        // children are listed right after their parent since paths are created in start order
+        for (auto &path: paths) {
+            size_t slash     = path.name.find_last_of('/');
+            std::string leaf = slash == std::string::npos ? path.name : path.name.substr(slash + 1);
+            double totalMs   = path.totalNs * 1e-6;
+
+            out << "  " << std::setw(10) << std::setprecision(2) << totalMs << std::setw(10)
+                << (path.totalNs - std::min(path.childNs, path.totalNs)) * 1e-6 << std::setw(8)
+                << std::setprecision(1) << (windowMs > 0.0 ? totalMs / windowMs * 100.0 : 0.0) << std::setw(8)
+                << path.calls << "  " << std::string(path.depth * 2, ' ') << leaf << std::endl;
+        }
+    }
+
+    out << std::defaultfloat;
+}
+
+void Profiler::writeTrace(const std::string &filename, const std::vector<TraceEvent> &extraEvents) {
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        throw std::runtime_error("failed to open " + filename + " for writing!");
+    }
+
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    {
+        std::lock_guard<std::mutex> lock(gRegistryMutex);
+        buffers = gThreadBuffers;
+    }
+
+    // trace event format: pid 0 holds the cpu threads, pid 1 the graphics queue, times in microseconds
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,\"args\":{\"name\":\"CPU\"}},\n";
+    file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"GPU\"}}";
+    for (auto &pBuffer: buffers) {
+        file << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << pBuffer->tid
+             << ",\"args\":{\"name\":";
+        writeJsonString(file, pBuffer->name);
+        file << "}}";
+    }
+
+    size_t eventCount = 0;
+    file << std::fixed << std::setprecision(3);
+    auto writeEvent = [&](const char *name, uint64_t startNs, uint64_t durationNs, uint32_t pid, uint32_t tid) {
+        file << ",\n{\"name\":";
+        writeJsonString(file, name);
+        file << ",\"ph\":\"X\",\"pid\":" << pid << ",\"tid\":" << tid << ",\"ts\":" << startNs * 1e-3
+             << ",\"dur\":" << durationNs * 1e-3 << "}";
+        eventCount++;
+    };
+
+    for (auto &pBuffer: buffers) {
+        for (auto &zone: readZones(*pBuffer, 0, UINT64_MAX))
+            writeEvent(zone.name, zone.startNs, zone.endNs - zone.startNs, 0, pBuffer->tid);
+    }
+    for (auto &event: extraEvents)
+        writeEvent(event.name, event.startNs, event.durationNs, event.pid, event.tid);
+
+    file << "\n]}\n";
+
+    std::cout << "wrote " << eventCount << " trace events to " << filename << std::endl;
+}
+
+} // namespace vuren
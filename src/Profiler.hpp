@@ -0,0 +1,71 @@
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace vuren {
+
+// one timed interval of a chrome trace, on the Profiler::now() clock
+struct TraceEvent {
+    const char *name;
+    uint64_t startNs;
+    uint64_t durationNs;
+    uint32_t pid; // 0: cpu threads, 1: gpu queue
+    uint32_t tid;
+};
+
+// hierarchical cpu zones.
+// every thread records the zones it closes into its own ring buffer, so recording takes no lock and costs two
+// clock reads. rings are only read when dumping a breakdown or a trace, which should happen while the other
+// threads are idle. zones are placed with the VUREN_PROFILE_ZONE macro, which compiles to nothing unless the
+// build enables VUREN_ENABLE_PROFILER.
+class Profiler {
+public:
+    static constexpr uint32_t kRingSize = 1 << 16; // zones kept per thread, older ones are overwritten
+
+    // nanoseconds since the process started
+    static uint64_t now();
+
+    // shown in the breakdown and the trace instead of the thread index
+    static void setThreadName(const std::string &name);
+
+    static uint32_t enterZone();
+    static void leaveZone(const char *name, uint64_t startNs, uint32_t depth);
+
+    // total and self time of every zone closed within [fromNs, toNs], aggregated by call path, per thread
+    static void printBreakdown(std::ostream &out, const std::string &title, uint64_t fromNs, uint64_t toNs);
+
+    // writes every recorded zone, plus extraEvents (e.g. gpu timings), as chrome trace json
+    static void writeTrace(const std::string &filename, const std::vector<TraceEvent> &extraEvents = {});
+};
+
+// records a zone from its construction to the end of the enclosing scope
+class ProfileZone {
+public:
+    // the name must outlive the profiler (a string literal)
+    explicit ProfileZone(const char *name) : m_name(name), m_depth(Profiler::enterZone()), m_startNs(Profiler::now()) {}
+    ~ProfileZone() { Profiler::leaveZone(m_name, m_startNs, m_depth); }
+
+    ProfileZone(const ProfileZone &)            = delete;
+    ProfileZone &operator=(const ProfileZone &) = delete;
+
+private:
+    const char *m_name;
+    uint32_t m_depth;
+    uint64_t m_startNs;
+};
+
+} // namespace vuren
+
+#ifdef VUREN_ENABLE_PROFILER
+#define VUREN_PROFILE_CONCAT_IMPL(a, b) a##b
+#define VUREN_PROFILE_CONCAT(a, b) VUREN_PROFILE_CONCAT_IMPL(a, b)
+#define VUREN_PROFILE_ZONE(name) ::vuren::ProfileZone VUREN_PROFILE_CONCAT(profileZone, __LINE__)(name)
+#else
+#define VUREN_PROFILE_ZONE(name) ((void) 0)
+#endif
+
+#endif // PROFILER_HPP
@@ -0,0 +1,199 @@
+#include "RayStatistics.hpp"
+
+#include <imgui/imgui.h>
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+namespace vuren {
+
+uint64_t getTracedRays(const RayStats &stats) {
+    uint64_t rays = 0;
+    for (uint32_t bounce = 0; bounce < RAY_STATS_MAX_BOUNCES; ++bounce)
+        rays += stats.raysPerBounce[bounce];
+    return rays;
+}
+
+double getAveragePathLength(uint64_t tracedRays, uint64_t paths) {
+    return paths > 0 ? 1.0 + static_cast<double>(tracedRays) / paths : 0.0;
+}
+
+bool RayStatistics::supportsSubgroupReduce(const VulkanContext &context) {
+    vk::PhysicalDeviceSubgroupProperties subgroupProperties;
+    vk::PhysicalDeviceProperties2 prop2{ .pNext = &subgroupProperties };
+    context.m_physicalDevice.getProperties2(&prop2);
+
+    return (subgroupProperties.supportedStages & vk::ShaderStageFlagBits::eRaygenKHR) &&
+           (subgroupProperties.supportedOperations & vk::SubgroupFeatureFlagBits::eArithmetic);
+}
+
+void RayStatistics::init(VulkanContext *pContext, std::shared_ptr<ResourceManager> pResourceManager,
+                         const std::string &counterBufferName) {
+    m_pContext         = pContext;
+    m_pResourceManager = pResourceManager;
+    m_pCounterBuffer   = m_pResourceManager->getBuffer(counterBufferName);
+
+    vk::DeviceSize bufferSize = sizeof(RayStats) * kSlotCount;
+    m_readbackBuffer =
+        m_pResourceManager->createBuffer(bufferSize, vk::BufferUsageFlagBits::eTransferDst,
+                                         vk::MemoryPropertyFlagBits::eHostVisible |
+                                             vk::MemoryPropertyFlagBits::eHostCoherent);
+    m_pMapped = static_cast<RayStats *>(m_pContext->m_device.mapMemory(m_readbackBuffer.memory, 0, bufferSize));
+
+    m_slots.resize(kSlotCount);
+}
+
+void RayStatistics::cleanup() {
+    if (!isEnabled())
+        return;
+
+    m_pContext->m_device.unmapMemory(m_readbackBuffer.memory);
+    m_pResourceManager->destroyBuffer(m_readbackBuffer);
+    m_slots.clear();
+
+    if (m_totalFrames == 0)
+        return;
+
+    std::cout << "ray statistics: " << m_totalFrames << " frames, " << m_totalRays / m_totalFrames
+              << " rays per frame, average path length " << std::fixed << std::setprecision(2)
+              << getAveragePathLength(m_totalRays, m_totalPaths) << std::defaultfloat << std::endl;
+    if (m_droppedFrames > 0)
+        std::cout << "  " << m_droppedFrames << " frames not read back" << std::endl;
+}
+
+void RayStatistics::recordReset(vk::CommandBuffer commandBuffer) {
+    vk::Buffer buffer = m_pCounterBuffer->descriptorInfo.buffer;
+    commandBuffer.fillBuffer(buffer, 0, VK_WHOLE_SIZE, 0);
+
+    vk::BufferMemoryBarrier barrier{ .srcAccessMask       = vk::AccessFlagBits::eTransferWrite,
+                                     .dstAccessMask       = vk::AccessFlagBits::eShaderRead |
+                                                            vk::AccessFlagBits::eShaderWrite,
+                                     .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                                     .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                                     .buffer              = buffer,
+                                     .offset              = 0,
+                                     .size                = VK_WHOLE_SIZE };
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+                                  vk::PipelineStageFlagBits::eRayTracingShaderKHR, {}, 0, nullptr, 1, &barrier, 0,
+                                  nullptr);
+}
+
+void RayStatistics::recordReadback(vk::CommandBuffer commandBuffer, uint64_t frameSerial) {
+    auto it = std::find_if(m_slots.begin(), m_slots.end(), [](const Slot &slot) { return !slot.inFlight; });
+    if (it == m_slots.end()) {
+        m_droppedFrames++;
+        return;
+    }
+
+    it->inFlight    = true;
+    it->frameSerial = frameSerial;
+
+    vk::Buffer buffer = m_pCounterBuffer->descriptorInfo.buffer;
+    vk::BufferMemoryBarrier barrier{ .srcAccessMask       = vk::AccessFlagBits::eShaderWrite,
+                                     .dstAccessMask       = vk::AccessFlagBits::eTransferRead,
+                                     .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                                     .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                                     .buffer              = buffer,
+                                     .offset              = 0,
+                                     .size                = VK_WHOLE_SIZE };
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eRayTracingShaderKHR,
+                                  vk::PipelineStageFlagBits::eTransfer, {}, 0, nullptr, 1, &barrier, 0, nullptr);
+
+    vk::BufferCopy region{ .srcOffset = 0,
+                           .dstOffset = sizeof(RayStats) * static_cast<vk::DeviceSize>(it - m_slots.begin()),
+                           .size      = sizeof(RayStats) };
+    commandBuffer.copyBuffer(buffer, m_readbackBuffer.descriptorInfo.buffer, 1, &region);
+
+    // make the copied counters visible to host reads once the submission's fence has signaled
+    vk::BufferMemoryBarrier hostBarrier{ .srcAccessMask       = vk::AccessFlagBits::eTransferWrite,
+                                         .dstAccessMask       = vk::AccessFlagBits::eHostRead,
+                                         .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                                         .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                                         .buffer              = m_readbackBuffer.descriptorInfo.buffer,
+                                         .offset              = region.dstOffset,
+                                         .size                = region.size };
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eHost, {}, 0,
+                                  nullptr, 1, &hostBarrier, 0, nullptr);
+}
+
+void RayStatistics::retire(uint64_t completedSerial) {
+    std::vector<size_t> completed;
+    for (size_t i = 0; i < m_slots.size(); ++i) {
+        if (m_slots[i].inFlight && m_slots[i].frameSerial <= completedSerial)
+            completed.push_back(i);
+    }
+
+    // keep the frame counts in frame order
+    std::sort(completed.begin(), completed.end(),
+              [&](size_t a, size_t b) { return m_slots[a].frameSerial < m_slots[b].frameSerial; });
+
+    for (size_t i: completed) {
+        const RayStats &stats = m_pMapped[i];
+
+        m_history[m_historyNext] = stats;
+        m_historyNext            = (m_historyNext + 1) % kHistorySize;
+        m_historyCount           = std::min(m_historyCount + 1, kHistorySize);
+
+        m_totalFrames++;
+        m_totalRays += getTracedRays(stats);
+        m_totalPaths += stats.paths;
+
+        if (m_frameCountsEnabled)
+            m_frameCounts.push_back({ m_slots[i].frameSerial, stats });
+
+        m_slots[i].inFlight = false;
+    }
+}
+
+void RayStatistics::updateGui(float passMs) {
+    if (!isEnabled() || !ImGui::CollapsingHeader("Ray Statistics"))
+        return;
+
+    if (m_historyCount == 0) {
+        ImGui::Text(" no frames read back yet");
+        return;
+    }
+
+    // averages over the same rolling window as the gpu profiler
+    std::array<double, RAY_STATS_MAX_BOUNCES> raysPerBounce{};
+    double hits   = 0.0;
+    double misses = 0.0;
+    double paths      = 0.0;
+    double shadowRays = 0.0;
+    for (uint32_t i = 0; i < m_historyCount; ++i) {
+        for (uint32_t bounce = 0; bounce < RAY_STATS_MAX_BOUNCES; ++bounce)
+            raysPerBounce[bounce] += m_history[i].raysPerBounce[bounce];
+        hits += m_history[i].hits;
+        misses += m_history[i].misses;
+        paths += m_history[i].paths;
+        shadowRays += m_history[i].shadowRays;
+    }
+
+    double rays = 0.0;
+    for (auto &count: raysPerBounce) {
+        count /= m_historyCount;
+        rays += count;
+    }
+    hits /= m_historyCount;
+    misses /= m_historyCount;
+    paths /= m_historyCount;
+    shadowRays /= m_historyCount;
+
+    // shadow rays are traced by the same pass, so they count towards its throughput
+    if (passMs > 0.0f)
+        ImGui::Text(" %.1f Mrays/s (%.3f ms)", (rays + shadowRays) / (passMs * 1e3), passMs);
+    ImGui::Text(" %.0f rays per frame, %.1f%% hits", rays,
+                hits + misses > 0.0 ? hits / (hits + misses) * 100.0 : 0.0);
+    ImGui::Text(" %.0f shadow rays per frame", shadowRays);
+    ImGui::Text(" average path length %.2f", paths > 0.0 ? 1.0 + rays / paths : 0.0);
+    for (uint32_t bounce = 0; bounce < RAY_STATS_MAX_BOUNCES; ++bounce) {
+        if (raysPerBounce[bounce] > 0.0)
+            ImGui::Text("   bounce %u: %.0f rays", bounce + 1, raysPerBounce[bounce]);
+    }
+
+    if (m_droppedFrames > 0)
+        ImGui::Text(" %llu frames not read back", static_cast<unsigned long long>(m_droppedFrames));
+}
+
+} // namespace vuren
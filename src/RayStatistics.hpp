@@ -0,0 +1,98 @@
+#ifndef RAY_STATISTICS_HPP
+#define RAY_STATISTICS_HPP
+
+#define VULKAN_HPP_NO_CONSTRUCTORS
+#define VULKAN_HPP_DISPATCH_LOADER_DYNAMIC 1
+#include <vulkan/vulkan.hpp>
+
+#include "Common.hpp"
+#include "CommonShaders/RayStats.h"
+#include "ResourceManager.hpp"
+
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace vuren {
+
+// the path segments traced in a frame, shadow rays excluded
+uint64_t getTracedRays(const RayStats &stats);
+
+// segments per path, the primary segment (rasterized by the g-buffer pass) included
+double getAveragePathLength(uint64_t tracedRays, uint64_t paths);
+
+// ray counters of a pass instrumented with RayStats.h.
+// the counter buffer is zeroed before the pass and copied into one of a few host-visible slots after it, in the
+// frame's own command buffer. a slot is read once its frame's fence has signaled, so the readback never stalls
+// the render loop. combined with the pass time from the GpuProfiler the counters give the ray throughput.
+class RayStatistics {
+public:
+    static constexpr uint32_t kSlotCount   = 4;
+    static constexpr uint32_t kHistorySize = 256;
+
+    RayStatistics() {}
+    ~RayStatistics() {}
+
+    // whether ray generation shaders can sum the counters over a subgroup before the atomics
+    static bool supportsSubgroupReduce(const VulkanContext &context);
+
+    // counterBufferName is the storage buffer the instrumented pass writes to
+    void init(VulkanContext *pContext, std::shared_ptr<ResourceManager> pResourceManager,
+              const std::string &counterBufferName);
+
+    // prints the totals of every frame read back
+    void cleanup();
+
+    bool isEnabled() const { return !m_slots.empty(); }
+
+    // must be recorded outside of a render pass instance, around the instrumented pass
+    void recordReset(vk::CommandBuffer commandBuffer);
+    void recordReadback(vk::CommandBuffer commandBuffer, uint64_t frameSerial);
+
+    // read the counters of every frame up to completedSerial
+    void retire(uint64_t completedSerial);
+
+    // every read back frame's counters, in frame order
+    struct FrameCounts {
+        uint64_t frameSerial;
+        RayStats stats;
+    };
+
+    void setFrameCountsEnabled(bool enabled) { m_frameCountsEnabled = enabled; }
+    const std::vector<FrameCounts> &getFrameCounts() const { return m_frameCounts; }
+
+    // passMs is the average time of the instrumented pass over about the same frames
+    void updateGui(float passMs);
+
+private:
+    struct Slot {
+        uint64_t frameSerial{ 0 };
+        bool inFlight{ false };
+    };
+
+    VulkanContext *m_pContext{ nullptr };
+    std::shared_ptr<ResourceManager> m_pResourceManager{ nullptr };
+    std::shared_ptr<Buffer> m_pCounterBuffer{ nullptr };
+
+    Buffer m_readbackBuffer;
+    RayStats *m_pMapped{ nullptr }; // one RayStats per slot
+    std::vector<Slot> m_slots;
+    uint64_t m_droppedFrames{ 0 };
+
+    // rolling counters of the last frames
+    std::array<RayStats, kHistorySize> m_history{};
+    uint32_t m_historyCount{ 0 };
+    uint32_t m_historyNext{ 0 };
+
+    uint64_t m_totalFrames{ 0 };
+    uint64_t m_totalRays{ 0 };
+    uint64_t m_totalPaths{ 0 };
+
+    bool m_frameCountsEnabled{ false };
+    std::vector<FrameCounts> m_frameCounts;
+};
+
+} // namespace vuren
+
+#endif // RAY_STATISTICS_HPP
@@ -1,6 +1,19 @@
 #include "RenderPass.hpp"
+#include "BindlessTable.hpp"
+#include "CommonShaders/Bindless.h"
+#include "DescriptorCache.hpp"
+#include "PipelineCache.hpp"
+#include "Profiler.hpp"
+#include "Timer.hpp"
 #include "VulkanContext.hpp"
 
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+
 namespace vuren {
 
 // ------------------ RenderPass bass class ------------------
@@ -18,169 +31,228 @@ void RenderPass::init(VulkanContext *pContext, vk::CommandPool commandPool,
     m_extent           = pResourceManager->getExtent();
 }
 
+vk::PipelineCache RenderPass::getPipelineCache() const {
+    return m_pContext->m_pPipelineCache ? m_pContext->m_pPipelineCache->get() : VK_NULL_HANDLE;
+}
+
+void RenderPass::addPipelineCreationTime(const std::string &shaderPath, double ms) {
+    if (m_pContext->m_pPipelineCache)
+        m_pContext->m_pPipelineCache->addCreationTime(std::filesystem::path(shaderPath).filename().string(), ms);
+}
+
+void RenderPass::setup() {
+    define();
+    compilePipeline();
+    finishSetup();
+}
+
 void RenderPass::cleanup() {
-    if (m_descriptorPool)
-        m_pContext->m_device.destroyDescriptorPool(m_descriptorPool, nullptr);
-    if (m_descriptorSetLayout)
-        m_pContext->m_device.destroyDescriptorSetLayout(m_descriptorSetLayout, nullptr);
+    // the descriptor set and its layout belong to the descriptor cache
     if (m_pipeline)
         m_pContext->m_device.destroyPipeline(m_pipeline, nullptr);
     if (m_pipelineLayout)
         m_pContext->m_device.destroyPipelineLayout(m_pipelineLayout, nullptr);
 }
 
-void RenderPass::createDescriptorSet(const std::vector<ResourceBindingInfo> &bindingInfos) {
-    std::vector<vk::DescriptorSetLayoutBinding> bindings;
-    uint32_t totalDescriptorCount = 0;
+void RenderPass::reloadShaders() {
+    VUREN_PROFILE_ZONE("RenderPass::reloadShaders");
+
+    // the state to restore if the new shaders cannot be used
+    std::vector<ReflectedBinding> reflectedBindings            = m_reflectedBindings;
+    std::vector<vk::DescriptorSetLayoutBinding> layoutBindings = m_layoutBindings;
+    vk::DescriptorSetLayout descriptorSetLayout                = m_descriptorSetLayout;
+    vk::DescriptorSet descriptorSet                            = m_descriptorSet;
+    vk::PipelineLayout pipelineLayout                          = m_pipelineLayout;
+    vk::Pipeline pipeline                                      = m_pipeline;
+
+    try {
+        readShaders();
+
+        // the same interface keeps the descriptor set and the pipeline layout. otherwise the old set goes back to
+        // the descriptor cache below, for the next set allocated with its layout.
+        bool sameInterface = std::equal(
+            m_reflectedBindings.begin(), m_reflectedBindings.end(), reflectedBindings.begin(), reflectedBindings.end(),
+            [](const ReflectedBinding &a, const ReflectedBinding &b) {
+                return a.set == b.set && a.binding == b.binding && a.descriptorType == b.descriptorType &&
+                       a.descriptorCount == b.descriptorCount && a.stageFlags == b.stageFlags;
+            });
+        if (!sameInterface) {
+            createDescriptorSet();
+            createPipelineLayout();
+        }
 
-    // create a descriptor set
-    for (const auto &binding: bindingInfos) {
-        vk::DescriptorSetLayoutBinding layoutBinding{ .binding            = static_cast<uint32_t>(bindings.size()),
-                                                      .descriptorType     = binding.descriptorType,
-                                                      .descriptorCount    = binding.descriptorCount,
-                                                      .stageFlags         = binding.stageFlags,
-                                                      .pImmutableSamplers = nullptr };
+        compilePipeline();
+    } catch (...) {
+        if (m_descriptorSet != descriptorSet)
+            m_pContext->m_pDescriptorCache->release(m_descriptorSet, m_descriptorSetLayout);
+        if (m_pipelineLayout != pipelineLayout && m_pipelineLayout)
+            m_pContext->m_device.destroyPipelineLayout(m_pipelineLayout, nullptr);
+        m_reflectedBindings   = reflectedBindings;
+        m_layoutBindings      = layoutBindings;
+        m_descriptorSetLayout = descriptorSetLayout;
+        m_descriptorSet       = descriptorSet;
+        m_pipelineLayout      = pipelineLayout;
+        m_pipeline            = pipeline;
+        throw;
+    }
 
-        bindings.push_back(layoutBinding);
+    // reloads are applied at a frame boundary, when no submitted frame uses the old set anymore
+    m_pContext->m_device.destroyPipeline(pipeline, nullptr);
+    if (m_pipelineLayout != pipelineLayout)
+        m_pContext->m_device.destroyPipelineLayout(pipelineLayout, nullptr);
+    if (m_descriptorSet != descriptorSet)
+        m_pContext->m_pDescriptorCache->release(descriptorSet, descriptorSetLayout);
+}
 
-        totalDescriptorCount += binding.descriptorCount;
+void RenderPass::reflectShader(const std::vector<char> &code, const std::string &shaderPath) {
+    mergeDescriptorBindings(m_reflectedBindings, reflectDescriptorBindings(code, shaderPath), shaderPath);
+
+    // set 0 is the bindless table, which is not the pass's to create
+    std::erase_if(m_reflectedBindings, [](const ReflectedBinding &reflected) { return reflected.set == BINDLESS_SET; });
+}
+
+const std::string &RenderPass::getBoundResource(const ReflectedBinding &reflected) const {
+    for (auto &bindingInfo: m_resourceBindings) {
+        if (bindingInfo.binding == reflected.binding)
+            return bindingInfo.name;
     }
+    throw std::runtime_error("no resource is bound to " + reflected.name + " (binding " +
+                             std::to_string(reflected.binding) + ")!");
+}
 
-    vk::DescriptorSetLayoutCreateInfo layoutInfo{ .bindingCount = static_cast<uint32_t>(bindings.size()),
-                                                  .pBindings    = bindings.data() };
+void RenderPass::createDescriptorSet() {
+    VUREN_PROFILE_ZONE("RenderPass::createDescriptorSet");
+    if (!m_pContext->m_pDescriptorCache)
+        throw std::runtime_error("the descriptor cache must be set before the descriptor set creation!");
 
-    if (m_pContext->m_device.createDescriptorSetLayout(&layoutInfo, nullptr, &m_descriptorSetLayout) !=
-        vk::Result::eSuccess) {
-        throw std::runtime_error("failed to create a descriptor set layout!");
+    m_layoutBindings.clear();
+    for (const auto &reflected: m_reflectedBindings) {
+        if (reflected.set != PASS_SET) {
+            throw std::runtime_error(reflected.name + " is in descriptor set " + std::to_string(reflected.set) +
+                                     ", the resources of a pass must be in set " + std::to_string(PASS_SET) + "!");
+        }
+
+        // a runtime sized array gets one descriptor per element of the bound array
+        uint32_t descriptorCount = reflected.descriptorCount;
+        if (descriptorCount == 0)
+            descriptorCount =
+                static_cast<uint32_t>(m_pResourceManager->getTextureArray(getBoundResource(reflected)).size());
+
+        m_layoutBindings.push_back({ .binding            = reflected.binding,
+                                     .descriptorType     = reflected.descriptorType,
+                                     .descriptorCount    = descriptorCount,
+                                     .stageFlags         = reflected.stageFlags,
+                                     .pImmutableSamplers = nullptr });
     }
 
-    // create a descriptor pool
-    std::vector<vk::DescriptorPoolSize> poolSizes(bindings.size());
-    for (size_t i = 0; i < poolSizes.size(); ++i) {
-        poolSizes[i].type            = bindings[i].descriptorType;
-        poolSizes[i].descriptorCount = bindings[i].descriptorCount;
+    for (const auto &bindingInfo: m_resourceBindings) {
+        auto it = std::find_if(
+            m_reflectedBindings.begin(), m_reflectedBindings.end(),
+            [&](const ReflectedBinding &reflected) { return reflected.binding == bindingInfo.binding; });
+        if (it == m_reflectedBindings.end()) {
+            std::cerr << "warning: " << bindingInfo.name << " is bound to binding " << bindingInfo.binding
+                      << ", which no shader of the pass declares" << std::endl;
+        }
     }
 
-    vk::DescriptorPoolCreateInfo poolInfo{ .maxSets       = 1,
-                                           .poolSizeCount = static_cast<uint32_t>(poolSizes.size()),
-                                           .pPoolSizes    = poolSizes.data() };
+    m_descriptorSetLayout = m_pContext->m_pDescriptorCache->getLayout(m_layoutBindings);
+    m_descriptorSet       = m_pContext->m_pDescriptorCache->allocate(m_descriptorSetLayout);
 
-    if (m_pContext->m_device.createDescriptorPool(&poolInfo, nullptr, &m_descriptorPool) != vk::Result::eSuccess) {
-        throw std::runtime_error("failed to create a descriptor pool!");
-    }
+    writeDescriptorSet();
+}
+
+void RenderPass::createPipelineLayout() {
+    if (!m_pContext->m_pBindlessTable)
+        throw std::runtime_error("the bindless table must be set before the pipeline layout creation!");
 
-    // write a descriptor set
-    vk::DescriptorSetAllocateInfo allocInfo{ .descriptorPool     = m_descriptorPool,
-                                             .descriptorSetCount = 1,
-                                             .pSetLayouts        = &m_descriptorSetLayout };
+    // every layout has the same set 0 and push constant range, so the bindless set stays bound across pipelines
+    std::array<vk::DescriptorSetLayout, 2> setLayouts = { m_pContext->m_pBindlessTable->getLayout(),
+                                                          m_descriptorSetLayout };
+    vk::PushConstantRange pushConstantRange           = BindlessTable::getPushConstantRange();
 
-    if (m_pContext->m_device.allocateDescriptorSets(&allocInfo, &m_descriptorSet) != vk::Result::eSuccess) {
-        throw std::runtime_error("failed to allocate offscreen descriptor sets!");
+    vk::PipelineLayoutCreateInfo layoutCreateInfo{ .setLayoutCount         = static_cast<uint32_t>(setLayouts.size()),
+                                                   .pSetLayouts            = setLayouts.data(),
+                                                   .pushConstantRangeCount = 1,
+                                                   .pPushConstantRanges    = &pushConstantRange };
+
+    if (m_pContext->m_device.createPipelineLayout(&layoutCreateInfo, nullptr, &m_pipelineLayout) !=
+        vk::Result::eSuccess) {
+        throw std::runtime_error("failed to create a pipeline layout!");
     }
+}
+
+void RenderPass::writeDescriptorSet() {
+    uint32_t totalDescriptorCount = 0;
+    for (const auto &binding: m_layoutBindings)
+        totalDescriptorCount += binding.descriptorCount;
 
     std::vector<vk::WriteDescriptorSet> descriptorWrites;
     std::vector<vk::DescriptorBufferInfo> bufferInfos;
     std::vector<vk::DescriptorImageInfo> imageInfos;
     std::vector<vk::WriteDescriptorSetAccelerationStructureKHR> tlasInfos;
 
+    // the writes point into these, so they must not reallocate
     bufferInfos.reserve(totalDescriptorCount);
     imageInfos.reserve(totalDescriptorCount);
     tlasInfos.reserve(totalDescriptorCount);
 
-    for (size_t i = 0; i < bindings.size(); ++i) {
-        vk::WriteDescriptorSet write;
-        vk::DescriptorBufferInfo bufferInfo;
-        vk::DescriptorImageInfo imageInfo;
-
-        write.pImageInfo  = nullptr;
-        write.pBufferInfo = nullptr;
-        write.pNext       = nullptr; // for TLAS
-
-        // top-level acceleration structures
-        if (bindings[i].descriptorType == vk::DescriptorType::eAccelerationStructureKHR) {
-            vk::WriteDescriptorSetAccelerationStructureKHR descriptorSetAsInfo{ .accelerationStructureCount =
-                                                                                    bindings[i].descriptorCount,
-                                                                                .pAccelerationStructures = &m_tlas.as };
-            tlasInfos.push_back(descriptorSetAsInfo);
-
-            write.pNext            = (void *) &tlasInfos.back();
-            write.dstSet           = m_descriptorSet;
-            write.dstBinding       = static_cast<uint32_t>(i);
-            write.dstArrayElement  = 0;
-            write.descriptorCount  = bindings[i].descriptorCount;
-            write.descriptorType   = bindings[i].descriptorType;
-            write.pTexelBufferView = nullptr;
-
-            descriptorWrites.push_back(write);
+    for (size_t i = 0; i < m_layoutBindings.size(); ++i) {
+        const ReflectedBinding &reflected             = m_reflectedBindings[i];
+        const vk::DescriptorSetLayoutBinding &binding = m_layoutBindings[i];
+        if (binding.descriptorCount == 0)
             continue;
-        }
 
-        // specialized bindings for scene resourses
-        if (bindingInfos[i].name == "SceneTextures") {
-            assert(bindings[i].descriptorType == vk::DescriptorType::eCombinedImageSampler);
-            for (auto pTexture: m_pScene->getTextures()) {
-                imageInfo             = m_pResourceManager->getTexture(pTexture->name)->descriptorInfo;
-                imageInfo.imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
-                imageInfos.push_back(imageInfo);
-            }
-            write.pImageInfo = &imageInfos.back() - m_pScene->getTextures().size() + 1;
-        } else if (bindingInfos[i].name == "SceneObjects") {
-            assert(bindings[i].descriptorType == vk::DescriptorType::eStorageBuffer);
-            for (auto &buffer: m_pScene->getObjects()) {
-                bufferInfo = m_pResourceManager->getBuffer("SceneObjectDeviceInfo")->descriptorInfo;
-                bufferInfos.push_back(bufferInfo);
-            }
-            write.pBufferInfo = &bufferInfos.back() - m_pScene->getObjects().size() + 1;
-        } else if (bindingInfos[i].name == "SceneMaterials") {
-            assert(bindings[i].descriptorType == vk::DescriptorType::eStorageBuffer);
-            for (auto &buffer: m_pScene->getMaterials()) {
-                bufferInfo = m_pResourceManager->getBuffer("MaterialBuffer")->descriptorInfo;
-                bufferInfos.push_back(bufferInfo);
+        const std::string &name = getBoundResource(reflected);
+        bool isArray            = reflected.descriptorCount != 1;
+
+        vk::WriteDescriptorSet write{ .dstSet          = m_descriptorSet,
+                                      .dstBinding      = binding.binding,
+                                      .dstArrayElement = 0,
+                                      .descriptorCount = binding.descriptorCount,
+                                      .descriptorType  = binding.descriptorType };
+
+        switch (binding.descriptorType) {
+            // top-level acceleration structures
+            case vk::DescriptorType::eAccelerationStructureKHR:
+                if (isArray)
+                    throw std::runtime_error("acceleration structure arrays are not supported!");
+                tlasInfos.push_back({ .accelerationStructureCount = 1, .pAccelerationStructures = &m_tlas.as });
+                write.pNext = &tlasInfos.back();
+                break;
+
+            case vk::DescriptorType::eCombinedImageSampler:
+            case vk::DescriptorType::eSampledImage:
+            case vk::DescriptorType::eStorageImage: {
+                vk::ImageLayout imageLayout = binding.descriptorType == vk::DescriptorType::eStorageImage
+                                                  ? vk::ImageLayout::eGeneral
+                                                  : vk::ImageLayout::eShaderReadOnlyOptimal;
+                std::vector<std::shared_ptr<Texture>> textures =
+                    isArray ? m_pResourceManager->getTextureArray(name)
+                            : std::vector<std::shared_ptr<Texture>>{ m_pResourceManager->getTexture(name) };
+                if (textures.size() < binding.descriptorCount)
+                    throw std::runtime_error(name + " has fewer textures than its binding!");
+
+                write.pImageInfo = imageInfos.data() + imageInfos.size();
+                for (uint32_t element = 0; element < binding.descriptorCount; ++element) {
+                    vk::DescriptorImageInfo imageInfo = textures[element]->descriptorInfo;
+                    imageInfo.imageLayout             = imageLayout;
+                    imageInfos.push_back(imageInfo);
+                }
+                break;
             }
-            write.pBufferInfo = &bufferInfos.back() - m_pScene->getMaterials().size() + 1;
-        }
 
-        // everything else resources
-        else {
-            switch (bindings[i].descriptorType) {
-                case vk::DescriptorType::eCombinedImageSampler:
-                    imageInfo             = m_pResourceManager->getTexture(bindingInfos[i].name)->descriptorInfo;
-                    imageInfo.imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
-                    imageInfos.push_back(imageInfo);
-                    write.pImageInfo = &imageInfos.back();
-                    break;
+            case vk::DescriptorType::eUniformBuffer:
+            case vk::DescriptorType::eStorageBuffer:
+                if (isArray)
+                    throw std::runtime_error("buffer arrays are not supported!");
+                bufferInfos.push_back(m_pResourceManager->getBuffer(name)->descriptorInfo);
+                write.pBufferInfo = &bufferInfos.back();
+                break;
 
-                case vk::DescriptorType::eStorageImage:
-                    imageInfo             = m_pResourceManager->getTexture(bindingInfos[i].name)->descriptorInfo;
-                    imageInfo.imageLayout = vk::ImageLayout::eGeneral;
-                    imageInfos.push_back(imageInfo);
-                    write.pImageInfo = &imageInfos.back();
-                    break;
-
-                case vk::DescriptorType::eUniformBuffer:
-                    bufferInfo = m_pResourceManager->getBuffer(bindingInfos[i].name)->descriptorInfo;
-                    bufferInfos.push_back(bufferInfo);
-                    write.pBufferInfo = &bufferInfos.back();
-                    break;
-
-                case vk::DescriptorType::eStorageBuffer:
-                    bufferInfo = m_pResourceManager->getBuffer(bindingInfos[i].name)->descriptorInfo;
-                    bufferInfos.push_back(bufferInfo);
-                    write.pBufferInfo = &bufferInfos.back();
-                    break;
-
-                default:
-                    throw std::runtime_error("unsupported descriptor type!");
-            }
+            default:
+                throw std::runtime_error("unsupported descriptor type!");
         }
 
-        write.dstSet           = m_descriptorSet;
-        write.dstBinding       = static_cast<uint32_t>(i);
-        write.dstArrayElement  = 0;
-        write.descriptorCount  = bindings[i].descriptorCount;
-        write.descriptorType   = bindings[i].descriptorType;
-        write.pTexelBufferView = nullptr;
-
         descriptorWrites.push_back(write);
     }
 
@@ -211,8 +283,6 @@ void RasterRenderPass::init(VulkanContext *pContext, vk::CommandPool commandPool
     RenderPass::init(pContext, commandPool, pResourceManager, pScene);
 }
 
-void RasterRenderPass::setup() { define(); }
-
 void RasterRenderPass::cleanup() {
     if (m_framebuffer)
         m_pContext->m_device.destroyFramebuffer(m_framebuffer, nullptr);
@@ -223,32 +293,35 @@ void RasterRenderPass::cleanup() {
 
 void RasterRenderPass::setupRasterPipeline(const std::string &vertShaderPath, const std::string &fragShaderPath,
                                            bool isBlitPass) {
-    if (!m_pContext->m_device || !m_descriptorSetLayout) {
-        throw std::runtime_error(
-            "pipeline setup failed! "
-            "logical device and descriptor set layout must be valid before the pipeline creation.");
+    VUREN_PROFILE_ZONE("RasterRenderPass::setupRasterPipeline");
+    if (!m_pContext->m_device) {
+        throw std::runtime_error("pipeline setup failed! logical device must be valid before the pipeline creation.");
     }
 
     m_vertShaderPath = vertShaderPath;
     m_fragShaderPath = fragShaderPath;
     m_isBiltPass     = isBlitPass;
 
-    // create a pipeline layout
-    vk::PipelineLayoutCreateInfo pipelineLayoutInfo{ .setLayoutCount         = 1,
-                                                     .pSetLayouts            = &m_descriptorSetLayout,
-                                                     .pushConstantRangeCount = 0,
-                                                     .pPushConstantRanges    = nullptr };
+    // the descriptor set layout follows the bindings the shaders declare
+    readShaders();
+    createDescriptorSet();
+    createPipelineLayout();
+}
 
-    if (m_pContext->m_device.createPipelineLayout(&pipelineLayoutInfo, nullptr, &m_pipelineLayout) !=
-        vk::Result::eSuccess) {
-        throw std::runtime_error("failed to create a pipeline layout!");
-    }
+void RasterRenderPass::readShaders() {
+    // the code is kept for compilePipeline()
+    m_vertShaderCode = readFile(m_vertShaderPath);
+    m_fragShaderCode = readFile(m_fragShaderPath);
 
-    auto vertShaderCode = readFile(m_vertShaderPath);
-    auto fragShaderCode = readFile(m_fragShaderPath);
+    m_reflectedBindings.clear();
+    reflectShader(m_vertShaderCode, m_vertShaderPath);
+    reflectShader(m_fragShaderCode, m_fragShaderPath);
+}
 
-    vk::ShaderModule vertShaderModule = createShaderModule(vertShaderCode);
-    vk::ShaderModule fragShaderModule = createShaderModule(fragShaderCode);
+void RasterRenderPass::compilePipeline() {
+    VUREN_PROFILE_ZONE("RasterRenderPass::compilePipeline");
+    vk::ShaderModule vertShaderModule = createShaderModule(m_vertShaderCode);
+    vk::ShaderModule fragShaderModule = createShaderModule(m_fragShaderCode);
 
     vk::PipelineShaderStageCreateInfo vertShaderStageInfo{ .stage  = vk::ShaderStageFlagBits::eVertex,
                                                            .module = vertShaderModule,
@@ -385,10 +458,12 @@ void RasterRenderPass::setupRasterPipeline(const std::string &vertShaderPath, co
                                                  .basePipelineHandle  = VK_NULL_HANDLE,
                                                  .basePipelineIndex   = -1 };
 
-    if (m_pContext->m_device.createGraphicsPipelines(VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_pipeline) !=
+    Timer timer;
+    if (m_pContext->m_device.createGraphicsPipelines(getPipelineCache(), 1, &pipelineInfo, nullptr, &m_pipeline) !=
         vk::Result::eSuccess) {
         throw std::runtime_error("failed to create rasterization pipeline!");
     }
+    addPipelineCreationTime(m_fragShaderPath, timer.elapsed());
 
     m_pContext->m_device.destroyShaderModule(fragShaderModule, nullptr);
     m_pContext->m_device.destroyShaderModule(vertShaderModule, nullptr);
@@ -520,12 +595,16 @@ void RayTracingRenderPass::init(VulkanContext *pContext, vk::CommandPool command
     createTlas(m_pScene->getInstances());
 }
 
-void RayTracingRenderPass::setup() {
-    define();
+void RayTracingRenderPass::finishSetup() {
     createShaderBindingTable();
+    storeActiveVariant();
 }
 
 void RayTracingRenderPass::cleanup() {
+    destroyInactiveVariants();
+    m_pVariantCompiler.reset();
+    m_pipelineVariants.clear();
+
     m_pResourceManager->destroyBuffer(m_sbtBuffer);
     m_pResourceManager->destroyBuffer(m_tlas.buffer);
     if (m_tlas.as)
@@ -578,11 +657,15 @@ RayTracingRenderPass::BlasInput RayTracingRenderPass::objectToVkGeometryKHR(cons
 // generate one BLAS for each BlasInput
 void RayTracingRenderPass::buildBlas(const std::vector<BlasInput> &input,
                                      vk::BuildAccelerationStructureFlagsKHR flags) {
+    VUREN_PROFILE_ZONE("RayTracingRenderPass::buildBlas");
 
     uint32_t blasCount            = static_cast<uint32_t>(input.size());
     vk::DeviceSize asTotalSize    = 0; // all aloocated BLAS
     uint32_t compactionsSize      = 0; // BLAS requesting compaction
     vk::DeviceSize maxScratchSize = 0;
+    vk::DeviceSize compactedSize  = 0; // all BLAS after compaction
+    uint64_t triangleCount        = 0;
+    Timer buildTimer;
 
     std::vector<BuildAccelerationStructure> buildAs(blasCount);
 
@@ -598,8 +681,10 @@ void RayTracingRenderPass::buildBlas(const std::vector<BlasInput> &input,
 
         // find sizes to create acceleration structure and scratch
         std::vector<uint32_t> maxPrimCount(input[i].asBuildOffsetInfo.size());
-        for (auto tt = 0; tt < input[i].asBuildOffsetInfo.size(); ++tt)
+        for (auto tt = 0; tt < input[i].asBuildOffsetInfo.size(); ++tt) {
             maxPrimCount[tt] = input[i].asBuildOffsetInfo[tt].primitiveCount;
+            triangleCount += maxPrimCount[tt];
+        }
 
         m_pContext->m_device.getAccelerationStructureBuildSizesKHR(vk::AccelerationStructureBuildTypeKHR::eDevice,
                                                                    &buildAs[i].buildInfo, maxPrimCount.data(),
@@ -646,8 +731,9 @@ void RayTracingRenderPass::buildBlas(const std::vector<BlasInput> &input,
             vk::CommandBuffer commandBuffer = beginSingleTimeCommands(*m_pContext, m_commandPool);
 
             // create BLAS
+            // reset on the device timeline: host query reset (vkResetQueryPool) needs the hostQueryReset feature
             if (queryPool)
-                m_pContext->m_device.resetQueryPool(queryPool, 0, static_cast<uint32_t>(indices.size()));
+                commandBuffer.resetQueryPool(queryPool, 0, static_cast<uint32_t>(indices.size()));
             uint32_t queryCount = 0;
 
             for (const auto &j: indices) {
@@ -703,6 +789,7 @@ void RayTracingRenderPass::buildBlas(const std::vector<BlasInput> &input,
                 for (auto idx: indices) {
                     buildAs[idx].cleanupAs                          = buildAs[idx].as;
                     buildAs[idx].sizeInfo.accelerationStructureSize = compactSizes[queryCount++];
+                    compactedSize += buildAs[idx].sizeInfo.accelerationStructureSize;
 
                     // create a compact version of the AS
                     vk::AccelerationStructureCreateInfoKHR asCreateInfo{
@@ -738,11 +825,28 @@ void RayTracingRenderPass::buildBlas(const std::vector<BlasInput> &input,
         m_blas.emplace_back(b.as);
     }
 
+    // report the build cost and memory footprint of the bottom-level structures
+    double buildTime         = buildTimer.elapsed();
+    vk::DeviceSize finalSize = queryPool ? compactedSize : asTotalSize;
+    m_blasBuildMs            = buildTime;
+    m_blasSize               = finalSize;
+    if (triangleCount > 0) {
+        std::cout << "BLAS: " << blasCount << " structures, " << triangleCount << " triangles, "
+                  << (flags & vk::BuildAccelerationStructureFlagBitsKHR::ePreferFastBuild ? "fast-build"
+                                                                                          : "fast-trace")
+                  << " mode, built in " << buildTime << " ms, " << asTotalSize / 1024 << " KB";
+        if (queryPool)
+            std::cout << " -> " << compactedSize / 1024 << " KB compacted";
+        std::cout << " (" << static_cast<double>(finalSize) / static_cast<double>(triangleCount) << " bytes/triangle)"
+                  << std::endl;
+    }
+
     m_pContext->m_device.destroyQueryPool(queryPool, nullptr);
     m_pResourceManager->destroyBuffer(scratchBuffer);
 }
 
 void RayTracingRenderPass::createBlas() {
+    VUREN_PROFILE_ZONE("RayTracingRenderPass::createBlas");
     // BLAS stores each primitive in a geometry.
     std::vector<BlasInput> allBlas;
     allBlas.reserve(m_pScene->getObjects().size());
@@ -752,11 +856,14 @@ void RayTracingRenderPass::createBlas() {
         allBlas.emplace_back(blas);
     }
 
-    buildBlas(allBlas, vk::BuildAccelerationStructureFlagBitsKHR::ePreferFastTrace);
+    // compaction copies each BLAS into an allocation of its real size, which is usually a fraction of the
+    // conservative size reported by getAccelerationStructureBuildSizesKHR
+    buildBlas(allBlas, m_blasBuildFlags | vk::BuildAccelerationStructureFlagBitsKHR::eAllowCompaction);
 }
 
 void RayTracingRenderPass::buildTlas(const std::vector<vk::AccelerationStructureInstanceKHR> &instances,
                                      vk::BuildAccelerationStructureFlagsKHR flags, bool update) {
+    VUREN_PROFILE_ZONE("RayTracingRenderPass::buildTlas");
     assert(m_tlas.as == vk::AccelerationStructureKHR{ VK_NULL_HANDLE } || update);
     uint32_t instanceCount = static_cast<uint32_t>(instances.size());
 
@@ -834,6 +941,7 @@ void RayTracingRenderPass::buildTlas(const std::vector<vk::AccelerationStructure
 }
 
 void RayTracingRenderPass::createTlas(const std::vector<ObjectInstance> &instances) {
+    VUREN_PROFILE_ZONE("RayTracingRenderPass::createTlas");
     // TLAS is the entry point in the rt scene description
     std::vector<vk::AccelerationStructureInstanceKHR> tlas;
     tlas.reserve(instances.size());
@@ -873,6 +981,7 @@ uint32_t RayTracingRenderPass::align_up(uint32_t size, uint32_t alignment) {
 }
 
 void RayTracingRenderPass::createShaderBindingTable() {
+    VUREN_PROFILE_ZONE("RayTracingRenderPass::createShaderBindingTable");
     uint32_t missCount   = 1;
     uint32_t hitCount    = 1;
     uint32_t handleCount = 1 + missCount + hitCount;
@@ -944,38 +1053,202 @@ void RayTracingRenderPass::createShaderBindingTable() {
     m_pContext->m_device.unmapMemory(m_sbtBuffer.memory);
 }
 
+void RayTracingRenderPass::setSpecializationConstant(uint32_t constantId, uint32_t value) {
+    for (size_t i = 0; i < m_specializationEntries.size(); ++i) {
+        if (m_specializationEntries[i].constantID == constantId) {
+            m_specializationData[i] = value;
+            return;
+        }
+    }
+
+    uint32_t offset = static_cast<uint32_t>(m_specializationData.size() * sizeof(uint32_t));
+    m_specializationEntries.push_back({ .constantID = constantId, .offset = offset, .size = sizeof(uint32_t) });
+    m_specializationData.push_back(value);
+}
+
+void RayTracingRenderPass::setSpecializationConstant(uint32_t constantId, float value) {
+    setSpecializationConstant(constantId, std::bit_cast<uint32_t>(value));
+}
+
+bool RayTracingRenderPass::updatePipelineVariant() {
+    if (m_specializationData == m_activeVariantKey)
+        return false;
+
+    auto it = m_pipelineVariants.find(m_specializationData);
+    if (it == m_pipelineVariants.end()) {
+        // one worker: requests are compiled in order, and the pipeline compilation itself may be multithreaded
+        if (!m_pVariantCompiler)
+            m_pVariantCompiler = std::make_unique<ThreadPool>(1);
+
+        PipelineVariant variant;
+        variant.pendingPipeline = m_pVariantCompiler->submit(
+            [this, entries = m_specializationEntries, data = m_specializationData]() {
+                return createPipeline(entries, data);
+            });
+        m_pipelineVariants.emplace(m_specializationData, std::move(variant));
+        return false;
+    }
+
+    PipelineVariant &variant = it->second;
+    if (variant.pendingPipeline.valid()) {
+        if (variant.pendingPipeline.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            return false;
+
+        try {
+            variant.pipeline = variant.pendingPipeline.get();
+
+            // the SBT of the new pipeline, created the same way as at setup
+            m_pipeline = variant.pipeline;
+            createShaderBindingTable();
+            variant.sbtBuffer  = m_sbtBuffer;
+            variant.rgenRegion = m_rgenRegion;
+            variant.missRegion = m_missRegion;
+            variant.hitRegion  = m_hitRegion;
+        } catch (const std::exception &e) {
+            std::cerr << "pipeline variant: " << e.what() << std::endl;
+            variant.failed = true;
+        }
+    }
+
+    // a failed variant stays cached, so it is not compiled again every frame
+    if (variant.failed) {
+        auto &active = m_pipelineVariants.at(m_activeVariantKey);
+        m_pipeline   = active.pipeline;
+        m_sbtBuffer  = active.sbtBuffer;
+        m_rgenRegion = active.rgenRegion;
+        m_missRegion = active.missRegion;
+        m_hitRegion  = active.hitRegion;
+        return false;
+    }
+
+    m_pipeline         = variant.pipeline;
+    m_sbtBuffer        = variant.sbtBuffer;
+    m_rgenRegion       = variant.rgenRegion;
+    m_missRegion       = variant.missRegion;
+    m_hitRegion        = variant.hitRegion;
+    m_activeVariantKey = it->first;
+    return true;
+}
+
+bool RayTracingRenderPass::isCompilingVariant() const {
+    return std::any_of(m_pipelineVariants.begin(), m_pipelineVariants.end(),
+                       [](const auto &entry) { return entry.second.pendingPipeline.valid(); });
+}
+
+void RayTracingRenderPass::storeActiveVariant() {
+    m_activeVariantKey       = m_specializationData;
+    PipelineVariant &variant = m_pipelineVariants[m_activeVariantKey];
+    variant.pipeline         = m_pipeline;
+    variant.sbtBuffer        = m_sbtBuffer;
+    variant.rgenRegion       = m_rgenRegion;
+    variant.missRegion       = m_missRegion;
+    variant.hitRegion        = m_hitRegion;
+}
+
+void RayTracingRenderPass::destroyInactiveVariants() {
+    for (auto it = m_pipelineVariants.begin(); it != m_pipelineVariants.end();) {
+        PipelineVariant &variant = it->second;
+        if (variant.pendingPipeline.valid()) {
+            try {
+                variant.pipeline = variant.pendingPipeline.get();
+            } catch (const std::exception &) {
+                variant.pipeline = VK_NULL_HANDLE;
+            }
+        }
+
+        if (it->first == m_activeVariantKey) {
+            ++it;
+            continue;
+        }
+        if (variant.pipeline)
+            m_pContext->m_device.destroyPipeline(variant.pipeline, nullptr);
+        m_pResourceManager->destroyBuffer(variant.sbtBuffer);
+        it = m_pipelineVariants.erase(it);
+    }
+}
+
 void RayTracingRenderPass::setupRayTracingPipeline(const std::string &raygenShaderPath,
                                                    const std::string &missShaderPath,
                                                    const std::string &closestHitShaderPath) {
+    VUREN_PROFILE_ZONE("RayTracingRenderPass::setupRayTracingPipeline");
     m_raygenShaderPath     = raygenShaderPath;
     m_missShaderPath       = missShaderPath;
     m_closestHitShaderPath = closestHitShaderPath;
 
+    // the descriptor set layout follows the bindings the shaders declare
+    readShaders();
+    createDescriptorSet();
+
+    // setup the pipeline layout that will describe how the pipeline will access external data
+    createPipelineLayout();
+}
+
+void RayTracingRenderPass::readShaders() {
+    // the code is kept for compilePipeline()
+    m_raygenShaderCode     = readFile(m_raygenShaderPath);
+    m_missShaderCode       = readFile(m_missShaderPath);
+    m_closestHitShaderCode = readFile(m_closestHitShaderPath);
+
+    m_reflectedBindings.clear();
+    reflectShader(m_raygenShaderCode, m_raygenShaderPath);
+    reflectShader(m_missShaderCode, m_missShaderPath);
+    reflectShader(m_closestHitShaderCode, m_closestHitShaderPath);
+}
+
+void RayTracingRenderPass::reloadShaders() {
+    // the cached variants are built from the previous shaders
+    destroyInactiveVariants();
+
+    RenderPass::reloadShaders();
+
+    // the shader group handles come from the pipeline
+    m_pResourceManager->destroyBuffer(m_sbtBuffer);
+    createShaderBindingTable();
+
+    m_pipelineVariants.clear();
+    storeActiveVariant();
+}
+
+void RayTracingRenderPass::compilePipeline() {
+    VUREN_PROFILE_ZONE("RayTracingRenderPass::compilePipeline");
+    m_pipeline = createPipeline(m_specializationEntries, m_specializationData);
+}
+
+vk::Pipeline RayTracingRenderPass::createPipeline(const std::vector<vk::SpecializationMapEntry> &specializationEntries,
+                                                  const std::vector<uint32_t> &specializationData) {
+    VUREN_PROFILE_ZONE("RayTracingRenderPass::createPipeline");
     enum StageIndices { eRaygen, eMiss, eClosestHit, eShaderGroupCount };
 
-    auto raygenShaderCode     = readFile(m_raygenShaderPath);
-    auto missShaderCode       = readFile(m_missShaderPath);
-    auto closestHitShaderCode = readFile(m_closestHitShaderPath);
+    vk::SpecializationInfo specializationInfo{
+        .mapEntryCount = static_cast<uint32_t>(specializationEntries.size()),
+        .pMapEntries   = specializationEntries.data(),
+        .dataSize      = specializationData.size() * sizeof(uint32_t),
+        .pData         = specializationData.data()
+    };
 
     std::array<vk::PipelineShaderStageCreateInfo, eShaderGroupCount> stages{};
-    vk::PipelineShaderStageCreateInfo stage{ .pName = "main" };
+    vk::PipelineShaderStageCreateInfo stage{ .pName               = "main",
+                                             .pSpecializationInfo = specializationEntries.empty()
+                                                                        ? nullptr
+                                                                        : &specializationInfo };
 
     // raygen
-    stage.module    = createShaderModule(raygenShaderCode);
+    stage.module    = createShaderModule(m_raygenShaderCode);
     stage.stage     = vk::ShaderStageFlagBits::eRaygenKHR;
     stages[eRaygen] = stage;
 
     // miss
-    stage.module  = createShaderModule(missShaderCode);
+    stage.module  = createShaderModule(m_missShaderCode);
     stage.stage   = vk::ShaderStageFlagBits::eMissKHR;
     stages[eMiss] = stage;
 
     // hit group - closest hit
-    stage.module        = createShaderModule(closestHitShaderCode);
+    stage.module        = createShaderModule(m_closestHitShaderCode);
     stage.stage         = vk::ShaderStageFlagBits::eClosestHitKHR;
     stages[eClosestHit] = stage;
 
     // shader groups
+    std::vector<vk::RayTracingShaderGroupCreateInfoKHR> shaderGroups;
     vk::RayTracingShaderGroupCreateInfoKHR group{ .generalShader      = VK_SHADER_UNUSED_KHR,
                                                   .closestHitShader   = VK_SHADER_UNUSED_KHR,
                                                   .anyHitShader       = VK_SHADER_UNUSED_KHR,
@@ -984,38 +1257,18 @@ void RayTracingRenderPass::setupRayTracingPipeline(const std::string &raygenShad
     // raygen
     group.type          = vk::RayTracingShaderGroupTypeKHR::eGeneral;
     group.generalShader = eRaygen;
-    m_shaderGroups.push_back(group);
+    shaderGroups.push_back(group);
 
     // miss
     group.type          = vk::RayTracingShaderGroupTypeKHR::eGeneral;
     group.generalShader = eMiss;
-    m_shaderGroups.push_back(group);
+    shaderGroups.push_back(group);
 
     // closest hit
     group.type             = vk::RayTracingShaderGroupTypeKHR::eTrianglesHitGroup;
     group.generalShader    = VK_SHADER_UNUSED_KHR;
     group.closestHitShader = eClosestHit;
-    m_shaderGroups.push_back(group);
-
-    // setup the pipeline layout that will describe how the pipeline will access external data
-
-    // define the push constant range used by the pipeline layout
-
-    vk::PushConstantRange pushConstantRange{ .stageFlags = vk::ShaderStageFlagBits::eRaygenKHR |
-                                                           vk::ShaderStageFlagBits::eClosestHitKHR |
-                                                           vk::ShaderStageFlagBits::eMissKHR,
-                                             .offset = 0,
-                                             .size   = sizeof(PushConstantRay) };
-
-    vk::PipelineLayoutCreateInfo layoutCreateInfo{ .setLayoutCount         = 1,
-                                                   .pSetLayouts            = &m_descriptorSetLayout,
-                                                   .pushConstantRangeCount = 1,
-                                                   .pPushConstantRanges    = &pushConstantRange };
-
-    if (m_pContext->m_device.createPipelineLayout(&layoutCreateInfo, nullptr, &m_pipelineLayout) !=
-        vk::Result::eSuccess) {
-        throw std::runtime_error("failed to create a pipeline layout!");
-    }
+    shaderGroups.push_back(group);
 
     // ray tracing pipeline can contain an arbitrary number of stages
     // depending on the number of active shaders in the scene.
@@ -1023,19 +1276,113 @@ void RayTracingRenderPass::setupRayTracingPipeline(const std::string &raygenShad
     // assemble the shader stages and recursion depth info
     vk::RayTracingPipelineCreateInfoKHR rtPipelineInfo{ .stageCount = static_cast<uint32_t>(stages.size()),
                                                         .pStages    = stages.data(),
-                                                        .groupCount = static_cast<uint32_t>(m_shaderGroups.size()),
-                                                        .pGroups    = m_shaderGroups.data(),
+                                                        .groupCount = static_cast<uint32_t>(shaderGroups.size()),
+                                                        .pGroups    = shaderGroups.data(),
                                                         .maxPipelineRayRecursionDepth = 1,
                                                         .layout                       = m_pipelineLayout };
 
-    if (m_pContext->m_device.createRayTracingPipelinesKHR({}, {}, 1, &rtPipelineInfo, nullptr, &m_pipeline) !=
-        vk::Result::eSuccess) {
+    Timer timer;
+    vk::Pipeline pipeline;
+    vk::Result result = m_pContext->m_device.createRayTracingPipelinesKHR({}, getPipelineCache(), 1, &rtPipelineInfo,
+                                                                          nullptr, &pipeline);
+    for (auto &stage: stages) {
+        m_pContext->m_device.destroyShaderModule(stage.module, nullptr);
+    }
+    if (result != vk::Result::eSuccess) {
         throw std::runtime_error("failed to create ray tracing pipelines");
     }
+    addPipelineCreationTime(m_raygenShaderPath, timer.elapsed());
 
-    for (auto &stage: stages) {
-        m_pContext->m_device.destroyShaderModule(stage.module, nullptr);
+    return pipeline;
+}
+
+// ------------------ ComputeRenderPass class ------------------
+
+ComputeRenderPass::ComputeRenderPass() {}
+
+ComputeRenderPass::~ComputeRenderPass() {}
+
+void ComputeRenderPass::init(VulkanContext *pContext, vk::CommandPool commandPool,
+                             std::shared_ptr<ResourceManager> pResourceManager, std::shared_ptr<Scene> pScene) {
+    RenderPass::init(pContext, commandPool, pResourceManager, pScene);
+}
+
+void ComputeRenderPass::cleanup() {
+    // the first pipeline is m_pipeline, destroyed by the base class
+    for (size_t i = 1; i < m_computePipelines.size(); ++i)
+        m_pContext->m_device.destroyPipeline(m_computePipelines[i], nullptr);
+    m_computePipelines.clear();
+    RenderPass::cleanup();
+}
+
+void ComputeRenderPass::setupComputePipelines(const std::vector<std::string> &computeShaderPaths) {
+    VUREN_PROFILE_ZONE("ComputeRenderPass::setupComputePipelines");
+    if (computeShaderPaths.empty())
+        throw std::runtime_error("a compute pass needs at least one shader!");
+
+    m_computeShaderPaths = computeShaderPaths;
+
+    // the descriptor set layout follows the bindings the shaders declare
+    readShaders();
+    createDescriptorSet();
+    createPipelineLayout();
+}
+
+void ComputeRenderPass::readShaders() {
+    // the code is kept for compilePipeline()
+    m_computeShaderCodes.clear();
+    for (auto &path: m_computeShaderPaths)
+        m_computeShaderCodes.push_back(readFile(path));
+
+    m_reflectedBindings.clear();
+    for (size_t i = 0; i < m_computeShaderPaths.size(); ++i)
+        reflectShader(m_computeShaderCodes[i], m_computeShaderPaths[i]);
+}
+
+void ComputeRenderPass::reloadShaders() {
+    std::vector<vk::Pipeline> pipelines = m_computePipelines;
+
+    // on failure compilePipeline() leaves m_computePipelines as it was
+    RenderPass::reloadShaders();
+
+    for (size_t i = 1; i < pipelines.size(); ++i)
+        m_pContext->m_device.destroyPipeline(pipelines[i], nullptr);
+}
+
+void ComputeRenderPass::compilePipeline() {
+    VUREN_PROFILE_ZONE("ComputeRenderPass::compilePipeline");
+    std::vector<vk::Pipeline> pipelines;
+    for (size_t i = 0; i < m_computeShaderCodes.size(); ++i) {
+        vk::ShaderModule shaderModule = createShaderModule(m_computeShaderCodes[i]);
+
+        vk::ComputePipelineCreateInfo pipelineInfo{ .stage  = { .stage  = vk::ShaderStageFlagBits::eCompute,
+                                                                .module = shaderModule,
+                                                                .pName  = "main" },
+                                                    .layout = m_pipelineLayout };
+
+        Timer timer;
+        vk::Pipeline pipeline;
+        vk::Result result =
+            m_pContext->m_device.createComputePipelines(getPipelineCache(), 1, &pipelineInfo, nullptr, &pipeline);
+        m_pContext->m_device.destroyShaderModule(shaderModule, nullptr);
+        if (result != vk::Result::eSuccess) {
+            for (auto created: pipelines)
+                m_pContext->m_device.destroyPipeline(created, nullptr);
+            throw std::runtime_error("failed to create compute pipeline for " + m_computeShaderPaths[i] + "!");
+        }
+        addPipelineCreationTime(m_computeShaderPaths[i], timer.elapsed());
+
+        pipelines.push_back(pipeline);
     }
+
+    m_computePipelines = pipelines;
+    m_pipeline         = m_computePipelines.front();
+}
+
+void ComputeRenderPass::bindComputePipeline(vk::CommandBuffer commandBuffer, uint32_t index) {
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, m_computePipelines[index]);
+    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, m_pipelineLayout, PASS_SET, 1,
+                                     &m_descriptorSet, 0, nullptr);
 }
 
 }; // namespace vuren
\ No newline at end of file
@@ -7,10 +7,15 @@
 #include <imgui/imgui.h>
 
 #include "Common.hpp"
+#include "CommonShaders/Bindless.h"
 #include "ResourceManager.hpp"
 #include "Scene.hpp"
+#include "ShaderReflection.hpp"
+#include "ThreadPool.hpp"
 #include "Utils.hpp"
 
+#include <future>
+#include <map>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -21,11 +26,11 @@ class VulkanContext;
 
 class RenderPass {
 public:
+    // a resource of the resource manager bound to a binding of the pass's shaders.
+    // acceleration structure bindings get the pass's TLAS, whatever the name.
     struct ResourceBindingInfo {
+        uint32_t binding;
         std::string name;
-        vk::DescriptorType descriptorType;
-        vk::ShaderStageFlags stageFlags;
-        uint32_t descriptorCount;
     };
 
     RenderPass();
@@ -35,28 +40,65 @@ public:
     virtual void init(VulkanContext *pContext, vk::CommandPool commandPool,
                       std::shared_ptr<ResourceManager> pResourceManager, std::shared_ptr<Scene> pScene);
     virtual void define()                                = 0;
-    virtual void setup()                                 = 0;
     virtual void record(vk::CommandBuffer commandBuffer) = 0;
     virtual void cleanup();
 
+    // setup() runs the three phases below in order. they can also be run separately, so that the pipelines of
+    // several passes compile concurrently while the main thread goes on:
+    // define() declares the resources, the descriptor set and the pipeline layout (main thread),
+    // compilePipeline() creates the pipeline (any thread, but one at a time per pass),
+    // finishSetup() creates what depends on the compiled pipeline (main thread).
+    virtual void setup();
+    virtual void compilePipeline() = 0;
+    virtual void finishSetup() {}
+
+    // the SPIR-V files of the pipeline
+    virtual std::vector<std::string> getShaderPaths() const { return {}; }
+
+    // reads the SPIR-V files again and replaces the pipeline (and for ray tracing, the SBT), while the scene and the
+    // resources stay. only the descriptor set and the pipeline layout of a pass whose shader interface changed are
+    // recreated. no submitted frame may use the pipeline any more. on failure the previous pipeline is kept.
+    virtual void reloadShaders();
+
     // a simple rule for output texture barriers
     // 1. output texture's newLayout is always ShaderReadOnly
     // 2. output texture's oldLayout is always General if the render pass is rt, 
     //    and ColorAttachment/DepthAttachment/eUndefined if the render pass is raster (doesn't matter)
     virtual void outputTextureBarrier(vk::CommandBuffer commandBuffer) {}
 
-    void createDescriptorSet(const std::vector<ResourceBindingInfo> &bindingInfos);
+    // the resources of the descriptor set, given before the pipeline is declared. the descriptor types, stages and
+    // array sizes are reflected from the shaders.
+    void bindResources(const std::vector<ResourceBindingInfo> &bindingInfos) { m_resourceBindings = bindingInfos; }
     vk::ShaderModule createShaderModule(const std::vector<char> &code);
 
     void setExtent(vk::Extent2D extent) { m_extent = extent; }
 
 protected:
+    vk::PipelineCache getPipelineCache() const;
+    void addPipelineCreationTime(const std::string &shaderPath, double ms);
+
+    // reads the SPIR-V of every stage and reflects its bindings
+    virtual void readShaders() = 0;
+    void reflectShader(const std::vector<char> &code, const std::string &shaderPath);
+    const std::string &getBoundResource(const ReflectedBinding &reflected) const;
+
+    // gets the layout of the reflected bindings from the descriptor cache, then allocates and writes the set.
+    // the pass's bindings are in set 1, set 0 is the bindless table.
+    void createDescriptorSet();
+    // {bindless table, pass set}, with the push constant range shared by every pass
+    void createPipelineLayout();
+    // writes the bound resources again, e.g. after bindResources() changed one
+    void writeDescriptorSet();
+
     vk::Pipeline m_pipeline{ VK_NULL_HANDLE };
     vk::PipelineLayout m_pipelineLayout{ VK_NULL_HANDLE };
     vk::DescriptorSetLayout m_descriptorSetLayout{ VK_NULL_HANDLE };
-    vk::DescriptorPool m_descriptorPool{ VK_NULL_HANDLE };
     vk::DescriptorSet m_descriptorSet{ VK_NULL_HANDLE };
 
+    std::vector<ResourceBindingInfo> m_resourceBindings;
+    std::vector<ReflectedBinding> m_reflectedBindings;
+    std::vector<vk::DescriptorSetLayoutBinding> m_layoutBindings; // the reflected bindings with arrays sized
+
     VulkanContext *m_pContext{ nullptr };
     vk::CommandPool m_commandPool{ VK_NULL_HANDLE };
 
@@ -91,9 +133,12 @@ public:
                       std::shared_ptr<ResourceManager> pResourceManager, std::shared_ptr<Scene> pScene);
     virtual void define()                                = 0;
     virtual void record(vk::CommandBuffer commandBuffer) = 0;
-    virtual void setup();
+    virtual void compilePipeline();
     virtual void cleanup();
 
+    std::vector<std::string> getShaderPaths() const override { return { m_vertShaderPath, m_fragShaderPath }; }
+
+    // declares the pipeline and creates its descriptor set, the pipeline is created by compilePipeline()
     void setupRasterPipeline(const std::string &vertShaderPath, const std::string &fragShaderPath,
                              bool isBlitPass = false);
     void createFramebuffer(const std::vector<AttachmentInfo> &colorAttachmentInfos,
@@ -104,12 +149,16 @@ public:
     vk::RenderPass getRenderPass() { return m_renderPass; }
 
 protected:
+    void readShaders() override;
+
     vk::RenderPass m_renderPass{ VK_NULL_HANDLE };
     vk::Framebuffer m_framebuffer{ VK_NULL_HANDLE };
     bool m_isBiltPass{ false };
     uint32_t m_colorAttachmentCount{ 0 };
     std::string m_vertShaderPath;
     std::string m_fragShaderPath;
+    std::vector<char> m_vertShaderCode;
+    std::vector<char> m_fragShaderCode;
 
 }; // class RasterRenderPass
 
@@ -137,9 +186,15 @@ public:
                       std::shared_ptr<ResourceManager> pResourceManager, std::shared_ptr<Scene> pScene);
     virtual void define()                                = 0;
     virtual void record(vk::CommandBuffer commandBuffer) = 0;
-    virtual void setup();
+    virtual void compilePipeline();
+    virtual void finishSetup();
     virtual void cleanup();
 
+    std::vector<std::string> getShaderPaths() const override {
+        return { m_raygenShaderPath, m_missShaderPath, m_closestHitShaderPath };
+    }
+    void reloadShaders() override;
+
     BlasInput objectToVkGeometryKHR(const SceneObject &object);
     void buildBlas(const std::vector<BlasInput> &input, vk::BuildAccelerationStructureFlagsKHR flags);
     void createBlas();
@@ -151,17 +206,74 @@ public:
     uint32_t align_up(uint32_t size, uint32_t alignment);
     void createShaderBindingTable();
 
+    // declares the pipeline and creates its descriptor set, the pipeline is created by compilePipeline()
     void setupRayTracingPipeline(const std::string &raygenShaderPath, const std::string &missShaderPath,
                                  const std::string &closestHitShaderPath);
 
+    // builder preference for the BLAS of this pass. must be set before init(), which builds the BLAS.
+    // ePreferFastTrace lets the driver spend more build time on a higher quality tree (e.g. with spatial splits
+    // for long, thin triangles); ePreferFastBuild trades trace performance for build time.
+    void setBlasBuildFlags(vk::BuildAccelerationStructureFlagsKHR flags) { m_blasBuildFlags = flags; }
+    // wall clock time and final (compacted) size of the last buildBlas(), to compare the builder preferences
+    double getBlasBuildMs() const { return m_blasBuildMs; }
+    vk::DeviceSize getBlasSize() const { return m_blasSize; }
+
+    // a 32-bit specialization constant (bool, int, uint or float) given to every stage of the pipeline.
+    // set before compilePipeline() for the initial pipeline, afterwards it takes effect with updatePipelineVariant().
+    void setSpecializationConstant(uint32_t constantId, uint32_t value);
+    void setSpecializationConstant(uint32_t constantId, float value);
+
+    // switches to the pipeline of the current specialization constant values. a combination used for the first time
+    // is compiled on a background thread while the current pipeline keeps rendering, and every compiled variant is
+    // kept, so switching back to it is free. main thread, once per frame. returns true when the pipeline changed.
+    bool updatePipelineVariant();
+    bool isCompilingVariant() const;
+    size_t getPipelineVariantCount() const { return m_pipelineVariants.size(); }
+
 protected:
+    // a pipeline compiled with one combination of specialization constant values, and its SBT
+    struct PipelineVariant {
+        std::future<vk::Pipeline> pendingPipeline; // valid while compiling
+        vk::Pipeline pipeline{ VK_NULL_HANDLE };
+        Buffer sbtBuffer;
+        vk::StridedDeviceAddressRegionKHR rgenRegion{};
+        vk::StridedDeviceAddressRegionKHR missRegion{};
+        vk::StridedDeviceAddressRegionKHR hitRegion{};
+        bool failed{ false };
+    };
+
+    void readShaders() override;
+
+    // only reads the shader code and the pipeline layout of the pass, so it can run on any thread
+    vk::Pipeline createPipeline(const std::vector<vk::SpecializationMapEntry> &specializationEntries,
+                                const std::vector<uint32_t> &specializationData);
+
+    // the active variant is the one in m_pipeline and m_sbtBuffer
+    void storeActiveVariant();
+    // waits for the variants being compiled, then destroys every variant but the active one
+    void destroyInactiveVariants();
+
     std::string m_raygenShaderPath;
     std::string m_missShaderPath;
     std::string m_closestHitShaderPath;
+    std::vector<char> m_raygenShaderCode;
+    std::vector<char> m_missShaderCode;
+    std::vector<char> m_closestHitShaderCode;
     std::vector<AccelerationStructure> m_blas;
+    vk::BuildAccelerationStructureFlagsKHR m_blasBuildFlags{
+        vk::BuildAccelerationStructureFlagBitsKHR::ePreferFastTrace
+    };
+    double m_blasBuildMs{ 0.0 };
+    vk::DeviceSize m_blasSize{ 0 };
+    std::vector<vk::SpecializationMapEntry> m_specializationEntries;
+    std::vector<uint32_t> m_specializationData;
+
+    // keyed by the specialization data (the entries only grow, so a key always means the same constants)
+    std::map<std::vector<uint32_t>, PipelineVariant> m_pipelineVariants;
+    std::vector<uint32_t> m_activeVariantKey;
+    std::unique_ptr<ThreadPool> m_pVariantCompiler;
 
     vk::PhysicalDeviceRayTracingPipelinePropertiesKHR m_rtProperties;
-    std::vector<vk::RayTracingShaderGroupCreateInfoKHR> m_shaderGroups;
     Buffer m_sbtBuffer;
     vk::StridedDeviceAddressRegionKHR m_rgenRegion{};
     vk::StridedDeviceAddressRegionKHR m_missRegion{};
@@ -170,6 +282,37 @@ protected:
 
 }; // class RayTracingRenderPass
 
+class ComputeRenderPass : public RenderPass {
+public:
+    ComputeRenderPass();
+    ~ComputeRenderPass();
+
+    virtual void init(VulkanContext *pContext, vk::CommandPool commandPool,
+                      std::shared_ptr<ResourceManager> pResourceManager, std::shared_ptr<Scene> pScene);
+    virtual void define()                                = 0;
+    virtual void record(vk::CommandBuffer commandBuffer) = 0;
+    virtual void compilePipeline();
+    virtual void cleanup();
+
+    std::vector<std::string> getShaderPaths() const override { return m_computeShaderPaths; }
+    void reloadShaders() override;
+
+    // declares one compute pipeline per shader, all sharing the pass's descriptor set (the union of their bindings)
+    // and pipeline layout, and creates the descriptor set. the pipelines are created by compilePipeline()
+    void setupComputePipelines(const std::vector<std::string> &computeShaderPaths);
+
+protected:
+    void readShaders() override;
+
+    // binds the pipeline of the index-th shader given to setupComputePipelines() and the pass's descriptor set
+    void bindComputePipeline(vk::CommandBuffer commandBuffer, uint32_t index);
+
+    std::vector<std::string> m_computeShaderPaths;
+    std::vector<std::vector<char>> m_computeShaderCodes;
+    std::vector<vk::Pipeline> m_computePipelines; // the first one is m_pipeline
+
+}; // class ComputeRenderPass
+
 } // namespace vuren
 
 #endif // RENDER_PASS_HPP
\ No newline at end of file
@@ -0,0 +1,17 @@
+#version 460
+#extension GL_GOOGLE_include_directive : enable
+#extension GL_EXT_shader_explicit_arithmetic_types_int64 : require
+
+#include "Common.hpp"
+#include "AccumCommon.h"
+
+layout(local_size_x = ACCUM_GROUP_SIZE, local_size_y = ACCUM_GROUP_SIZE) in;
+
+void main() {
+    ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+    ivec2 size = textureSize(currentFrame, 0);
+    if (any(greaterThanEqual(pixel, size)))
+        return;
+
+    accumulate(pixel, size);
+}
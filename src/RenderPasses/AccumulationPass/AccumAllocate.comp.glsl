@@ -0,0 +1,49 @@
+#version 460
+#extension GL_GOOGLE_include_directive : enable
+#extension GL_EXT_shader_explicit_arithmetic_types_int64 : require
+
+#include "Common.hpp"
+#include "AccumCommon.h"
+#include "RenderPasses/PathTracingPass/PtCommon.h"
+
+layout(local_size_x = ACCUM_ALLOCATE_GROUP_SIZE, local_size_y = ACCUM_ALLOCATE_GROUP_SIZE) in;
+
+// the path tracer's adaptive launch: the pixels to trace, and the size of the launch, zeroed before the kernel
+layout(set = 1, binding = 11) buffer _PtPixelList {
+    uint pixelList[];
+};
+layout(set = 1, binding = 12) buffer _PtDispatch {
+    PtDispatch dispatchSize;
+};
+// 1 in r for the pixels in the list, read by the svgf pass
+layout(set = 1, binding = 13, rgba8) uniform writeonly image2D sampledMask;
+
+shared uint groupCount;
+shared uint groupOffset;
+
+// sample allocation: appends every pixel that needs a path this frame to the list the path tracer launches over.
+// a workgroup reserves the slots of its pixels with a single atomic, so the pixels of a tile stay together.
+void main() {
+    ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+    ivec2 size = imageSize(momentsImages[0]);
+    bool inside = all(lessThan(pixel, size));
+    bool sampled = inside && isPixelSampled(pixel);
+    if (inside)
+        imageStore(sampledMask, pixel, vec4(sampled ? 1.0 : 0.0));
+
+    if (gl_LocalInvocationIndex == 0)
+        groupCount = 0;
+    barrier();
+
+    uint slot = 0;
+    if (sampled)
+        slot = atomicAdd(groupCount, 1);
+    barrier();
+
+    if (gl_LocalInvocationIndex == 0)
+        groupOffset = atomicAdd(dispatchSize.width, groupCount);
+    barrier();
+
+    if (sampled)
+        pixelList[groupOffset + slot] = packPixel(uvec2(pixel));
+}
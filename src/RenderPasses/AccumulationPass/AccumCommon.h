@@ -12,12 +12,207 @@ using mat4 = glm::mat4x4;
 using uint = unsigned int;
 #endif
 
+// the accumulation kernel runs 16x16 threads per workgroup
+#define ACCUM_GROUP_SIZE 16
+
 struct AccumData {
-    uint frameCount;
+    uint frameCount;   // frames since the last reset
+    uint historyIndex; // the color and geometry images written this frame (0 or 1), the other pair is read
+    uint reset;        // 1 drops every history sample
+    uint maxHistoryLength;
+
+    // disocclusion: the reprojected history is rejected when its view depth differs by more than depthTolerance
+    // (relative) or its normal by more than acos(normalTolerance)
+    float depthTolerance;
+    float normalTolerance;
+
+    // moving pixels clamp the history to the current frame's 3x3 mean +- clampGamma * standard deviation
+    float clampGamma;
+
+    // adaptive sampling: while the view is still, a pixel only gets paths until the standard error of its mean
+    // luminance is below errorThreshold times the mean, after at least minSamples
+    float errorThreshold;
+    uint adaptive; // 1 when the path tracer only launches the pixels of the allocation kernel's list
+    uint minSamples;
+    uint pad0;
+    uint pad1;
+};
+
+// one pixel out of every ACCUM_STATS_STRIDE x ACCUM_STATS_STRIDE adds its history length to the counters
+#define ACCUM_STATS_STRIDE 16
+
+struct AccumStats {
+    uint sampledPixels;
+    uint historySum;        // history samples after this frame (at most 65536 each), summed over the sampled pixels
+    uint disoccludedPixels; // sampled pixels that started over this frame
+    uint activePixels;      // pixels given a path this frame (adaptive sampling), copied from the dispatch size
+};
+
+// the allocation kernel runs 16x16 threads per workgroup as well, each group appends its pixels in one go
+#define ACCUM_ALLOCATE_GROUP_SIZE 16
+
+// tone mapping operators of the fused present kernel
+#define ACCUM_TONEMAP_CLAMP 0u
+#define ACCUM_TONEMAP_ACES 1u
+
+// pushed before the fused present kernel, AccumPresent.comp
+struct AccumPresentPushConstant {
+    float exposure;   // in stops
+    uint tonemap;     // ACCUM_TONEMAP_CLAMP or ACCUM_TONEMAP_ACES
+    uint swapRedBlue; // 1 when the swap chain is BGRA, the present image is copied to it bit by bit
+    uint pad;
 };
 
 #ifdef __cplusplus
 } // namespace vuren
-#endif
+#else
+
+// the resources of both kernels, Accum.comp and AccumPresent.comp
+layout(set = 1, binding = 0) uniform sampler2D currentFrame;
+layout(set = 1, binding = 1) uniform sampler2D worldPos;
+layout(set = 1, binding = 2) uniform sampler2D worldNormal;
+layout(set = 1, binding = 3) uniform sampler2D motion;
+
+// two pairs of images indexed by accumData.historyIndex, the pair of the last frame is read while the other one is
+// written. color: the accumulated mean in rgb and its number of samples in a, which is also the output of the frame.
+// geometry: the world normal in xyz and the view depth in w (0 for the background).
+layout(set = 1, binding = 4, rgba32f) uniform image2D colorImages[2];
+layout(set = 1, binding = 5, rgba32f) uniform image2D geometryImages[2];
+
+layout(set = 1, binding = 6) uniform _AccumData {
+	AccumData accumData;
+};
+layout(set = 1, binding = 7) uniform _Camera {
+	CameraData camera;
+};
+layout(set = 1, binding = 8) buffer _AccumStats {
+	AccumStats accumStats;
+};
+
+// adaptive sampling, indexed by accumData.historyIndex as well: the second moment of the luminance in r, and in g
+// whether the pixel gets a path in the next frame
+layout(set = 1, binding = 10, rgba32f) uniform image2D momentsImages[2];
+
+float luminance(vec3 color) {
+    return dot(color, vec3(0.2126, 0.7152, 0.0722));
+}
+
+vec4 loadHistoryColor(ivec2 pixel) {
+    return imageLoad(colorImages[accumData.historyIndex ^ 1], pixel);
+}
+
+vec4 loadHistoryGeometry(ivec2 pixel) {
+    return imageLoad(geometryImages[accumData.historyIndex ^ 1], pixel);
+}
+
+vec4 loadHistoryMoments(ivec2 pixel) {
+    return imageLoad(momentsImages[accumData.historyIndex ^ 1], pixel);
+}
+
+// whether the path tracer launches a pixel this frame (adaptive sampling): every pixel while the history is dropped
+// or the view moves, otherwise the ones the accumulation of the last frame found too noisy. the allocation kernel
+// and the accumulation read the same history, so they agree.
+bool isPixelSampled(ivec2 pixel) {
+    if (accumData.reset != 0 || camera.view != camera.prevView || camera.proj != camera.prevProj)
+        return true;
+    return loadHistoryMoments(pixel).g != 0.0;
+}
+
+// whether the mean of n samples still needs more of them: its standard error against the mean luminance. the mean
+// is floored so that nearly black pixels do not chase a vanishing error.
+bool needsSamples(float mean, float m2, float n) {
+    if (n < float(accumData.minSamples))
+        return true;
+    float variance = max(m2 - mean * mean, 0.0) * n / (n - 1.0);
+    return sqrt(variance / n) > accumData.errorThreshold * max(mean, 1e-2);
+}
+
+void addStats(ivec2 pixel, float historyLength, bool valid) {
+    if (all(equal(pixel % ACCUM_STATS_STRIDE, ivec2(0)))) {
+        // capped so that the sum cannot overflow
+        atomicAdd(accumStats.sampledPixels, 1);
+        atomicAdd(accumStats.historySum, uint(min(historyLength, 65536.0)));
+        if (!valid)
+            atomicAdd(accumStats.disoccludedPixels, 1);
+    }
+}
+
+// whether the surface seen at prevPixel in the last frame is the one seen now
+bool isSameSurface(ivec2 prevPixel, vec4 position, vec3 normal) {
+    vec4 prevGeometry = loadHistoryGeometry(prevPixel);
+    bool background = position.w == 0.0;
+    if (background || prevGeometry.w == 0.0)
+        return background && prevGeometry.w == 0.0;
+
+    // the view depth the current surface had in the last frame
+    float expectedDepth = -(camera.prevView * vec4(position.xyz, 1.0)).z;
+    if (abs(prevGeometry.w - expectedDepth) > accumData.depthTolerance * max(expectedDepth, 1e-4))
+        return false;
+    return dot(prevGeometry.xyz, normal) >= accumData.normalTolerance;
+}
+
+// accumulates the current frame into the color image of this frame and returns the accumulated color
+vec3 accumulate(ivec2 pixel, ivec2 size) {
+    // a pixel left out of the launch still holds an old path in the current frame, its history is carried over
+    if (accumData.adaptive != 0 && !isPixelSampled(pixel)) {
+        vec4 history = loadHistoryColor(pixel);
+        imageStore(colorImages[accumData.historyIndex], pixel, history);
+        imageStore(geometryImages[accumData.historyIndex], pixel, loadHistoryGeometry(pixel));
+        imageStore(momentsImages[accumData.historyIndex], pixel, loadHistoryMoments(pixel));
+        addStats(pixel, history.a, true);
+        return history.rgb;
+    }
+
+    vec4 current = texelFetch(currentFrame, pixel, 0);
+    vec4 position = texelFetch(worldPos, pixel, 0);
+    vec3 normal = texelFetch(worldNormal, pixel, 0).xyz;
+    vec2 pixelMotion = texelFetch(motion, pixel, 0).xy * vec2(size);
+
+    // the nearest pixel of the last frame
+    ivec2 prevPixel = ivec2(floor(vec2(pixel) + 0.5 - pixelMotion));
+    bool valid = accumData.reset == 0 && all(greaterThanEqual(prevPixel, ivec2(0))) &&
+                 all(lessThan(prevPixel, size)) && isSameSurface(prevPixel, position, normal);
+
+    vec4 history = valid ? loadHistoryColor(prevPixel) : vec4(0.0);
+    vec3 prevMean = history.rgb;
+    float n = min(history.a, float(accumData.maxHistoryLength));
+
+    // a reprojected history may come from a slightly different surface point, keep it within the range of the
+    // current neighborhood. a still pixel is left alone, so a static view converges like a plain running mean.
+    if (valid && dot(pixelMotion, pixelMotion) > 1e-6) {
+        vec3 m1 = vec3(0.0);
+        vec3 m2 = vec3(0.0);
+        for (int y = -1; y <= 1; ++y) {
+            for (int x = -1; x <= 1; ++x) {
+                vec3 c = texelFetch(currentFrame, clamp(pixel + ivec2(x, y), ivec2(0), size - 1), 0).rgb;
+                m1 += c;
+                m2 += c * c;
+            }
+        }
+        vec3 mean = m1 / 9.0;
+        vec3 sigma = sqrt(max(m2 / 9.0 - mean * mean, vec3(0.0)));
+        prevMean = clamp(prevMean, mean - accumData.clampGamma * sigma, mean + accumData.clampGamma * sigma);
+    }
+
+    vec3 accum = (prevMean * n + current.rgb) / (n + 1.0);
+    float depth = position.w == 0.0 ? 0.0 : -(camera.view * vec4(position.xyz, 1.0)).z;
+
+    imageStore(colorImages[accumData.historyIndex], pixel, vec4(accum, n + 1.0));
+    imageStore(geometryImages[accumData.historyIndex], pixel, vec4(normal, depth));
+
+    if (accumData.adaptive != 0) {
+        float m2 = valid ? loadHistoryMoments(prevPixel).r : 0.0;
+        float l = luminance(current.rgb);
+        m2 = (m2 * n + l * l) / (n + 1.0);
+        float next = needsSamples(luminance(accum), m2, n + 1.0) ? 1.0 : 0.0;
+        imageStore(momentsImages[accumData.historyIndex], pixel, vec4(m2, next, 0.0, 0.0));
+    }
+
+    addStats(pixel, n + 1.0, valid);
+
+    return accum;
+}
+
+#endif // __cplusplus
 
 #endif // ACCUM_COMMON_H
\ No newline at end of file
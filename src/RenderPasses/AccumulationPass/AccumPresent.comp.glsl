@@ -0,0 +1,42 @@
+#version 460
+#extension GL_GOOGLE_include_directive : enable
+#extension GL_EXT_shader_explicit_arithmetic_types_int64 : require
+
+#include "Common.hpp"
+#include "AccumCommon.h"
+
+layout(local_size_x = ACCUM_GROUP_SIZE, local_size_y = ACCUM_GROUP_SIZE) in;
+
+// the displayed frame: tone mapped and sRGB encoded, copied to the swap chain image as it is
+layout(set = 1, binding = 9, rgba8) uniform writeonly image2D presentImage;
+
+layout(push_constant) uniform _AccumPresentPushConstant {
+    AccumPresentPushConstant presentPush;
+};
+
+// the fit of the ACES filmic curve by Krzysztof Narkowicz
+vec3 tonemapAces(vec3 x) {
+    return clamp((x * (2.51 * x + 0.03)) / (x * (2.43 * x + 0.59) + 0.14), 0.0, 1.0);
+}
+
+vec3 encodeSrgb(vec3 linear) {
+    bvec3 low = lessThanEqual(linear, vec3(0.0031308));
+    return mix(1.055 * pow(linear, vec3(1.0 / 2.4)) - 0.055, linear * 12.92, low);
+}
+
+// accumulates and presents in one dispatch, the accumulated color is never read back by a fullscreen pass
+void main() {
+    ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+    ivec2 size = textureSize(currentFrame, 0);
+    if (any(greaterThanEqual(pixel, size)))
+        return;
+
+    vec3 color = accumulate(pixel, size) * exp2(presentPush.exposure);
+    color = presentPush.tonemap == ACCUM_TONEMAP_ACES ? tonemapAces(color) : clamp(color, 0.0, 1.0);
+    color = encodeSrgb(color);
+    if (presentPush.swapRedBlue != 0)
+        color = color.bgr;
+
+    // the images are sampled with the origin at the top left, as the swap chain is
+    imageStore(presentImage, pixel, vec4(color, 1.0));
+}
@@ -1,11 +1,16 @@
 #ifndef ACCUMULATION_PASS_HPP
 #define ACCUMULATION_PASS_HPP
 
+#include "BindlessTable.hpp"
 #include "RenderPass.hpp"
 #include "AccumCommon.h"
+#include "RenderPasses/PathTracingPass/PtCommon.h"
 
 namespace vuren {
-class AccumulationPass : public RasterRenderPass {
+
+// temporal accumulation of the path traced frames, in a compute shader. the accumulated color is written once per
+// pixel, into one of two images that take turns as the output and the history of the next frame.
+class AccumulationPass : public ComputeRenderPass {
 public:
     AccumulationPass() {}
 
@@ -13,140 +18,383 @@ public:
 
     void init(VulkanContext *pContext, vk::CommandPool commandPool, std::shared_ptr<ResourceManager> pResourceManager,
               std::shared_ptr<Scene> pScene) override {
-        RasterRenderPass::init(pContext, commandPool, pResourceManager, pScene);
+        ComputeRenderPass::init(pContext, commandPool, pResourceManager, pScene);
+
+        m_accumData.frameCount       = 0;
+        m_accumData.historyIndex     = 0;
+        m_accumData.reset            = 1;
+        m_accumData.maxHistoryLength = 1u << 24; // the sample count is stored as a float
+        m_accumData.depthTolerance   = 0.05f;
+        m_accumData.normalTolerance  = 0.9f;
+        m_accumData.clampGamma       = 1.0f;
+        m_accumData.errorThreshold   = 0.02f;
+        m_accumData.adaptive         = 0;
+        m_accumData.minSamples       = 16;
+
+        // the same image as the final pass by default, which clamps and encodes
+        m_presentPush.exposure = 0.0f;
+        m_presentPush.tonemap  = ACCUM_TONEMAP_CLAMP;
+
+        // the first frame has no history
+        m_resetPending = true;
+    }
+
+    // accumulates, tone maps and sRGB encodes in one dispatch (AccumPresent.comp) into "AccumPresentImage", which
+    // takes the place of the final pass: it is copied to the swap chain image as it is. must be called before define().
+    // swapRedBlue: the swap chain images are BGRA
+    void enablePresent(bool swapRedBlue) {
+        m_presentEnabled          = true;
+        m_presentPush.swapRedBlue = swapRedBlue ? 1 : 0;
+    }
+
+    bool isPresentEnabled() const { return m_presentEnabled; }
 
-        m_accumData.frameCount = 0;
-        m_lastCameraView = m_pScene->getCamera().getData().view;
+    // tracks the variance of every pixel and lists the ones above the error threshold for the path tracer's adaptive
+    // launch (PtPixelList and PtDispatch), see recordSampleAllocation(). must be called before define().
+    // errorThreshold: the standard error of a pixel's mean luminance relative to it, minSamples: at least 2
+    void enableAdaptiveSampling(float errorThreshold, uint32_t minSamples) {
+        m_accumData.adaptive       = 1;
+        m_accumData.errorThreshold = errorThreshold;
+        m_accumData.minSamples     = minSamples;
     }
 
-    void updateGui() {
+    bool isAdaptiveSamplingEnabled() const { return m_accumData.adaptive != 0; }
+
+    // passMs: the average gpu time of the pass
+    void updateGui(float passMs) {
         if (!ImGui::CollapsingHeader("Accumulation Pass"))
             return;
 
-        ImGui::Text(" %d frames accumulated", m_accumData.frameCount);
+        double pixels         = static_cast<double>(m_extent.width) * m_extent.height;
+        uint32_t momentsBytes = isAdaptiveSamplingEnabled() ? kBytesMomentsPerPixel : 0;
+        double readBytes      = pixels * (kBytesReadPerPixel + momentsBytes);
+        double writtenBytes   = pixels * (kBytesWrittenPerPixel + momentsBytes +
+                                        (m_presentEnabled ? kBytesPresentedPerPixel : 0));
+        ImGui::Text(" %.3f ms, %.1f MB read and %.1f MB written per frame", passMs, readBytes / 1e6,
+                    writtenBytes / 1e6);
+        if (passMs > 0.0f)
+            ImGui::Text(" %.1f GB/s", (readBytes + writtenBytes) / (passMs * 1e6));
+
+        ImGui::Text(" %d frames since the last reset", m_accumData.frameCount);
+        ImGui::Text(" %.1f spp retained on average, %.1f%% disoccluded", m_effectiveSpp,
+                    m_disoccludedFraction * 100.0f);
+        ImGui::SliderFloat("Depth tolerance", &m_accumData.depthTolerance, 0.001f, 0.5f);
+        ImGui::SliderFloat("Normal tolerance", &m_accumData.normalTolerance, 0.0f, 1.0f);
+        ImGui::SliderFloat("Clamp gamma", &m_accumData.clampGamma, 0.5f, 4.0f);
+
+        if (isAdaptiveSamplingEnabled()) {
+            ImGui::Text(" %.1f%% of the pixels traced in the last frame",
+                        m_activePixels * 100.0 / (static_cast<double>(m_extent.width) * m_extent.height));
+
+            // the converged pixels are not evaluated again, so a new threshold starts over
+            ImGui::SliderFloat("Error threshold", &m_accumData.errorThreshold, 0.001f, 0.2f, "%.3f",
+                               ImGuiSliderFlags_Logarithmic);
+            bool changed   = ImGui::IsItemDeactivatedAfterEdit();
+            int minSamples = static_cast<int>(m_accumData.minSamples);
+            ImGui::SliderInt("Min samples", &minSamples, 2, 256);
+            m_accumData.minSamples = static_cast<uint32_t>(minSamples);
+            changed |= ImGui::IsItemDeactivatedAfterEdit();
+            if (changed)
+                resetHistory();
+        }
+
+        if (m_presentEnabled) {
+            const char *tonemaps[] = { "Clamp", "ACES" };
+            int tonemap            = static_cast<int>(m_presentPush.tonemap);
+            if (ImGui::Combo("Tone mapping", &tonemap, tonemaps, IM_ARRAYSIZE(tonemaps)))
+                m_presentPush.tonemap = static_cast<uint32_t>(tonemap);
+            ImGui::SliderFloat("Exposure", &m_presentPush.exposure, -8.0f, 8.0f);
+        }
     }
 
+    // must be called once per submitted frame, once the last frame has completed
     void updateUniformBuffer() {
-        // camera has moved
-        if (m_lastCameraView != m_pScene->getCamera().getData().view) {
-            m_lastCameraView = m_pScene->getCamera().getData().view;
+        if (m_resetPending) {
             m_accumData.frameCount = 0;
+            m_accumData.reset      = 1;
+            m_resetPending         = false;
+        } else {
+            m_accumData.frameCount++;
+            m_accumData.reset = 0;
         }
 
-        else
-            m_accumData.frameCount++;
-        
+        // the pair written by the last frame is read by this one
+        m_accumData.historyIndex ^= 1;
+
         memcpy(m_pResourceManager->getMappedBuffer("AccumData"), &m_accumData, sizeof(AccumData));
+
+        // descriptor sets sampling "AccumOutput" have to be written again to follow it
+        m_pResourceManager->redirectTexture(kColorTextureNames[m_accumData.historyIndex], "AccumOutput");
     }
 
-    void connectTextureCurrentFrame(const std::string &srcTexture) {
-        m_pResourceManager->connectTextures(srcTexture, "AccumInCurrentFrame");
+    // starts over with the next frame, e.g. after the shaders producing it changed.
+    // a moving camera reprojects the history instead.
+    void resetHistory() { m_resetPending = true; }
+
+    // reads the counters of the last frame, once its fence has signaled
+    void readStats() {
+        m_activePixels = m_pStats->activePixels;
+        if (m_pStats->sampledPixels == 0)
+            return;
+
+        m_effectiveSpp        = m_pStats->historySum / static_cast<float>(m_pStats->sampledPixels);
+        m_disoccludedFraction = m_pStats->disoccludedPixels / static_cast<float>(m_pStats->sampledPixels);
     }
 
-    void define() override {
-        m_pResourceManager->createTextureRGBA32Sfloat("AccumInCurrentFrame");
-        m_pResourceManager->createTextureRGBA32Sfloat("AccumInPreviousFrames");
-        m_pResourceManager->createTextureRGBA32Sfloat("AccumOutput");
-        m_pResourceManager->createDepthTexture("AccumDepth");
-        m_pResourceManager->createUniformBuffer<AccumData>("AccumData");
+    // the average number of samples a pixel holds after the last frame, and the fraction that started over
+    float getEffectiveSpp() const { return m_effectiveSpp; }
+    float getDisoccludedFraction() const { return m_disoccludedFraction; }
 
-        m_pContext->kOffscreenOutputTextureNames.push_back("AccumOutput");
-        
-        transitionImageLayout(*m_pContext, m_commandPool, m_pResourceManager->getTexture("AccumInPreviousFrames"), vk::ImageLayout::eUndefined,
-                              vk::ImageLayout::eGeneral, vk::PipelineStageFlagBits::eAllCommands,
-                              vk::PipelineStageFlagBits::eFragmentShader);
-
-        // create a descriptor set
-        std::vector<ResourceBindingInfo> bindings;
-        bindings.push_back(
-            { "AccumInCurrentFrame", vk::DescriptorType::eCombinedImageSampler, vk::ShaderStageFlagBits::eFragment, 1 });
-        bindings.push_back(
-            { "AccumInPreviousFrames", vk::DescriptorType::eStorageImage, vk::ShaderStageFlagBits::eFragment, 1 });
-        bindings.push_back({ "AccumData", vk::DescriptorType::eUniformBuffer, vk::ShaderStageFlagBits::eFragment, 1 });
-
-        createDescriptorSet(bindings);
-
-        // create framebuffers for the attachments
-        std::vector<AttachmentInfo> colorAttachments = {
-            { .imageView     = m_pResourceManager->getTexture("AccumOutput")->descriptorInfo.imageView,
-              .format        = vk::Format::eR32G32B32A32Sfloat,
-              .oldLayout     = vk::ImageLayout::eUndefined,
-              .newLayout     = vk::ImageLayout::eColorAttachmentOptimal,
-              .srcStageMask  = vk::PipelineStageFlagBits::eColorAttachmentOutput,
-              .dstStageMask  = vk::PipelineStageFlagBits::eColorAttachmentOutput,
-              .srcAccessMask = vk::AccessFlagBits::eNone,
-              .dstAccessMask = vk::AccessFlagBits::eColorAttachmentWrite }
-        };
-
-        AttachmentInfo depthStencilAttachment = {
-            .imageView     = m_pResourceManager->getTexture("AccumDepth")->descriptorInfo.imageView,
-            .format        = findDepthFormat(*m_pContext),
-            .oldLayout     = vk::ImageLayout::eUndefined,
-            .newLayout     = vk::ImageLayout::eDepthStencilAttachmentOptimal,
-            .srcStageMask  = vk::PipelineStageFlagBits::eEarlyFragmentTests,
-            .dstStageMask  = vk::PipelineStageFlagBits::eEarlyFragmentTests,
-            .srcAccessMask = vk::AccessFlagBits::eNone,
-            .dstAccessMask = vk::AccessFlagBits::eDepthStencilAttachmentWrite
-        };
-
-        // create a vulkan render pass object
-        createVkRenderPass(colorAttachments, depthStencilAttachment);
-
-        createFramebuffer(colorAttachments, depthStencilAttachment);
-
-        // create a graphics pipeline for this render pass
-        setupRasterPipeline("shaders/RenderPasses/AccumulationPass/Accum.vert.spv",
-                            "shaders/RenderPasses/AccumulationPass/Accum.frag.spv", true);
+    // the paths the adaptive launch of the last frame traced, 0 once every pixel has converged
+    uint32_t getActivePixelCount() const { return m_activePixels; }
+
+    void connectTextureCurrentFrame(const std::string &srcTexture) {
+        m_pResourceManager->connectTextures(srcTexture, "AccumInCurrentFrame");
     }
 
-    void outputTextureBarrier(vk::CommandBuffer commandBuffer) override {
-        auto accumTexture = m_pResourceManager->getTexture("AccumOutput");
-        transitionImageLayout(commandBuffer, accumTexture, vk::ImageLayout::eColorAttachmentOptimal,
-                              vk::ImageLayout::eShaderReadOnlyOptimal, vk::PipelineStageFlagBits::eAllGraphics,
-                              vk::PipelineStageFlagBits::eFragmentShader);
+    // the g-buffer of the current frame, for the reprojection and disocclusion
+    void connectTextureWorldPos(const std::string &srcTexture) {
+        m_pResourceManager->connectTextures(srcTexture, "AccumInWorldPos");
     }
 
-    void record(vk::CommandBuffer commandBuffer) override {
+    void connectTextureWorldNormal(const std::string &srcTexture) {
+        m_pResourceManager->connectTextures(srcTexture, "AccumInWorldNormal");
+    }
 
-        std::array<vk::ClearValue, 2> clearValues{};
-        clearValues[0].color        = vk::ClearColorValue{ std::array<float, 4>{ 0.0f, 0.0f, 0.0f, 0.0f } };
-        clearValues[1].depthStencil = vk::ClearDepthStencilValue{ 1.0f, 0 };
+    void connectTextureMotion(const std::string &srcTexture) {
+        m_pResourceManager->connectTextures(srcTexture, "AccumInMotion");
+    }
 
-        vk::RenderPassBeginInfo renderPassInfo{ .renderPass  = m_renderPass,
-                                                .framebuffer = m_framebuffer,
-                                                .renderArea{ .offset = { 0, 0 }, .extent = m_extent },
-                                                .clearValueCount = static_cast<uint32_t>(clearValues.size()),
-                                                .pClearValues    = clearValues.data() };
+    void define() override {
+        m_pResourceManager->createTextureRGBA32Sfloat("AccumInCurrentFrame");
+        m_pResourceManager->createTextureRGBA32Sfloat("AccumInWorldPos");
+        m_pResourceManager->createTextureRGBA32Sfloat("AccumInWorldNormal");
+        m_pResourceManager->createTextureRGBA32Sfloat("AccumInMotion");
+        m_pResourceManager->createUniformBuffer<AccumData>("AccumData");
 
-        commandBuffer.beginRenderPass(&renderPassInfo, vk::SubpassContents::eInline);
+        // ping-pong by frame, see Accum.comp. the geometry is only read by the kernel, so it stays in the general
+        // layout, while the color is sampled by the following passes between the frames, see record()
+        for (auto &name: kGeometryTextureNames) {
+            m_pResourceManager->createTextureRGBA32Sfloat(name);
+            transitionImageLayout(*m_pContext, m_commandPool, m_pResourceManager->getTexture(name),
+                                  vk::ImageLayout::eUndefined, vk::ImageLayout::eGeneral,
+                                  vk::PipelineStageFlagBits::eAllCommands, vk::PipelineStageFlagBits::eComputeShader);
+        }
+        for (auto &name: kColorTextureNames) {
+            m_pResourceManager->createTextureRGBA32Sfloat(name);
+            transitionImageLayout(*m_pContext, m_commandPool, m_pResourceManager->getTexture(name),
+                                  vk::ImageLayout::eUndefined, vk::ImageLayout::eShaderReadOnlyOptimal,
+                                  vk::PipelineStageFlagBits::eAllCommands, vk::PipelineStageFlagBits::eFragmentShader);
+        }
+        m_pResourceManager->insertTextureArray("AccumColorImages",
+                                               { m_pResourceManager->getTexture(kColorTextureNames[0]),
+                                                 m_pResourceManager->getTexture(kColorTextureNames[1]) });
+        m_pResourceManager->insertTextureArray("AccumGeometryImages",
+                                               { m_pResourceManager->getTexture(kGeometryTextureNames[0]),
+                                                 m_pResourceManager->getTexture(kGeometryTextureNames[1]) });
+
+        // ping-pong as well, only read and written by the kernels. always bound, but only touched when adaptive
+        for (auto &name: kMomentsTextureNames) {
+            m_pResourceManager->createTextureRGBA32Sfloat(name);
+            transitionImageLayout(*m_pContext, m_commandPool, m_pResourceManager->getTexture(name),
+                                  vk::ImageLayout::eUndefined, vk::ImageLayout::eGeneral,
+                                  vk::PipelineStageFlagBits::eAllCommands, vk::PipelineStageFlagBits::eComputeShader);
+        }
+        m_pResourceManager->insertTextureArray("AccumMomentsImages",
+                                               { m_pResourceManager->getTexture(kMomentsTextureNames[0]),
+                                                 m_pResourceManager->getTexture(kMomentsTextureNames[1]) });
 
-        commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, m_pipeline);
+        // follows the color image written last, see updateUniformBuffer()
+        m_pResourceManager->connectTextures(kColorTextureNames[m_accumData.historyIndex], "AccumOutput");
+        m_pContext->kOffscreenOutputTextureNames.push_back("AccumOutput");
 
-        vk::Viewport viewport{ .x        = 0.0f,
-                               .y        = 0.0f,
-                               .width    = static_cast<float>(m_extent.width),
-                               .height   = static_cast<float>(m_extent.height),
-                               .minDepth = 0.0f,
-                               .maxDepth = 1.0f };
-        commandBuffer.setViewport(0, 1, &viewport);
+        // counters of the sampled pixels, zeroed before the pass and read by the host after the frame
+        m_pResourceManager->insertBuffer(
+            "AccumStats", m_pResourceManager->createBuffer(sizeof(AccumStats),
+                                                           vk::BufferUsageFlagBits::eStorageBuffer |
+                                                               vk::BufferUsageFlagBits::eTransferDst,
+                                                           vk::MemoryPropertyFlagBits::eHostVisible |
+                                                               vk::MemoryPropertyFlagBits::eHostCoherent));
+        m_pStats = static_cast<AccumStats *>(m_pContext->m_device.mapMemory(
+            m_pResourceManager->getBuffer("AccumStats")->memory, 0, sizeof(AccumStats)));
+        memset(m_pStats, 0, sizeof(AccumStats));
+
+        // resources of the descriptor set, by binding
+        std::vector<ResourceBindingInfo> bindings = { { 0, "AccumInCurrentFrame" },
+                                                      { 1, "AccumInWorldPos" },
+                                                      { 2, "AccumInWorldNormal" },
+                                                      { 3, "AccumInMotion" },
+                                                      { 4, "AccumColorImages" },
+                                                      { 5, "AccumGeometryImages" },
+                                                      { 6, "AccumData" },
+                                                      { 7, "CameraBuffer" },
+                                                      { 8, "AccumStats" },
+                                                      { 10, "AccumMomentsImages" } };
+
+        // indexed by Kernel
+        std::vector<std::string> kernels = { "shaders/RenderPasses/AccumulationPass/Accum.comp.spv" };
+        if (m_presentEnabled) {
+            // only written by the kernel and read by transfers, so it stays in the general layout
+            m_pResourceManager->createStorageTextureRGBA8Unorm("AccumPresentImage");
+            transitionImageLayout(*m_pContext, m_commandPool, m_pResourceManager->getTexture("AccumPresentImage"),
+                                  vk::ImageLayout::eUndefined, vk::ImageLayout::eGeneral,
+                                  vk::PipelineStageFlagBits::eAllCommands, vk::PipelineStageFlagBits::eComputeShader);
+            bindings.push_back({ 9, "AccumPresentImage" });
+            kernels[eAccumulate] = "shaders/RenderPasses/AccumulationPass/AccumPresent.comp.spv";
+        }
+        if (isAdaptiveSamplingEnabled()) {
+            // which pixels the allocation kernel launched this frame, for the passes after it that blend PtOutput
+            // (see SvgfPass::connectTextureSampledMask). only written by the kernel, so it stays in the general layout
+            m_pResourceManager->createStorageTextureRGBA8Unorm("AccumSampledMask");
+            transitionImageLayout(*m_pContext, m_commandPool, m_pResourceManager->getTexture("AccumSampledMask"),
+                                  vk::ImageLayout::eUndefined, vk::ImageLayout::eGeneral,
+                                  vk::PipelineStageFlagBits::eAllCommands, vk::PipelineStageFlagBits::eComputeShader);
+
+            // the launch of the path tracer and the mask, only declared by the allocation kernel
+            bindings.push_back({ 11, "PtPixelList" });
+            bindings.push_back({ 12, "PtDispatch" });
+            bindings.push_back({ 13, "AccumSampledMask" });
+            kernels.push_back("shaders/RenderPasses/AccumulationPass/AccumAllocate.comp.spv");
+        }
 
-        vk::Rect2D scissor{ .offset = { 0, 0 }, .extent = m_extent };
-        commandBuffer.setScissor(0, 1, &scissor);
+        bindResources(bindings);
+        setupComputePipelines(kernels);
+    }
 
-        uint32_t objSize         = m_pScene->getObjects().size();
-        vk::DeviceSize offsets[] = { 0 };
+    // the sample allocation of the adaptive sampling, recorded before the path tracing pass: lists the pixels that
+    // need a path this frame into PtPixelList and their count into PtDispatch
+    void recordSampleAllocation(vk::CommandBuffer commandBuffer) {
+        vk::Buffer dispatchBuffer = m_pResourceManager->getBuffer("PtDispatch")->descriptorInfo.buffer;
+        PtDispatch emptyDispatch{ .width = 0, .height = 1, .depth = 1 };
+        commandBuffer.updateBuffer(dispatchBuffer, 0, sizeof(PtDispatch), &emptyDispatch);
+
+        // the zeroed count, and the moments the last frame has written after its launch read the list
+        vk::MemoryBarrier barrier{ .srcAccessMask = vk::AccessFlagBits::eTransferWrite |
+                                                    vk::AccessFlagBits::eShaderWrite,
+                                   .dstAccessMask = vk::AccessFlagBits::eShaderRead |
+                                                    vk::AccessFlagBits::eShaderWrite };
+        commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer |
+                                          vk::PipelineStageFlagBits::eDrawIndirect |
+                                          vk::PipelineStageFlagBits::eRayTracingShaderKHR |
+                                          vk::PipelineStageFlagBits::eComputeShader,
+                                      vk::PipelineStageFlagBits::eComputeShader, {}, 1, &barrier, 0, nullptr, 0,
+                                      nullptr);
+
+        bindComputePipeline(commandBuffer, eAllocate);
+        commandBuffer.dispatch((m_extent.width + ACCUM_ALLOCATE_GROUP_SIZE - 1) / ACCUM_ALLOCATE_GROUP_SIZE,
+                               (m_extent.height + ACCUM_ALLOCATE_GROUP_SIZE - 1) / ACCUM_ALLOCATE_GROUP_SIZE, 1);
+
+        // the launch size and the list, read by the path tracing pass
+        vk::MemoryBarrier launchBarrier{ .srcAccessMask = vk::AccessFlagBits::eShaderWrite,
+                                         .dstAccessMask = vk::AccessFlagBits::eIndirectCommandRead |
+                                                          vk::AccessFlagBits::eShaderRead |
+                                                          vk::AccessFlagBits::eTransferRead };
+        commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader,
+                                      vk::PipelineStageFlagBits::eDrawIndirect |
+                                          vk::PipelineStageFlagBits::eRayTracingShaderKHR |
+                                          vk::PipelineStageFlagBits::eTransfer,
+                                      {}, 1, &launchBarrier, 0, nullptr, 0, nullptr);
+    }
 
-        commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, m_pipelineLayout, 0, 1, &m_descriptorSet, 0,
-                                         nullptr);
+    void record(vk::CommandBuffer commandBuffer) override {
+        vk::Buffer statsBuffer = m_pResourceManager->getBuffer("AccumStats")->descriptorInfo.buffer;
+        // the active pixels are copied in after the kernel
+        commandBuffer.fillBuffer(statsBuffer, 0, offsetof(AccumStats, activePixels), 0);
+
+        // the zeroed counters, the g-buffer, the path traced frame and the history written by the last frame
+        vk::MemoryBarrier barrier{ .srcAccessMask = vk::AccessFlagBits::eTransferWrite |
+                                                    vk::AccessFlagBits::eColorAttachmentWrite |
+                                                    vk::AccessFlagBits::eShaderWrite,
+                                   .dstAccessMask = vk::AccessFlagBits::eShaderRead |
+                                                    vk::AccessFlagBits::eShaderWrite };
+        commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer |
+                                          vk::PipelineStageFlagBits::eColorAttachmentOutput |
+                                          vk::PipelineStageFlagBits::eFragmentShader |
+                                          vk::PipelineStageFlagBits::eRayTracingShaderKHR |
+                                          vk::PipelineStageFlagBits::eComputeShader,
+                                      vk::PipelineStageFlagBits::eComputeShader, {}, 1, &barrier, 0, nullptr, 0,
+                                      nullptr);
+
+        // the history is loaded and the output stored as storage images
+        for (auto &name: kColorTextureNames)
+            transitionImageLayout(commandBuffer, m_pResourceManager->getTexture(name),
+                                  vk::ImageLayout::eShaderReadOnlyOptimal, vk::ImageLayout::eGeneral,
+                                  vk::PipelineStageFlagBits::eFragmentShader, vk::PipelineStageFlagBits::eComputeShader);
+
+        bindComputePipeline(commandBuffer, eAccumulate);
+        if (m_presentEnabled)
+            commandBuffer.pushConstants(m_pipelineLayout, BindlessTable::getPushConstantRange().stageFlags, 0,
+                                        sizeof(AccumPresentPushConstant), &m_presentPush);
+        commandBuffer.dispatch((m_extent.width + ACCUM_GROUP_SIZE - 1) / ACCUM_GROUP_SIZE,
+                               (m_extent.height + ACCUM_GROUP_SIZE - 1) / ACCUM_GROUP_SIZE, 1);
+
+        // the launch size of this frame
+        vk::PipelineStageFlags srcStages = vk::PipelineStageFlagBits::eComputeShader;
+        if (isAdaptiveSamplingEnabled()) {
+            vk::BufferCopy copyRegion{ .srcOffset = offsetof(PtDispatch, width),
+                                       .dstOffset = offsetof(AccumStats, activePixels),
+                                       .size      = sizeof(uint32_t) };
+            commandBuffer.copyBuffer(m_pResourceManager->getBuffer("PtDispatch")->descriptorInfo.buffer, statsBuffer,
+                                     1, &copyRegion);
+            srcStages |= vk::PipelineStageFlagBits::eTransfer;
+        }
 
-        commandBuffer.draw(3, 1, 0, 0);
+        // make the counters visible to host reads once the submission's fence has signaled
+        vk::BufferMemoryBarrier hostBarrier{ .srcAccessMask       = vk::AccessFlagBits::eShaderWrite |
+                                                                    vk::AccessFlagBits::eTransferWrite,
+                                             .dstAccessMask       = vk::AccessFlagBits::eHostRead,
+                                             .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                                             .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                                             .buffer              = statsBuffer,
+                                             .offset              = 0,
+                                             .size                = VK_WHOLE_SIZE };
+        commandBuffer.pipelineBarrier(srcStages, vk::PipelineStageFlagBits::eHost, {}, 0, nullptr, 1, &hostBarrier, 0,
+                                      nullptr);
+    }
 
-        commandBuffer.endRenderPass();
+    void outputTextureBarrier(vk::CommandBuffer commandBuffer) override {
+        // the general layout does not make the storage writes available by itself
+        vk::MemoryBarrier barrier{ .srcAccessMask = vk::AccessFlagBits::eShaderWrite,
+                                   .dstAccessMask = vk::AccessFlagBits::eShaderRead |
+                                                    vk::AccessFlagBits::eTransferRead };
+        commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader,
+                                      vk::PipelineStageFlagBits::eFragmentShader | vk::PipelineStageFlagBits::eTransfer,
+                                      {}, 1, &barrier, 0, nullptr, 0, nullptr);
+
+        for (auto &name: kColorTextureNames)
+            transitionImageLayout(commandBuffer, m_pResourceManager->getTexture(name), vk::ImageLayout::eGeneral,
+                                  vk::ImageLayout::eShaderReadOnlyOptimal, vk::PipelineStageFlagBits::eComputeShader,
+                                  vk::PipelineStageFlagBits::eFragmentShader);
     }
 
 private:
+    // the accumulation or the fused present kernel, then the allocation kernel when adaptive
+    enum Kernel { eAccumulate, eAllocate };
+
+    // indexed by AccumData::historyIndex
+    static inline const std::array<std::string, 2> kColorTextureNames    = { "AccumColor0", "AccumColor1" };
+    static inline const std::array<std::string, 2> kGeometryTextureNames = { "AccumGeometry0", "AccumGeometry1" };
+    static inline const std::array<std::string, 2> kMomentsTextureNames  = { "AccumMoments0", "AccumMoments1" };
+
+    // the current frame, the world position, normal and motion, and the reprojected color and geometry. the 3x3
+    // neighborhood of the clamp is left out, it hits the cache.
+    static constexpr uint32_t kBytesReadPerPixel    = 6 * sizeof(vec4);
+    static constexpr uint32_t kBytesWrittenPerPixel = 2 * sizeof(vec4);
+    // the 8-bit present image
+    static constexpr uint32_t kBytesPresentedPerPixel = 4;
+    // the moments of the adaptive sampling, read and written
+    static constexpr uint32_t kBytesMomentsPerPixel = sizeof(vec4);
+
     AccumData m_accumData;
-    glm::mat4 m_lastCameraView;
+    bool m_resetPending{ true };
+
+    bool m_presentEnabled{ false };
+    AccumPresentPushConstant m_presentPush;
+
+    AccumStats *m_pStats{ nullptr };
+    float m_effectiveSpp{ 0.0f };
+    float m_disoccludedFraction{ 0.0f };
+    uint32_t m_activePixels{ 0 };
 
 }; // class AccumulationPass
 
@@ -3,20 +3,24 @@
 #extension GL_GOOGLE_include_directive : enable
 #extension GL_EXT_shader_explicit_arithmetic_types_int64 : require
 #extension GL_EXT_nonuniform_qualifier : enable
+#extension GL_KHR_shader_subgroup_arithmetic : enable
+
+#define RAY_STATS_BINDING 5
 
 #include "Common.hpp"
 #include "AoCommon.h"
 #include "CommonShaders/Random.h"
+#include "CommonShaders/RayStats.h"
 
 layout(location = 0) rayPayloadEXT SurfaceHit payload;
 
-layout(set = 0, binding = 0) uniform accelerationStructureEXT tlas;
-layout(set = 0, binding = 1) uniform _AoData {
+layout(set = 1, binding = 0) uniform accelerationStructureEXT tlas;
+layout(set = 1, binding = 1) uniform _AoData {
 	AoData aoData;
 };
-layout(set = 0, binding = 2) uniform sampler2D worldPos;
-layout(set = 0, binding = 3) uniform sampler2D worldNormal;
-layout(set = 0, binding = 4, rgba32f) uniform image2D outputColor;
+layout(set = 1, binding = 2) uniform sampler2D worldPos;
+layout(set = 1, binding = 3) uniform sampler2D worldNormal;
+layout(set = 1, binding = 4, rgba32f) uniform image2D outputColor;
 
 void main() {
     const vec2 pixelCenter = vec2(gl_LaunchIDEXT.xy) + vec2(0.5);
@@ -55,5 +59,9 @@ void main() {
         color = payload.color;
     }
 
+    // the occlusion ray is skipped on the background. the closest hit shader is skipped, a hit leaves color at 0
+    uint tracedRays = pos.w != 0.0 ? 1 : 0;
+    addRayStats(tracedRays, tracedRays > 0 && color == 0.0 ? 1 : 0, 0, pos.w != 0.0);
+
     imageStore(outputColor, ivec2(gl_LaunchIDEXT.xy), vec4(color, color, color, 0));
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 #define AMBIENT_OCCLUSION_PASS_HPP
 
 #include "AoCommon.h"
+#include "CommonShaders/RayStats.h"
 #include "RenderPass.hpp"
 
 namespace vuren {
@@ -34,6 +35,12 @@ public:
         m_pResourceManager->connectTextures(srcTexture, "AoInWorldNormal");
     }
 
+    // count the traced rays into AoRayStats (see RayStats.h), must be called before setup()
+    void enableRayStats(bool subgroupReduce) {
+        setSpecializationConstant(RAY_STATS_ENABLED_CONSTANT_ID, VK_TRUE);
+        setSpecializationConstant(RAY_STATS_SUBGROUP_CONSTANT_ID, subgroupReduce ? VK_TRUE : VK_FALSE);
+    }
+
     void define() override {
         // prepare resources
         m_pResourceManager->createTextureRGBA32Sfloat("AoInWorldPos");
@@ -50,15 +57,21 @@ public:
         // prepare the AO variable buffer
         m_pResourceManager->createUniformBuffer<AoData>("AoData");
 
-        // create a descriptor set
-        std::vector<ResourceBindingInfo> bindings = {
-            { "Tlas", vk::DescriptorType::eAccelerationStructureKHR, vk::ShaderStageFlagBits::eRaygenKHR, 1 },
-            { "AoData", vk::DescriptorType::eUniformBuffer, vk::ShaderStageFlagBits::eRaygenKHR, 1 },
-            { "AoInWorldPos", vk::DescriptorType::eCombinedImageSampler, vk::ShaderStageFlagBits::eRaygenKHR, 1 },
-            { "AoInWorldNormal", vk::DescriptorType::eCombinedImageSampler, vk::ShaderStageFlagBits::eRaygenKHR, 1 },
-            { "AoOutput", vk::DescriptorType::eStorageImage, vk::ShaderStageFlagBits::eRaygenKHR, 1 },
-        };
-        createDescriptorSet(bindings);
+        // ray counters, only written when enabled but always bound
+        m_pResourceManager->insertBuffer(
+            "AoRayStats", m_pResourceManager->createBuffer(sizeof(RayStats),
+                                                           vk::BufferUsageFlagBits::eStorageBuffer |
+                                                               vk::BufferUsageFlagBits::eTransferSrc |
+                                                               vk::BufferUsageFlagBits::eTransferDst,
+                                                           vk::MemoryPropertyFlagBits::eDeviceLocal));
+
+        // resources of the descriptor set, by binding
+        bindResources({ { 0, "Tlas" },
+                        { 1, "AoData" },
+                        { 2, "AoInWorldPos" },
+                        { 3, "AoInWorldNormal" },
+                        { 4, "AoOutput" },
+                        { 5, "AoRayStats" } });
 
         setupRayTracingPipeline("shaders/RenderPasses/AmbientOcclusionPass/AO.rgen.spv",
                                 "shaders/RenderPasses/AmbientOcclusionPass/AO.rmiss.spv",
@@ -68,7 +81,7 @@ public:
     void record(vk::CommandBuffer commandBuffer) override {
         commandBuffer.bindPipeline(vk::PipelineBindPoint::eRayTracingKHR, m_pipeline);
 
-        commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eRayTracingKHR, m_pipelineLayout, 0, 1,
+        commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eRayTracingKHR, m_pipelineLayout, PASS_SET, 1,
                                          &m_descriptorSet, 0, nullptr);
 
         commandBuffer.traceRaysKHR(&m_rgenRegion, &m_missRegion, &m_hitRegion, &m_callRegion, m_extent.width,
@@ -3,21 +3,27 @@
 #extension GL_EXT_shader_explicit_arithmetic_types_int64 : require
 #extension GL_EXT_nonuniform_qualifier : enable
 
+#include "CommonShaders/Bindless.h"
 #include "CommonShaders/HitData.h"
 
-// input from descriptor set
-layout(binding = 1) uniform sampler2D[] texSamplers;
-
 // input from vertex shader
 layout(location = 0) in SurfaceHit inHitData;
+layout(location = 5) in vec4 inClipPos;
+layout(location = 6) in vec4 inPrevClipPos;
 
 layout(location = 0) out vec4 outColor;
 layout(location = 1) out vec4 outPosWorld;
 layout(location = 2) out vec4 outNormalWorld;
+layout(location = 3) out vec4 outMotion;
 
 void main() {
     uint texId = 0;
-    outColor = texture(texSamplers[nonuniformEXT(texId)], inHitData.texCoord);
+    outColor = texture(sceneTextures[nonuniformEXT(texId)], inHitData.texCoord);
     outPosWorld = inHitData.worldPos;
     outNormalWorld = vec4(inHitData.worldNormal, 1.0);
+
+    // screen space motion in uv units, the previous position of this pixel is uv - motion
+    vec2 uv = inClipPos.xy / inClipPos.w * 0.5 + 0.5;
+    vec2 prevUv = inPrevClipPos.xy / inPrevClipPos.w * 0.5 + 0.5;
+    outMotion = vec4(uv - prevUv, 0.0, 1.0);
 }
\ No newline at end of file
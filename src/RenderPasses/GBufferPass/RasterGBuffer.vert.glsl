@@ -7,7 +7,7 @@
 #include "CommonShaders/HitData.h"
 
 // camera data
-layout(binding = 0) uniform _Camera {
+layout(set = 1, binding = 0) uniform _Camera {
 	CameraData camera;
 };
 
@@ -33,6 +33,8 @@ layout(location = 11) in int instanceId;
 
 // output
 layout(location = 0) out SurfaceHit outHitData;
+layout(location = 5) out vec4 outClipPos;
+layout(location = 6) out vec4 outPrevClipPos;
 
 void main() {
 	vec4 worldPos = instanceWorld * vec4(inPosition, 1.0);
@@ -41,6 +43,10 @@ void main() {
 	// gl_Position = camera.proj * worldPos;
 	gl_Position = camera.proj * camera.view * worldPos;
 
+	// the instances are static, so only the camera contributes to the motion
+	outClipPos = gl_Position;
+	outPrevClipPos = camera.prevProj * camera.prevView * worldPos;
+
 	outHitData.worldPos = worldPos;
 	outHitData.worldNormal = normalize((instanceInvTransposeWorld * vec4(inNormal, 0.0)).xyz);
     outHitData.texCoord = inTexCoord;
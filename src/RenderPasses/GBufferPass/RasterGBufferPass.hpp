@@ -24,23 +24,16 @@ public:
         m_pResourceManager->createTextureRGBA32Sfloat("RasterColor");
         m_pResourceManager->createTextureRGBA32Sfloat("RasterWorldPos");
         m_pResourceManager->createTextureRGBA32Sfloat("RasterWorldNormal");
+        m_pResourceManager->createTextureRGBA32Sfloat("RasterMotion");
         m_pResourceManager->createDepthTexture("RasterDepth");
 
         m_pContext->kOffscreenOutputTextureNames.push_back("RasterColor");
         m_pContext->kOffscreenOutputTextureNames.push_back("RasterWorldPos");
         m_pContext->kOffscreenOutputTextureNames.push_back("RasterWorldNormal");
+        m_pContext->kOffscreenOutputTextureNames.push_back("RasterMotion");
 
-        // create a descriptor set
-        std::vector<ResourceBindingInfo> bindings;
-
-        // uniform buffers
-        bindings.push_back({ "CameraBuffer", vk::DescriptorType::eUniformBuffer, vk::ShaderStageFlagBits::eVertex, 1 });
-        // model textures
-        bindings.push_back({ "SceneTextures", vk::DescriptorType::eCombinedImageSampler,
-                             vk::ShaderStageFlagBits::eFragment,
-                             static_cast<uint32_t>(m_pScene->getTextures().size()) });
-
-        createDescriptorSet(bindings);
+        // resources of the descriptor set: the camera and the model textures
+        bindResources({ { 0, "CameraBuffer" } });
 
         // create framebuffers for the attachments
         std::vector<AttachmentInfo> colorAttachments = {
@@ -61,6 +54,14 @@ public:
               .srcAccessMask = vk::AccessFlagBits::eNone,
               .dstAccessMask = vk::AccessFlagBits::eColorAttachmentWrite },
             { .imageView     = m_pResourceManager->getTexture("RasterWorldNormal")->descriptorInfo.imageView,
+              .format        = vk::Format::eR32G32B32A32Sfloat,
+              .oldLayout     = vk::ImageLayout::eUndefined,
+              .newLayout     = vk::ImageLayout::eColorAttachmentOptimal,
+              .srcStageMask  = vk::PipelineStageFlagBits::eColorAttachmentOutput,
+              .dstStageMask  = vk::PipelineStageFlagBits::eColorAttachmentOutput,
+              .srcAccessMask = vk::AccessFlagBits::eNone,
+              .dstAccessMask = vk::AccessFlagBits::eColorAttachmentWrite },
+            { .imageView     = m_pResourceManager->getTexture("RasterMotion")->descriptorInfo.imageView,
               .format        = vk::Format::eR32G32B32A32Sfloat,
               .oldLayout     = vk::ImageLayout::eUndefined,
               .newLayout     = vk::ImageLayout::eColorAttachmentOptimal,
@@ -106,14 +107,20 @@ public:
         transitionImageLayout(commandBuffer, normalTexture, vk::ImageLayout::eColorAttachmentOptimal,
                               vk::ImageLayout::eShaderReadOnlyOptimal, vk::PipelineStageFlagBits::eAllGraphics,
                               vk::PipelineStageFlagBits::eAllGraphics);
+
+        auto motionTexture = m_pResourceManager->getTexture("RasterMotion");
+        transitionImageLayout(commandBuffer, motionTexture, vk::ImageLayout::eColorAttachmentOptimal,
+                              vk::ImageLayout::eShaderReadOnlyOptimal, vk::PipelineStageFlagBits::eAllGraphics,
+                              vk::PipelineStageFlagBits::eAllGraphics);
     }
 
     void record(vk::CommandBuffer commandBuffer) override {
-        std::array<vk::ClearValue, 4> clearValues{};
+        std::array<vk::ClearValue, 5> clearValues{};
         clearValues[0].color        = vk::ClearColorValue{ std::array<float, 4>{ 0.0f, 0.0f, 0.0f, 0.0f } };
         clearValues[1].color        = vk::ClearColorValue{ std::array<float, 4>{ 0.0f, 0.0f, 0.0f, 0.0f } };
         clearValues[2].color        = vk::ClearColorValue{ std::array<float, 4>{ 0.0f, 0.0f, 0.0f, 0.0f } };
-        clearValues[3].depthStencil = vk::ClearDepthStencilValue{ 1.0f, 0 };
+        clearValues[3].color        = vk::ClearColorValue{ std::array<float, 4>{ 0.0f, 0.0f, 0.0f, 0.0f } };
+        clearValues[4].depthStencil = vk::ClearDepthStencilValue{ 1.0f, 0 };
 
         vk::RenderPassBeginInfo renderPassInfo{ .renderPass  = m_renderPass,
                                                 .framebuffer = m_framebuffer,
@@ -145,8 +152,8 @@ public:
             vk::Buffer instanceBuffer =
                 m_pResourceManager->getBuffer("InstanceBuffer" + std::to_string(i))->descriptorInfo.buffer;
 
-            commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, m_pipelineLayout, 0, 1, &m_descriptorSet,
-                                             0, nullptr);
+            commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, m_pipelineLayout, PASS_SET, 1,
+                                             &m_descriptorSet, 0, nullptr);
 
             commandBuffer.bindVertexBuffers(0, 1, &vertexBuffers, offsets);
             commandBuffer.bindVertexBuffers(1, 1, &instanceBuffer, offsets);
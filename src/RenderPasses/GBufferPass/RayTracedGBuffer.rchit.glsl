@@ -7,21 +7,14 @@
 #extension GL_EXT_scalar_block_layout : enable
 
 #include "Common.hpp"
+#include "CommonShaders/Bindless.h"
 #include "CommonShaders/HitDataRt.h"
 
-layout(set = 0, binding = 1) uniform sampler2D[] texSamplers;
-layout(set = 0, binding = 2) buffer _SceneObjectDevice {
-    SceneObjectDevice data[];
-} objDevice;
-layout(set = 0, binding = 6) buffer _Material {
-    Material data[];
-} materials;
-
 layout(location = 0) rayPayloadInEXT SurfaceHit payload;
 hitAttributeEXT IntersectionAttribute attribs;
 
 void main() {
-    SceneObjectDevice objInfo = objDevice.data[gl_InstanceCustomIndexEXT];
-    Material material = materials.data[objInfo.materialId];
+    SceneObjectDevice objInfo = sceneObjects.data[gl_InstanceCustomIndexEXT];
+    Material material = sceneMaterials.data[objInfo.materialId];
     payload = getHitData(objInfo, attribs, material);
 }
\ No newline at end of file
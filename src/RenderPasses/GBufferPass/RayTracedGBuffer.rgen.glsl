@@ -10,12 +10,12 @@
 
 layout(location = 0) rayPayloadEXT SurfaceHit payload;
 
-layout(set = 0, binding = 0) uniform _Camera {
+layout(set = 1, binding = 0) uniform _Camera {
 	CameraData camera;
 };
-layout(set = 0, binding = 3, rgba32f) uniform image2D worldPos;
-layout(set = 0, binding = 4, rgba32f) uniform image2D worldNormal;
-layout(set = 0, binding = 5) uniform accelerationStructureEXT tlas;
+layout(set = 1, binding = 1, rgba32f) uniform image2D worldPos;
+layout(set = 1, binding = 2, rgba32f) uniform image2D worldNormal;
+layout(set = 1, binding = 3) uniform accelerationStructureEXT tlas;
 
 void main() {
     const vec2 pixelCenter = vec2(gl_LaunchIDEXT.xy) + vec2(0.5);
@@ -1,6 +1,7 @@
 #ifndef RAYTRACED_GBUFFER_PASS_HPP
 #define RAYTRACED_GBUFFER_PASS_HPP
 
+#include "BindlessTable.hpp"
 #include "GBufferCommon.h"
 #include "RenderPass.hpp"
 
@@ -37,21 +38,11 @@ public:
         m_pContext->kOffscreenOutputTextureNames.push_back("RayTracedWorldPos");
         m_pContext->kOffscreenOutputTextureNames.push_back("RayTracedWorldNormal");
 
-        // create a descriptor set
-        std::vector<ResourceBindingInfo> bindings = {
-            { "CameraBuffer", vk::DescriptorType::eUniformBuffer, vk::ShaderStageFlagBits::eRaygenKHR, 1 },
-            { "SceneTextures", vk::DescriptorType::eCombinedImageSampler, vk::ShaderStageFlagBits::eClosestHitKHR,
-              static_cast<uint32_t>(m_pScene->getTextures().size()) },
-            { "SceneObjects", vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eClosestHitKHR,
-              static_cast<uint32_t>(m_pScene->getObjects().size()) },
-            { "RayTracedWorldPos", vk::DescriptorType::eStorageImage, vk::ShaderStageFlagBits::eRaygenKHR, 1 },
-            { "RayTracedWorldNormal", vk::DescriptorType::eStorageImage, vk::ShaderStageFlagBits::eRaygenKHR, 1 },
-            { "GBufferTlas", vk::DescriptorType::eAccelerationStructureKHR, vk::ShaderStageFlagBits::eRaygenKHR,
-              1 }, // name doesn't matter for AS
-            { "SceneMaterials", vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eClosestHitKHR,
-              static_cast<uint32_t>(m_pScene->getMaterials().size()) }
-        };
-        createDescriptorSet(bindings);
+        // resources of the descriptor set, by binding
+        bindResources({ { 0, "CameraBuffer" },
+                        { 1, "RayTracedWorldPos" },
+                        { 2, "RayTracedWorldNormal" },
+                        { 3, "GBufferTlas" } }); // name doesn't matter for AS
 
         setupRayTracingPipeline("shaders/RenderPasses/GBufferPass/RayTracedGBuffer.rgen.spv",
                                 "shaders/RenderPasses/GBufferPass/RayTracedGBuffer.rmiss.spv",
@@ -64,13 +55,12 @@ public:
 
         commandBuffer.bindPipeline(vk::PipelineBindPoint::eRayTracingKHR, m_pipeline);
 
-        commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eRayTracingKHR, m_pipelineLayout, 0, 1,
+        commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eRayTracingKHR, m_pipelineLayout, PASS_SET, 1,
                                          &m_descriptorSet, 0, nullptr);
 
-        commandBuffer.pushConstants(m_pipelineLayout,
-                                    vk::ShaderStageFlagBits::eRaygenKHR | vk::ShaderStageFlagBits::eClosestHitKHR |
-                                        vk::ShaderStageFlagBits::eMissKHR,
-                                    0, sizeof(PushConstantRay), &m_pcRay);
+        vk::PushConstantRange pushConstantRange = BindlessTable::getPushConstantRange();
+        commandBuffer.pushConstants(m_pipelineLayout, pushConstantRange.stageFlags, 0, sizeof(PushConstantRay),
+                                    &m_pcRay);
 
         commandBuffer.traceRaysKHR(&m_rgenRegion, &m_missRegion, &m_hitRegion, &m_callRegion, m_extent.width,
                                    m_extent.height, 2);
@@ -1,6 +1,8 @@
 #ifndef PATH_TRACING_PASS_HPP
 #define PATH_TRACING_PASS_HPP
 
+#include "CommonShaders/RayStats.h"
+#include "CommonShaders/Sampler.h"
 #include "PtCommon.h"
 #include "RenderPass.hpp"
 
@@ -16,11 +18,32 @@ public:
         RayTracingRenderPass::init(pContext, commandPool, pResourceManager, pScene);
 
         m_frameData.frameCount = 0;
+        setVariantConstants();
     }
 
     void updateGui() {
         if (!ImGui::CollapsingHeader("Path Tracing Pass"))
             return;
+
+        // a new variant is requested once an edit is done, not for every value dragged through
+        bool changed = false;
+        ImGui::SliderInt("Max depth", &m_maxDepth, 1, RAY_STATS_MAX_BOUNCES);
+        changed |= ImGui::IsItemDeactivatedAfterEdit();
+        const char *directLightings[] = { "All lights, unshadowed", "One light by power, shadowed",
+                                          "One light from the light BVH, shadowed" };
+        changed |= ImGui::Combo("Direct lighting", &m_directLighting, directLightings, IM_ARRAYSIZE(directLightings));
+        const char *samplers[] = { "Independent (white noise)", "Owen-scrambled Sobol",
+                                   "Rank-1 lattice, blue-noise dithered" };
+        changed |= ImGui::Combo("Sampler", &m_sampler, samplers, IM_ARRAYSIZE(samplers));
+        ImGui::InputFloat("tMin", &m_tMin, 0.0f, 0.0f, "%.6f");
+        changed |= ImGui::IsItemDeactivatedAfterEdit();
+        ImGui::InputFloat("tMax", &m_tMax, 0.0f, 0.0f, "%.1f");
+        changed |= ImGui::IsItemDeactivatedAfterEdit();
+        if (changed)
+            setVariantConstants();
+
+        ImGui::Text(" %zu pipeline variants%s", getPipelineVariantCount(),
+                    isCompilingVariant() ? ", compiling..." : "");
     }
 
     void connectTextureWorldPos(const std::string &srcTexture) {
@@ -31,6 +54,40 @@ public:
         m_pResourceManager->connectTextures(srcTexture, "PtInWorldNormal");
     }
 
+    // PT_DIRECT_LIGHTING_UNSHADOWED, PT_DIRECT_LIGHTING_NEE or PT_DIRECT_LIGHTING_LIGHT_BVH, the lights are in the
+    // bindless table
+    void setDirectLighting(uint32_t directLighting) {
+        m_directLighting = static_cast<int>(directLighting);
+        setVariantConstants();
+    }
+
+    // path vertices, from 1 (the direct lighting of the g-buffer surface) to RAY_STATS_MAX_BOUNCES
+    void setMaxDepth(uint32_t maxDepth) {
+        m_maxDepth = static_cast<int>(maxDepth);
+        setVariantConstants();
+    }
+
+    // SAMPLER_INDEPENDENT, SAMPLER_SOBOL or SAMPLER_RANK1, indexed by the frame count
+    void setSampler(uint32_t sampler) {
+        m_sampler = static_cast<int>(sampler);
+        setVariantConstants();
+    }
+
+    // launch only the pixels the accumulation pass's allocation kernel lists in PtPixelList, with the size it counts
+    // into PtDispatch (traceRaysIndirect), must be called before setup()
+    void enableAdaptiveSampling() {
+        m_adaptive = true;
+        setSpecializationConstant(PT_ADAPTIVE_CONSTANT_ID, VK_TRUE);
+    }
+
+    bool isAdaptiveSamplingEnabled() const { return m_adaptive; }
+
+    // count the traced rays into PtRayStats (see RayStats.h), must be called before setup()
+    void enableRayStats(bool subgroupReduce) {
+        setSpecializationConstant(RAY_STATS_ENABLED_CONSTANT_ID, VK_TRUE);
+        setSpecializationConstant(RAY_STATS_SUBGROUP_CONSTANT_ID, subgroupReduce ? VK_TRUE : VK_FALSE);
+    }
+
     void define() override {
         // prepare resources
         m_pResourceManager->createTextureRGBA32Sfloat("PtInWorldPos");
@@ -47,21 +104,40 @@ public:
         // prepare the Pt variable buffer
         m_pResourceManager->createUniformBuffer<FrameData>("FrameData");
 
-        // create a descriptor set
-        std::vector<ResourceBindingInfo> bindings = {
-            { "Tlas", vk::DescriptorType::eAccelerationStructureKHR, vk::ShaderStageFlagBits::eRaygenKHR, 1 },
-            { "FrameData", vk::DescriptorType::eUniformBuffer, vk::ShaderStageFlagBits::eRaygenKHR, 1 },
-            { "PtInWorldPos", vk::DescriptorType::eCombinedImageSampler, vk::ShaderStageFlagBits::eRaygenKHR, 1 },
-            { "PtInWorldNormal", vk::DescriptorType::eCombinedImageSampler, vk::ShaderStageFlagBits::eRaygenKHR, 1 },
-            { "PtOutput", vk::DescriptorType::eStorageImage, vk::ShaderStageFlagBits::eRaygenKHR, 1 },
-            { "SceneTextures", vk::DescriptorType::eCombinedImageSampler, vk::ShaderStageFlagBits::eClosestHitKHR,
-              static_cast<uint32_t>(m_pScene->getTextures().size()) },
-            { "SceneObjects", vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eClosestHitKHR,
-              static_cast<uint32_t>(m_pScene->getObjects().size()) },
-            { "SceneMaterials", vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eClosestHitKHR,
-              static_cast<uint32_t>(m_pScene->getMaterials().size()) }
-        };
-        createDescriptorSet(bindings);
+        // ray counters, only written when enabled but always bound
+        m_pResourceManager->insertBuffer(
+            "PtRayStats", m_pResourceManager->createBuffer(sizeof(RayStats),
+                                                           vk::BufferUsageFlagBits::eStorageBuffer |
+                                                               vk::BufferUsageFlagBits::eTransferSrc |
+                                                               vk::BufferUsageFlagBits::eTransferDst,
+                                                           vk::MemoryPropertyFlagBits::eDeviceLocal));
+
+        // the adaptive launch, written by the accumulation pass. the list is only sized when enabled but always bound
+        vk::DeviceSize pixelListSize = m_adaptive ? static_cast<vk::DeviceSize>(m_extent.width) * m_extent.height *
+                                                        sizeof(uint32_t)
+                                                  : sizeof(uint32_t);
+        m_pResourceManager->insertBuffer("PtPixelList", m_pResourceManager->createBuffer(
+                                                            pixelListSize, vk::BufferUsageFlagBits::eStorageBuffer,
+                                                            vk::MemoryPropertyFlagBits::eDeviceLocal));
+        m_pResourceManager->insertBuffer(
+            "PtDispatch", m_pResourceManager->createBuffer(sizeof(PtDispatch),
+                                                           vk::BufferUsageFlagBits::eStorageBuffer |
+                                                               vk::BufferUsageFlagBits::eIndirectBuffer |
+                                                               vk::BufferUsageFlagBits::eShaderDeviceAddress |
+                                                               vk::BufferUsageFlagBits::eTransferSrc |
+                                                               vk::BufferUsageFlagBits::eTransferDst,
+                                                           vk::MemoryPropertyFlagBits::eDeviceLocal));
+        m_dispatchAddress =
+            m_pContext->getBufferDeviceAddress(m_pResourceManager->getBuffer("PtDispatch")->descriptorInfo.buffer);
+
+        // resources of the descriptor set, by binding
+        bindResources({ { 0, "Tlas" },
+                        { 1, "FrameData" },
+                        { 2, "PtInWorldPos" },
+                        { 3, "PtInWorldNormal" },
+                        { 4, "PtOutput" },
+                        { 5, "PtRayStats" },
+                        { 6, "PtPixelList" } });
 
         setupRayTracingPipeline("shaders/RenderPasses/PathTracingPass/pt.rgen.spv",
                                 "shaders/RenderPasses/PathTracingPass/pt.rmiss.spv",
@@ -71,11 +147,16 @@ public:
     void record(vk::CommandBuffer commandBuffer) override {
         commandBuffer.bindPipeline(vk::PipelineBindPoint::eRayTracingKHR, m_pipeline);
 
-        commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eRayTracingKHR, m_pipelineLayout, 0, 1,
+        commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eRayTracingKHR, m_pipelineLayout, PASS_SET, 1,
                                          &m_descriptorSet, 0, nullptr);
 
-        commandBuffer.traceRaysKHR(&m_rgenRegion, &m_missRegion, &m_hitRegion, &m_callRegion, m_extent.width,
-                                   m_extent.height, 1);
+        // the pixels left out keep the path of an earlier frame in PtOutput, the accumulation skips them
+        if (m_adaptive)
+            commandBuffer.traceRaysIndirectKHR(&m_rgenRegion, &m_missRegion, &m_hitRegion, &m_callRegion,
+                                               m_dispatchAddress);
+        else
+            commandBuffer.traceRaysKHR(&m_rgenRegion, &m_missRegion, &m_hitRegion, &m_callRegion, m_extent.width,
+                                       m_extent.height, 1);
     }
 
     void updateUniformBuffer() {
@@ -84,7 +165,25 @@ public:
     }
 
 private:
+    void setVariantConstants() {
+        setSpecializationConstant(PT_MAX_DEPTH_CONSTANT_ID, static_cast<uint32_t>(m_maxDepth));
+        setSpecializationConstant(PT_DIRECT_LIGHTING_CONSTANT_ID, static_cast<uint32_t>(m_directLighting));
+        setSpecializationConstant(PT_T_MIN_CONSTANT_ID, m_tMin);
+        setSpecializationConstant(PT_T_MAX_CONSTANT_ID, m_tMax);
+        setSpecializationConstant(PT_SAMPLER_CONSTANT_ID, static_cast<uint32_t>(m_sampler));
+    }
+
     FrameData m_frameData;
+
+    // specialization constants of pt.rgen
+    int m_maxDepth{ 4 };
+    int m_directLighting{ PT_DIRECT_LIGHTING_NEE };
+    float m_tMin{ 0.00001f };
+    float m_tMax{ 10000.0f };
+    int m_sampler{ SAMPLER_SOBOL };
+
+    bool m_adaptive{ false };
+    vk::DeviceAddress m_dispatchAddress{ 0 };
 };
 
 } // namespace vuren
@@ -18,8 +18,41 @@ struct FrameData {
     uint frameCount;
 };
 
+// the size of the adaptive launch (vk::TraceRaysIndirectCommandKHR), counted by the accumulation pass's allocation
+// kernel
+struct PtDispatch {
+    uint width; // pixels in PtPixelList
+    uint height;
+    uint depth;
+};
+
+// specialization constants of pt.rgen, after the ray statistics ones (RayStats.h).
+// each combination is its own pipeline, so the bounce loop has a constant trip count.
+#define PT_MAX_DEPTH_CONSTANT_ID 2
+#define PT_DIRECT_LIGHTING_CONSTANT_ID 3
+#define PT_T_MIN_CONSTANT_ID 4
+#define PT_T_MAX_CONSTANT_ID 5
+#define PT_SAMPLER_CONSTANT_ID 6  // SAMPLER_INDEPENDENT, SAMPLER_SOBOL or SAMPLER_RANK1 (Sampler.h)
+#define PT_ADAPTIVE_CONSTANT_ID 7 // launches the pixels of PtPixelList only, one dimensional
+
+// direct lighting estimators at every path vertex
+#define PT_DIRECT_LIGHTING_UNSHADOWED 0u // every light, without any visibility test
+#define PT_DIRECT_LIGHTING_NEE 1u        // one light picked by power, with a shadow ray
+#define PT_DIRECT_LIGHTING_LIGHT_BVH 2u  // one light picked by its bound contribution in the light bvh, shadowed
+
 #ifdef __cplusplus
 } // namespace vuren
-#endif
+#else
+
+// the pixels of PtPixelList, x in the low 16 bits
+uint packPixel(uvec2 pixel) {
+    return pixel.x | (pixel.y << 16);
+}
+
+uvec2 unpackPixel(uint packed) {
+    return uvec2(packed & 0xffffu, packed >> 16);
+}
+
+#endif // __cplusplus
 
 #endif // PT_COMMON_H
\ No newline at end of file
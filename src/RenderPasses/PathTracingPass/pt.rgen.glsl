@@ -5,39 +5,179 @@
 #extension GL_EXT_nonuniform_qualifier : enable
 #extension GL_EXT_buffer_reference2 : require
 #extension GL_EXT_scalar_block_layout : enable
+#extension GL_KHR_shader_subgroup_arithmetic : enable
+
+#define RAY_STATS_BINDING 5
 
 #include "Common.hpp"
 #include "PtCommon.h"
+#include "CommonShaders/Bindless.h"
 #include "CommonShaders/Random.h"
+#include "CommonShaders/Sampler.h"
 #include "CommonShaders/HitData.h"
+#include "CommonShaders/RayStats.h"
 
 layout(location = 0) rayPayloadEXT SurfaceHit payload;
 
-layout(set = 0, binding = 0) uniform accelerationStructureEXT tlas;
-layout(set = 0, binding = 1) uniform _FrameData {
+layout(set = 1, binding = 0) uniform accelerationStructureEXT tlas;
+layout(set = 1, binding = 1) uniform _FrameData {
 	FrameData frameData;
 };
 
 // g-buffers
-layout(set = 0, binding = 2) uniform sampler2D worldPos;
-layout(set = 0, binding = 3) uniform sampler2D worldNormal;
+layout(set = 1, binding = 2) uniform sampler2D worldPos;
+layout(set = 1, binding = 3) uniform sampler2D worldNormal;
 
 // output texture
-layout(set = 0, binding = 4, rgba32f) uniform image2D outputColor;
+layout(set = 1, binding = 4, rgba32f) uniform image2D outputColor;
+
+// the pixels of the adaptive launch (kAdaptive), packed by packPixel
+layout(set = 1, binding = 6) readonly buffer _PtPixelList {
+    uint pixelList[];
+};
+
+// the defaults match PathTracingPass
+layout(constant_id = PT_MAX_DEPTH_CONSTANT_ID) const int kMaxDepth = 4;
+layout(constant_id = PT_DIRECT_LIGHTING_CONSTANT_ID) const uint kDirectLighting = PT_DIRECT_LIGHTING_NEE;
+layout(constant_id = PT_T_MIN_CONSTANT_ID) const float kTMin = 0.00001; // bias to avoid self-intersection
+layout(constant_id = PT_T_MAX_CONSTANT_ID) const float kTMax = 10000.0;
+layout(constant_id = PT_SAMPLER_CONSTANT_ID) const uint kSampler = SAMPLER_SOBOL;
+layout(constant_id = PT_ADAPTIVE_CONSTANT_ID) const bool kAdaptive = false;
+
+// the light's contribution to a surface, without the throughput and visibility
+vec3 evaluateLight(Light light, vec3 position, vec3 normal) {
+    vec3 ldir = light.pos - position;
+    float ldist2 = dot(ldir, ldir);
+    float NdotL = clamp(dot(normal, ldir * inversesqrt(ldist2)), 0.0, 1.0);
+    return light.intensity * NdotL / ldist2;
+}
+
+// whether nothing is in between. the closest hit shader is skipped and the first hit ends the traversal, so only
+// the miss shader can run: it clears the payload's hit position.
+bool isVisible(vec3 position, vec3 target) {
+    vec3 ldir = target - position;
+    float ldist = length(ldir);
+
+    payload.worldPos.w = 1.0;
+    traceRayEXT(tlas,
+                gl_RayFlagsOpaqueEXT | gl_RayFlagsTerminateOnFirstHitEXT | gl_RayFlagsSkipClosestHitShaderEXT,
+                0xFF, 0, 0, 0, position, kTMin, ldir / ldist, ldist, 0);
+    return payload.worldPos.w == 0.0;
+}
+
+// cos(max(a - b, 0)) and sin(max(a - b, 0)) from the sines and cosines of the angles
+float cosSubClamped(float sinA, float cosA, float sinB, float cosB) {
+    return cosA > cosB ? 1.0 : cosA * cosB + sinA * sinB;
+}
+
+float sinSubClamped(float sinA, float cosA, float sinB, float cosB) {
+    return cosA > cosB ? 0.0 : sinA * cosB - cosA * sinB;
+}
+
+// an upper bound of the contribution of the node's lights to the surface, mirrors LightBvh::importance
+float lightBvhImportance(LightBvhNode node, vec3 position, vec3 normal) {
+    vec3 center = (node.boundsMin + node.boundsMax) * 0.5;
+    vec3 halfExtent = (node.boundsMax - node.boundsMin) * 0.5;
+    float radius2 = dot(halfExtent, halfExtent);
+    vec3 toPosition = position - center;
+    float dist2 = dot(toPosition, toPosition);
+    vec3 wi = dist2 > 0.0 ? toPosition * inversesqrt(dist2) : vec3(0.0, 0.0, 1.0);
+    float clampDist2 = max(max(dist2, radius2), 1e-8);
+
+    // the directions from the position to the bounding sphere, every direction from inside
+    float cosThetaB = dist2 > radius2 ? sqrt(max(1.0 - radius2 / dist2, 0.0)) : -1.0;
+    float sinThetaB = sqrt(max(1.0 - cosThetaB * cosThetaB, 0.0));
+
+    // the emission cone against the direction to the position
+    float cosThetaW = dot(node.axis, wi);
+    float sinThetaW = sqrt(max(1.0 - cosThetaW * cosThetaW, 0.0));
+    float sinThetaO = sqrt(max(1.0 - node.cosThetaO * node.cosThetaO, 0.0));
+    float cosThetaX = cosSubClamped(sinThetaW, cosThetaW, sinThetaO, node.cosThetaO);
+    float sinThetaX = sinSubClamped(sinThetaW, cosThetaW, sinThetaO, node.cosThetaO);
+    float cosThetaP = cosSubClamped(sinThetaX, cosThetaX, sinThetaB, cosThetaB);
+    if (cosThetaP <= 0.0)
+        return 0.0;
+
+    // the normal against the directions to the bounds
+    float cosThetaI = -dot(normal, wi);
+    float sinThetaI = sqrt(max(1.0 - cosThetaI * cosThetaI, 0.0));
+    float cosThetaIP = cosSubClamped(sinThetaI, cosThetaI, sinThetaB, cosThetaB);
+    if (cosThetaIP <= 0.0)
+        return 0.0;
+
+    return node.power * cosThetaP * cosThetaIP / clampDist2;
+}
+
+// walks down the light bvh, picking each child by importance and rescaling u in between. false when no light
+// reaches the surface.
+bool sampleLightBvh(vec3 position, vec3 normal, float u, out uint lightIndex, out float pmf) {
+    uint nodeIndex = 0;
+    pmf = 1.0;
+    while ((sceneLightBvh.data[nodeIndex].childOrLight & LIGHT_BVH_LEAF) == 0) {
+        uint left = nodeIndex + 1;
+        uint right = sceneLightBvh.data[nodeIndex].childOrLight;
+        float leftWeight = lightBvhImportance(sceneLightBvh.data[left], position, normal);
+        float rightWeight = lightBvhImportance(sceneLightBvh.data[right], position, normal);
+        if (leftWeight + rightWeight <= 0.0)
+            return false;
+
+        float pLeft = leftWeight / (leftWeight + rightWeight);
+        if (u < pLeft) {
+            nodeIndex = left;
+            pmf *= pLeft;
+            u = min(u / pLeft, ONE_MINUS_EPSILON);
+        } else {
+            nodeIndex = right;
+            pmf *= 1.0 - pLeft;
+            u = min((u - pLeft) / (1.0 - pLeft), ONE_MINUS_EPSILON);
+        }
+    }
+
+    lightIndex = sceneLightBvh.data[nodeIndex].childOrLight & ~LIGHT_BVH_LEAF;
+    return true;
+}
+
+// one light picked with the alias table (in proportion to its power) or the light bvh, divided by the probability
+// of picking it
+vec3 sampleDirectLight(vec3 position, vec3 normal, inout SamplerState samples, inout uint shadowRays) {
+    uint lightIndex;
+    float pmf;
+    if (kDirectLighting == PT_DIRECT_LIGHTING_LIGHT_BVH) {
+        if (!sampleLightBvh(position, normal, sample1D(samples), lightIndex, pmf))
+            return vec3(0.0);
+    } else {
+        uint lightCount = uint(sceneLightAliasTable.data.length());
+        float u = sample1D(samples) * float(lightCount);
+        uint bucket = min(uint(u), lightCount - 1);
+        LightAliasEntry entry = sceneLightAliasTable.data[bucket];
+        lightIndex = u - float(bucket) < entry.threshold ? bucket : entry.alias;
+        pmf = sceneLightAliasTable.data[lightIndex].pmf;
+    }
+
+    Light light = sceneLights.data[lightIndex];
+    vec3 contribution = evaluateLight(light, position, normal);
+    if (all(equal(contribution, vec3(0.0))))
+        return vec3(0.0);
+
+    shadowRays++;
+    if (!isVisible(position, light.pos))
+        return vec3(0.0);
+    return contribution / pmf;
+}
 
 void main() {
-    const vec2 pixelCenter = vec2(gl_LaunchIDEXT.xy) + vec2(0.5);
-    const vec2 inUV = pixelCenter / vec2(gl_LaunchSizeEXT.xy);
+    // the adaptive launch is one dimensional, over the pixels that still need paths
+    const uvec2 pixel = kAdaptive ? unpackPixel(pixelList[gl_LaunchIDEXT.x]) : gl_LaunchIDEXT.xy;
+    const vec2 pixelCenter = vec2(pixel) + vec2(0.5);
+    const vec2 inUV = pixelCenter / vec2(imageSize(outputColor));
     // vec2 ndc = inUV * 2.0 - 1.0;
 
-    uint rngState = initRNG(gl_LaunchIDEXT.xy, gl_LaunchSizeEXT.xy, frameData.frameCount);
+    // the frame count starts at 1
+    SamplerState samples = initSampler(kSampler, pixel.x, pixel.y, frameData.frameCount - 1u, 0u);
     uint rayFlags = gl_RayFlagsOpaqueEXT;
-    float tMin = 0.00001; // bias to avoid self-intersection
-    float tMax = 10000.0; 
 
     vec3 radiance = vec3(0.0);
     vec3 throughput = vec3(1.0);
-    int max_depth = 4;
 
     // depth = 0: black image
 
@@ -45,13 +185,19 @@ void main() {
     vec4 pos = texture(worldPos, inUV);
     vec3 normal = texture(worldNormal, inUV).xyz;
     
-    vec2 uv = vec2(rand(rngState), rand(rngState));
+    vec2 uv = sample2D(samples);
     vec3 worldDir = getCosHemisphereSample(uv, normal);
 
-    // max_depth = 0: black image
-    // max_depth = 1: we can see area light only
-    // max_depth = 2: we can see "one scatter" result
-    for (int depth = 1; depth <= max_depth; ++depth) {
+    // ray statistics
+    bool pathStarted = pos.w != 0.0;
+    uint tracedRays = 0;
+    uint hits = 0;
+    uint shadowRays = 0;
+
+    // kMaxDepth = 0: black image
+    // kMaxDepth = 1: we can see area light only
+    // kMaxDepth = 2: we can see "one scatter" result
+    for (int depth = 1; depth <= kMaxDepth; ++depth) {
         if (depth > 1) {
             // trace a scatter ray using path sampling info computed at the iteration right before (or from g-buffer)
             traceRayEXT(tlas,           // as
@@ -61,11 +207,12 @@ void main() {
                         0,              // sbtRecordStride
                         0,              // missIndex
                         pos.xyz,        // ray origin
-                        tMin,           // ray min range
+                        kTMin,          // ray min range
                         worldDir,       // ray direction
-                        tMax,           // ray max range
+                        kTMax,          // ray max range
                         0               // payload location
             );
+            tracedRays++;
 
             // chit 또는 miss shader가 실행되어 페이로드가 알아서 업데이트된다
             // chit으로부터 셰이딩 데이터(hit position, normal)를 업데이트
@@ -80,28 +227,27 @@ void main() {
         // ray miss: background radiance was already calculated in the miss shader
         if (pos.w == 0.0)
             break;
+        if (depth > 1)
+            hits++;
 
         // lighting
-        // for (int lightIdx = 0; lightIdx <);
-        //     radiance += throughput * sceneLights[lightIdx].Le(worldDir)
-
-        vec3 lightpos = vec3(2,2,2);
-        vec3 ldir = lightpos - pos.xyz;
-        vec3 L = normalize(ldir);
-        float ldist = length(ldir);
-        float intensity = 15.0 / (ldist * ldist);
-        float NdotL = clamp(dot(normal, L), 0.0, 1.0);
-
-        radiance += vec3(intensity * throughput * NdotL);
+        if (kDirectLighting == PT_DIRECT_LIGHTING_UNSHADOWED) {
+            for (int lightIdx = 0; lightIdx < sceneLights.data.length(); ++lightIdx)
+                radiance += throughput * evaluateLight(sceneLights.data[lightIdx], pos.xyz, normal);
+        } else {
+            radiance += throughput * sampleDirectLight(pos.xyz, normal, samples, shadowRays);
+        }
 
         // shading the pixel
         // radiance = throughput;
 
         // sample the next path segment
-        uv = vec2(rand(rngState), rand(rngState));
+        uv = sample2D(samples);
         worldDir = getCosHemisphereSample(uv, normal);
     
     }
 
-    imageStore(outputColor, ivec2(gl_LaunchIDEXT.xy), vec4(radiance, 0));
+    addRayStats(tracedRays, hits, shadowRays, pathStarted);
+
+    imageStore(outputColor, ivec2(pixel), vec4(radiance, 0));
 }
\ No newline at end of file
@@ -0,0 +1,116 @@
+#ifndef RESTIR_COMMON_H
+#define RESTIR_COMMON_H
+
+#include "Common.hpp"
+
+#ifdef __cplusplus
+namespace vuren {
+#endif
+
+// every kernel runs 16x16 threads per workgroup
+#define RESTIR_GROUP_SIZE 16
+
+// a reservoir is a uvec2 per pixel: x holds the selected light in its low RESTIR_LIGHT_BITS bits and the number of
+// candidates seen (M, saturating) in the others, y the unbiased contribution weight W as float bits
+#define RESTIR_LIGHT_BITS 20
+#define RESTIR_LIGHT_MASK 0xfffffu
+#define RESTIR_MAX_M 0xfffu
+
+// the light of an empty reservoir, so the scene has fewer lights than this
+#define RESTIR_INVALID_LIGHT RESTIR_LIGHT_MASK
+
+struct RestirData {
+    uint frameCount;   // seeds the random numbers
+    uint historyIndex; // the reservoirs and geometry written this frame (0 or 1), the other pair is read
+    uint reset;        // 1 drops the reservoirs of the last frame
+
+    uint initialCandidates; // lights picked by power for every pixel and resampled into one
+    uint temporalReuse;     // 1 combines with the reprojected reservoir of the last frame
+    uint maxHistory;        // the M of the last frame's reservoir is capped at maxHistory times the new one's
+
+    uint spatialSamples; // neighbors combined with every pixel, 0 disables the spatial reuse
+    float spatialRadius; // in pixels
+
+    // a reservoir of the last frame or of a neighbor is rejected when its view depth differs by more than
+    // depthTolerance (relative) or its normal by more than acos(normalTolerance)
+    float depthTolerance;
+    float normalTolerance;
+
+    float tMin; // bias of the visibility ray against self-intersection
+    float pad0;
+};
+
+#ifdef __cplusplus
+} // namespace vuren
+#else
+
+// the includer enables GL_EXT_nonuniform_qualifier for the bindless table
+#include "CommonShaders/Bindless.h"
+
+// payload of the visibility ray, only set by the miss shader (the closest hit shader is skipped)
+struct VisibilityPayload {
+    float visible;
+};
+
+struct Reservoir {
+    uint lightIndex; // RESTIR_INVALID_LIGHT when empty
+    uint M;          // candidates seen
+    float W;         // unbiased contribution weight, an estimate of 1 / pdf of the light
+    float wSum;      // sum of the resampling weights, only kept while streaming candidates in
+};
+
+Reservoir emptyReservoir() {
+    return Reservoir(RESTIR_INVALID_LIGHT, 0u, 0.0, 0.0);
+}
+
+uvec2 packReservoir(Reservoir r) {
+    return uvec2(r.lightIndex | (min(r.M, RESTIR_MAX_M) << RESTIR_LIGHT_BITS), floatBitsToUint(r.W));
+}
+
+Reservoir unpackReservoir(uvec2 packed) {
+    return Reservoir(packed.x & RESTIR_LIGHT_MASK, packed.x >> RESTIR_LIGHT_BITS, uintBitsToFloat(packed.y), 0.0);
+}
+
+// weighted reservoir sampling: streams in a candidate standing for M samples with the resampling weight w, and
+// returns whether it replaced the selected light. u is uniform in [0, 1).
+bool updateReservoir(inout Reservoir r, uint lightIndex, float w, uint M, float u) {
+    r.wSum += w;
+    r.M += M;
+    if (w > 0.0 && u * r.wSum < w) {
+        r.lightIndex = lightIndex;
+        return true;
+    }
+    return false;
+}
+
+// W of the selected light from the target function at it
+void finalizeReservoir(inout Reservoir r, float targetPdf) {
+    r.W = targetPdf > 0.0 ? r.wSum / (float(r.M) * targetPdf) : 0.0;
+    if (r.W == 0.0)
+        r.lightIndex = RESTIR_INVALID_LIGHT;
+}
+
+float luminance(vec3 color) {
+    return dot(color, vec3(0.2126, 0.7152, 0.0722));
+}
+
+float viewDepth(mat4 view, vec3 position) {
+    return -(view * vec4(position, 1.0)).z;
+}
+
+// the light's contribution to a surface, without the visibility. mirrors pt.rgen
+vec3 evaluateLight(Light light, vec3 position, vec3 normal) {
+    vec3 ldir = light.pos - position;
+    float ldist2 = dot(ldir, ldir);
+    float NdotL = clamp(dot(normal, ldir * inversesqrt(ldist2)), 0.0, 1.0);
+    return light.intensity * NdotL / ldist2;
+}
+
+// the resampling target: the luminance of the unshadowed contribution
+float targetPdf(uint lightIndex, vec3 position, vec3 normal) {
+    return luminance(evaluateLight(sceneLights.data[lightIndex], position, normal));
+}
+
+#endif // __cplusplus
+
+#endif // RESTIR_COMMON_H
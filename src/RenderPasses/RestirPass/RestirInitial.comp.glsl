@@ -0,0 +1,48 @@
+#version 460
+#extension GL_GOOGLE_include_directive : enable
+#extension GL_EXT_shader_explicit_arithmetic_types_int64 : require
+#extension GL_EXT_nonuniform_qualifier : enable
+
+#include "RestirKernel.h"
+#include "CommonShaders/Random.h"
+
+layout(local_size_x = RESTIR_GROUP_SIZE, local_size_y = RESTIR_GROUP_SIZE) in;
+
+// resampled importance sampling of the direct lighting: a few lights are picked in proportion to their power and one
+// of them is kept in proportion to its unshadowed contribution. also stores the geometry for the next frame.
+void main() {
+    ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+    ivec2 size = imageSize(geometryHistory0);
+    if (any(greaterThanEqual(pixel, size)))
+        return;
+
+    vec4 position = texelFetch(worldPos, pixel, 0);
+    vec3 normal = texelFetch(worldNormal, pixel, 0).xyz;
+
+    Reservoir r = emptyReservoir();
+    if (position.w != 0.0) {
+        uint rngState = initRNG(uvec2(pixel), uvec2(size), restirData.frameCount * 3u);
+        uint lightCount = uint(sceneLightAliasTable.data.length());
+        float selectedPdf = 0.0;
+
+        for (uint i = 0; i < restirData.initialCandidates; ++i) {
+            float u = rand(rngState) * float(lightCount);
+            uint bucket = min(uint(u), lightCount - 1);
+            LightAliasEntry entry = sceneLightAliasTable.data[bucket];
+            uint lightIndex = u - float(bucket) < entry.threshold ? bucket : entry.alias;
+            float sourcePdf = sceneLightAliasTable.data[lightIndex].pmf;
+
+            float candidatePdf = targetPdf(lightIndex, position.xyz, normal);
+            if (updateReservoir(r, lightIndex, candidatePdf / sourcePdf, 1u, rand(rngState)))
+                selectedPdf = candidatePdf;
+        }
+        finalizeReservoir(r, selectedPdf);
+    }
+    initialReservoirs.data[pixelIndex(pixel)] = packReservoir(r);
+
+    float depth = position.w == 0.0 ? 0.0 : viewDepth(camera.view, position.xyz);
+    if (restirData.historyIndex == 0)
+        imageStore(geometryHistory0, pixel, vec4(normal, depth));
+    else
+        imageStore(geometryHistory1, pixel, vec4(normal, depth));
+}
@@ -0,0 +1,59 @@
+#ifndef RESTIR_KERNEL_H
+#define RESTIR_KERNEL_H
+
+#include "RestirCommon.h"
+
+// the resources of every resampling kernel, which share one descriptor set
+layout(set = 1, binding = 0) uniform sampler2D worldPos;
+layout(set = 1, binding = 1) uniform sampler2D worldNormal;
+layout(set = 1, binding = 2) uniform sampler2D motion;
+
+// ping-pong by frame: the world normal and the view depth (0 for the background)
+layout(set = 1, binding = 3, rgba32f) uniform image2D geometryHistory0;
+layout(set = 1, binding = 4, rgba32f) uniform image2D geometryHistory1;
+
+// one packed reservoir per pixel, row by row: the initial candidates, after the temporal reuse, and after the
+// spatial reuse (ping-pong by frame, the shading pass reads them and the next frame reuses them)
+layout(set = 1, binding = 5) buffer _InitialReservoirs {
+    uvec2 data[];
+} initialReservoirs;
+layout(set = 1, binding = 6) buffer _TemporalReservoirs {
+    uvec2 data[];
+} temporalReservoirs;
+layout(set = 1, binding = 7) buffer _Reservoirs0 {
+    uvec2 data[];
+} reservoirs0;
+layout(set = 1, binding = 8) buffer _Reservoirs1 {
+    uvec2 data[];
+} reservoirs1;
+
+layout(set = 1, binding = 9) uniform _RestirData {
+    RestirData restirData;
+};
+layout(set = 1, binding = 10) uniform _Camera {
+    CameraData camera;
+};
+
+uint pixelIndex(ivec2 pixel) {
+    return uint(pixel.y) * uint(imageSize(geometryHistory0).x) + uint(pixel.x);
+}
+
+// the pair written this frame and the one of the last frame
+vec4 loadGeometry(ivec2 pixel, bool current) {
+    return (restirData.historyIndex == 0) == current ? imageLoad(geometryHistory0, pixel)
+                                                     : imageLoad(geometryHistory1, pixel);
+}
+
+Reservoir loadReservoir(ivec2 pixel, bool current) {
+    return unpackReservoir((restirData.historyIndex == 0) == current ? reservoirs0.data[pixelIndex(pixel)]
+                                                                     : reservoirs1.data[pixelIndex(pixel)]);
+}
+
+// whether a surface of the given geometry (normal and view depth) is close enough to reuse its reservoir
+bool isSimilarSurface(vec4 geometry, vec3 normal, float depth) {
+    if (geometry.w == 0.0 || abs(geometry.w - depth) > restirData.depthTolerance * max(depth, 1e-4))
+        return false;
+    return dot(geometry.xyz, normal) >= restirData.normalTolerance;
+}
+
+#endif // RESTIR_KERNEL_H
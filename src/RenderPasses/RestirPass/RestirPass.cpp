@@ -0,0 +1,5 @@
+#include "RestirPass.hpp"
+
+namespace vuren {
+
+} // namespace vuren
\ No newline at end of file
@@ -0,0 +1,198 @@
+#ifndef RESTIR_PASS_HPP
+#define RESTIR_PASS_HPP
+
+#include "BindlessTable.hpp"
+#include "GpuProfiler.hpp"
+#include "RenderPass.hpp"
+#include "RestirCommon.h"
+
+namespace vuren {
+
+// reservoir-based spatiotemporal importance resampling of the direct lighting (Bitterli et al. 2020, ReSTIR), in
+// compute shaders: every pixel resamples a few lights picked by power into one reservoir, combines it with the
+// reservoir its surface had in the last frame (found through the motion vectors) and then with those of a few
+// neighbors. the reservoirs hold one light each and are packed into 8 bytes per pixel. RestirShadePass traces the
+// visibility ray towards the selected light. the biased variant: the combined reservoirs are not tested for
+// visibility, so occluders at the edges of shadows can darken or brighten a few pixels.
+class RestirPass : public ComputeRenderPass {
+public:
+    RestirPass() {}
+
+    ~RestirPass() {}
+
+    void init(VulkanContext *pContext, vk::CommandPool commandPool, std::shared_ptr<ResourceManager> pResourceManager,
+              std::shared_ptr<Scene> pScene) override {
+        ComputeRenderPass::init(pContext, commandPool, pResourceManager, pScene);
+
+        m_restirData.frameCount      = 0;
+        m_restirData.historyIndex    = 0;
+        m_restirData.reset           = 1;
+        m_restirData.spatialRadius   = 30.0f;
+        m_restirData.depthTolerance  = 0.1f;
+        m_restirData.normalTolerance = 0.9f;
+        m_restirData.tMin            = 0.00001f;
+
+        // the first frame has no history
+        m_resetPending = true;
+    }
+
+    void updateGui() {
+        if (!ImGui::CollapsingHeader("ReSTIR Pass"))
+            return;
+
+        ImGui::SliderInt("Initial candidates", &m_initialCandidates, 1, 64);
+        ImGui::Checkbox("Temporal reuse", &m_temporalReuse);
+        ImGui::SliderInt("Max history (x candidates)", &m_maxHistory, 1, 40);
+        ImGui::SliderInt("Spatial samples", &m_spatialSamples, 0, 8);
+        ImGui::SliderFloat("Spatial radius (px)", &m_restirData.spatialRadius, 1.0f, 64.0f);
+    }
+
+    // scopes every kernel in the gpu profiler
+    void setGpuProfiler(GpuProfiler *pGpuProfiler) { m_pGpuProfiler = pGpuProfiler; }
+
+    // must be called once per submitted frame, once the last frame has completed
+    void updateUniformBuffer() {
+        m_restirData.frameCount++;
+        m_restirData.reset = m_resetPending ? 1 : 0;
+        m_resetPending     = false;
+
+        // the pair written by the last frame is read by this one
+        m_restirData.historyIndex ^= 1;
+
+        m_restirData.initialCandidates = static_cast<uint32_t>(m_initialCandidates);
+        m_restirData.temporalReuse     = m_temporalReuse ? 1 : 0;
+        m_restirData.maxHistory        = static_cast<uint32_t>(m_maxHistory);
+        m_restirData.spatialSamples    = static_cast<uint32_t>(m_spatialSamples);
+
+        memcpy(m_pResourceManager->getMappedBuffer("RestirData"), &m_restirData, sizeof(RestirData));
+    }
+
+    // starts over with the next frame, e.g. after the lights changed
+    void resetHistory() { m_resetPending = true; }
+
+    void connectTextureMotion(const std::string &srcTexture) {
+        m_pResourceManager->connectTextures(srcTexture, "RestirInMotion");
+    }
+
+    void define() override {
+        if (m_pScene->getLights().size() >= RESTIR_INVALID_LIGHT)
+            throw std::runtime_error("too many lights for the reservoirs of the ReSTIR pass!");
+
+        m_pResourceManager->createTextureRGBA32Sfloat("RestirInMotion");
+        m_pResourceManager->createUniformBuffer<RestirData>("RestirData");
+
+        // only written and read by the kernels, so they stay in the general layout
+        for (auto &name: kGeometryTextureNames) {
+            m_pResourceManager->createTextureRGBA32Sfloat(name);
+            transitionImageLayout(*m_pContext, m_commandPool, m_pResourceManager->getTexture(name),
+                                  vk::ImageLayout::eUndefined, vk::ImageLayout::eGeneral,
+                                  vk::PipelineStageFlagBits::eAllCommands, vk::PipelineStageFlagBits::eComputeShader);
+        }
+
+        // one packed reservoir (uvec2) per pixel
+        vk::DeviceSize reservoirsSize = static_cast<vk::DeviceSize>(m_extent.width) * m_extent.height * 2 *
+                                        sizeof(uint32_t);
+        for (auto &name: kReservoirBufferNames) {
+            m_pResourceManager->insertBuffer(name, m_pResourceManager->createBuffer(
+                                                       reservoirsSize, vk::BufferUsageFlagBits::eStorageBuffer,
+                                                       vk::MemoryPropertyFlagBits::eDeviceLocal));
+        }
+
+        // resources of the descriptor set, by binding (see RestirKernel.h). the g-buffer is the path tracing pass's
+        // input, so that pass is defined first
+        bindResources({ { 0, "PtInWorldPos" },
+                        { 1, "PtInWorldNormal" },
+                        { 2, "RestirInMotion" },
+                        { 3, "RestirGeometry0" },
+                        { 4, "RestirGeometry1" },
+                        { 5, "RestirInitialReservoirs" },
+                        { 6, "RestirTemporalReservoirs" },
+                        { 7, "RestirReservoirs0" },
+                        { 8, "RestirReservoirs1" },
+                        { 9, "RestirData" },
+                        { 10, "CameraBuffer" } });
+
+        // indexed by Kernel
+        setupComputePipelines({ "shaders/RenderPasses/RestirPass/RestirInitial.comp.spv",
+                                "shaders/RenderPasses/RestirPass/RestirTemporal.comp.spv",
+                                "shaders/RenderPasses/RestirPass/RestirSpatial.comp.spv" });
+    }
+
+    void record(vk::CommandBuffer commandBuffer) override {
+        // the g-buffer, and the reservoirs the shading pass of the last frame has written
+        vk::MemoryBarrier inputBarrier{ .srcAccessMask = vk::AccessFlagBits::eColorAttachmentWrite |
+                                                         vk::AccessFlagBits::eShaderWrite,
+                                        .dstAccessMask = vk::AccessFlagBits::eShaderRead |
+                                                         vk::AccessFlagBits::eShaderWrite };
+        commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eColorAttachmentOutput |
+                                          vk::PipelineStageFlagBits::eRayTracingShaderKHR |
+                                          vk::PipelineStageFlagBits::eComputeShader,
+                                      vk::PipelineStageFlagBits::eComputeShader, {}, 1, &inputBarrier, 0, nullptr, 0,
+                                      nullptr);
+
+        uint32_t groupCountX = (m_extent.width + RESTIR_GROUP_SIZE - 1) / RESTIR_GROUP_SIZE;
+        uint32_t groupCountY = (m_extent.height + RESTIR_GROUP_SIZE - 1) / RESTIR_GROUP_SIZE;
+
+        beginScope(commandBuffer, "RestirInitial");
+        bindComputePipeline(commandBuffer, eInitial);
+        commandBuffer.dispatch(groupCountX, groupCountY, 1);
+        endScope(commandBuffer);
+        computeBarrier(commandBuffer, vk::PipelineStageFlagBits::eComputeShader);
+
+        beginScope(commandBuffer, "RestirTemporal");
+        bindComputePipeline(commandBuffer, eTemporal);
+        commandBuffer.dispatch(groupCountX, groupCountY, 1);
+        endScope(commandBuffer);
+        computeBarrier(commandBuffer, vk::PipelineStageFlagBits::eComputeShader);
+
+        beginScope(commandBuffer, "RestirSpatial");
+        bindComputePipeline(commandBuffer, eSpatial);
+        commandBuffer.dispatch(groupCountX, groupCountY, 1);
+        endScope(commandBuffer);
+
+        // the shading pass reads the reservoirs and drops the occluded lights
+        computeBarrier(commandBuffer, vk::PipelineStageFlagBits::eRayTracingShaderKHR);
+    }
+
+private:
+    enum Kernel { eInitial, eTemporal, eSpatial };
+
+    static inline const std::array<std::string, 2> kGeometryTextureNames = { "RestirGeometry0", "RestirGeometry1" };
+    static inline const std::array<std::string, 4> kReservoirBufferNames = {
+        "RestirInitialReservoirs", "RestirTemporalReservoirs", "RestirReservoirs0", "RestirReservoirs1"
+    };
+
+    void computeBarrier(vk::CommandBuffer commandBuffer, vk::PipelineStageFlags dstStage) {
+        vk::MemoryBarrier barrier{ .srcAccessMask = vk::AccessFlagBits::eShaderWrite,
+                                   .dstAccessMask = vk::AccessFlagBits::eShaderRead |
+                                                    vk::AccessFlagBits::eShaderWrite };
+        commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, dstStage, {}, 1, &barrier, 0,
+                                      nullptr, 0, nullptr);
+    }
+
+    void beginScope(vk::CommandBuffer commandBuffer, const char *name) {
+        if (m_pGpuProfiler)
+            m_pGpuProfiler->beginScope(commandBuffer, name);
+    }
+
+    void endScope(vk::CommandBuffer commandBuffer) {
+        if (m_pGpuProfiler)
+            m_pGpuProfiler->endScope(commandBuffer);
+    }
+
+    RestirData m_restirData;
+    bool m_resetPending{ true };
+
+    // mirrored into m_restirData every frame
+    int m_initialCandidates{ 32 };
+    bool m_temporalReuse{ true };
+    int m_maxHistory{ 20 };
+    int m_spatialSamples{ 5 };
+
+    GpuProfiler *m_pGpuProfiler{ nullptr };
+
+}; // class RestirPass
+
+} // namespace vuren
+
+#endif // RESTIR_PASS_HPP
@@ -0,0 +1,14 @@
+#version 460
+#extension GL_EXT_ray_tracing : require
+#extension GL_GOOGLE_include_directive : enable
+#extension GL_EXT_shader_explicit_arithmetic_types_int64 : require
+#extension GL_EXT_nonuniform_qualifier : enable
+
+#include "Common.hpp"
+#include "RestirCommon.h"
+
+layout(location = 0) rayPayloadInEXT VisibilityPayload payload;
+
+// never runs, the visibility ray skips the closest hit shader
+void main() {
+}
@@ -0,0 +1,67 @@
+#version 460
+#extension GL_EXT_ray_tracing : require
+#extension GL_GOOGLE_include_directive : enable
+#extension GL_EXT_shader_explicit_arithmetic_types_int64 : require
+#extension GL_EXT_nonuniform_qualifier : enable
+
+#include "Common.hpp"
+#include "RestirCommon.h"
+
+layout(location = 0) rayPayloadEXT VisibilityPayload payload;
+
+layout(set = 1, binding = 0) uniform accelerationStructureEXT tlas;
+layout(set = 1, binding = 1) uniform _RestirData {
+    RestirData restirData;
+};
+
+// g-buffers
+layout(set = 1, binding = 2) uniform sampler2D worldPos;
+layout(set = 1, binding = 3) uniform sampler2D worldNormal;
+
+// the reservoirs after the spatial reuse, ping-pong by frame (see RestirKernel.h)
+layout(set = 1, binding = 4) buffer _Reservoirs0 {
+    uvec2 data[];
+} reservoirs0;
+layout(set = 1, binding = 5) buffer _Reservoirs1 {
+    uvec2 data[];
+} reservoirs1;
+
+// output texture
+layout(set = 1, binding = 6, rgba32f) uniform image2D outputColor;
+
+// shades every pixel with the light selected by its reservoir, behind one visibility ray. an occluded light is
+// dropped from the reservoir, so the next frame does not reuse it.
+void main() {
+    ivec2 pixel = ivec2(gl_LaunchIDEXT.xy);
+    uint index = gl_LaunchIDEXT.y * gl_LaunchSizeEXT.x + gl_LaunchIDEXT.x;
+
+    vec4 pos = texelFetch(worldPos, pixel, 0);
+    vec3 normal = texelFetch(worldNormal, pixel, 0).xyz;
+    Reservoir r = unpackReservoir(restirData.historyIndex == 0 ? reservoirs0.data[index] : reservoirs1.data[index]);
+
+    vec3 radiance = vec3(0.0);
+    if (pos.w != 0.0 && r.lightIndex != RESTIR_INVALID_LIGHT) {
+        Light light = sceneLights.data[r.lightIndex];
+        vec3 ldir = light.pos - pos.xyz;
+        float ldist = length(ldir);
+
+        payload.visible = 0.0;
+        traceRayEXT(tlas,
+                    gl_RayFlagsOpaqueEXT | gl_RayFlagsTerminateOnFirstHitEXT | gl_RayFlagsSkipClosestHitShaderEXT,
+                    0xFF, 0, 0, 0, pos.xyz, restirData.tMin, ldir / ldist, ldist, 0);
+
+        if (payload.visible != 0.0) {
+            radiance = evaluateLight(light, pos.xyz, normal) * r.W;
+        } else {
+            // the candidates seen are kept, the reservoir only loses its light
+            r.lightIndex = RESTIR_INVALID_LIGHT;
+            r.W = 0.0;
+            if (restirData.historyIndex == 0)
+                reservoirs0.data[index] = packReservoir(r);
+            else
+                reservoirs1.data[index] = packReservoir(r);
+        }
+    }
+
+    imageStore(outputColor, pixel, vec4(radiance, 0.0));
+}
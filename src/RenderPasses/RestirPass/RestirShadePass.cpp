@@ -0,0 +1,5 @@
+#include "RestirShadePass.hpp"
+
+namespace vuren {
+
+} // namespace vuren
\ No newline at end of file
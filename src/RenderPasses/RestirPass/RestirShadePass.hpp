@@ -0,0 +1,66 @@
+#ifndef RESTIR_SHADE_PASS_HPP
+#define RESTIR_SHADE_PASS_HPP
+
+#include "RenderPass.hpp"
+#include "RestirCommon.h"
+
+namespace vuren {
+
+// the last step of ReSTIR: shades every pixel with the light its reservoir selected, behind a visibility ray, into
+// "RestirOutput" (the direct lighting only). reads the reservoirs and the uniforms of the RestirPass recorded before
+// it, so that pass is defined first.
+class RestirShadePass : public RayTracingRenderPass {
+public:
+    RestirShadePass() {}
+
+    ~RestirShadePass() {}
+
+    void define() override {
+        // sampled by the following passes between the frames, see record()
+        m_pResourceManager->createTextureRGBA32Sfloat("RestirOutput");
+        transitionImageLayout(*m_pContext, m_commandPool, m_pResourceManager->getTexture("RestirOutput"),
+                              vk::ImageLayout::eUndefined, vk::ImageLayout::eShaderReadOnlyOptimal,
+                              vk::PipelineStageFlagBits::eAllCommands, vk::PipelineStageFlagBits::eFragmentShader);
+
+        // for gui output selection
+        m_pContext->kOffscreenOutputTextureNames.push_back("RestirOutput");
+
+        // resources of the descriptor set, by binding
+        bindResources({ { 0, "Tlas" },
+                        { 1, "RestirData" },
+                        { 2, "PtInWorldPos" },
+                        { 3, "PtInWorldNormal" },
+                        { 4, "RestirReservoirs0" },
+                        { 5, "RestirReservoirs1" },
+                        { 6, "RestirOutput" } });
+
+        setupRayTracingPipeline("shaders/RenderPasses/RestirPass/RestirShade.rgen.spv",
+                                "shaders/RenderPasses/RestirPass/RestirShade.rmiss.spv",
+                                "shaders/RenderPasses/RestirPass/RestirShade.rchit.spv");
+    }
+
+    void record(vk::CommandBuffer commandBuffer) override {
+        transitionImageLayout(commandBuffer, m_pResourceManager->getTexture("RestirOutput"),
+                              vk::ImageLayout::eShaderReadOnlyOptimal, vk::ImageLayout::eGeneral,
+                              vk::PipelineStageFlagBits::eFragmentShader | vk::PipelineStageFlagBits::eComputeShader,
+                              vk::PipelineStageFlagBits::eRayTracingShaderKHR);
+
+        commandBuffer.bindPipeline(vk::PipelineBindPoint::eRayTracingKHR, m_pipeline);
+
+        commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eRayTracingKHR, m_pipelineLayout, PASS_SET, 1,
+                                         &m_descriptorSet, 0, nullptr);
+
+        commandBuffer.traceRaysKHR(&m_rgenRegion, &m_missRegion, &m_hitRegion, &m_callRegion, m_extent.width,
+                                   m_extent.height, 1);
+    }
+
+    void outputTextureBarrier(vk::CommandBuffer commandBuffer) override {
+        transitionImageLayout(commandBuffer, m_pResourceManager->getTexture("RestirOutput"), vk::ImageLayout::eGeneral,
+                              vk::ImageLayout::eShaderReadOnlyOptimal, vk::PipelineStageFlagBits::eRayTracingShaderKHR,
+                              vk::PipelineStageFlagBits::eFragmentShader | vk::PipelineStageFlagBits::eComputeShader);
+    }
+};
+
+} // namespace vuren
+
+#endif // RESTIR_SHADE_PASS_HPP
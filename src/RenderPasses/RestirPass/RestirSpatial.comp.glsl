@@ -0,0 +1,62 @@
+#version 460
+#extension GL_GOOGLE_include_directive : enable
+#extension GL_EXT_shader_explicit_arithmetic_types_int64 : require
+#extension GL_EXT_nonuniform_qualifier : enable
+
+#include "RestirKernel.h"
+#include "CommonShaders/Random.h"
+
+layout(local_size_x = RESTIR_GROUP_SIZE, local_size_y = RESTIR_GROUP_SIZE) in;
+
+// combines the reservoir with those of a few random neighbors on a similar surface. the result is shaded by the
+// visibility pass and reused by the next frame.
+void main() {
+    ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+    ivec2 size = imageSize(geometryHistory0);
+    if (any(greaterThanEqual(pixel, size)))
+        return;
+
+    Reservoir r = unpackReservoir(temporalReservoirs.data[pixelIndex(pixel)]);
+    vec4 position = texelFetch(worldPos, pixel, 0);
+
+    if (restirData.spatialSamples > 0 && position.w != 0.0) {
+        vec3 normal = texelFetch(worldNormal, pixel, 0).xyz;
+        float depth = loadGeometry(pixel, true).w;
+        uint rngState = initRNG(uvec2(pixel), uvec2(size), restirData.frameCount * 3u + 2u);
+
+        Reservoir canonical = r;
+        r = emptyReservoir();
+        float selectedPdf = 0.0;
+        float canonicalPdf = canonical.lightIndex != RESTIR_INVALID_LIGHT
+                                 ? targetPdf(canonical.lightIndex, position.xyz, normal)
+                                 : 0.0;
+        if (updateReservoir(r, canonical.lightIndex, canonicalPdf * canonical.W * float(canonical.M), canonical.M,
+                            rand(rngState)))
+            selectedPdf = canonicalPdf;
+
+        for (uint i = 0; i < restirData.spatialSamples; ++i) {
+            // uniform in a disk around the pixel
+            float radius = restirData.spatialRadius * sqrt(rand(rngState));
+            float angle = 2.0 * PI * rand(rngState);
+            ivec2 q = pixel + ivec2(round(radius * vec2(cos(angle), sin(angle))));
+            if (q == pixel || any(lessThan(q, ivec2(0))) || any(greaterThanEqual(q, size)))
+                continue;
+            if (!isSimilarSurface(loadGeometry(q, true), normal, depth))
+                continue;
+
+            Reservoir neighbor = unpackReservoir(temporalReservoirs.data[pixelIndex(q)]);
+            float neighborPdf = neighbor.lightIndex != RESTIR_INVALID_LIGHT
+                                    ? targetPdf(neighbor.lightIndex, position.xyz, normal)
+                                    : 0.0;
+            if (updateReservoir(r, neighbor.lightIndex, neighborPdf * neighbor.W * float(neighbor.M), neighbor.M,
+                                rand(rngState)))
+                selectedPdf = neighborPdf;
+        }
+        finalizeReservoir(r, selectedPdf);
+    }
+
+    if (restirData.historyIndex == 0)
+        reservoirs0.data[pixelIndex(pixel)] = packReservoir(r);
+    else
+        reservoirs1.data[pixelIndex(pixel)] = packReservoir(r);
+}
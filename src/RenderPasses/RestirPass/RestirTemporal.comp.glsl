@@ -0,0 +1,62 @@
+#version 460
+#extension GL_GOOGLE_include_directive : enable
+#extension GL_EXT_shader_explicit_arithmetic_types_int64 : require
+#extension GL_EXT_nonuniform_qualifier : enable
+
+#include "RestirKernel.h"
+#include "CommonShaders/Random.h"
+
+layout(local_size_x = RESTIR_GROUP_SIZE, local_size_y = RESTIR_GROUP_SIZE) in;
+
+// whether the surface seen at prevPixel in the last frame is the one seen now
+bool isSameSurface(ivec2 prevPixel, ivec2 size, vec3 position, vec3 normal) {
+    if (any(lessThan(prevPixel, ivec2(0))) || any(greaterThanEqual(prevPixel, size)))
+        return false;
+
+    // the view depth the current surface had in the last frame
+    return isSimilarSurface(loadGeometry(prevPixel, false), normal, viewDepth(camera.prevView, position));
+}
+
+// combines the new reservoir with the one the surface had in the last frame, found through the motion vectors
+void main() {
+    ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+    ivec2 size = imageSize(geometryHistory0);
+    if (any(greaterThanEqual(pixel, size)))
+        return;
+
+    Reservoir current = unpackReservoir(initialReservoirs.data[pixelIndex(pixel)]);
+    vec4 position = texelFetch(worldPos, pixel, 0);
+    vec3 normal = texelFetch(worldNormal, pixel, 0).xyz;
+
+    // a reservoir holds a single light, so the nearest previous pixel is taken instead of a bilinear blend
+    vec2 pixelMotion = texelFetch(motion, pixel, 0).xy * vec2(size);
+    ivec2 prevPixel = ivec2(round(vec2(pixel) - pixelMotion));
+
+    if (restirData.temporalReuse == 0 || restirData.reset != 0 || position.w == 0.0 ||
+        !isSameSurface(prevPixel, size, position.xyz, normal)) {
+        temporalReservoirs.data[pixelIndex(pixel)] = packReservoir(current);
+        return;
+    }
+
+    uint rngState = initRNG(uvec2(pixel), uvec2(size), restirData.frameCount * 3u + 1u);
+    Reservoir r = emptyReservoir();
+    float selectedPdf = 0.0;
+
+    // the resampling weight of a reservoir is its target pdf here times W, and it stands for its M candidates
+    float currentPdf = current.lightIndex != RESTIR_INVALID_LIGHT
+                           ? targetPdf(current.lightIndex, position.xyz, normal)
+                           : 0.0;
+    if (updateReservoir(r, current.lightIndex, currentPdf * current.W * float(current.M), current.M,
+                        rand(rngState)))
+        selectedPdf = currentPdf;
+
+    // the history is capped, so that it keeps following changes of the lighting
+    Reservoir prev = loadReservoir(prevPixel, false);
+    prev.M = min(prev.M, restirData.maxHistory * max(current.M, 1u));
+    float prevPdf = prev.lightIndex != RESTIR_INVALID_LIGHT ? targetPdf(prev.lightIndex, position.xyz, normal) : 0.0;
+    if (updateReservoir(r, prev.lightIndex, prevPdf * prev.W * float(prev.M), prev.M, rand(rngState)))
+        selectedPdf = prevPdf;
+
+    finalizeReservoir(r, selectedPdf);
+    temporalReservoirs.data[pixelIndex(pixel)] = packReservoir(r);
+}
@@ -0,0 +1,126 @@
+#version 460
+#extension GL_GOOGLE_include_directive : enable
+#extension GL_EXT_shader_explicit_arithmetic_types_int64 : require
+
+#include "SvgfCommon.h"
+
+layout(local_size_x = SVGF_GROUP_SIZE, local_size_y = SVGF_GROUP_SIZE) in;
+
+// a workgroup filters a 16x16 lattice of pixels spaced by the step size. the 5x5 taps of its pixels are on the same
+// lattice, so the taps of the whole group fit in a 20x20 tile at every iteration.
+#define TILE_SIZE (SVGF_GROUP_SIZE + 4)
+#define TILE_INVALID 0xffffffffu
+
+shared vec4 tileColor[TILE_SIZE * TILE_SIZE];     // color and variance
+shared uvec4 tileGeometry[TILE_SIZE * TILE_SIZE]; // world position bits, octahedral normal (TILE_INVALID if none)
+
+uint packNormal(vec3 n) {
+    vec2 p = n.xy / (abs(n.x) + abs(n.y) + abs(n.z));
+    if (n.z < 0.0)
+        p = (1.0 - abs(p.yx)) * vec2(p.x >= 0.0 ? 1.0 : -1.0, p.y >= 0.0 ? 1.0 : -1.0);
+    return packSnorm2x16(p);
+}
+
+vec3 unpackNormal(uint packed) {
+    vec2 p = unpackSnorm2x16(packed);
+    vec3 n = vec3(p, 1.0 - abs(p.x) - abs(p.y));
+    float t = max(-n.z, 0.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
+
+int tileIndex(ivec2 tile) {
+    return tile.y * TILE_SIZE + tile.x;
+}
+
+vec4 loadSource(ivec2 pixel) {
+    return imageLoad(filterImages[svgfPush.srcImage], pixel);
+}
+
+void main() {
+    int stepSize = int(svgfPush.stepSize);
+    ivec2 size = imageSize(integratedColor);
+
+    // the groups of a block of 16 * stepSize pixels take one lattice offset each
+    ivec2 group = ivec2(gl_WorkGroupID.xy);
+    ivec2 origin = (group / stepSize) * SVGF_GROUP_SIZE * stepSize + group % stepSize;
+    ivec2 pixel = origin + ivec2(gl_LocalInvocationID.xy) * stepSize;
+
+    for (uint i = gl_LocalInvocationIndex; i < TILE_SIZE * TILE_SIZE; i += SVGF_GROUP_SIZE * SVGF_GROUP_SIZE) {
+        ivec2 q = origin + (ivec2(i % TILE_SIZE, i / TILE_SIZE) - 2) * stepSize;
+        tileColor[i] = vec4(0.0);
+        tileGeometry[i] = uvec4(TILE_INVALID);
+        if (any(lessThan(q, ivec2(0))) || any(greaterThanEqual(q, size)))
+            continue;
+
+        tileColor[i] = loadSource(q);
+        vec4 position = texelFetch(worldPos, q, 0);
+        if (position.w != 0.0)
+            tileGeometry[i] = uvec4(floatBitsToUint(position.xyz), packNormal(texelFetch(worldNormal, q, 0).xyz));
+    }
+    barrier();
+
+    if (any(greaterThanEqual(pixel, size)))
+        return;
+
+    ivec2 center = ivec2(gl_LocalInvocationID.xy) + 2;
+    vec4 centerColor = tileColor[tileIndex(center)];
+    uvec4 centerGeometry = tileGeometry[tileIndex(center)];
+
+    vec4 result = centerColor;
+    if (centerGeometry.w != TILE_INVALID) {
+        vec3 position = uintBitsToFloat(centerGeometry.xyz);
+        vec3 normal = unpackNormal(centerGeometry.w);
+        float centerLum = luminance(centerColor.rgb);
+        float footprint = pixelFootprint(viewDepth(camera.view, position)) * float(stepSize);
+
+        // the luminance edge-stopping uses the variance blurred over the 3x3 lattice neighbors
+        const float gaussian[2] = { 0.25, 0.125 };
+        float variance = 0.0;
+        for (int y = -1; y <= 1; ++y) {
+            for (int x = -1; x <= 1; ++x) {
+                float w = gaussian[abs(x)] * gaussian[abs(y)] * 4.0;
+                variance += w * tileColor[tileIndex(center + ivec2(x, y))].a;
+            }
+        }
+        float phiLum = svgfData.phiColor * sqrt(max(variance, 0.0)) + 1e-10;
+
+        // the B3 spline kernel
+        const float kernel[3] = { 3.0 / 8.0, 1.0 / 4.0, 1.0 / 16.0 };
+        vec3 colorSum = centerColor.rgb;
+        float varianceSum = centerColor.a;
+        float weightSum = 1.0;
+        for (int y = -2; y <= 2; ++y) {
+            for (int x = -2; x <= 2; ++x) {
+                if (x == 0 && y == 0)
+                    continue;
+
+                int q = tileIndex(center + ivec2(x, y));
+                if (tileGeometry[q].w == TILE_INVALID)
+                    continue;
+
+                vec4 qColor = tileColor[q];
+                vec3 qPosition = uintBitsToFloat(tileGeometry[q].xyz);
+                vec3 qNormal = unpackNormal(tileGeometry[q].w);
+
+                float planeDistance = abs(dot(normal, qPosition - position));
+                float wNormal = pow(max(dot(normal, qNormal), 0.0), svgfData.phiNormal);
+                float wDepth = exp(-planeDistance / (svgfData.phiDepth * footprint * length(vec2(x, y)) + 1e-6));
+                float wLum = exp(-abs(luminance(qColor.rgb) - centerLum) / phiLum);
+
+                float w = kernel[abs(x)] * kernel[abs(y)] / (kernel[0] * kernel[0]) * wNormal * wDepth * wLum;
+                colorSum += w * qColor.rgb;
+                varianceSum += w * w * qColor.a;
+                weightSum += w;
+            }
+        }
+        result = vec4(colorSum / weightSum, varianceSum / (weightSum * weightSum));
+    }
+
+    if (svgfPush.writeHistory != 0)
+        imageStore(colorHistory, pixel, vec4(result.rgb, 0.0));
+
+    if (svgfPush.dstImage == SVGF_OUTPUT_IMAGE)
+        result.a = 1.0;
+    imageStore(filterImages[svgfPush.dstImage], pixel, result);
+}
@@ -0,0 +1,118 @@
+#ifndef SVGF_COMMON_H
+#define SVGF_COMMON_H
+
+#include "Common.hpp"
+
+#ifdef __cplusplus
+namespace vuren {
+#endif
+
+// every kernel runs 16x16 threads per workgroup
+#define SVGF_GROUP_SIZE 16
+#define SVGF_MAX_ITERATIONS 5
+
+// the a-trous iterations ping-pong between the two filter images, the last one writes the output image
+#define SVGF_FILTER_IMAGE_0 0u
+#define SVGF_FILTER_IMAGE_1 1u
+#define SVGF_OUTPUT_IMAGE 2u
+#define SVGF_FILTER_IMAGE_COUNT 3
+
+struct SvgfData {
+    uint historyIndex; // the moments and geometry history written this frame (0 or 1), the other pair is read
+    uint reset;        // 1 drops every history sample
+
+    // the smallest weight of the new frame in the temporal integration, a short history uses 1 / length instead
+    float colorAlpha;
+    float momentsAlpha;
+
+    // edge-stopping functions of the a-trous filter: luminance distance in standard deviations, the exponent of the
+    // normal weight, and the distance to the tangent plane in pixel footprints
+    float phiColor;
+    float phiNormal;
+    float phiDepth;
+
+    // reprojection: the history is rejected when its view depth differs by more than depthTolerance (relative) or
+    // its normal by more than acos(normalTolerance)
+    float depthTolerance;
+    float normalTolerance;
+
+    uint adaptive; // 1 when the path tracer launches only the pixels of the sampled mask, see SvgfTemporal.comp
+    float pad0;
+    float pad1;
+};
+
+// pushed before every a-trous iteration
+struct SvgfPushConstant {
+    uint stepSize;     // 1 << iteration, in pixels
+    uint srcImage;     // SVGF_FILTER_IMAGE_0, SVGF_FILTER_IMAGE_1 or SVGF_OUTPUT_IMAGE
+    uint dstImage;
+    uint writeHistory; // the output is also the color history of the next frame
+};
+
+#ifdef __cplusplus
+} // namespace vuren
+#else
+
+// the resources of every kernel, which share one descriptor set
+layout(set = 1, binding = 0) uniform sampler2D currentFrame;
+layout(set = 1, binding = 1) uniform sampler2D worldPos;
+layout(set = 1, binding = 2) uniform sampler2D worldNormal;
+layout(set = 1, binding = 3) uniform sampler2D motion;
+
+// the filtered color of the last frame, after the first a-trous iteration
+layout(set = 1, binding = 4, rgba32f) uniform image2D colorHistory;
+
+// ping-pong by frame. moments: the first two luminance moments and the history length.
+// geometry: the world normal and the view depth (0 for the background).
+layout(set = 1, binding = 5, rgba32f) uniform image2D momentsHistory0;
+layout(set = 1, binding = 6, rgba32f) uniform image2D momentsHistory1;
+layout(set = 1, binding = 7, rgba32f) uniform image2D geometryHistory0;
+layout(set = 1, binding = 8, rgba32f) uniform image2D geometryHistory1;
+
+// the temporally integrated color, and the history length in a
+layout(set = 1, binding = 9, rgba32f) uniform image2D integratedColor;
+
+// the color in rgb and its variance in a
+layout(set = 1, binding = 10, rgba32f) uniform image2D filterImages[SVGF_FILTER_IMAGE_COUNT];
+
+layout(set = 1, binding = 11) uniform _SvgfData {
+    SvgfData svgfData;
+};
+layout(set = 1, binding = 12) uniform _Camera {
+    CameraData camera;
+};
+
+// adaptive sampling: 1 in r where the current frame holds a new path, the other pixels keep an old one
+layout(set = 1, binding = 13, rgba8) uniform readonly image2D sampledMask;
+
+layout(push_constant) uniform _SvgfPushConstant {
+    SvgfPushConstant svgfPush;
+};
+
+float luminance(vec3 color) {
+    return dot(color, vec3(0.2126, 0.7152, 0.0722));
+}
+
+float viewDepth(mat4 view, vec3 position) {
+    return -(view * vec4(position, 1.0)).z;
+}
+
+// the world space size of a pixel at the given view depth
+float pixelFootprint(float depth) {
+    return depth * 2.0 / (float(imageSize(integratedColor).y) * abs(camera.proj[1][1]));
+}
+
+// the pair written this frame and the one of the last frame
+vec4 loadMoments(ivec2 pixel, bool current) {
+    return (svgfData.historyIndex == 0) == current ? imageLoad(momentsHistory0, pixel)
+                                                   : imageLoad(momentsHistory1, pixel);
+}
+
+vec4 loadGeometry(ivec2 pixel, bool current) {
+    return (svgfData.historyIndex == 0) == current ? imageLoad(geometryHistory0, pixel)
+                                                   : imageLoad(geometryHistory1, pixel);
+}
+
+#endif // __cplusplus
+
+#endif // SVGF_COMMON_H
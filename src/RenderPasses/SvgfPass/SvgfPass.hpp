@@ -0,0 +1,262 @@
+#ifndef SVGF_PASS_HPP
+#define SVGF_PASS_HPP
+
+#include "BindlessTable.hpp"
+#include "GpuProfiler.hpp"
+#include "RenderPass.hpp"
+#include "SvgfCommon.h"
+
+namespace vuren {
+
+// spatiotemporal variance-guided filtering (Schied et al. 2017) of a 1 spp frame, in compute shaders:
+// the frame is reprojected and blended with the history together with its luminance moments, the variance is
+// estimated from the moments (spatially while the history is short), and a few iterations of an edge-aware a-trous
+// wavelet filter, guided by the g-buffer and the variance, denoise it. the output of the first iteration is the
+// color history of the next frame.
+class SvgfPass : public ComputeRenderPass {
+public:
+    SvgfPass() {}
+
+    ~SvgfPass() {}
+
+    void init(VulkanContext *pContext, vk::CommandPool commandPool, std::shared_ptr<ResourceManager> pResourceManager,
+              std::shared_ptr<Scene> pScene) override {
+        ComputeRenderPass::init(pContext, commandPool, pResourceManager, pScene);
+
+        m_svgfData.historyIndex    = 0;
+        m_svgfData.reset           = 1;
+        m_svgfData.colorAlpha      = 0.2f;
+        m_svgfData.momentsAlpha    = 0.2f;
+        m_svgfData.phiColor        = 4.0f;
+        m_svgfData.phiNormal       = 128.0f;
+        m_svgfData.phiDepth        = 1.0f;
+        m_svgfData.depthTolerance  = 0.05f;
+        m_svgfData.normalTolerance = 0.9f;
+        m_svgfData.adaptive        = 0;
+
+        // the first frame has no history
+        m_resetPending = true;
+    }
+
+    void updateGui() {
+        if (!ImGui::CollapsingHeader("SVGF Pass"))
+            return;
+
+        ImGui::SliderInt("Iterations", &m_iterations, 1, SVGF_MAX_ITERATIONS);
+        ImGui::SliderFloat("Color alpha", &m_svgfData.colorAlpha, 0.01f, 1.0f);
+        ImGui::SliderFloat("Moments alpha", &m_svgfData.momentsAlpha, 0.01f, 1.0f);
+        ImGui::SliderFloat("Phi color", &m_svgfData.phiColor, 0.1f, 16.0f);
+        ImGui::SliderFloat("Phi normal", &m_svgfData.phiNormal, 1.0f, 256.0f);
+        ImGui::SliderFloat("Phi depth", &m_svgfData.phiDepth, 0.1f, 16.0f);
+    }
+
+    // scopes every kernel, and every a-trous iteration, in the gpu profiler
+    void setGpuProfiler(GpuProfiler *pGpuProfiler) { m_pGpuProfiler = pGpuProfiler; }
+
+    // must be called once per submitted frame, once the last frame has completed
+    void updateUniformBuffer() {
+        m_svgfData.reset = m_resetPending ? 1 : 0;
+        m_resetPending   = false;
+
+        // the pair written by the last frame is read by this one
+        m_svgfData.historyIndex ^= 1;
+
+        memcpy(m_pResourceManager->getMappedBuffer("SvgfData"), &m_svgfData, sizeof(SvgfData));
+    }
+
+    // starts over with the next frame, e.g. after the shaders producing it changed
+    void resetHistory() { m_resetPending = true; }
+
+    void connectTextureCurrentFrame(const std::string &srcTexture) {
+        m_pResourceManager->connectTextures(srcTexture, "SvgfInCurrentFrame");
+    }
+
+    void connectTextureWorldPos(const std::string &srcTexture) {
+        m_pResourceManager->connectTextures(srcTexture, "SvgfInWorldPos");
+    }
+
+    void connectTextureWorldNormal(const std::string &srcTexture) {
+        m_pResourceManager->connectTextures(srcTexture, "SvgfInWorldNormal");
+    }
+
+    void connectTextureMotion(const std::string &srcTexture) {
+        m_pResourceManager->connectTextures(srcTexture, "SvgfInMotion");
+    }
+
+    // with adaptive sampling the pixels left out of the launch keep their old path in the current frame, which must
+    // not be blended into the history again. the mask is written before the path tracer, see AccumAllocate.comp.
+    // must be called before define().
+    void connectTextureSampledMask(const std::string &srcTexture) {
+        m_pResourceManager->connectTextures(srcTexture, "SvgfInSampledMask");
+        m_svgfData.adaptive = 1;
+    }
+
+    void define() override {
+        // without adaptive sampling every pixel is launched, and the mask is never read
+        if (m_svgfData.adaptive == 0) {
+            m_pResourceManager->createStorageTextureRGBA8Unorm("SvgfInSampledMask");
+            transitionImageLayout(*m_pContext, m_commandPool, m_pResourceManager->getTexture("SvgfInSampledMask"),
+                                  vk::ImageLayout::eUndefined, vk::ImageLayout::eGeneral,
+                                  vk::PipelineStageFlagBits::eAllCommands, vk::PipelineStageFlagBits::eComputeShader);
+        }
+
+        m_pResourceManager->createTextureRGBA32Sfloat("SvgfInCurrentFrame");
+        m_pResourceManager->createTextureRGBA32Sfloat("SvgfInWorldPos");
+        m_pResourceManager->createTextureRGBA32Sfloat("SvgfInWorldNormal");
+        m_pResourceManager->createTextureRGBA32Sfloat("SvgfInMotion");
+        m_pResourceManager->createUniformBuffer<SvgfData>("SvgfData");
+
+        // only written and read by the kernels, so they stay in the general layout
+        for (auto &name: kStorageTextureNames) {
+            m_pResourceManager->createTextureRGBA32Sfloat(name);
+            transitionImageLayout(*m_pContext, m_commandPool, m_pResourceManager->getTexture(name),
+                                  vk::ImageLayout::eUndefined, vk::ImageLayout::eGeneral,
+                                  vk::PipelineStageFlagBits::eAllCommands, vk::PipelineStageFlagBits::eComputeShader);
+        }
+
+        // sampled by the following passes between the frames, see record()
+        m_pResourceManager->createTextureRGBA32Sfloat("SvgfOutput");
+        transitionImageLayout(*m_pContext, m_commandPool, m_pResourceManager->getTexture("SvgfOutput"),
+                              vk::ImageLayout::eUndefined, vk::ImageLayout::eShaderReadOnlyOptimal,
+                              vk::PipelineStageFlagBits::eAllCommands, vk::PipelineStageFlagBits::eFragmentShader);
+        m_pContext->kOffscreenOutputTextureNames.push_back("SvgfOutput");
+
+        // indexed by SVGF_FILTER_IMAGE_0, SVGF_FILTER_IMAGE_1 and SVGF_OUTPUT_IMAGE
+        m_pResourceManager->insertTextureArray("SvgfFilterImages", { m_pResourceManager->getTexture("SvgfFilter0"),
+                                                                     m_pResourceManager->getTexture("SvgfFilter1"),
+                                                                     m_pResourceManager->getTexture("SvgfOutput") });
+
+        // resources of the descriptor set, by binding (see SvgfCommon.h)
+        bindResources({ { 0, "SvgfInCurrentFrame" },
+                        { 1, "SvgfInWorldPos" },
+                        { 2, "SvgfInWorldNormal" },
+                        { 3, "SvgfInMotion" },
+                        { 4, "SvgfColorHistory" },
+                        { 5, "SvgfMoments0" },
+                        { 6, "SvgfMoments1" },
+                        { 7, "SvgfGeometry0" },
+                        { 8, "SvgfGeometry1" },
+                        { 9, "SvgfIntegrated" },
+                        { 10, "SvgfFilterImages" },
+                        { 11, "SvgfData" },
+                        { 12, "CameraBuffer" },
+                        { 13, "SvgfInSampledMask" } });
+
+        // indexed by Kernel
+        setupComputePipelines({ "shaders/RenderPasses/SvgfPass/SvgfTemporal.comp.spv",
+                                "shaders/RenderPasses/SvgfPass/SvgfVariance.comp.spv",
+                                "shaders/RenderPasses/SvgfPass/SvgfAtrous.comp.spv" });
+    }
+
+    void record(vk::CommandBuffer commandBuffer) override {
+        // the g-buffer, the path traced frame and the history of the last frame
+        vk::MemoryBarrier inputBarrier{ .srcAccessMask = vk::AccessFlagBits::eColorAttachmentWrite |
+                                                         vk::AccessFlagBits::eShaderWrite,
+                                        .dstAccessMask = vk::AccessFlagBits::eShaderRead |
+                                                         vk::AccessFlagBits::eShaderWrite };
+        commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eColorAttachmentOutput |
+                                          vk::PipelineStageFlagBits::eFragmentShader |
+                                          vk::PipelineStageFlagBits::eRayTracingShaderKHR |
+                                          vk::PipelineStageFlagBits::eComputeShader,
+                                      vk::PipelineStageFlagBits::eComputeShader, {}, 1, &inputBarrier, 0, nullptr, 0,
+                                      nullptr);
+
+        transitionImageLayout(commandBuffer, m_pResourceManager->getTexture("SvgfOutput"),
+                              vk::ImageLayout::eShaderReadOnlyOptimal, vk::ImageLayout::eGeneral,
+                              vk::PipelineStageFlagBits::eFragmentShader, vk::PipelineStageFlagBits::eComputeShader);
+
+        uint32_t groupCountX = (m_extent.width + SVGF_GROUP_SIZE - 1) / SVGF_GROUP_SIZE;
+        uint32_t groupCountY = (m_extent.height + SVGF_GROUP_SIZE - 1) / SVGF_GROUP_SIZE;
+
+        beginScope(commandBuffer, "SvgfTemporal");
+        bindComputePipeline(commandBuffer, eTemporal);
+        commandBuffer.dispatch(groupCountX, groupCountY, 1);
+        endScope(commandBuffer);
+        computeBarrier(commandBuffer);
+
+        beginScope(commandBuffer, "SvgfVariance");
+        bindComputePipeline(commandBuffer, eVariance);
+        commandBuffer.dispatch(groupCountX, groupCountY, 1);
+        endScope(commandBuffer);
+        computeBarrier(commandBuffer);
+
+        bindComputePipeline(commandBuffer, eAtrous);
+        vk::ShaderStageFlags pushStages = BindlessTable::getPushConstantRange().stageFlags;
+        for (int i = 0; i < m_iterations; ++i) {
+            bool last = i == m_iterations - 1;
+            SvgfPushConstant push{
+                .stepSize     = 1u << i,
+                .srcImage     = i % 2 == 0 ? SVGF_FILTER_IMAGE_0 : SVGF_FILTER_IMAGE_1,
+                .dstImage     = last ? SVGF_OUTPUT_IMAGE : (i % 2 == 0 ? SVGF_FILTER_IMAGE_1 : SVGF_FILTER_IMAGE_0),
+                .writeHistory = i == 0 ? 1u : 0u,
+            };
+            commandBuffer.pushConstants(m_pipelineLayout, pushStages, 0, sizeof(SvgfPushConstant), &push);
+
+            // a group covers every stepSize-th pixel of a block of 16 * stepSize pixels
+            uint32_t blockSize = SVGF_GROUP_SIZE * push.stepSize;
+            beginScope(commandBuffer, kAtrousScopeNames[i]);
+            commandBuffer.dispatch((m_extent.width + blockSize - 1) / blockSize * push.stepSize,
+                                   (m_extent.height + blockSize - 1) / blockSize * push.stepSize, 1);
+            endScope(commandBuffer);
+            if (!last)
+                computeBarrier(commandBuffer);
+        }
+    }
+
+    void outputTextureBarrier(vk::CommandBuffer commandBuffer) override {
+        // the general layout does not make the storage writes available by itself
+        vk::MemoryBarrier barrier{ .srcAccessMask = vk::AccessFlagBits::eShaderWrite,
+                                   .dstAccessMask = vk::AccessFlagBits::eShaderRead |
+                                                    vk::AccessFlagBits::eTransferRead };
+        commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader,
+                                      vk::PipelineStageFlagBits::eFragmentShader | vk::PipelineStageFlagBits::eTransfer,
+                                      {}, 1, &barrier, 0, nullptr, 0, nullptr);
+
+        transitionImageLayout(commandBuffer, m_pResourceManager->getTexture("SvgfOutput"), vk::ImageLayout::eGeneral,
+                              vk::ImageLayout::eShaderReadOnlyOptimal, vk::PipelineStageFlagBits::eComputeShader,
+                              vk::PipelineStageFlagBits::eFragmentShader);
+    }
+
+private:
+    enum Kernel { eTemporal, eVariance, eAtrous };
+
+    static inline const std::array<std::string, 8> kStorageTextureNames = {
+        "SvgfColorHistory", "SvgfMoments0",   "SvgfMoments1", "SvgfGeometry0",
+        "SvgfGeometry1",    "SvgfIntegrated", "SvgfFilter0",  "SvgfFilter1"
+    };
+
+    // the profiler keeps the pointers
+    static constexpr const char *kAtrousScopeNames[SVGF_MAX_ITERATIONS] = { "SvgfAtrous0", "SvgfAtrous1",
+                                                                            "SvgfAtrous2", "SvgfAtrous3",
+                                                                            "SvgfAtrous4" };
+
+    void computeBarrier(vk::CommandBuffer commandBuffer) {
+        vk::MemoryBarrier barrier{ .srcAccessMask = vk::AccessFlagBits::eShaderWrite,
+                                   .dstAccessMask = vk::AccessFlagBits::eShaderRead |
+                                                    vk::AccessFlagBits::eShaderWrite };
+        commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader,
+                                      vk::PipelineStageFlagBits::eComputeShader, {}, 1, &barrier, 0, nullptr, 0,
+                                      nullptr);
+    }
+
+    void beginScope(vk::CommandBuffer commandBuffer, const char *name) {
+        if (m_pGpuProfiler)
+            m_pGpuProfiler->beginScope(commandBuffer, name);
+    }
+
+    void endScope(vk::CommandBuffer commandBuffer) {
+        if (m_pGpuProfiler)
+            m_pGpuProfiler->endScope(commandBuffer);
+    }
+
+    SvgfData m_svgfData;
+    bool m_resetPending{ true };
+    int m_iterations{ SVGF_MAX_ITERATIONS };
+
+    GpuProfiler *m_pGpuProfiler{ nullptr };
+
+}; // class SvgfPass
+
+} // namespace vuren
+
+#endif // SVGF_PASS_HPP
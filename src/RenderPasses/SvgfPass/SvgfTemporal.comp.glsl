@@ -0,0 +1,92 @@
+#version 460
+#extension GL_GOOGLE_include_directive : enable
+#extension GL_EXT_shader_explicit_arithmetic_types_int64 : require
+
+#include "SvgfCommon.h"
+
+layout(local_size_x = SVGF_GROUP_SIZE, local_size_y = SVGF_GROUP_SIZE) in;
+
+// whether the surface seen at prevPixel in the last frame is the one seen now
+bool isSameSurface(ivec2 prevPixel, ivec2 size, vec4 position, vec3 normal) {
+    if (any(lessThan(prevPixel, ivec2(0))) || any(greaterThanEqual(prevPixel, size)))
+        return false;
+
+    vec4 prevGeometry = loadGeometry(prevPixel, false);
+    bool background = position.w == 0.0;
+    if (background || prevGeometry.w == 0.0)
+        return background && prevGeometry.w == 0.0;
+
+    // the view depth the current surface had in the last frame
+    float expectedDepth = viewDepth(camera.prevView, position.xyz);
+    if (abs(prevGeometry.w - expectedDepth) > svgfData.depthTolerance * max(expectedDepth, 1e-4))
+        return false;
+    return dot(prevGeometry.xyz, normal) >= svgfData.normalTolerance;
+}
+
+// reprojects the filtered color and the moments of the last frame, and blends the current frame in
+void main() {
+    ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+    ivec2 size = imageSize(integratedColor);
+    if (any(greaterThanEqual(pixel, size)))
+        return;
+
+    vec3 current = texelFetch(currentFrame, pixel, 0).rgb;
+    vec4 position = texelFetch(worldPos, pixel, 0);
+    vec3 normal = texelFetch(worldNormal, pixel, 0).xyz;
+    vec2 pixelMotion = texelFetch(motion, pixel, 0).xy * vec2(size);
+
+    // bilinear over the previous pixels around the reprojected position, only those of the same surface
+    vec2 prevPos = vec2(pixel) - pixelMotion;
+    ivec2 base = ivec2(floor(prevPos));
+    vec2 f = prevPos - vec2(base);
+    float bilinear[4] = { (1.0 - f.x) * (1.0 - f.y), f.x * (1.0 - f.y), (1.0 - f.x) * f.y, f.x * f.y };
+
+    vec3 prevColor = vec3(0.0);
+    vec3 prevMoments = vec3(0.0);
+    float weightSum = 0.0;
+    if (svgfData.reset == 0) {
+        for (int i = 0; i < 4; ++i) {
+            ivec2 q = base + ivec2(i & 1, i >> 1);
+            if (bilinear[i] > 0.0 && isSameSurface(q, size, position, normal)) {
+                prevColor += bilinear[i] * imageLoad(colorHistory, q).rgb;
+                prevMoments += bilinear[i] * loadMoments(q, false).xyz;
+                weightSum += bilinear[i];
+            }
+        }
+    }
+
+    float lum = luminance(current);
+    vec2 moments = vec2(lum, lum * lum);
+    vec3 color = current;
+    float historyLength = 1.0;
+
+    if (weightSum > 0.01) {
+        prevColor /= weightSum;
+        prevMoments /= weightSum;
+
+        if (svgfData.adaptive != 0 && imageLoad(sampledMask, pixel).r == 0.0) {
+            // left out of the launch: the current frame still holds a sample the history already has
+            historyLength = prevMoments.z;
+            color = prevColor;
+            moments = prevMoments.xy;
+        } else {
+            // a running mean while the history is short, then an exponential moving average
+            historyLength = min(prevMoments.z + 1.0, 256.0);
+            float colorAlpha = max(svgfData.colorAlpha, 1.0 / historyLength);
+            float momentsAlpha = max(svgfData.momentsAlpha, 1.0 / historyLength);
+            color = mix(prevColor, current, colorAlpha);
+            moments = mix(prevMoments.xy, moments, momentsAlpha);
+        }
+    }
+
+    float depth = position.w == 0.0 ? 0.0 : viewDepth(camera.view, position.xyz);
+
+    if (svgfData.historyIndex == 0) {
+        imageStore(momentsHistory0, pixel, vec4(moments, historyLength, 0.0));
+        imageStore(geometryHistory0, pixel, vec4(normal, depth));
+    } else {
+        imageStore(momentsHistory1, pixel, vec4(moments, historyLength, 0.0));
+        imageStore(geometryHistory1, pixel, vec4(normal, depth));
+    }
+    imageStore(integratedColor, pixel, vec4(color, historyLength));
+}
@@ -0,0 +1,61 @@
+#version 460
+#extension GL_GOOGLE_include_directive : enable
+#extension GL_EXT_shader_explicit_arithmetic_types_int64 : require
+
+#include "SvgfCommon.h"
+
+layout(local_size_x = SVGF_GROUP_SIZE, local_size_y = SVGF_GROUP_SIZE) in;
+
+// the luminance variance of every pixel: temporal from the moments, or spatial over a 7x7 neighborhood of the same
+// surface while the history is too short. writes the first input of the a-trous iterations.
+void main() {
+    ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+    ivec2 size = imageSize(integratedColor);
+    if (any(greaterThanEqual(pixel, size)))
+        return;
+
+    vec4 integrated = imageLoad(integratedColor, pixel);
+    vec4 moments = loadMoments(pixel, true);
+    float historyLength = integrated.a;
+    vec4 position = texelFetch(worldPos, pixel, 0);
+
+    if (historyLength >= 4.0 || position.w == 0.0) {
+        float variance = max(moments.y - moments.x * moments.x, 0.0);
+        imageStore(filterImages[SVGF_FILTER_IMAGE_0], pixel, vec4(integrated.rgb, variance));
+        return;
+    }
+
+    vec3 normal = texelFetch(worldNormal, pixel, 0).xyz;
+    float footprint = pixelFootprint(viewDepth(camera.view, position.xyz));
+
+    vec3 colorSum = vec3(0.0);
+    vec2 momentsSum = vec2(0.0);
+    float weightSum = 0.0;
+    for (int y = -3; y <= 3; ++y) {
+        for (int x = -3; x <= 3; ++x) {
+            ivec2 q = pixel + ivec2(x, y);
+            if (any(lessThan(q, ivec2(0))) || any(greaterThanEqual(q, size)))
+                continue;
+
+            vec4 qPosition = texelFetch(worldPos, q, 0);
+            if (qPosition.w == 0.0)
+                continue;
+            vec3 qNormal = texelFetch(worldNormal, q, 0).xyz;
+
+            float planeDistance = abs(dot(normal, qPosition.xyz - position.xyz));
+            float w = pow(max(dot(normal, qNormal), 0.0), svgfData.phiNormal) *
+                      exp(-planeDistance / (svgfData.phiDepth * footprint * length(vec2(x, y)) + 1e-6));
+            colorSum += w * imageLoad(integratedColor, q).rgb;
+            momentsSum += w * loadMoments(q, true).xy;
+            weightSum += w;
+        }
+    }
+
+    // the center has weight 1
+    colorSum /= weightSum;
+    momentsSum /= weightSum;
+
+    // the spatial estimate is less reliable the shorter the history
+    float variance = max(momentsSum.y - momentsSum.x * momentsSum.x, 0.0) * 4.0 / historyLength;
+    imageStore(filterImages[SVGF_FILTER_IMAGE_0], pixel, vec4(colorSum, variance));
+}
@@ -4,6 +4,7 @@
 #include <tinyobjloader/tiny_obj_loader.h>
 
 #include "ResourceManager.hpp"
+#include "Profiler.hpp"
 
 namespace vuren {
 
@@ -22,6 +23,16 @@ void ResourceManager::connectTextures(const std::string &srcTexture, const std::
     m_globalTextureDict.insert({ dstTexture, m_globalTextureDict[srcTexture] });
 }
 
+void ResourceManager::redirectTexture(const std::string &srcTexture, const std::string &dstTexture) {
+    if (m_globalTextureDict.find(srcTexture) == m_globalTextureDict.end()) {
+        throw std::runtime_error("redirectTexture: cannot find the src texture!");
+    }
+    if (m_globalTextureDict.find(dstTexture) == m_globalTextureDict.end()) {
+        throw std::runtime_error("redirectTexture: the destination texture is not connected yet!");
+    }
+    m_globalTextureDict[dstTexture] = m_globalTextureDict[srcTexture];
+}
+
 void ResourceManager::createTextureRGBA32Sfloat(const std::string &name) {
     if (m_globalTextureDict.find(name) != m_globalTextureDict.end()) {
         return;
@@ -29,7 +40,8 @@ void ResourceManager::createTextureRGBA32Sfloat(const std::string &name) {
 
     std::shared_ptr<Texture> pTexture = createTexture(
         m_extent.width, m_extent.height, vk::Format::eR32G32B32A32Sfloat, vk::ImageTiling::eOptimal,
-        vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eStorage,
+        vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eStorage |
+            vk::ImageUsageFlagBits::eTransferSrc,
         vk::MemoryPropertyFlagBits::eDeviceLocal);
     createImageView(pTexture, vk::Format::eR32G32B32A32Sfloat, vk::ImageAspectFlagBits::eColor);
     createSampler(pTexture);
@@ -41,6 +53,22 @@ void ResourceManager::createTextureRGBA32Sfloat(const std::string &name) {
     m_globalTextureDict.insert({ name, pTexture });
 }
 
+void ResourceManager::createStorageTextureRGBA8Unorm(const std::string &name) {
+    if (m_globalTextureDict.find(name) != m_globalTextureDict.end()) {
+        return;
+    }
+
+    std::shared_ptr<Texture> pTexture =
+        createTexture(m_extent.width, m_extent.height, vk::Format::eR8G8B8A8Unorm, vk::ImageTiling::eOptimal,
+                      vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eTransferSrc,
+                      vk::MemoryPropertyFlagBits::eDeviceLocal);
+    createImageView(pTexture, vk::Format::eR8G8B8A8Unorm, vk::ImageAspectFlagBits::eColor);
+
+    pTexture->name = name;
+
+    m_globalTextureDict.insert({ name, pTexture });
+}
+
 void ResourceManager::createDepthTexture(const std::string &name) {
     if (m_globalTextureDict.find(name) != m_globalTextureDict.end())
         throw std::runtime_error("same depth key already exists in texture dictionary!");
@@ -59,6 +87,7 @@ void ResourceManager::createDepthTexture(const std::string &name) {
 }
 
 std::shared_ptr<Texture> ResourceManager::createModelTexture(const std::string &name, const std::string &filename) {
+    VUREN_PROFILE_ZONE("ResourceManager::createModelTexture");
     int texWidth, texHeight, texChannels;
     stbi_uc *pixels          = stbi_load(filename.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
     vk::DeviceSize imageSize = texWidth * texHeight * 4;
@@ -174,45 +203,13 @@ void ResourceManager::setCommandPool(vk::CommandPool commandPool) { m_commandPoo
 
 void ResourceManager::loadObjModel(const std::string &name, const std::string &filename,
                                    std::shared_ptr<Scene> pScene, uint32_t materialId) {
+    VUREN_PROFILE_ZONE("ResourceManager::loadObjModel");
     std::string vertexBufferKey = std::string(name + "_vertexBuffer");
     std::string indexBufferKey  = std::string(name + "_indexBuffer");
     std::vector<Vertex> vertices;
     std::vector<uint32_t> indices;
 
-    tinyobj::attrib_t attrib;
-    std::vector<tinyobj::shape_t> shapes;
-    std::vector<tinyobj::material_t> materials;
-    std::string warn, err;
-
-    if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, filename.c_str())) {
-        throw std::runtime_error(warn + err);
-    }
-
-    // model loading and vertex deduplication function is based off of Vulkan Tutorial's code.
-    // https://vulkan-tutorial.com/Loading_models#page_Loading-vertices-and-indices
-    std::unordered_map<Vertex, uint32_t> uniqueVertices{};
-
-    for (const auto &shape: shapes) {
-        for (const auto &index: shape.mesh.indices) {
-            Vertex vertex{};
-
-            vertex.pos = { attrib.vertices[3 * index.vertex_index + 0], attrib.vertices[3 * index.vertex_index + 1],
-                           attrib.vertices[3 * index.vertex_index + 2] };
-
-            vertex.normal = { attrib.normals[3 * index.normal_index + 0], attrib.normals[3 * index.normal_index + 1],
-                              attrib.normals[3 * index.normal_index + 2] };
-
-            vertex.texCoord = { attrib.texcoords[2 * index.texcoord_index + 0],
-                                1.0f - attrib.texcoords[2 * index.texcoord_index + 1] };
-
-            if (uniqueVertices.count(vertex) == 0) {
-                uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
-                vertices.push_back(vertex);
-            }
-
-            indices.push_back(uniqueVertices[vertex]);
-        }
-    }
+    loadObjMesh(filename, vertices, indices);
 
     createVertexBuffer(vertexBufferKey, vertices);
     createIndexBuffer(indexBufferKey, indices);
@@ -288,6 +285,62 @@ void ResourceManager::destroyAs(AccelerationStructure &as) {
     m_pContext->m_device.destroyAccelerationStructureKHR(as.as);
 }
 
+std::vector<float> ResourceManager::readTextureRGBA32Sfloat(const std::string &name, vk::ImageLayout currentLayout) {
+    size_t floatCount         = static_cast<size_t>(m_extent.width) * m_extent.height * 4;
+    vk::DeviceSize bufferSize = floatCount * sizeof(float);
+
+    Buffer stagingBuffer =
+        createBuffer(bufferSize, vk::BufferUsageFlagBits::eTransferDst,
+                     vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+
+    vk::CommandBuffer commandBuffer = beginSingleTimeCommands(*m_pContext, m_commandPool);
+    recordTextureReadback(commandBuffer, name, stagingBuffer.descriptorInfo.buffer, currentLayout);
+    endSingleTimeCommands(*m_pContext, m_commandPool, commandBuffer);
+
+    std::vector<float> pixels(floatCount);
+    void *data = m_pContext->m_device.mapMemory(stagingBuffer.memory, 0, bufferSize);
+    memcpy(pixels.data(), data, static_cast<size_t>(bufferSize));
+    m_pContext->m_device.unmapMemory(stagingBuffer.memory);
+
+    destroyBuffer(stagingBuffer);
+
+    return pixels;
+}
+
+void ResourceManager::recordTextureReadback(vk::CommandBuffer commandBuffer, const std::string &name,
+                                            vk::Buffer dstBuffer, vk::ImageLayout currentLayout) {
+    std::shared_ptr<Texture> pTexture = getTexture(name);
+
+    transitionImageLayout(commandBuffer, pTexture, currentLayout, vk::ImageLayout::eTransferSrcOptimal,
+                          vk::PipelineStageFlagBits::eAllCommands, vk::PipelineStageFlagBits::eTransfer);
+
+    vk::BufferImageCopy region{ .bufferOffset      = 0,
+                                .bufferRowLength   = 0,
+                                .bufferImageHeight = 0,
+                                .imageSubresource  = { .aspectMask     = vk::ImageAspectFlagBits::eColor,
+                                                       .mipLevel       = 0,
+                                                       .baseArrayLayer = 0,
+                                                       .layerCount     = 1 },
+                                .imageOffset       = { 0, 0, 0 },
+                                .imageExtent       = { m_extent.width, m_extent.height, 1 } };
+
+    commandBuffer.copyImageToBuffer(pTexture->image, vk::ImageLayout::eTransferSrcOptimal, dstBuffer, 1, &region);
+
+    // make the copied data visible to host reads once the submission's fence has signaled
+    vk::BufferMemoryBarrier hostBarrier{ .srcAccessMask       = vk::AccessFlagBits::eTransferWrite,
+                                         .dstAccessMask       = vk::AccessFlagBits::eHostRead,
+                                         .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                                         .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                                         .buffer              = dstBuffer,
+                                         .offset              = 0,
+                                         .size                = VK_WHOLE_SIZE };
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eHost, {}, 0,
+                                  nullptr, 1, &hostBarrier, 0, nullptr);
+
+    transitionImageLayout(commandBuffer, pTexture, vk::ImageLayout::eTransferSrcOptimal, currentLayout,
+                          vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eAllCommands);
+}
+
 std::shared_ptr<Texture> ResourceManager::createTexture(uint32_t width, uint32_t height, vk::Format format,
                                                         vk::ImageTiling tiling, vk::ImageUsageFlags usage,
                                                         vk::MemoryPropertyFlags properties) {
@@ -369,6 +422,50 @@ void ResourceManager::createSampler(std::shared_ptr<Texture> pTexture) {
 
 //// class ResourceManager member functions
 
+void loadObjMesh(const std::string &filename, std::vector<Vertex> &vertices, std::vector<uint32_t> &indices) {
+    VUREN_PROFILE_ZONE("loadObjMesh");
+    tinyobj::attrib_t attrib;
+    std::vector<tinyobj::shape_t> shapes;
+    std::vector<tinyobj::material_t> materials;
+    std::string warn, err;
+
+    if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, filename.c_str())) {
+        throw std::runtime_error(warn + err);
+    }
+
+    // model loading and vertex deduplication function is based off of Vulkan Tutorial's code.
+    // https://vulkan-tutorial.com/Loading_models#page_Loading-vertices-and-indices
+    std::unordered_map<Vertex, uint32_t> uniqueVertices{};
+
+    for (const auto &shape: shapes) {
+        for (const auto &index: shape.mesh.indices) {
+            Vertex vertex{};
+
+            vertex.pos = { attrib.vertices[3 * index.vertex_index + 0], attrib.vertices[3 * index.vertex_index + 1],
+                           attrib.vertices[3 * index.vertex_index + 2] };
+
+            // scanned meshes often come without normals or uvs
+            if (index.normal_index >= 0) {
+                vertex.normal = { attrib.normals[3 * index.normal_index + 0],
+                                  attrib.normals[3 * index.normal_index + 1],
+                                  attrib.normals[3 * index.normal_index + 2] };
+            }
+
+            if (index.texcoord_index >= 0) {
+                vertex.texCoord = { attrib.texcoords[2 * index.texcoord_index + 0],
+                                    1.0f - attrib.texcoords[2 * index.texcoord_index + 1] };
+            }
+
+            if (uniqueVertices.count(vertex) == 0) {
+                uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
+                vertices.push_back(vertex);
+            }
+
+            indices.push_back(uniqueVertices[vertex]);
+        }
+    }
+}
+
 bool hasStencilComponent(vk::Format format) {
     return format == vk::Format::eD32SfloatS8Uint || format == vk::Format::eD24UnormS8Uint;
 }
@@ -508,6 +605,9 @@ void transitionImageLayout(vk::CommandBuffer commandBuffer, std::shared_ptr<Text
         case vk::ImageLayout::eTransferDstOptimal:
             barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
             break;
+        case vk::ImageLayout::eTransferSrcOptimal:
+            barrier.srcAccessMask = vk::AccessFlagBits::eTransferRead;
+            break;
         default:
             throw std::invalid_argument("unsupported layout transition!");
     }
@@ -526,6 +626,9 @@ void transitionImageLayout(vk::CommandBuffer commandBuffer, std::shared_ptr<Text
         case vk::ImageLayout::eTransferDstOptimal:
             barrier.dstAccessMask = vk::AccessFlagBits::eTransferWrite;
             break;
+        case vk::ImageLayout::eTransferSrcOptimal:
+            barrier.dstAccessMask = vk::AccessFlagBits::eTransferRead;
+            break;
         case vk::ImageLayout::eDepthAttachmentOptimal:
         case vk::ImageLayout::eDepthStencilAttachmentOptimal:
             barrier.dstAccessMask =
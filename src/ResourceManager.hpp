@@ -43,14 +43,22 @@ void transitionImageLayout(const VulkanContext &context, vk::CommandPool &comman
 void transitionImageLayout(const VulkanContext &context, vk::CommandPool &commandPool, std::shared_ptr<Texture> pTexture,
                            vk::Format format, vk::ImageLayout oldLayout, vk::ImageLayout newLayout);
 
+// parse an obj file into a deduplicated vertex/index list, without touching the device
+void loadObjMesh(const std::string &filename, std::vector<Vertex> &vertices, std::vector<uint32_t> &indices);
+
 class ResourceManager {
 public:
     ResourceManager(VulkanContext *pContext);
     ~ResourceManager();
 
     void connectTextures(const std::string &srcTexture, const std::string &dstTexture);
+    // points a name made by connectTextures() at another texture, e.g. the image a ping-pong pass wrote last.
+    // descriptor sets keep the texture the name had when they were written.
+    void redirectTexture(const std::string &srcTexture, const std::string &dstTexture);
 
     void createTextureRGBA32Sfloat(const std::string &name);
+    // an 8-bit image written by compute shaders and copied out, e.g. to the swap chain
+    void createStorageTextureRGBA8Unorm(const std::string &name);
     void createDepthTexture(const std::string &name);
     std::shared_ptr<Texture> createModelTexture(const std::string &name, const std::string &filename);
     void createModelTextureSampler(std::shared_ptr<Texture> pTexture);
@@ -64,6 +72,31 @@ public:
         createBufferByHostData<Material>(pScene->getMaterials(), vk::BufferUsageFlagBits::eStorageBuffer,
                                                   vk::MemoryPropertyFlagBits::eDeviceLocal, "MaterialBuffer");
     }
+    // the lights, their alias table and their bvh, for next-event estimation. with dynamic lights, the light and
+    // bvh buffers stay mapped (getMappedBuffer) to be updated in place, and are read from host memory.
+    void createLightBuffers(std::shared_ptr<Scene> pScene, bool dynamic) {
+        if (dynamic) {
+            createMappedBufferByHostData<Light>(pScene->getLights(), vk::BufferUsageFlagBits::eStorageBuffer,
+                                                "LightBuffer");
+            createMappedBufferByHostData<LightBvhNode>(pScene->getLightBvh().getNodes(),
+                                                       vk::BufferUsageFlagBits::eStorageBuffer, "LightBvh");
+        } else {
+            createBufferByHostData<Light>(pScene->getLights(), vk::BufferUsageFlagBits::eStorageBuffer,
+                                          vk::MemoryPropertyFlagBits::eDeviceLocal, "LightBuffer");
+            createBufferByHostData<LightBvhNode>(pScene->getLightBvh().getNodes(),
+                                                 vk::BufferUsageFlagBits::eStorageBuffer,
+                                                 vk::MemoryPropertyFlagBits::eDeviceLocal, "LightBvh");
+        }
+        createBufferByHostData<LightAliasEntry>(pScene->getLightAliasTable(), vk::BufferUsageFlagBits::eStorageBuffer,
+                                                vk::MemoryPropertyFlagBits::eDeviceLocal, "LightAliasTable");
+    }
+    // copy an RGBA32 float texture back to the host. blocks until the copy has finished.
+    // the texture is returned to currentLayout afterwards.
+    std::vector<float> readTextureRGBA32Sfloat(const std::string &name, vk::ImageLayout currentLayout);
+    // record a copy of a whole texture into dstBuffer, leaving the texture in currentLayout
+    void recordTextureReadback(vk::CommandBuffer commandBuffer, const std::string &name, vk::Buffer dstBuffer,
+                               vk::ImageLayout currentLayout);
+
     void createAs(vk::AccelerationStructureCreateInfoKHR createInfo, AccelerationStructure &as);
     void destroyAs(AccelerationStructure &as);
 
@@ -112,6 +145,24 @@ public:
         m_globalBufferDict.insert({ name, std::make_shared<Buffer>(uniformBuffer) });
     }
 
+    // a host visible buffer initialized with hostData and kept mapped, for data the host rewrites while rendering
+    template <typename DataType>
+    void createMappedBufferByHostData(const std::vector<DataType> &hostData, vk::BufferUsageFlags bufferUsage,
+                                      const std::string &name) {
+        vk::DeviceSize bufferSize = sizeof(hostData[0]) * hostData.size();
+
+        Buffer buffer =
+            createBuffer(bufferSize, bufferUsage,
+                         vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+
+        void *mapped;
+        mapped = m_pContext->m_device.mapMemory(buffer.memory, 0, bufferSize);
+        memcpy(mapped, hostData.data(), (size_t) bufferSize);
+
+        m_uniformBufferMappedDict.insert({ name, mapped });
+        m_globalBufferDict.insert({ name, std::make_shared<Buffer>(buffer) });
+    }
+
     // if name is not given, the returned buffer will not be managed by resource manager.
     // in that case, user must manually destroy the buffer after use.
     template <typename DataType>
@@ -167,6 +218,13 @@ public:
         return m_uniformBufferMappedDict[name];
     }
 
+    // an array of textures already owned elsewhere, e.g. the scene textures. it is bound to an array binding.
+    const std::vector<std::shared_ptr<Texture>> &getTextureArray(const std::string &name) {
+        if (m_textureArrayDict.find(name) == m_textureArrayDict.end())
+            throw std::runtime_error("failed to find the texture array!");
+        return m_textureArrayDict[name];
+    }
+
     const std::unordered_map<std::string, std::shared_ptr<Texture>> &getTextureDict() { return m_globalTextureDict; }
 
     void insertBuffer(const std::string &name, Buffer buffer) { 
@@ -179,6 +237,10 @@ public:
         m_globalTextureDict.insert({ name, pTexture });
     }
 
+    void insertTextureArray(const std::string &name, const std::vector<std::shared_ptr<Texture>> &textures) {
+        m_textureArrayDict.insert({ name, textures });
+    }
+
     vk::Extent2D getExtent() {
         return m_extent;
     }
@@ -186,6 +248,7 @@ public:
 private:
     std::unordered_map<std::string, std::shared_ptr<Texture>> m_globalTextureDict;
     std::unordered_map<std::string, std::shared_ptr<Buffer>> m_globalBufferDict;
+    std::unordered_map<std::string, std::vector<std::shared_ptr<Texture>>> m_textureArrayDict;
     std::unordered_map<std::string, void *> m_uniformBufferMappedDict;
 
     VulkanContext *m_pContext{ nullptr };
@@ -1,3 +1,66 @@
 #include "Scene.hpp"
 
-namespace vuren {} // namespace vuren
\ No newline at end of file
+#include <algorithm>
+
+namespace vuren {
+
+std::vector<LightAliasEntry> buildLightAliasTable(const std::vector<Light> &lights) {
+    size_t count = lights.size();
+    std::vector<LightAliasEntry> table(count);
+    if (count == 0)
+        return table;
+
+    // a point light's power is its intensity times 4 pi, the constant cancels out
+    std::vector<double> power(count);
+    double totalPower = 0.0;
+    for (size_t i = 0; i < count; ++i) {
+        power[i] = std::max(glm::dot(lights[i].intensity, vec3(0.2126f, 0.7152f, 0.0722f)), 0.0f);
+        totalPower += power[i];
+    }
+
+    // the probabilities scaled by the light count, so an average bucket holds exactly 1.
+    // lights without any power are picked uniformly when all of them are dark.
+    std::vector<double> scaled(count);
+    std::vector<uint32_t> small, large;
+    for (uint32_t i = 0; i < count; ++i) {
+        double pmf = totalPower > 0.0 ? power[i] / totalPower : 1.0 / count;
+        table[i]   = { .threshold = 1.0f, .alias = i, .pmf = static_cast<float>(pmf), .pad = 0.0f };
+        scaled[i]  = pmf * count;
+        (scaled[i] < 1.0 ? small : large).push_back(i);
+    }
+
+    // every bucket under 1 is topped up by a light over 1, which may drop under 1 itself
+    while (!small.empty() && !large.empty()) {
+        uint32_t s = small.back();
+        uint32_t l = large.back();
+        small.pop_back();
+
+        table[s].threshold = static_cast<float>(scaled[s]);
+        table[s].alias     = l;
+
+        scaled[l] -= 1.0 - scaled[s];
+        if (scaled[l] < 1.0) {
+            large.pop_back();
+            small.push_back(l);
+        }
+    }
+
+    // the buckets left are full up to rounding errors, their threshold stays 1
+    return table;
+}
+
+void Scene::setLights(const std::vector<Light> &lights) {
+    m_lights                = lights;
+    m_lightAliasTable       = buildLightAliasTable(lights);
+    m_globalData.lightCount = static_cast<uint>(lights.size());
+    m_lightBvh.build(lights);
+}
+
+bool Scene::moveLights(const std::vector<uint32_t> &lightIndices, const std::vector<vec3> &positions,
+                       std::vector<uint32_t> &updatedNodes) {
+    for (size_t i = 0; i < lightIndices.size(); ++i)
+        m_lights[lightIndices[i]].pos = positions[i];
+    return m_lightBvh.refit(m_lights, lightIndices, updatedNodes);
+}
+
+} // namespace vuren
@@ -3,12 +3,17 @@
 
 #include "Common.hpp"
 #include "Camera.hpp"
+#include "LightBvh.hpp"
 
 #include <string>
 #include <vector>
 
 namespace vuren {
 
+// the alias table picking each light in proportion to its power (Vose's method), O(1) per sample:
+// bucket = floor(u * n), then the bucket's light if frac(u * n) < threshold, else its alias
+std::vector<LightAliasEntry> buildLightAliasTable(const std::vector<Light> &lights);
+
 class Scene {
 public:
     Scene() {}
@@ -26,6 +31,14 @@ public:
 
     const std::vector<Material> &getMaterials() { return m_materials; }
 
+    const std::vector<Light> &getLights() { return m_lights; }
+
+    const std::vector<LightAliasEntry> &getLightAliasTable() { return m_lightAliasTable; }
+
+    const LightBvh &getLightBvh() { return m_lightBvh; }
+
+    const SceneGlobalData &getGlobalData() { return m_globalData; }
+
     void addObject(SceneObject object) { m_objects.emplace_back(object); }
 
     void addObjectDevice(SceneObjectDevice object) { m_objectsDevice.emplace_back(object); }
@@ -38,6 +51,14 @@ public:
 
     void addMaterial(Material material) { m_materials.emplace_back(material); }
 
+    // replaces the lights and rebuilds their alias table and bvh
+    void setLights(const std::vector<Light> &lights);
+
+    // moves some lights and refits their bvh nodes, see LightBvh::refit. their power is unchanged, and so is the
+    // alias table.
+    bool moveLights(const std::vector<uint32_t> &lightIndices, const std::vector<vec3> &positions,
+                    std::vector<uint32_t> &updatedNodes);
+
     void setInstanceCount(uint32_t objectId, uint32_t count) { m_objects[objectId].instanceCount = count; }
 
     Camera& getCamera() {
@@ -51,8 +72,11 @@ private:
     std::vector<ObjectInstance> m_instances;
     std::vector<std::shared_ptr<Texture>> m_textures;
     std::vector<Material> m_materials;
+    std::vector<Light> m_lights;
+    std::vector<LightAliasEntry> m_lightAliasTable;
+    LightBvh m_lightBvh;
 
-    SceneGlobalData m_globalData;
+    SceneGlobalData m_globalData{ .lightCount = 0 };
     Camera m_camera;
 };
 
@@ -0,0 +1,218 @@
+#include "ShaderHotReload.hpp"
+#include "Timer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+#endif
+
+namespace vuren {
+
+namespace {
+
+const auto kPollInterval = std::chrono::milliseconds(250);
+
+std::string quote(const std::string &s) { return "\"" + s + "\""; }
+
+} // namespace
+
+void ShaderHotReload::init(const std::string &sourceDir, const std::string &compilerPath) {
+    m_sourceDir    = sourceDir;
+    m_compilerPath = compilerPath;
+}
+
+void ShaderHotReload::watch(RenderPass *pPass) {
+    for (auto &spirvPath: pPass->getShaderPaths()) {
+        // the build step compiles <sourceDir>/<dir>/<name>.glsl into shaders/<dir>/<name>.spv
+        std::filesystem::path sourcePath = m_sourceDir / std::filesystem::path(spirvPath).lexically_relative("shaders");
+        sourcePath.replace_extension(".glsl");
+        if (!std::filesystem::exists(sourcePath)) {
+            std::cerr << "shader hot reload: cannot find the source of " << spirvPath << " (" << sourcePath.string()
+                      << ")" << std::endl;
+            continue;
+        }
+
+        auto it = std::find_if(m_shaders.begin(), m_shaders.end(),
+                               [&](const WatchedShader &shader) { return shader.sourcePath == sourcePath; });
+        if (it == m_shaders.end()) {
+            m_shaders.push_back({ .sourcePath = sourcePath, .spirvPath = spirvPath });
+            it = std::prev(m_shaders.end());
+        }
+        if (std::find(it->passes.begin(), it->passes.end(), pPass) == it->passes.end())
+            it->passes.push_back(pPass);
+    }
+}
+
+void ShaderHotReload::start() {
+    if (m_shaders.empty())
+        return;
+
+    for (auto &shader: m_shaders)
+        updateWriteTimes(shader);
+
+    std::cout << "shader hot reload: watching " << m_shaders.size() << " shaders in " << m_sourceDir.string()
+              << std::endl;
+    m_thread = std::thread(&ShaderHotReload::pollLoop, this);
+}
+
+void ShaderHotReload::cleanup() {
+    if (!m_thread.joinable())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_condition.notify_one();
+    m_thread.join();
+}
+
+uint32_t ShaderHotReload::applyReloads() {
+    std::unordered_set<RenderPass *> passes;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        passes.swap(m_pendingPasses);
+    }
+
+    uint32_t reloaded = 0;
+    for (auto pPass: passes) {
+        // a pass that fails to reload keeps its previous pipeline, the next save tries again
+        try {
+            Timer timer;
+            pPass->reloadShaders();
+            std::cout << "shader hot reload: pipeline rebuilt in " << timer.elapsed() << " ms" << std::endl;
+            reloaded++;
+        } catch (const std::exception &e) {
+            std::cerr << "shader hot reload: " << e.what() << std::endl;
+        }
+    }
+    return reloaded;
+}
+
+void ShaderHotReload::pollLoop() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_condition.wait_for(lock, kPollInterval, [this] { return m_stopping; })) {
+        lock.unlock();
+
+        std::vector<RenderPass *> recompiled;
+        for (auto &shader: m_shaders) {
+            if (!hasChanged(shader))
+                continue;
+
+            // the includes may have changed as well. a failed compilation is only retried after the next save.
+            updateWriteTimes(shader);
+            if (compile(shader))
+                recompiled.insert(recompiled.end(), shader.passes.begin(), shader.passes.end());
+        }
+
+        lock.lock();
+        m_pendingPasses.insert(recompiled.begin(), recompiled.end());
+    }
+}
+
+bool ShaderHotReload::hasChanged(const WatchedShader &shader) const {
+    for (auto &[path, writeTime]: shader.writeTimes) {
+        // an editor may replace the file while saving, a missing file is checked again on the next poll
+        std::error_code error;
+        auto currentTime = std::filesystem::last_write_time(path, error);
+        if (!error && currentTime != writeTime)
+            return true;
+    }
+    return false;
+}
+
+void ShaderHotReload::updateWriteTimes(WatchedShader &shader) const {
+    std::unordered_set<std::string> files;
+    collectIncludes(shader.sourcePath, files);
+
+    shader.writeTimes.clear();
+    for (auto &file: files) {
+        std::error_code error;
+        auto writeTime = std::filesystem::last_write_time(file, error);
+        if (!error)
+            shader.writeTimes[file] = writeTime;
+    }
+}
+
+void ShaderHotReload::collectIncludes(const std::filesystem::path &path,
+                                      std::unordered_set<std::string> &visited) const {
+    if (!visited.insert(path.string()).second)
+        return;
+
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        size_t directive = line.find("#include");
+        if (directive == std::string::npos)
+            continue;
+        size_t begin = line.find_first_of("\"<", directive);
+        size_t end   = begin == std::string::npos ? begin : line.find_first_of("\">", begin + 1);
+        if (end == std::string::npos)
+            continue;
+        std::string name = line.substr(begin + 1, end - begin - 1);
+
+        // the same search order as the build step: the including file's directory, then the include paths
+        for (auto &dir: { path.parent_path(), m_sourceDir, m_sourceDir / "shaders" }) {
+            std::filesystem::path candidate = dir / name;
+            if (std::filesystem::exists(candidate)) {
+                collectIncludes(candidate.lexically_normal(), visited);
+                break;
+            }
+        }
+    }
+}
+
+bool ShaderHotReload::compile(const WatchedShader &shader) {
+    Timer timer;
+
+    // written next to the output, then renamed over it, so a pass never reads a partially written file
+    std::filesystem::path tempPath = shader.spirvPath;
+    tempPath += ".tmp";
+
+    std::string command = quote(m_compilerPath) + " -V " + quote(shader.sourcePath.string()) + " -I" +
+                          quote(m_sourceDir.string()) + " -I" + quote((m_sourceDir / "shaders").string()) + " -o " +
+                          quote(tempPath.string()) + " --target-env spirv1.5 2>&1";
+#ifdef _WIN32
+    // cmd.exe strips the outer quotes
+    command = quote(command);
+#endif
+
+    std::FILE *pPipe = popen(command.c_str(), "r");
+    if (!pPipe) {
+        std::cerr << "shader hot reload: failed to run " << m_compilerPath << std::endl;
+        return false;
+    }
+    std::string output;
+    char buffer[256];
+    while (std::fgets(buffer, sizeof(buffer), pPipe))
+        output += buffer;
+    int status = pclose(pPipe);
+
+    std::string name = shader.sourcePath.filename().string();
+    if (status != 0) {
+        std::cerr << "shader hot reload: " << name << " failed to compile, the current pipeline is kept\n"
+                  << output << std::endl;
+        std::error_code error;
+        std::filesystem::remove(tempPath, error);
+        return false;
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tempPath, shader.spirvPath, error);
+    if (error) {
+        std::cerr << "shader hot reload: failed to replace " << shader.spirvPath.string() << ": " << error.message()
+                  << std::endl;
+        return false;
+    }
+
+    std::cout << "shader hot reload: recompiled " << name << " in " << timer.elapsed() << " ms" << std::endl;
+    return true;
+}
+
+} // namespace vuren
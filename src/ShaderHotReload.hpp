@@ -0,0 +1,73 @@
+#ifndef SHADER_HOT_RELOAD_HPP
+#define SHADER_HOT_RELOAD_HPP
+
+#include "RenderPass.hpp"
+
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace vuren {
+
+// recompiles the glsl sources of the watched passes when they (or a file they include) change on disk.
+// a background thread polls the modification times and runs the shader compiler, which overwrites the SPIR-V the
+// passes load. the main thread then rebuilds the pipelines of the affected passes at a frame boundary with
+// applyReloads(), without touching the scene or the other passes.
+class ShaderHotReload {
+public:
+    ShaderHotReload() {}
+    ~ShaderHotReload() {}
+
+    // sourceDir is the directory the shader build step compiles from (src), compilerPath a glslangValidator
+    void init(const std::string &sourceDir, const std::string &compilerPath);
+
+    // every pass must be watched before start()
+    void watch(RenderPass *pPass);
+    void start();
+
+    // stops the polling thread, a running compilation finishes first
+    void cleanup();
+
+    bool isEnabled() const { return m_thread.joinable(); }
+
+    // on the main thread, once no submitted frame uses the pipelines of the watched passes any more.
+    // returns the number of passes whose pipeline was rebuilt.
+    uint32_t applyReloads();
+
+private:
+    struct WatchedShader {
+        std::filesystem::path sourcePath;
+        std::filesystem::path spirvPath; // the path the pass loads, relative to the working directory
+        std::vector<RenderPass *> passes;
+
+        // the source and everything it includes, with the modification times of the last compilation
+        std::unordered_map<std::string, std::filesystem::file_time_type> writeTimes;
+    };
+
+    void pollLoop();
+    bool hasChanged(const WatchedShader &shader) const;
+    void updateWriteTimes(WatchedShader &shader) const;
+    void collectIncludes(const std::filesystem::path &path, std::unordered_set<std::string> &visited) const;
+    bool compile(const WatchedShader &shader);
+
+    std::filesystem::path m_sourceDir;
+    std::string m_compilerPath;
+
+    // fixed once started, then only used by the polling thread
+    std::vector<WatchedShader> m_shaders;
+
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_stopping{ false };
+    std::unordered_set<RenderPass *> m_pendingPasses; // recompiled, waiting for applyReloads()
+};
+
+} // namespace vuren
+
+#endif // SHADER_HOT_RELOAD_HPP
@@ -0,0 +1,255 @@
+#include "ShaderReflection.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace vuren {
+
+namespace {
+
+// the few spir-v enumerants the reflection needs, see the spir-v specification
+constexpr uint32_t kMagicNumber = 0x07230203;
+
+constexpr uint32_t kOpName                         = 5;
+constexpr uint32_t kOpEntryPoint                   = 15;
+constexpr uint32_t kOpTypeImage                    = 25;
+constexpr uint32_t kOpTypeSampler                  = 26;
+constexpr uint32_t kOpTypeSampledImage             = 27;
+constexpr uint32_t kOpTypeArray                    = 28;
+constexpr uint32_t kOpTypeRuntimeArray             = 29;
+constexpr uint32_t kOpTypeStruct                   = 30;
+constexpr uint32_t kOpTypePointer                  = 32;
+constexpr uint32_t kOpConstant                     = 43;
+constexpr uint32_t kOpVariable                     = 59;
+constexpr uint32_t kOpDecorate                     = 71;
+constexpr uint32_t kOpTypeAccelerationStructureKHR = 5341;
+
+constexpr uint32_t kDecorationBufferBlock   = 3;
+constexpr uint32_t kDecorationBinding       = 33;
+constexpr uint32_t kDecorationDescriptorSet = 34;
+
+constexpr uint32_t kStorageClassUniformConstant = 0;
+constexpr uint32_t kStorageClassUniform         = 2;
+constexpr uint32_t kStorageClassStorageBuffer   = 12;
+
+constexpr uint32_t kDimBuffer      = 5;
+constexpr uint32_t kDimSubpassData = 6;
+
+struct SpirvId {
+    uint32_t opcode{ 0 };
+    uint32_t typeId{ 0 }; // pointee, element or variable type
+    uint32_t storageClass{ 0 };
+    uint32_t value{ 0 };   // constant value, array length id or image dimension
+    uint32_t sampled{ 0 }; // image: 1 sampled, 2 storage
+    uint32_t set{ 0 };
+    uint32_t binding{ 0 };
+    bool hasSet{ false };
+    bool hasBinding{ false };
+    bool isBufferBlock{ false };
+    std::string name;
+};
+
+vk::ShaderStageFlags executionModelToStage(uint32_t executionModel) {
+    switch (executionModel) {
+        case 0:
+            return vk::ShaderStageFlagBits::eVertex;
+        case 1:
+            return vk::ShaderStageFlagBits::eTessellationControl;
+        case 2:
+            return vk::ShaderStageFlagBits::eTessellationEvaluation;
+        case 3:
+            return vk::ShaderStageFlagBits::eGeometry;
+        case 4:
+            return vk::ShaderStageFlagBits::eFragment;
+        case 5:
+            return vk::ShaderStageFlagBits::eCompute;
+        case 5313:
+            return vk::ShaderStageFlagBits::eRaygenKHR;
+        case 5314:
+            return vk::ShaderStageFlagBits::eIntersectionKHR;
+        case 5315:
+            return vk::ShaderStageFlagBits::eAnyHitKHR;
+        case 5316:
+            return vk::ShaderStageFlagBits::eClosestHitKHR;
+        case 5317:
+            return vk::ShaderStageFlagBits::eMissKHR;
+        case 5318:
+            return vk::ShaderStageFlagBits::eCallableKHR;
+        default:
+            return {};
+    }
+}
+
+} // namespace
+
+std::vector<ReflectedBinding> reflectDescriptorBindings(const std::vector<char> &code, const std::string &shaderPath) {
+    if (code.size() % sizeof(uint32_t) != 0 || code.size() < 5 * sizeof(uint32_t))
+        throw std::runtime_error("failed to reflect " + shaderPath + ", not a spir-v module!");
+
+    std::vector<uint32_t> words(code.size() / sizeof(uint32_t));
+    std::memcpy(words.data(), code.data(), code.size());
+    if (words[0] != kMagicNumber)
+        throw std::runtime_error("failed to reflect " + shaderPath + ", not a spir-v module!");
+
+    // word 3 of the header bounds every result id
+    std::vector<SpirvId> ids(words[3]);
+    std::vector<uint32_t> variables;
+    vk::ShaderStageFlags stage;
+
+    for (size_t offset = 5; offset < words.size();) {
+        uint32_t opcode    = words[offset] & 0xffff;
+        uint32_t wordCount = words[offset] >> 16;
+        if (wordCount == 0 || offset + wordCount > words.size())
+            throw std::runtime_error("failed to reflect " + shaderPath + ", truncated instruction!");
+        const uint32_t *op = &words[offset];
+
+        switch (opcode) {
+            case kOpName:
+                // the string is nul terminated and padded to a whole word
+                ids[op[1]].name = reinterpret_cast<const char *>(&op[2]);
+                break;
+            case kOpEntryPoint:
+                stage |= executionModelToStage(op[1]);
+                break;
+            case kOpDecorate:
+                if (op[2] == kDecorationDescriptorSet) {
+                    ids[op[1]].set    = op[3];
+                    ids[op[1]].hasSet = true;
+                } else if (op[2] == kDecorationBinding) {
+                    ids[op[1]].binding    = op[3];
+                    ids[op[1]].hasBinding = true;
+                } else if (op[2] == kDecorationBufferBlock) {
+                    ids[op[1]].isBufferBlock = true;
+                }
+                break;
+            case kOpTypeImage:
+                ids[op[1]].opcode  = opcode;
+                ids[op[1]].value   = op[3];
+                ids[op[1]].sampled = op[7];
+                break;
+            case kOpTypeSampler:
+            case kOpTypeStruct:
+            case kOpTypeAccelerationStructureKHR:
+                ids[op[1]].opcode = opcode;
+                break;
+            case kOpTypeSampledImage:
+            case kOpTypeRuntimeArray:
+                ids[op[1]].opcode = opcode;
+                ids[op[1]].typeId = op[2];
+                break;
+            case kOpTypeArray:
+                ids[op[1]].opcode = opcode;
+                ids[op[1]].typeId = op[2];
+                ids[op[1]].value  = op[3];
+                break;
+            case kOpTypePointer:
+                ids[op[1]].opcode       = opcode;
+                ids[op[1]].storageClass = op[2];
+                ids[op[1]].typeId       = op[3];
+                break;
+            case kOpConstant:
+                ids[op[2]].opcode = opcode;
+                ids[op[2]].value  = op[3];
+                break;
+            case kOpVariable:
+                ids[op[2]].opcode       = opcode;
+                ids[op[2]].typeId       = op[1];
+                ids[op[2]].storageClass = op[3];
+                variables.push_back(op[2]);
+                break;
+            default:
+                break;
+        }
+
+        offset += wordCount;
+    }
+
+    std::vector<ReflectedBinding> bindings;
+    for (uint32_t variableId: variables) {
+        const SpirvId &variable = ids[variableId];
+        if (!variable.hasBinding)
+            continue;
+        if (variable.storageClass != kStorageClassUniformConstant && variable.storageClass != kStorageClassUniform &&
+            variable.storageClass != kStorageClassStorageBuffer)
+            continue;
+
+        // peel the pointer and any arrays off the variable's type
+        const SpirvId *pType = &ids[ids[variable.typeId].typeId];
+        uint32_t count       = 1;
+        while (pType->opcode == kOpTypeArray || pType->opcode == kOpTypeRuntimeArray) {
+            count = pType->opcode == kOpTypeArray ? count * ids[pType->value].value : 0;
+            pType = &ids[pType->typeId];
+        }
+
+        vk::DescriptorType descriptorType;
+        switch (pType->opcode) {
+            case kOpTypeSampledImage:
+                descriptorType = vk::DescriptorType::eCombinedImageSampler;
+                break;
+            case kOpTypeImage:
+                if (pType->value == kDimSubpassData)
+                    descriptorType = vk::DescriptorType::eInputAttachment;
+                else if (pType->value == kDimBuffer)
+                    descriptorType = pType->sampled == 2 ? vk::DescriptorType::eStorageTexelBuffer
+                                                         : vk::DescriptorType::eUniformTexelBuffer;
+                else
+                    descriptorType =
+                        pType->sampled == 2 ? vk::DescriptorType::eStorageImage : vk::DescriptorType::eSampledImage;
+                break;
+            case kOpTypeSampler:
+                descriptorType = vk::DescriptorType::eSampler;
+                break;
+            case kOpTypeAccelerationStructureKHR:
+                descriptorType = vk::DescriptorType::eAccelerationStructureKHR;
+                break;
+            case kOpTypeStruct:
+                // glsl buffers are Block structs in the StorageBuffer class, or BufferBlock structs in older spir-v
+                if (variable.storageClass == kStorageClassStorageBuffer || pType->isBufferBlock)
+                    descriptorType = vk::DescriptorType::eStorageBuffer;
+                else
+                    descriptorType = vk::DescriptorType::eUniformBuffer;
+                break;
+            default:
+                throw std::runtime_error("failed to reflect " + shaderPath + ", unsupported type at binding " +
+                                         std::to_string(variable.binding) + "!");
+        }
+
+        bindings.push_back({ .set             = variable.set,
+                             .binding         = variable.binding,
+                             .descriptorType  = descriptorType,
+                             .descriptorCount = count,
+                             .stageFlags      = stage,
+                             .name            = variable.name.empty() ? pType->name : variable.name });
+    }
+
+    std::sort(bindings.begin(), bindings.end(), [](const ReflectedBinding &a, const ReflectedBinding &b) {
+        return a.set != b.set ? a.set < b.set : a.binding < b.binding;
+    });
+    return bindings;
+}
+
+void mergeDescriptorBindings(std::vector<ReflectedBinding> &bindings, const std::vector<ReflectedBinding> &stage,
+                             const std::string &shaderPath) {
+    for (auto &binding: stage) {
+        auto it = std::find_if(bindings.begin(), bindings.end(), [&](const ReflectedBinding &b) {
+            return b.set == binding.set && b.binding == binding.binding;
+        });
+        if (it == bindings.end()) {
+            bindings.push_back(binding);
+            continue;
+        }
+
+        if (it->descriptorType != binding.descriptorType || it->descriptorCount != binding.descriptorCount) {
+            throw std::runtime_error(shaderPath + " declares binding " + std::to_string(binding.binding) +
+                                     " differently than the other stages!");
+        }
+        it->stageFlags |= binding.stageFlags;
+    }
+
+    std::sort(bindings.begin(), bindings.end(), [](const ReflectedBinding &a, const ReflectedBinding &b) {
+        return a.set != b.set ? a.set < b.set : a.binding < b.binding;
+    });
+}
+
+} // namespace vuren
@@ -0,0 +1,34 @@
+#ifndef SHADER_REFLECTION_HPP
+#define SHADER_REFLECTION_HPP
+
+#define VULKAN_HPP_NO_CONSTRUCTORS
+#define VULKAN_HPP_DISPATCH_LOADER_DYNAMIC 1
+#include <vulkan/vulkan.hpp>
+
+#include <string>
+#include <vector>
+
+namespace vuren {
+
+// a descriptor binding declared by a shader
+struct ReflectedBinding {
+    uint32_t set;
+    uint32_t binding;
+    vk::DescriptorType descriptorType;
+    uint32_t descriptorCount; // 0 for a runtime sized array (e.g. sampler2D[]), sized by the bound resource
+    vk::ShaderStageFlags stageFlags;
+    std::string name; // variable name, or the block name of a buffer
+};
+
+// reads the descriptor bindings of a spir-v module, i.e. the resource variables decorated with a set and a binding.
+// only the handful of instructions describing them are parsed, everything else is skipped by its word count.
+std::vector<ReflectedBinding> reflectDescriptorBindings(const std::vector<char> &code, const std::string &shaderPath);
+
+// adds the bindings of another stage, a binding used by several stages gets the union of their stage flags.
+// the result is sorted by set and binding.
+void mergeDescriptorBindings(std::vector<ReflectedBinding> &bindings, const std::vector<ReflectedBinding> &stage,
+                             const std::string &shaderPath);
+
+} // namespace vuren
+
+#endif // SHADER_REFLECTION_HPP
@@ -13,11 +13,8 @@ void FinalRenderPass::define() {
     // global dict is not required for swap chain images
     m_pResourceManager->createDepthTexture("FinalDepth");
 
-    // create a descriptor set
-    std::vector<ResourceBindingInfo> bindings = { { m_pContext->kOffscreenOutputTextureNames[m_pContext->kCurrentItem],
-                                                    vk::DescriptorType::eCombinedImageSampler,
-                                                    vk::ShaderStageFlagBits::eFragment, 1 } };
-    createDescriptorSet(bindings);
+    // the displayed texture
+    bindResources({ { 0, m_pContext->kOffscreenOutputTextureNames[m_pContext->kCurrentItem] } });
 
     // create the renderpass
     std::vector<AttachmentInfo> colorAttachments;
@@ -78,8 +75,8 @@ void FinalRenderPass::record(vk::CommandBuffer commandBuffer) {
     vk::Rect2D scissor{ .offset = { 0, 0 }, .extent = m_extent };
     commandBuffer.setScissor(0, 1, &scissor);
 
-    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, m_pipelineLayout, 0, 1, &m_descriptorSet, 0,
-                                     nullptr);
+    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, m_pipelineLayout, PASS_SET, 1,
+                                     &m_descriptorSet, 0, nullptr);
 
     commandBuffer.draw(3, 1, 0, 0);
 
@@ -95,43 +92,85 @@ void FinalRenderPass::createSwapChainFrameBuffers(Texture swapChainDepthImage) {
 }
 
 void FinalRenderPass::updateDescriptorSets() {
-    std::vector<ResourceBindingInfo> bindings = { { m_pContext->kOffscreenOutputTextureNames[m_pContext->kCurrentItem],
-                                                    vk::DescriptorType::eCombinedImageSampler,
-                                                    vk::ShaderStageFlagBits::eFragment } };
-
-    std::vector<vk::WriteDescriptorSet> descriptorWrites;
-    std::vector<vk::DescriptorImageInfo> imageInfos;
-    imageInfos.reserve(bindings.size());
-
-    for (size_t i = 0; i < bindings.size(); ++i) {
-        vk::DescriptorImageInfo imageInfo;
-
-        switch (bindings[i].descriptorType) {
-            case vk::DescriptorType::eCombinedImageSampler:
-                imageInfo.sampler     = m_pResourceManager->getTexture(bindings[i].name)->descriptorInfo.sampler;
-                imageInfo.imageView   = m_pResourceManager->getTexture(bindings[i].name)->descriptorInfo.imageView;
-                imageInfo.imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
-                imageInfos.emplace_back(imageInfo);
-                break;
-
-            default:
-                throw std::runtime_error("unsupported descriptor type!");
-        }
+    bindResources({ { 0, m_pContext->kOffscreenOutputTextureNames[m_pContext->kCurrentItem] } });
+    writeDescriptorSet();
+}
 
-        vk::WriteDescriptorSet bufferWrite = { .dstSet           = m_descriptorSet,
-                                               .dstBinding       = static_cast<uint32_t>(i),
-                                               .dstArrayElement  = 0,
-                                               .descriptorCount  = 1,
-                                               .descriptorType   = bindings[i].descriptorType,
-                                               .pImageInfo       = &imageInfos.back(),
-                                               .pBufferInfo      = nullptr,
-                                               .pTexelBufferView = nullptr };
+// ------------------ OverlayRenderPass class ------------------
+
+void OverlayRenderPass::init(VulkanContext *pContext, std::shared_ptr<SwapChain> pSwapChain) {
+    m_pContext   = pContext;
+    m_pSwapChain = pSwapChain;
+
+    // the copied image is kept and the gui blended over it
+    vk::AttachmentDescription colorAttachment{ .format         = m_pSwapChain->getImageFormat(),
+                                               .samples        = vk::SampleCountFlagBits::e1,
+                                               .loadOp         = vk::AttachmentLoadOp::eLoad,
+                                               .storeOp        = vk::AttachmentStoreOp::eStore,
+                                               .stencilLoadOp  = vk::AttachmentLoadOp::eDontCare,
+                                               .stencilStoreOp = vk::AttachmentStoreOp::eDontCare,
+                                               .initialLayout  = vk::ImageLayout::eTransferDstOptimal,
+                                               .finalLayout    = vk::ImageLayout::ePresentSrcKHR };
+
+    vk::AttachmentReference colorAttachmentRef{ .attachment = 0, .layout = vk::ImageLayout::eColorAttachmentOptimal };
+
+    vk::SubpassDescription subpass = { .pipelineBindPoint    = vk::PipelineBindPoint::eGraphics,
+                                       .colorAttachmentCount = 1,
+                                       .pColorAttachments    = &colorAttachmentRef };
+
+    vk::SubpassDependency dependency{ .srcSubpass    = VK_SUBPASS_EXTERNAL,
+                                      .dstSubpass    = 0,
+                                      .srcStageMask  = vk::PipelineStageFlagBits::eTransfer,
+                                      .dstStageMask  = vk::PipelineStageFlagBits::eColorAttachmentOutput,
+                                      .srcAccessMask = vk::AccessFlagBits::eTransferWrite,
+                                      .dstAccessMask = vk::AccessFlagBits::eColorAttachmentRead |
+                                                       vk::AccessFlagBits::eColorAttachmentWrite };
+
+    vk::RenderPassCreateInfo renderPassInfo{ .attachmentCount = 1,
+                                             .pAttachments    = &colorAttachment,
+                                             .subpassCount    = 1,
+                                             .pSubpasses      = &subpass,
+                                             .dependencyCount = 1,
+                                             .pDependencies   = &dependency };
+
+    if (m_pContext->m_device.createRenderPass(&renderPassInfo, nullptr, &m_renderPass) != vk::Result::eSuccess) {
+        throw std::runtime_error("failed to create overlay render pass!");
+    }
+
+    auto &imageViews = *m_pSwapChain->getSwapChainColorImageViews();
+    m_framebuffers.resize(imageViews.size());
+    for (size_t i = 0; i < m_framebuffers.size(); ++i) {
+        vk::FramebufferCreateInfo framebufferInfo{ .renderPass      = m_renderPass,
+                                                   .attachmentCount = 1,
+                                                   .pAttachments    = &imageViews[i],
+                                                   .width           = m_pSwapChain->getExtent().width,
+                                                   .height          = m_pSwapChain->getExtent().height,
+                                                   .layers          = 1 };
 
-        descriptorWrites.emplace_back(bufferWrite);
+        if (m_pContext->m_device.createFramebuffer(&framebufferInfo, nullptr, &m_framebuffers[i]) !=
+            vk::Result::eSuccess) {
+            throw std::runtime_error("failed to create overlay framebuffer!");
+        }
     }
+}
+
+void OverlayRenderPass::record(vk::CommandBuffer commandBuffer) {
+    vk::RenderPassBeginInfo renderPassInfo{ .renderPass  = m_renderPass,
+                                            .framebuffer = m_framebuffers[m_pSwapChain->getImageIndex()],
+                                            .renderArea{ .offset = { 0, 0 }, .extent = m_pSwapChain->getExtent() } };
 
-    m_pContext->m_device.updateDescriptorSets(static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(),
-                                              0, nullptr);
+    commandBuffer.beginRenderPass(&renderPassInfo, vk::SubpassContents::eInline);
+
+    ImGui::Render();
+    ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), commandBuffer);
+
+    commandBuffer.endRenderPass();
+}
+
+void OverlayRenderPass::cleanup() {
+    for (auto &framebuffer: m_framebuffers)
+        m_pContext->m_device.destroyFramebuffer(framebuffer, nullptr);
+    m_pContext->m_device.destroyRenderPass(m_renderPass, nullptr);
 }
 
 // ------------------ SwapChain class ------------------
@@ -172,6 +211,12 @@ void SwapChain::createSwapChain() {
                                            .imageArrayLayers = 1,
                                            .imageUsage       = vk::ImageUsageFlagBits::eColorAttachment };
 
+    // the fused present path copies the displayed image in
+    m_transferDst = static_cast<bool>(swapChainSupport.capabilities.supportedUsageFlags &
+                                      vk::ImageUsageFlagBits::eTransferDst);
+    if (m_transferDst)
+        createInfo.imageUsage |= vk::ImageUsageFlagBits::eTransferDst;
+
     QueueFamilyIndices indices    = m_pContext->findQueueFamilies(m_pContext->m_physicalDevice);
     uint32_t queueFamilyIndices[] = { indices.graphicsFamily.value(), indices.presentFamily.value() };
     if (indices.graphicsFamily != indices.presentFamily) {
@@ -40,6 +40,32 @@ private:
 
 }; // class FinalRenderPass
 
+// the gui alone, drawn over a swap chain image that was copied to (see AccumulationPass::enablePresent).
+// it takes the place of the final pass, without a fullscreen triangle or a depth attachment.
+class OverlayRenderPass {
+public:
+    OverlayRenderPass() {}
+
+    ~OverlayRenderPass() {}
+
+    // the swap chain images must be in the transfer dst layout when the pass begins, they are presented afterwards
+    void init(VulkanContext *pContext, std::shared_ptr<SwapChain> pSwapChain);
+
+    void record(vk::CommandBuffer commandBuffer);
+
+    void cleanup();
+
+    vk::RenderPass getRenderPass() { return m_renderPass; }
+
+private:
+    VulkanContext *m_pContext{ nullptr };
+    std::shared_ptr<SwapChain> m_pSwapChain{ nullptr };
+
+    vk::RenderPass m_renderPass{ VK_NULL_HANDLE };
+    std::vector<vk::Framebuffer> m_framebuffers; // by swap chain image
+
+}; // class OverlayRenderPass
+
 class SwapChain {
 public:
     SwapChain(VulkanContext *pContext, GLFWwindow *pWindow) : m_pContext(pContext), m_pWindow(pWindow) {}
@@ -61,6 +87,11 @@ public:
 
     vk::Extent2D getExtent() { return m_extent; }
 
+    vk::Format getImageFormat() { return m_imageFormat; }
+
+    // whether the images can be the destination of a transfer, which the fused present path needs
+    bool canCopyToImages() { return m_transferDst; }
+
     vk::SwapchainKHR getVkSwapChain() { return m_swapChain; }
 
     uint32_t getImageCount() { return m_imageCount; }
@@ -82,6 +113,7 @@ private:
     vk::SwapchainKHR m_swapChain{ VK_NULL_HANDLE };
     vk::Format m_imageFormat;
     vk::Extent2D m_extent;
+    bool m_transferDst{ false };
     uint32_t m_imageCount{ 0 };
     uint32_t m_imageIndex{ 0 };
 
@@ -0,0 +1,46 @@
+#include "ThreadPool.hpp"
+#include "Profiler.hpp"
+
+#include <algorithm>
+
+namespace vuren {
+
+ThreadPool::ThreadPool(uint32_t threadCount) {
+    if (threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+    m_workers.reserve(threadCount);
+    for (uint32_t i = 0; i < threadCount; ++i)
+        m_workers.emplace_back(&ThreadPool::workerLoop, this);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_condition.notify_all();
+
+    // remaining jobs are drained before the workers exit
+    for (auto &worker: m_workers)
+        worker.join();
+}
+
+void ThreadPool::workerLoop() {
+    Profiler::setThreadName("worker");
+
+    while (true) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this] { return m_stopping || !m_jobs.empty(); });
+            if (m_jobs.empty())
+                return;
+            job = std::move(m_jobs.front());
+            m_jobs.pop();
+        }
+        job();
+    }
+}
+
+} // namespace vuren
@@ -0,0 +1,54 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace vuren {
+
+// a fixed-size pool of worker threads consuming a single fifo job queue
+class ThreadPool {
+public:
+    // threadCount == 0 uses one worker per hardware thread
+    explicit ThreadPool(uint32_t threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &)            = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    template <typename F> auto submit(F &&job) -> std::future<decltype(job())> {
+        using ReturnType = decltype(job());
+
+        // std::function needs a copyable callable, so the packaged task is shared
+        auto pTask = std::make_shared<std::packaged_task<ReturnType()>>(std::forward<F>(job));
+        std::future<ReturnType> future = pTask->get_future();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_jobs.emplace([pTask]() { (*pTask)(); });
+        }
+        m_condition.notify_one();
+        return future;
+    }
+
+    uint32_t getThreadCount() const { return static_cast<uint32_t>(m_workers.size()); }
+
+private:
+    void workerLoop();
+
+    std::vector<std::thread> m_workers;
+    std::queue<std::function<void()>> m_jobs;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_stopping{ false };
+};
+
+} // namespace vuren
+
+#endif // THREAD_POOL_HPP
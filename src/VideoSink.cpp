@@ -0,0 +1,355 @@
+#include "VideoSink.hpp"
+#include "Profiler.hpp"
+
+#include <imgui/imgui.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cmath>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define VUREN_VIDEO_SSE2
+#endif
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace vuren {
+
+namespace {
+
+// linear [0, 1] quantized to 14 bits keeps the lookup within one code of the exact sRGB curve
+const int kSrgbLutBits = 14;
+const int kSrgbLutSize = 1 << kSrgbLutBits;
+
+const std::array<uint8_t, kSrgbLutSize> &getSrgbLut() {
+    static const std::array<uint8_t, kSrgbLutSize> lut = [] {
+        std::array<uint8_t, kSrgbLutSize> table{};
+        for (int i = 0; i < kSrgbLutSize; ++i) {
+            float value = static_cast<float>(i) / (kSrgbLutSize - 1);
+            value = value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+            table[i] = static_cast<uint8_t>(value * 255.0f + 0.5f);
+        }
+        return table;
+    }();
+    return lut;
+}
+
+// RGBA32 float -> packed rgb24 sRGB, clamped like the swap chain does
+void convertToSrgb8(const float *pRgba, size_t pixelCount, uint8_t *pRgb) {
+    const std::array<uint8_t, kSrgbLutSize> &lut = getSrgbLut();
+    size_t i = 0;
+
+#ifdef VUREN_VIDEO_SSE2
+    // one pixel per register: clamp, scale and round four channels at once, then look the codes up
+    const __m128 zero  = _mm_setzero_ps();
+    const __m128 one   = _mm_set1_ps(1.0f);
+    const __m128 scale = _mm_set1_ps(static_cast<float>(kSrgbLutSize - 1));
+    alignas(16) int32_t indices[16];
+
+    for (; i + 4 <= pixelCount; i += 4) {
+        for (int p = 0; p < 4; ++p) {
+            __m128 color = _mm_loadu_ps(pRgba + (i + p) * 4);
+            color        = _mm_min_ps(_mm_max_ps(color, zero), one);
+            _mm_store_si128(reinterpret_cast<__m128i *>(indices + p * 4), _mm_cvtps_epi32(_mm_mul_ps(color, scale)));
+        }
+        for (int p = 0; p < 4; ++p) {
+            pRgb[(i + p) * 3 + 0] = lut[indices[p * 4 + 0]];
+            pRgb[(i + p) * 3 + 1] = lut[indices[p * 4 + 1]];
+            pRgb[(i + p) * 3 + 2] = lut[indices[p * 4 + 2]];
+        }
+    }
+#endif
+
+    for (; i < pixelCount; ++i) {
+        for (int c = 0; c < 3; ++c) {
+            float value = std::clamp(pRgba[i * 4 + c], 0.0f, 1.0f);
+            // std::isnan guard: clamp passes nan through, which would index out of the table
+            int index       = std::isnan(value) ? 0 : static_cast<int>(value * (kSrgbLutSize - 1) + 0.5f);
+            pRgb[i * 3 + c] = lut[index];
+        }
+    }
+}
+
+// bt.601 limited range, planar 4:4:4
+void convertRgbToYuv444(const uint8_t *pRgb, size_t pixelCount, uint8_t *pY, uint8_t *pU, uint8_t *pV) {
+    for (size_t i = 0; i < pixelCount; ++i) {
+        int r = pRgb[i * 3 + 0];
+        int g = pRgb[i * 3 + 1];
+        int b = pRgb[i * 3 + 2];
+        pY[i] = static_cast<uint8_t>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+        pU[i] = static_cast<uint8_t>(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+        pV[i] = static_cast<uint8_t>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+    }
+}
+
+} // namespace
+
+void VideoSink::init(VulkanContext *pContext, std::shared_ptr<ResourceManager> pResourceManager,
+                     const std::string &path, VideoFormat format, uint32_t fps) {
+    m_pContext         = pContext;
+    m_pResourceManager = pResourceManager;
+    m_extent           = pResourceManager->getExtent();
+    m_path             = path;
+    m_format           = format;
+    m_fps              = fps;
+
+#ifndef _WIN32
+    // a consumer closing the pipe should end the stream, not the process
+    std::signal(SIGPIPE, SIG_IGN);
+#endif
+
+    // double-buffered: one frame being converted while the next one is read back
+    vk::DeviceSize bufferSize = static_cast<vk::DeviceSize>(m_extent.width) * m_extent.height * 4 * sizeof(float);
+    for (int i = 0; i < 2; ++i) {
+        auto pSlot     = std::make_unique<Slot>();
+        pSlot->buffer  = m_pResourceManager->createBuffer(bufferSize, vk::BufferUsageFlagBits::eTransferDst,
+                                                          vk::MemoryPropertyFlagBits::eHostVisible |
+                                                              vk::MemoryPropertyFlagBits::eHostCoherent);
+        pSlot->pMapped = m_pContext->m_device.mapMemory(pSlot->buffer.memory, 0, bufferSize);
+        m_slots.push_back(std::move(pSlot));
+    }
+
+    size_t pixelCount = static_cast<size_t>(m_extent.width) * m_extent.height;
+    m_rgb.resize(pixelCount * 3);
+    m_frameBytes.resize(pixelCount * 3);
+
+    // the output is opened by the conversion thread, since a named pipe has to wait for a reader to show up
+    m_thread = std::thread(&VideoSink::conversionLoop, this);
+}
+
+void VideoSink::cleanup() {
+    if (!isEnabled())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_condition.notify_all();
+    m_thread.join();
+
+    if (m_pFile) {
+        std::fflush(m_pFile);
+        if (m_pFile != stdout)
+            std::fclose(m_pFile);
+        m_pFile = nullptr;
+    }
+
+    uint64_t frames = m_writtenFrames;
+    double seconds  = getElapsedSeconds();
+    std::cout << "video sink: " << frames << " frames written to " << m_path << ", " << m_droppedFrames
+              << " dropped" << std::endl;
+    if (frames > 0 && seconds > 0.0) {
+        std::cout << "  " << frames / seconds << " frames/s, " << m_writtenBytes / (1024.0 * 1024.0) / seconds
+                  << " MB/s, " << m_convertMicroseconds / 1000.0 / frames << " ms conversion per frame" << std::endl;
+    }
+
+    for (auto &pSlot: m_slots) {
+        m_pContext->m_device.unmapMemory(pSlot->buffer.memory);
+        m_pResourceManager->destroyBuffer(pSlot->buffer);
+    }
+    m_slots.clear();
+}
+
+void VideoSink::recordCopy(vk::CommandBuffer commandBuffer, const std::string &textureName,
+                           vk::ImageLayout currentLayout, uint64_t frameSerial) {
+    if (!m_started) {
+        m_startTime = std::chrono::steady_clock::now();
+        m_started   = true;
+    }
+
+    if (m_failed)
+        return;
+
+    auto it = std::find_if(m_slots.begin(), m_slots.end(),
+                           [](const std::unique_ptr<Slot> &pSlot) { return pSlot->state == SlotState::eFree; });
+    if (it == m_slots.end()) {
+        // the consumer (or the conversion) is slower than the renderer
+        m_droppedFrames++;
+        return;
+    }
+
+    Slot &slot       = **it;
+    slot.state       = SlotState::eInFlight;
+    slot.frameSerial = frameSerial;
+
+    m_pResourceManager->recordTextureReadback(commandBuffer, textureName, slot.buffer.descriptorInfo.buffer,
+                                              currentLayout);
+}
+
+void VideoSink::retire(uint64_t completedSerial) {
+    std::vector<Slot *> completed;
+    for (auto &pSlot: m_slots) {
+        if (pSlot->state == SlotState::eInFlight && pSlot->frameSerial <= completedSerial)
+            completed.push_back(pSlot.get());
+    }
+    if (completed.empty())
+        return;
+
+    // keep the stream in frame order
+    std::sort(completed.begin(), completed.end(),
+              [](const Slot *pA, const Slot *pB) { return pA->frameSerial < pB->frameSerial; });
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (Slot *pSlot: completed) {
+            pSlot->state = SlotState::eQueued;
+            m_readySlots.push_back(pSlot);
+        }
+    }
+    m_condition.notify_one();
+}
+
+bool VideoSink::openOutput() {
+    if (m_path == "-") {
+#ifdef _WIN32
+        _setmode(_fileno(stdout), _O_BINARY);
+#endif
+        m_pFile = stdout;
+    } else {
+#ifndef _WIN32
+        struct stat status;
+        bool isPipe = stat(m_path.c_str(), &status) == 0 && S_ISFIFO(status.st_mode);
+        m_pFile     = isPipe ? openPipe() : std::fopen(m_path.c_str(), "wb");
+#else
+        m_pFile = std::fopen(m_path.c_str(), "wb");
+#endif
+    }
+
+    if (!m_pFile) {
+        std::cerr << "video sink: failed to open " << m_path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    if (m_format == VideoFormat::eY4m) {
+        std::fprintf(m_pFile, "YUV4MPEG2 W%u H%u F%u:1 Ip A1:1 C444\n", m_extent.width, m_extent.height, m_fps);
+    }
+    return true;
+}
+
+#ifndef _WIN32
+std::FILE *VideoSink::openPipe() {
+    // a blocking open would wait for a reader with nothing to interrupt it, and cleanup() could never join the
+    // thread. with O_NONBLOCK the open fails with ENXIO until a reader shows up, so it is retried until then.
+    bool announced = false;
+    while (true) {
+        int fd = open(m_path.c_str(), O_WRONLY | O_NONBLOCK);
+        if (fd >= 0) {
+            // the writes block again once the reader is there, like those to a regular file
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+            std::FILE *pFile = fdopen(fd, "wb");
+            if (!pFile)
+                close(fd);
+            return pFile;
+        }
+        if (errno != ENXIO)
+            return nullptr;
+
+        if (!announced) {
+            std::cerr << "video sink: waiting for a reader on " << m_path << std::endl;
+            announced = true;
+        }
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_condition.wait_for(lock, std::chrono::milliseconds(100), [this] { return m_stopping; })) {
+            errno = ENXIO;
+            return nullptr;
+        }
+    }
+}
+#endif
+
+void VideoSink::writeFrame(const float *pPixels) {
+    size_t pixelCount = static_cast<size_t>(m_extent.width) * m_extent.height;
+
+    if (m_format == VideoFormat::eY4m) {
+        convertToSrgb8(pPixels, pixelCount, m_rgb.data());
+        convertRgbToYuv444(m_rgb.data(), pixelCount, m_frameBytes.data(), m_frameBytes.data() + pixelCount,
+                           m_frameBytes.data() + pixelCount * 2);
+    } else {
+        convertToSrgb8(pPixels, pixelCount, m_frameBytes.data());
+    }
+}
+
+void VideoSink::conversionLoop() {
+    Profiler::setThreadName("video sink");
+
+    if (!openOutput())
+        m_failed = true;
+
+    while (true) {
+        Slot *pSlot = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this] { return m_stopping || !m_readySlots.empty(); });
+            if (m_readySlots.empty())
+                return;
+            pSlot = m_readySlots.front();
+            m_readySlots.pop_front();
+        }
+
+        if (m_failed) {
+            pSlot->state = SlotState::eFree;
+            continue;
+        }
+
+        // convert straight out of the mapped buffer, then give it back before the (possibly blocking) write
+        auto start = std::chrono::steady_clock::now();
+        {
+            VUREN_PROFILE_ZONE("VideoSink::convert");
+            writeFrame(static_cast<const float *>(pSlot->pMapped));
+        }
+        pSlot->state = SlotState::eFree;
+        m_convertMicroseconds +=
+            std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+        bool written = true;
+        if (m_format == VideoFormat::eY4m)
+            written = std::fputs("FRAME\n", m_pFile) >= 0;
+        written = written && std::fwrite(m_frameBytes.data(), 1, m_frameBytes.size(), m_pFile) == m_frameBytes.size();
+
+        if (!written) {
+            std::cerr << "video sink: the consumer closed " << m_path << ", stopping the stream" << std::endl;
+            m_failed = true;
+            continue;
+        }
+
+        m_writtenFrames++;
+        m_writtenBytes += m_frameBytes.size();
+    }
+}
+
+double VideoSink::getElapsedSeconds() const {
+    if (!m_started)
+        return 0.0;
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_startTime).count();
+}
+
+void VideoSink::updateGui() {
+    if (!isEnabled() || !ImGui::CollapsingHeader("Video Sink"))
+        return;
+
+    uint64_t frames = m_writtenFrames;
+    double seconds  = getElapsedSeconds();
+
+    ImGui::Text(" %s (%s)", m_path.c_str(), m_format == VideoFormat::eY4m ? "y4m" : "rgb24");
+    ImGui::Text(" %llu written, %llu dropped", static_cast<unsigned long long>(frames),
+                static_cast<unsigned long long>(m_droppedFrames));
+    ImGui::Text(" %.1f frames/s, %.3f ms conversion", seconds > 0.0 ? frames / seconds : 0.0,
+                frames > 0 ? m_convertMicroseconds / 1000.0 / frames : 0.0);
+    if (m_failed)
+        ImGui::Text(" stream closed");
+}
+
+} // namespace vuren
@@ -0,0 +1,106 @@
+#ifndef VIDEO_SINK_HPP
+#define VIDEO_SINK_HPP
+
+#define VULKAN_HPP_NO_CONSTRUCTORS
+#define VULKAN_HPP_DISPATCH_LOADER_DYNAMIC 1
+#include <vulkan/vulkan.hpp>
+
+#include "Common.hpp"
+#include "ResourceManager.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace vuren {
+
+enum class VideoFormat {
+    eY4m, // yuv4mpeg2, 4:4:4 bt.601 limited range, understood by ffmpeg and most encoders
+    eRgb  // headerless packed rgb24
+};
+
+// streams rendered frames into stdout ("-") or a file / named pipe.
+// frames are read back through two host-visible buffers recorded into the frame command buffer. a dedicated
+// thread converts them to 8-bit sRGB (as displayed by the swap chain) and writes them out in order, so a slow
+// consumer only makes the sink drop frames, it never blocks the render loop.
+class VideoSink {
+public:
+    VideoSink() {}
+    ~VideoSink() {}
+
+    void init(VulkanContext *pContext, std::shared_ptr<ResourceManager> pResourceManager, const std::string &path,
+              VideoFormat format, uint32_t fps);
+
+    // writes out the frames already read back, then reports the throughput
+    void cleanup();
+
+    bool isEnabled() const { return !m_slots.empty(); }
+
+    // the texture must be an RGBA32 float texture currently in currentLayout
+    void recordCopy(vk::CommandBuffer commandBuffer, const std::string &textureName, vk::ImageLayout currentLayout,
+                    uint64_t frameSerial);
+
+    // queue every frame up to completedSerial for conversion
+    void retire(uint64_t completedSerial);
+
+    void updateGui();
+
+private:
+    enum class SlotState { eFree, eInFlight, eQueued };
+
+    struct Slot {
+        Buffer buffer;
+        void *pMapped{ nullptr };
+        std::atomic<SlotState> state{ SlotState::eFree };
+        uint64_t frameSerial{ 0 };
+    };
+
+    void conversionLoop();
+    bool openOutput();
+#ifndef _WIN32
+    // opens a named pipe once a reader has opened it, or returns null when the sink stops first
+    std::FILE *openPipe();
+#endif
+    void writeFrame(const float *pPixels);
+    double getElapsedSeconds() const;
+
+    VulkanContext *m_pContext{ nullptr };
+    std::shared_ptr<ResourceManager> m_pResourceManager{ nullptr };
+
+    std::vector<std::unique_ptr<Slot>> m_slots;
+    vk::Extent2D m_extent;
+    std::string m_path;
+    VideoFormat m_format{ VideoFormat::eY4m };
+    uint32_t m_fps{ 60 };
+    std::FILE *m_pFile{ nullptr };
+
+    // conversion thread and its queue of slots ready to be converted, in frame order
+    std::thread m_thread;
+    std::deque<Slot *> m_readySlots;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_stopping{ false };
+    std::atomic<bool> m_failed{ false }; // the consumer went away
+
+    std::vector<uint8_t> m_rgb;
+    std::vector<uint8_t> m_frameBytes;
+
+    // statistics
+    std::atomic<uint64_t> m_writtenFrames{ 0 };
+    std::atomic<uint64_t> m_writtenBytes{ 0 };
+    std::atomic<uint64_t> m_convertMicroseconds{ 0 };
+    uint64_t m_droppedFrames{ 0 };
+    bool m_started{ false };
+    std::chrono::steady_clock::time_point m_startTime;
+};
+
+} // namespace vuren
+
+#endif // VIDEO_SINK_HPP
@@ -1,5 +1,6 @@
 #include "VulkanContext.hpp"
 #include "Utils.hpp"
+#include <cstring>
 #include <set>
 
 namespace vuren {
@@ -19,15 +20,19 @@ void VulkanContext::init(std::string appName, GLFWwindow *pWindow) {
     createLogicalDevice();
 }
 
+// also safe to call after a failed init(), e.g. when no suitable device was found
 void VulkanContext::cleanup() {
-    m_device.destroy(nullptr);
+    if (m_device)
+        m_device.destroy(nullptr);
 
-    if (kEnableValidationLayers) {
+    if (kEnableValidationLayers && m_debugMessenger) {
         DestroyDebugUtilsMessengerEXT(m_instance, m_debugMessenger, nullptr);
     }
 
-    m_instance.destroySurfaceKHR(m_surface, nullptr);
-    m_instance.destroy(nullptr);
+    if (m_surface)
+        m_instance.destroySurfaceKHR(m_surface, nullptr);
+    if (m_instance)
+        m_instance.destroy(nullptr);
 }
 
 void VulkanContext::createInstance() {
@@ -107,6 +112,9 @@ void VulkanContext::setupDebugMessenger() {
 }
 
 void VulkanContext::createSurface() {
+    if (isHeadless())
+        return;
+
     VkSurfaceKHR surface;
 
     if (glfwCreateWindowSurface(static_cast<VkInstance>(m_instance), m_pWindow, nullptr, &surface) != VK_SUCCESS) {
@@ -129,9 +137,9 @@ void VulkanContext::pickPhysicalDevice() {
         }
     }
 
-    // if (!m_physicalDevice) {
-    //     throw std::runtime_error("failed to find a suitable GPU!");
-    // }
+    if (!m_physicalDevice) {
+        throw std::runtime_error("failed to find a suitable GPU!");
+    }
 }
 
 void VulkanContext::createLogicalDevice() {
@@ -159,21 +167,31 @@ void VulkanContext::createLogicalDevice() {
     deviceFeatures.fragmentStoresAndAtomics = VK_TRUE;
 
     vk::PhysicalDeviceAccelerationStructureFeaturesKHR accelFeature{ .accelerationStructure = VK_TRUE };
-    vk::PhysicalDeviceRayTracingPipelineFeaturesKHR rtPipelineFeature{ .rayTracingPipeline = VK_TRUE };
+    // the adaptive sampling of the path tracer launches as many paths as the gpu counted (traceRaysIndirect)
+    vk::PhysicalDeviceRayTracingPipelineFeaturesKHR rtPipelineFeature{
+        .rayTracingPipeline                  = VK_TRUE,
+        .rayTracingPipelineTraceRaysIndirect = VK_TRUE,
+    };
     vk::PhysicalDeviceBufferDeviceAddressFeaturesEXT bufferAddressFeature{ .bufferDeviceAddress = VK_TRUE,
                                                                            .bufferDeviceAddressCaptureReplay =
                                                                                VK_TRUE };
     vk::PhysicalDeviceDescriptorIndexingFeaturesEXT descriptorIndexingFeature{
-        .shaderSampledImageArrayNonUniformIndexing = VK_TRUE,
-        .descriptorBindingVariableDescriptorCount  = VK_TRUE,
-        .runtimeDescriptorArray                    = VK_TRUE,
+        .shaderSampledImageArrayNonUniformIndexing     = VK_TRUE,
+        .descriptorBindingSampledImageUpdateAfterBind  = VK_TRUE,
+        .descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE,
+        .descriptorBindingUpdateUnusedWhilePending     = VK_TRUE,
+        .descriptorBindingPartiallyBound               = VK_TRUE,
+        .descriptorBindingVariableDescriptorCount      = VK_TRUE,
+        .runtimeDescriptorArray                        = VK_TRUE,
     };
 
+    std::vector<const char *> deviceExtensions = getRequiredDeviceExtensions();
+
     vk::DeviceCreateInfo createInfo{ // .pNext = &accelFeature,
                                      .queueCreateInfoCount    = static_cast<uint32_t>(queueCreateInfos.size()),
                                      .pQueueCreateInfos       = queueCreateInfos.data(),
-                                     .enabledExtensionCount   = static_cast<uint32_t>(kDeviceExtensions.size()),
-                                     .ppEnabledExtensionNames = kDeviceExtensions.data(),
+                                     .enabledExtensionCount   = static_cast<uint32_t>(deviceExtensions.size()),
+                                     .ppEnabledExtensionNames = deviceExtensions.data(),
                                      .pEnabledFeatures        = &deviceFeatures
     };
 
@@ -203,9 +221,9 @@ void VulkanContext::createLogicalDevice() {
 bool VulkanContext::isDeviceSuitable(vk::PhysicalDevice device) {
     QueueFamilyIndices indices = findQueueFamilies(device);
     bool extensionsSupported   = checkDeviceExtensionSupport(device);
-    bool swapChainAdequate     = false;
+    bool swapChainAdequate     = isHeadless();
 
-    if (extensionsSupported) {
+    if (extensionsSupported && !isHeadless()) {
         SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device);
         swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
     }
@@ -234,12 +252,16 @@ QueueFamilyIndices VulkanContext::findQueueFamilies(vk::PhysicalDevice device) {
     int i = 0;
     for (const auto &queueFamily: queueFamilies) {
 
-        if (device.getSurfaceSupportKHR(i, m_surface)) {
+        if (!isHeadless() && device.getSurfaceSupportKHR(i, m_surface)) {
             indices.presentFamily = i;
         }
 
         if (queueFamily.queueFlags & vk::QueueFlagBits::eGraphics) {
             indices.graphicsFamily = i;
+
+            // nothing is presented without a surface; the present queue simply aliases the graphics queue
+            if (isHeadless())
+                indices.presentFamily = i;
         }
 
         if (indices.isComplete()) {
@@ -275,11 +297,16 @@ bool VulkanContext::checkValidationLayerSupport() {
 }
 
 std::vector<const char *> VulkanContext::getRequiredExtensions() {
-    uint32_t glfwExtensionCount = 0;
-    const char **glfwExtensions;
-    glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+    std::vector<const char *> extensions;
 
-    std::vector<const char *> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+    // glfw is not initialized at all in headless mode
+    if (!isHeadless()) {
+        uint32_t glfwExtensionCount = 0;
+        const char **glfwExtensions;
+        glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+
+        extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+    }
 
     if (kEnableValidationLayers) {
         extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
@@ -288,9 +315,22 @@ std::vector<const char *> VulkanContext::getRequiredExtensions() {
     return extensions;
 }
 
+std::vector<const char *> VulkanContext::getRequiredDeviceExtensions() {
+    std::vector<const char *> extensions;
+
+    for (const char *extension: kDeviceExtensions) {
+        if (isHeadless() && std::strcmp(extension, VK_KHR_SWAPCHAIN_EXTENSION_NAME) == 0)
+            continue;
+        extensions.push_back(extension);
+    }
+
+    return extensions;
+}
+
 bool VulkanContext::checkDeviceExtensionSupport(vk::PhysicalDevice device) {
     std::vector<vk::ExtensionProperties> availableExtensions = device.enumerateDeviceExtensionProperties(nullptr);
-    std::set<std::string> requiredExtensions(kDeviceExtensions.begin(), kDeviceExtensions.end());
+    std::vector<const char *> deviceExtensions               = getRequiredDeviceExtensions();
+    std::set<std::string> requiredExtensions(deviceExtensions.begin(), deviceExtensions.end());
 
     for (const auto &extension: availableExtensions) {
         requiredExtensions.erase(extension.extensionName);
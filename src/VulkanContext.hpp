@@ -11,6 +11,10 @@
 
 namespace vuren {
 
+class BindlessTable;
+class DescriptorCache;
+class PipelineCache;
+
 #ifdef NDEBUG
 const bool kEnableValidationLayers = false;
 #else
@@ -55,6 +59,7 @@ public:
     void cleanup();
 
     std::vector<const char *> getRequiredExtensions();
+    std::vector<const char *> getRequiredDeviceExtensions();
     bool isDeviceSuitable(vk::PhysicalDevice device);
     SwapChainSupportDetails querySwapChainSupport(vk::PhysicalDevice device);
     bool checkDeviceExtensionSupport(vk::PhysicalDevice device);
@@ -67,6 +72,9 @@ public:
                                                         void *pUserData);
     void populateDebugMessengerCreateInfo(vk::DebugUtilsMessengerCreateInfoEXT &createInfo);
 
+    // headless contexts have no window, surface, present queue or swap chain
+    bool isHeadless() const { return m_pWindow == nullptr; }
+
     vk::DeviceAddress getBufferDeviceAddress(vk::Buffer buffer) {
         vk::BufferDeviceAddressInfo bufferAddressInfo = { .buffer = buffer };
         vk::DeviceAddress bufferAddress               = m_device.getBufferAddress(bufferAddressInfo);
@@ -80,6 +88,15 @@ public:
     vk::Queue m_graphicsQueue;
     vk::Queue m_presentQueue;
 
+    // shared by every pipeline creation, owned by the application. may be null.
+    PipelineCache *m_pPipelineCache{ nullptr };
+
+    // descriptor set layouts and sets of every render pass, owned by the application
+    DescriptorCache *m_pDescriptorCache{ nullptr };
+
+    // set 0 of every pipeline layout, owned by the application
+    BindlessTable *m_pBindlessTable{ nullptr };
+
     // temporary: for output texture control in GUI
     std::vector<std::string> kOffscreenOutputTextureNames;
     int kCurrentItem = 0;
@@ -14,16 +14,19 @@
 
 #include <algorithm>
 #include <array>
+#include <chrono>
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
 #include <fstream>
+#include <future>
 #include <iostream>
 #include <memory>
 #include <optional>
 #include <random>
 #include <set>
 #include <stdexcept>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
@@ -31,105 +34,341 @@
 VULKAN_HPP_DEFAULT_DISPATCH_LOADER_DYNAMIC_STORAGE
 #endif
 
+#include "BenchmarkReport.hpp"
+#include "BindlessTable.hpp"
+#include "CameraPath.hpp"
 #include "Common.hpp"
+#include "CpuDenoiser.hpp"
+#include "CpuRenderer.hpp"
+#include "DescriptorCache.hpp"
+#include "FrameCapture.hpp"
+#include "GpuProfiler.hpp"
+#include "Profiler.hpp"
+#include "ImageWriter.hpp"
+#include "Options.hpp"
+#include "PipelineCache.hpp"
+#include "RayStatistics.hpp"
 #include "RenderPass.hpp"
 #include "ResourceManager.hpp"
 #include "Scene.hpp"
+#include "ShaderHotReload.hpp"
+#include "ThreadPool.hpp"
 #include "Timer.hpp"
 #include "Utils.hpp"
 #include "SwapChain.hpp"
+#include "VideoSink.hpp"
 #include "VulkanContext.hpp"
 #include "RenderPasses/AmbientOcclusionPass/AmbientOcclusionPass.hpp"
 #include "RenderPasses/GBufferPass/RayTracedGBufferPass.hpp"
 #include "RenderPasses/GBufferPass/RasterGBufferPass.hpp"
 #include "RenderPasses/AccumulationPass/AccumulationPass.hpp"
+#include "RenderPasses/SvgfPass/SvgfPass.hpp"
 #include "RenderPasses/PathTracingPass/PathTracingPass.hpp"
+#include "RenderPasses/RestirPass/RestirPass.hpp"
+#include "RenderPasses/RestirPass/RestirShadePass.hpp"
 
 namespace vuren {
 
+// a model file of the scene and how many randomly placed instances of it to create
+struct ModelDesc {
+    std::string name;
+    std::string path;
+    uint32_t materialId;
+    uint32_t instanceCount;
+};
+
+// rmse of the accumulated output against the reference after spp samples per pixel, rendered in ms
+struct ConvergencePoint {
+    uint32_t spp;
+    double ms;
+    double rmse;
+};
+
+void writeConvergence(const std::string &path, const std::vector<ConvergencePoint> &points) {
+    std::ofstream file(path);
+    if (!file)
+        throw std::runtime_error("failed to open " + path + "!");
+    file << "spp,ms,rmse\n";
+    for (auto &point: points)
+        file << point.spp << "," << point.ms << "," << point.rmse << "\n";
+    std::cout << "wrote " << path << std::endl;
+}
+
 class Application {
 public:
-    Application() {}
+    // headless renders use a fixed seed, so the gpu and cpu paths (and benchmark runs) see the same instances
+    Application(const Options &options)
+        : m_options(options),
+          m_rng(options.hasSeed ? options.seed : options.headless ? 0u : static_cast<unsigned>(time(nullptr))) {}
 
     void run() {
-        initGlfw();
-        initApplication();
-        initScene();
-        initRenderGraph();
-        initImGui();
+        if (!m_options.benchmarkPath.empty()) {
+            runBenchmark();
+            return;
+        }
+
+        if (m_options.headless) {
+            runHeadless();
+            return;
+        }
+
+        {
+            VUREN_PROFILE_ZONE("Startup");
+            initGlfw();
+            initApplication();
+            initScene();
+            initRenderGraph();
+            initFrameCapture();
+            initVideoSink();
+            initImGui();
+            finishRenderGraph();
+            initShaderHotReload();
+        }
+        Profiler::printBreakdown(std::cout, getStartupTitle(), 0, Profiler::now());
+
         mainLoop();
         cleanup();
     }
 
     void initGlfw() {
+        VUREN_PROFILE_ZONE("initGlfw");
         glfwInit();
 
         // tell glfw to not create an OpenGL context
         glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
 
         glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
-        m_pWindow = glfwCreateWindow(kWidth, kHeight, "vuren", nullptr, nullptr);
+        m_pWindow = glfwCreateWindow(m_options.width, m_options.height, "vuren", nullptr, nullptr);
         glfwSetWindowUserPointer(m_pWindow, this);
         glfwSetFramebufferSizeCallback(m_pWindow, framebufferResizeCallback);
         glfwSetMouseButtonCallback(m_pWindow, mouseCallback);
         glfwSetKeyCallback(m_pWindow, keyCallback);
     }
 
+    void runHeadless() {
+        if (m_options.cpu) {
+            renderHeadlessCpu();
+            return;
+        }
+
+        {
+            VUREN_PROFILE_ZONE("Startup");
+
+            // devices without ray tracing support (e.g. software vulkan implementations) are rejected here
+            try {
+                VUREN_PROFILE_ZONE("VulkanContext::init");
+                m_vkContext.init("test", nullptr);
+            } catch (const std::exception &e) {
+                std::cerr << "vulkan initialization failed: " << e.what() << std::endl;
+                std::cerr << "falling back to the cpu renderer" << std::endl;
+                m_vkContext.cleanup();
+                renderHeadlessCpu();
+                return;
+            }
+
+            initApplication();
+            initScene();
+            initRenderGraph();
+            initFrameCapture();
+            initVideoSink();
+            finishRenderGraph();
+        }
+        Profiler::printBreakdown(std::cout, getStartupTitle(), 0, Profiler::now());
+
+        renderHeadlessGpu();
+        cleanup();
+    }
+
     void initApplication() {
-        // init vulkan instance
-        m_vkContext.init("test", m_pWindow);
+        VUREN_PROFILE_ZONE("initApplication");
+
+        // init vulkan instance (the headless path has already done this)
+        if (!m_options.headless) {
+            VUREN_PROFILE_ZONE("VulkanContext::init");
+            m_vkContext.init("test", m_pWindow);
+        }
+
+        // every pipeline created from here on goes through the on-disk cache
+        {
+            VUREN_PROFILE_ZONE("PipelineCache::init");
+            m_pipelineCache.init(&m_vkContext, m_options.pipelineCachePath);
+            m_vkContext.m_pPipelineCache = &m_pipelineCache;
+        }
+        m_descriptorCache.init(&m_vkContext);
+        m_vkContext.m_pDescriptorCache = &m_descriptorCache;
 
         // init resource manager and scene object
         m_pResourceManager = std::make_shared<ResourceManager>(&m_vkContext);
         m_pScene           = std::make_shared<Scene>();
 
+        m_bindlessTable.init(&m_vkContext, m_pResourceManager);
+        m_vkContext.m_pBindlessTable = &m_bindlessTable;
+
         // init swap chain
-        m_pSwapChain = std::make_shared<SwapChain>(&m_vkContext, m_pWindow);
-        m_pSwapChain->createSwapChain();
-        m_pSwapChain->createSwapChainImageViews();
-        m_finalRenderPass.setSwapChain(m_pSwapChain);
+        if (!m_options.headless) {
+            VUREN_PROFILE_ZONE("createSwapChain");
+            m_pSwapChain = std::make_shared<SwapChain>(&m_vkContext, m_pWindow);
+            m_pSwapChain->createSwapChain();
+            m_pSwapChain->createSwapChainImageViews();
+            m_finalRenderPass.setSwapChain(m_pSwapChain);
+        }
 
         // init command pool
         createCommandPool();
         createCommandBuffers();
         createSyncObjects();
         m_pResourceManager->setCommandPool(m_commandPool);
-        m_pResourceManager->setExtent(m_pSwapChain->getExtent());
+
+        m_gpuProfiler.init(&m_vkContext, m_commandPool);
+        m_gpuProfiler.setTraceEnabled(!m_options.tracePath.empty());
+        m_pResourceManager->setExtent(m_options.headless ? vk::Extent2D{ m_options.width, m_options.height }
+                                                         : m_pSwapChain->getExtent());
+    }
+
+    std::vector<ModelDesc> getSceneModels() const {
+        if (!m_options.scenePath.empty())
+            return { { "Model", m_options.scenePath, 0, 1 } };
+
+        return { { "Bunny", "assets/models/bunny.obj", 0, 9 }, { "GreenBunny", "assets/models/bunny.obj", 1, 1 } };
+    }
+
+    std::vector<Material> getSceneMaterials() const {
+        if (!m_options.scenePath.empty())
+            return { { .diffuse = vec3(0.8f, 0.8f, 0.8f), .textureId = 0 } };
+
+        Material material1 = {
+            .diffuse = vec3(0.8f, 0.3f, 0.3f),
+            .textureId = 0
+        };
+        Material material2 = {
+            .diffuse = vec3(0.0f, 1.0f, 0.0f),
+            .textureId = 1
+        };
+        return { material1, material2 };
+    }
+
+    // the default scene has a warm key light and two dimmer ones, a model given with --scene only the key light
+    std::vector<Light> getSceneLights() const {
+        if (m_options.randomLights > 0) {
+            // the instances are placed within [-2, 2]^3. the lights share the power of about three key lights, so
+            // the image brightness does not depend on their count. a fixed seed keeps the gpu and cpu paths equal.
+            std::vector<Light> lights = m_options.lights;
+            std::default_random_engine rng(m_options.hasSeed ? m_options.seed : 0u);
+            std::uniform_real_distribution<float> uniformDistPos(-3.0f, 3.0f);
+            std::uniform_real_distribution<float> uniformDistTint(0.5f, 1.0f);
+            float intensity = 45.0f / static_cast<float>(m_options.randomLights);
+            for (uint32_t i = 0; i < m_options.randomLights; ++i) {
+                vec3 pos  = vec3(uniformDistPos(rng), uniformDistPos(rng), uniformDistPos(rng));
+                vec3 tint = vec3(uniformDistTint(rng), uniformDistTint(rng), uniformDistTint(rng));
+                lights.push_back({ .pos = pos, .type = LIGHT_TYPE_POINT, .intensity = tint * intensity, .pad = 0.0f });
+            }
+            return lights;
+        }
+        if (!m_options.lights.empty())
+            return m_options.lights;
+
+        Light key = { .pos = vec3(2.0f), .type = LIGHT_TYPE_POINT, .intensity = vec3(15.0f), .pad = 0.0f };
+        if (!m_options.scenePath.empty())
+            return { key };
+
+        Light fill = {
+            .pos = vec3(-3.0f, 1.5f, 1.0f), .type = LIGHT_TYPE_POINT, .intensity = vec3(4.0f, 3.0f, 2.0f), .pad = 0.0f
+        };
+        Light rim = {
+            .pos = vec3(0.0f, 3.0f, -3.0f), .type = LIGHT_TYPE_POINT, .intensity = vec3(1.5f, 2.0f, 4.0f), .pad = 0.0f
+        };
+        return { key, fill, rim };
+    }
+
+    uint32_t getDirectLighting() const {
+        if (m_options.directLighting == "unshadowed")
+            return PT_DIRECT_LIGHTING_UNSHADOWED;
+        if (m_options.directLighting == "light-bvh")
+            return PT_DIRECT_LIGHTING_LIGHT_BVH;
+        return PT_DIRECT_LIGHTING_NEE;
+    }
+
+    uint32_t getSampler() const {
+        if (m_options.sampler == "independent")
+            return SAMPLER_INDEPENDENT;
+        if (m_options.sampler == "rank1")
+            return SAMPLER_RANK1;
+        return SAMPLER_SOBOL;
+    }
+
+    vk::BuildAccelerationStructureFlagsKHR getBlasBuildFlags() const {
+        if (m_options.blasBuild == "fast-build")
+            return vk::BuildAccelerationStructureFlagBitsKHR::ePreferFastBuild;
+        return vk::BuildAccelerationStructureFlagBitsKHR::ePreferFastTrace;
+    }
+
+    // the rendered frame the accumulation and the denoiser take
+    std::string getFrameTexture() const { return m_options.restir ? "RestirOutput" : "PtOutput"; }
+
+    // the --reference image, the size of the output
+    std::vector<float> readReference() const {
+        uint32_t width, height;
+        std::vector<float> reference = readPfm(m_options.referencePath, width, height);
+        if (width != m_options.width || height != m_options.height)
+            throw std::runtime_error("the reference image does not match the output size!");
+        return reference;
+    }
+
+    void applyCameraOptions(Camera &camera) {
+        camera.setFovY(m_options.fovY);
+        if (m_options.hasCamera)
+            camera.setLookAt(m_options.eye, m_options.center, m_options.up);
+        else
+            camera.updateCamera();
     }
 
     void initScene() {
+        VUREN_PROFILE_ZONE("initScene");
+
         // scene camera and object description
         m_pResourceManager->createUniformBuffer<CameraData>("CameraBuffer");
-        m_pScene->getCamera().setExtent(m_pSwapChain->getExtent());
+        m_pScene->getCamera().setExtent(m_pResourceManager->getExtent());
         m_pScene->getCamera().setMappedCameraBuffer(m_pResourceManager->getMappedBuffer("CameraBuffer"));
         m_pScene->getCamera().init();
+        applyCameraOptions(m_pScene->getCamera());
 
         auto texture1 = m_pResourceManager->createModelTexture("Bunny", "assets/textures/texture.jpg");
         m_pScene->addTexture(texture1);
-        m_pResourceManager->loadObjModel("Bunny", "assets/models/bunny.obj", m_pScene, 0);
-        m_pResourceManager->loadObjModel("GreenBunny", "assets/models/bunny.obj", m_pScene, 1);
+
+        std::vector<ModelDesc> models = getSceneModels();
+        for (auto &model: models)
+            m_pResourceManager->loadObjModel(model.name, model.path, m_pScene, model.materialId);
 
         auto texture2 = m_pResourceManager->createModelTexture("VikingRoom", "assets/textures/viking_room.png");
         m_pScene->addTexture(texture2);
 
+        // the material texture ids index the scene's textures, so they go to the bindless table in the same order
+        for (auto &texture: m_pScene->getTextures())
+            m_bindlessTable.addTexture(texture);
+
         // m_pResourceManager->loadObjModel("Room", "assets/models/viking_room.obj", m_pScene);
 
-        Material material1 = {
-            .diffuse = vec3(0.8f, 0.3f, 0.3f),
-            .textureId = 0
-        };
-        Material material2 = {
-            .diffuse = vec3(0.0f, 1.0f, 0.0f),
-            .textureId = 1
-        };
-        m_pScene->addMaterial(material1);
-        m_pScene->addMaterial(material2);
+        for (auto &material: getSceneMaterials())
+            m_pScene->addMaterial(material);
         m_pResourceManager->createMaterialBuffer(m_pScene);
 
         m_pResourceManager->createObjectDeviceInfoBuffer(m_pScene);
 
-        createRandomInstances(0, 9);
-        createRandomInstances(1, 1);
+        m_pScene->setLights(getSceneLights());
+        m_pResourceManager->createLightBuffers(m_pScene, m_options.animateLights);
+        if (m_options.animateLights) {
+            for (auto &light: m_pScene->getLights())
+                m_lightOrigins.push_back(light.pos);
+        }
+
+        m_bindlessTable.setBuffer(BINDLESS_MATERIALS_BINDING, "MaterialBuffer");
+        m_bindlessTable.setBuffer(BINDLESS_OBJECTS_BINDING, "SceneObjectDeviceInfo");
+        m_bindlessTable.setBuffer(BINDLESS_LIGHTS_BINDING, "LightBuffer");
+        m_bindlessTable.setBuffer(BINDLESS_LIGHT_ALIAS_BINDING, "LightAliasTable");
+        m_bindlessTable.setBuffer(BINDLESS_LIGHT_BVH_BINDING, "LightBvh");
+
+        for (uint32_t objId = 0; objId < models.size(); ++objId)
+            createInstances(objId, models[objId].instanceCount);
     }
 
     void initRenderGraph() {
@@ -155,9 +394,15 @@ public:
         //     |    (Swap Chain)    |
         //     +--------------------+
 
+        VUREN_PROFILE_ZONE("initRenderGraph");
+
         // rasterized g-buffer pass
-        m_rasterGBufferPass.init(&m_vkContext, m_commandPool, m_pResourceManager, m_pScene);
-        m_rasterGBufferPass.setup();
+        {
+            VUREN_PROFILE_ZONE("RasterGBufferPass");
+            m_rasterGBufferPass.init(&m_vkContext, m_commandPool, m_pResourceManager, m_pScene);
+            m_rasterGBufferPass.define();
+            compilePipeline(m_rasterGBufferPass);
+        }
 
         // ray traced ambient occlusion pass
         // input textures: world position, world normal (from g-buffer pass)
@@ -166,24 +411,224 @@ public:
         // m_aoPass.connectTextureWorldNormal("RasterWorldNormal");
         // m_aoPass.setup();
 
-        m_pathTracingPass.init(&m_vkContext, m_commandPool, m_pResourceManager, m_pScene);
-        m_pathTracingPass.connectTextureWorldPos("RasterWorldPos");
-        m_pathTracingPass.connectTextureWorldNormal("RasterWorldNormal");
-        m_pathTracingPass.setup();
+        {
+            VUREN_PROFILE_ZONE("PathTracingPass");
+            m_pathTracingPass.setBlasBuildFlags(getBlasBuildFlags());
+            m_pathTracingPass.init(&m_vkContext, m_commandPool, m_pResourceManager, m_pScene);
+            m_pathTracingPass.connectTextureWorldPos("RasterWorldPos");
+            m_pathTracingPass.connectTextureWorldNormal("RasterWorldNormal");
+            m_pathTracingPass.setDirectLighting(getDirectLighting());
+            m_pathTracingPass.setMaxDepth(m_options.maxDepth);
+            m_pathTracingPass.setSampler(getSampler());
+            if (m_options.adaptiveThreshold > 0.0f)
+                m_pathTracingPass.enableAdaptiveSampling();
+            if (m_options.rayStats)
+                m_pathTracingPass.enableRayStats(RayStatistics::supportsSubgroupReduce(m_vkContext));
+            m_pathTracingPass.define();
+            compilePipeline(m_pathTracingPass);
+            if (m_options.rayStats)
+                m_rayStats.init(&m_vkContext, m_pResourceManager, "PtRayStats");
+        }
+
+        // ReSTIR direct lighting passes, recorded in place of the path tracing pass
+        // input textures: the path tracing pass's world position and world normal, motion vectors (from g-buffer pass)
+        if (m_options.restir) {
+            VUREN_PROFILE_ZONE("RestirPass");
+            m_restirPass.init(&m_vkContext, m_commandPool, m_pResourceManager, m_pScene);
+            m_restirPass.connectTextureMotion("RasterMotion");
+            m_restirPass.setGpuProfiler(&m_gpuProfiler);
+            m_restirPass.define();
+            compilePipeline(m_restirPass);
+
+            m_restirShadePass.setBlasBuildFlags(getBlasBuildFlags());
+            m_restirShadePass.init(&m_vkContext, m_commandPool, m_pResourceManager, m_pScene);
+            m_restirShadePass.define();
+            compilePipeline(m_restirShadePass);
+        }
 
         // temporal accumulation pass
-        // input textures: the current frame's rendered result
-        m_accumPass.init(&m_vkContext, m_commandPool, m_pResourceManager, m_pScene);
-        m_accumPass.connectTextureCurrentFrame("PtOutput");
-        m_accumPass.setup();
+        // input textures: the current frame's rendered result, world position, world normal and motion vectors (from
+        // g-buffer pass)
+        {
+            VUREN_PROFILE_ZONE("AccumulationPass");
+            m_accumPass.init(&m_vkContext, m_commandPool, m_pResourceManager, m_pScene);
+            m_accumPass.connectTextureCurrentFrame(getFrameTexture());
+            m_accumPass.connectTextureWorldPos("RasterWorldPos");
+            m_accumPass.connectTextureWorldNormal("RasterWorldNormal");
+            m_accumPass.connectTextureMotion("RasterMotion");
+            if (m_options.fusedPresent)
+                m_accumPass.enablePresent(presentSwapsRedBlue());
+            if (m_options.adaptiveThreshold > 0.0f)
+                m_accumPass.enableAdaptiveSampling(m_options.adaptiveThreshold, m_options.adaptiveMinSpp);
+            m_accumPass.define();
+            compilePipeline(m_accumPass);
+        }
+
+        // svgf denoiser pass
+        // input textures: the current frame's rendered result, world position, world normal and motion vectors (from
+        // g-buffer pass)
+        {
+            VUREN_PROFILE_ZONE("SvgfPass");
+            m_svgfPass.init(&m_vkContext, m_commandPool, m_pResourceManager, m_pScene);
+            m_svgfPass.connectTextureCurrentFrame(getFrameTexture());
+            m_svgfPass.connectTextureWorldPos("RasterWorldPos");
+            m_svgfPass.connectTextureWorldNormal("RasterWorldNormal");
+            m_svgfPass.connectTextureMotion("RasterMotion");
+            if (m_accumPass.isAdaptiveSamplingEnabled())
+                m_svgfPass.connectTextureSampledMask("AccumSampledMask");
+            m_svgfPass.setGpuProfiler(&m_gpuProfiler);
+            m_svgfPass.define();
+            compilePipeline(m_svgfPass);
+        }
 
         // final rendering pass (and swap chain)
         // which texture will be displayed on the screen is selected at runtime (by the gui)
-        m_finalRenderPass.init(&m_vkContext, m_commandPool, m_pResourceManager, m_pScene);
-        m_finalRenderPass.setup();
+        if (hasFinalPass()) {
+            VUREN_PROFILE_ZONE("FinalRenderPass");
+            m_finalRenderPass.init(&m_vkContext, m_commandPool, m_pResourceManager, m_pScene);
+            m_finalRenderPass.define();
+            compilePipeline(m_finalRenderPass);
+        }
+
+        // the accumulation pass writes the displayed image, only the gui is left to draw
+        if (m_options.fusedPresent)
+            m_overlayPass.init(&m_vkContext, m_pSwapChain);
 
         // set to display the output texture of the last render pass by default
-        m_vkContext.kCurrentItem = m_vkContext.kOffscreenOutputTextureNames.size() - 1;
+        auto &outputNames        = m_vkContext.kOffscreenOutputTextureNames;
+        m_vkContext.kCurrentItem = outputNames.size() - 1;
+        if (m_options.fusedPresent)
+            m_vkContext.kCurrentItem = std::find(outputNames.begin(), outputNames.end(), "AccumOutput") -
+                                       outputNames.begin();
+    }
+
+    // the fullscreen pass sampling the selected output into the swap chain image
+    bool hasFinalPass() const { return !m_options.headless && !m_options.fusedPresent; }
+
+    // the denoiser's output is only worth computing while it is displayed, captured or streamed
+    bool isSvgfOutputUsed() const {
+        if (m_frameCapture.isEnabled() && m_options.captureTexture == "SvgfOutput")
+            return true;
+        if (m_videoSink.isEnabled() && m_options.videoTexture == "SvgfOutput")
+            return true;
+        return hasFinalPass() && m_vkContext.kOffscreenOutputTextureNames[m_vkContext.kCurrentItem] == "SvgfOutput";
+    }
+
+    // decides whether the svgf pass is recorded this frame. its history stops following the camera while it is
+    // skipped, so it starts over when its output is selected again.
+    void updateSvgf() {
+        bool used = isSvgfOutputUsed();
+        if (used && !m_svgfRecorded)
+            m_svgfPass.resetHistory();
+        m_svgfRecorded = used;
+        m_svgfPass.updateUniformBuffer();
+    }
+
+    // the present image is RGBA8 and copied to the swap chain image bit by bit, so the channels follow its format
+    bool presentSwapsRedBlue() {
+        if (!m_pSwapChain->canCopyToImages())
+            throw std::runtime_error("--fused-present: the swap chain images cannot be copied to!");
+
+        switch (m_pSwapChain->getImageFormat()) {
+        case vk::Format::eB8G8R8A8Srgb:
+        case vk::Format::eB8G8R8A8Unorm:
+            return true;
+        case vk::Format::eR8G8B8A8Srgb:
+        case vk::Format::eR8G8B8A8Unorm:
+            return false;
+        default:
+            throw std::runtime_error("--fused-present needs an 8-bit RGBA or BGRA swap chain!");
+        }
+    }
+
+    // the pipelines of the passes defined so far are compiled on worker threads while the main thread goes on with
+    // the next pass (e.g. the path tracer's acceleration structures) and the rest of the startup
+    void compilePipeline(RenderPass &pass) {
+        if (m_options.serialPipelines) {
+            pass.compilePipeline();
+            return;
+        }
+
+        // a few workers are enough, the render graph only has a handful of pipelines
+        if (!m_pPipelineCompilePool)
+            m_pPipelineCompilePool = std::make_unique<ThreadPool>(std::min(4u, std::thread::hardware_concurrency()));
+        m_pipelineJobs.push_back(m_pPipelineCompilePool->submit([&pass]() { pass.compilePipeline(); }));
+    }
+
+    // waits for every pipeline, then creates what depends on them (the shader binding tables)
+    void finishRenderGraph() {
+        VUREN_PROFILE_ZONE("finishRenderGraph");
+        {
+            VUREN_PROFILE_ZONE("WaitForPipelines");
+            // get() rethrows a failed compilation here, on the main thread
+            for (auto &job: m_pipelineJobs)
+                job.get();
+            m_pipelineJobs.clear();
+            m_pPipelineCompilePool.reset();
+        }
+
+        m_rasterGBufferPass.finishSetup();
+        m_pathTracingPass.finishSetup();
+        if (m_options.restir) {
+            m_restirPass.finishSetup();
+            m_restirShadePass.finishSetup();
+        }
+        m_accumPass.finishSetup();
+        m_svgfPass.finishSetup();
+        if (hasFinalPass())
+            m_finalRenderPass.finishSetup();
+    }
+
+    void initShaderHotReload() {
+        if (!m_options.hotReload)
+            return;
+
+        // the build tree's shaders are compiled from this source tree
+        m_shaderHotReload.init(VUREN_SHADER_SOURCE_DIR, VUREN_GLSLANG_VALIDATOR);
+        m_shaderHotReload.watch(&m_rasterGBufferPass);
+        m_shaderHotReload.watch(&m_pathTracingPass);
+        if (m_options.restir) {
+            m_shaderHotReload.watch(&m_restirPass);
+            m_shaderHotReload.watch(&m_restirShadePass);
+        }
+        m_shaderHotReload.watch(&m_accumPass);
+        m_shaderHotReload.watch(&m_svgfPass);
+        if (hasFinalPass())
+            m_shaderHotReload.watch(&m_finalRenderPass);
+        m_shaderHotReload.start();
+    }
+
+    std::string getStartupTitle() const {
+        return m_options.serialPipelines ? "startup (serial pipelines)" : "startup (parallel pipelines)";
+    }
+
+    void initFrameCapture() {
+        if (m_options.captureDirectory.empty())
+            return;
+        VUREN_PROFILE_ZONE("initFrameCapture");
+
+        auto &outputNames = m_vkContext.kOffscreenOutputTextureNames;
+        if (std::find(outputNames.begin(), outputNames.end(), m_options.captureTexture) == outputNames.end()) {
+            throw std::runtime_error("cannot capture " + m_options.captureTexture +
+                                     ": not an offscreen output texture");
+        }
+
+        m_frameCapture.init(&m_vkContext, m_pResourceManager, m_options.captureDirectory, m_options.captureFormat,
+                            m_options.captureRingSize);
+    }
+
+    void initVideoSink() {
+        if (m_options.videoPath.empty())
+            return;
+        VUREN_PROFILE_ZONE("initVideoSink");
+
+        auto &outputNames = m_vkContext.kOffscreenOutputTextureNames;
+        if (std::find(outputNames.begin(), outputNames.end(), m_options.videoTexture) == outputNames.end()) {
+            throw std::runtime_error("cannot stream " + m_options.videoTexture + ": not an offscreen output texture");
+        }
+
+        m_videoSink.init(&m_vkContext, m_pResourceManager, m_options.videoPath,
+                         m_options.videoFormat == "rgb" ? VideoFormat::eRgb : VideoFormat::eY4m, m_options.videoFps);
     }
 
     void mainLoop() {
@@ -191,18 +636,41 @@ public:
 
         while (!glfwWindowShouldClose(m_pWindow)) {
             float deltaTime = static_cast<float>(timer.elapsed());
+            VUREN_PROFILE_ZONE("Frame");
             glfwPollEvents();
 
-            updateGUI(deltaTime);
-            manipulateCamera();
-            // m_aoPass.updateUniformBuffer();
-            m_pathTracingPass.updateUniformBuffer();
-            m_accumPass.updateUniformBuffer();
+            {
+                VUREN_PROFILE_ZONE("Update");
+                updateGUI(deltaTime);
+                m_pScene->getCamera().beginFrame();
+                manipulateCamera();
+                // m_aoPass.updateUniformBuffer();
+                if (m_pathTracingPass.updatePipelineVariant()) {
+                    m_accumPass.resetHistory();
+                    m_svgfPass.resetHistory();
+                }
+                m_pathTracingPass.updateUniformBuffer();
+            }
 
             drawFrame();
         }
 
         m_vkContext.m_device.waitIdle();
+        m_frameCapture.retire(m_submittedFrames);
+        m_videoSink.retire(m_submittedFrames);
+        m_rayStats.retire(m_submittedFrames);
+
+        // what it costs to get the accumulation on screen, to compare runs with and without --fused-present (the
+        // offscreen benchmark has no swap chain). the fused path tone maps in the accumulation pass, which is
+        // counted as well.
+        m_gpuProfiler.resolvePending();
+        float accumMs   = m_gpuProfiler.getAverageMs("AccumulationPass");
+        float presentMs = m_options.fusedPresent
+                              ? m_gpuProfiler.getAverageMs("PresentCopy") + m_gpuProfiler.getAverageMs("OverlayPass")
+                              : m_gpuProfiler.getAverageMs("FinalRenderPass");
+        std::cout << "present (" << (m_options.fusedPresent ? "fused" : "final pass") << "): AccumulationPass "
+                  << accumMs << " ms + " << presentMs << " ms = " << accumMs + presentMs << " ms, gpu frame "
+                  << m_gpuProfiler.getAverageMs("Frame") << " ms" << std::endl;
     }
 
     void recordCommandBuffer(vk::CommandBuffer commandBuffer, uint32_t imageIndex) {
@@ -213,7 +681,17 @@ public:
             throw std::runtime_error("failed to begin recording command buffer!");
         }
 
+        // set 0 of every pass, it stays bound while the passes only rebind set 1
+        m_bindlessTable.bind(commandBuffer, vk::PipelineBindPoint::eGraphics);
+        m_bindlessTable.bind(commandBuffer, vk::PipelineBindPoint::eRayTracingKHR);
+        m_bindlessTable.bind(commandBuffer, vk::PipelineBindPoint::eCompute);
+
+        m_gpuProfiler.beginFrame(commandBuffer);
+        m_gpuProfiler.beginScope(commandBuffer, "Frame");
+
+        m_gpuProfiler.beginScope(commandBuffer, "RasterGBufferPass");
         m_rasterGBufferPass.record(commandBuffer);
+        m_gpuProfiler.endScope(commandBuffer);
         m_rasterGBufferPass.outputTextureBarrier(commandBuffer);
 
         // AO pass output texture
@@ -223,29 +701,92 @@ public:
         //                       vk::ImageLayout::eShaderReadOnlyOptimal, vk::PipelineStageFlagBits::eRayTracingShaderKHR,
         //                       vk::PipelineStageFlagBits::eFragmentShader);
 
-        
-        m_pathTracingPass.record(commandBuffer);
-        auto rtTexture = m_pResourceManager->getTexture("PtOutput");
-        transitionImageLayout(commandBuffer, rtTexture, vk::ImageLayout::eGeneral,
-                              vk::ImageLayout::eShaderReadOnlyOptimal, vk::PipelineStageFlagBits::eRayTracingShaderKHR,
-                              vk::PipelineStageFlagBits::eFragmentShader);
+        if (m_options.restir) {
+            // the scopes of the kernels are nested in the pass's
+            m_gpuProfiler.beginScope(commandBuffer, "RestirPass");
+            m_restirPass.record(commandBuffer);
+            m_gpuProfiler.endScope(commandBuffer);
 
+            m_gpuProfiler.beginScope(commandBuffer, "RestirShadePass");
+            m_restirShadePass.record(commandBuffer);
+            m_gpuProfiler.endScope(commandBuffer);
+            m_restirShadePass.outputTextureBarrier(commandBuffer);
+        } else {
+            // the pixels the path tracer launches, from the variance the accumulation tracks
+            if (m_accumPass.isAdaptiveSamplingEnabled()) {
+                m_gpuProfiler.beginScope(commandBuffer, "SampleAllocation");
+                m_accumPass.recordSampleAllocation(commandBuffer);
+                m_gpuProfiler.endScope(commandBuffer);
+            }
+            if (m_rayStats.isEnabled())
+                m_rayStats.recordReset(commandBuffer);
+            m_gpuProfiler.beginScope(commandBuffer, "PathTracingPass");
+            m_pathTracingPass.record(commandBuffer);
+            m_gpuProfiler.endScope(commandBuffer);
+            if (m_rayStats.isEnabled())
+                m_rayStats.recordReadback(commandBuffer, m_submittedFrames + 1);
+            auto rtTexture = m_pResourceManager->getTexture("PtOutput");
+            transitionImageLayout(commandBuffer, rtTexture, vk::ImageLayout::eGeneral,
+                                  vk::ImageLayout::eShaderReadOnlyOptimal,
+                                  vk::PipelineStageFlagBits::eRayTracingShaderKHR,
+                                  vk::PipelineStageFlagBits::eFragmentShader |
+                                      vk::PipelineStageFlagBits::eComputeShader);
+        }
 
 
+        m_gpuProfiler.beginScope(commandBuffer, "AccumulationPass");
         m_accumPass.record(commandBuffer);
+        m_gpuProfiler.endScope(commandBuffer);
         m_accumPass.outputTextureBarrier(commandBuffer);
 
+        // the scopes of the kernels and iterations are nested in the pass's. when skipped, SvgfOutput stays in the
+        // shader read layout the final pass samples it in.
+        if (m_svgfRecorded) {
+            m_gpuProfiler.beginScope(commandBuffer, "SvgfPass");
+            m_svgfPass.record(commandBuffer);
+            m_gpuProfiler.endScope(commandBuffer);
+            m_svgfPass.outputTextureBarrier(commandBuffer);
+        }
+
+        // every offscreen output is ready to be sampled by the final pass at this point
+        if (m_frameCapture.isEnabled())
+            m_frameCapture.recordCopy(commandBuffer, m_options.captureTexture,
+                                      vk::ImageLayout::eShaderReadOnlyOptimal, m_submittedFrames + 1);
+        if (m_videoSink.isEnabled())
+            m_videoSink.recordCopy(commandBuffer, m_options.videoTexture, vk::ImageLayout::eShaderReadOnlyOptimal,
+                                   m_submittedFrames + 1);
+
         // this texture will be read from final fullscreen triangle shader
-        m_finalRenderPass.record(commandBuffer);
+        if (hasFinalPass()) {
+            m_gpuProfiler.beginScope(commandBuffer, "FinalRenderPass");
+            m_finalRenderPass.record(commandBuffer);
+            m_gpuProfiler.endScope(commandBuffer);
+        } else if (m_options.fusedPresent) {
+            m_gpuProfiler.beginScope(commandBuffer, "PresentCopy");
+            recordPresentCopy(commandBuffer);
+            m_gpuProfiler.endScope(commandBuffer);
+
+            m_gpuProfiler.beginScope(commandBuffer, "OverlayPass");
+            m_overlayPass.record(commandBuffer);
+            m_gpuProfiler.endScope(commandBuffer);
+        }
 
         // for raster attachments, we don't need to transition to the original layout(eColorAttachmentOptimal)
         // explicitly. because we defined oldLayout = eUndefined(which means "don't care") for raster render pass
         // initialization. in contrast, ray traced output texutre layout need to be recovered explicitly.
-        transitionImageLayout(commandBuffer, rtTexture, vk::ImageLayout::eShaderReadOnlyOptimal,
-                              vk::ImageLayout::eGeneral, vk::PipelineStageFlagBits::eFragmentShader,
-                              vk::PipelineStageFlagBits::eBottomOfPipe);
+        // with --restir the path tracer is not recorded and PtOutput stays general, while the ReSTIR shading pass
+        // keeps its own output sampled between the frames
+        if (!m_options.restir)
+            transitionImageLayout(commandBuffer, m_pResourceManager->getTexture("PtOutput"),
+                                  vk::ImageLayout::eShaderReadOnlyOptimal, vk::ImageLayout::eGeneral,
+                                  vk::PipelineStageFlagBits::eFragmentShader |
+                                      vk::PipelineStageFlagBits::eComputeShader,
+                                  vk::PipelineStageFlagBits::eBottomOfPipe);
         // to fix: general and scalable image flushing/invalidation strategy for ray tracing passes
 
+        m_gpuProfiler.endScope(commandBuffer);
+        m_gpuProfiler.endFrame();
+
         try {
             commandBuffer.end();
         } catch (vk::SystemError err) {
@@ -253,17 +794,121 @@ public:
         }
     }
 
+    // the accumulation pass has written the displayed image (made visible to transfers by its output barrier), it is
+    // copied into the swap chain image as it is and left in the transfer dst layout for the overlay pass
+    void recordPresentCopy(vk::CommandBuffer commandBuffer) {
+        vk::Image swapChainImage = (*m_pSwapChain->getSwapChainColorImages())[m_pSwapChain->getImageIndex()];
+
+        // the wait on the acquire semaphore is at the transfer stage, see drawFrame()
+        vk::ImageMemoryBarrier barrier{ .srcAccessMask       = {},
+                                        .dstAccessMask       = vk::AccessFlagBits::eTransferWrite,
+                                        .oldLayout           = vk::ImageLayout::eUndefined,
+                                        .newLayout           = vk::ImageLayout::eTransferDstOptimal,
+                                        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                                        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                                        .image               = swapChainImage,
+                                        .subresourceRange    = { .aspectMask     = vk::ImageAspectFlagBits::eColor,
+                                                                 .baseMipLevel   = 0,
+                                                                 .levelCount     = 1,
+                                                                 .baseArrayLayer = 0,
+                                                                 .layerCount     = 1 } };
+        commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer, {}, 0,
+                                      nullptr, 0, nullptr, 1, &barrier);
+
+        // the present image keeps the extent the passes were created with, while the swap chain follows the window.
+        // only their overlap is copied, and the rest of a larger window is cleared rather than left undefined.
+        vk::Extent2D renderExtent    = m_pResourceManager->getExtent();
+        vk::Extent2D swapChainExtent = m_pSwapChain->getExtent();
+        vk::Extent2D extent{ std::min(renderExtent.width, swapChainExtent.width),
+                             std::min(renderExtent.height, swapChainExtent.height) };
+        if (swapChainExtent.width > extent.width || swapChainExtent.height > extent.height) {
+            vk::ClearColorValue black{ std::array<float, 4>{ 0.0f, 0.0f, 0.0f, 1.0f } };
+            commandBuffer.clearColorImage(swapChainImage, vk::ImageLayout::eTransferDstOptimal, black,
+                                          barrier.subresourceRange);
+            // the copy writes over the cleared texels
+            vk::MemoryBarrier clearBarrier{ .srcAccessMask = vk::AccessFlagBits::eTransferWrite,
+                                            .dstAccessMask = vk::AccessFlagBits::eTransferWrite };
+            commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer,
+                                          {}, 1, &clearBarrier, 0, nullptr, 0, nullptr);
+        }
+
+        // a copy rather than a blit: the formats have the same texel size, so the encoded bytes are kept as they are
+        vk::ImageSubresourceLayers layers{ .aspectMask     = vk::ImageAspectFlagBits::eColor,
+                                           .mipLevel       = 0,
+                                           .baseArrayLayer = 0,
+                                           .layerCount     = 1 };
+        vk::ImageCopy region{ .srcSubresource = layers,
+                              .srcOffset      = { 0, 0, 0 },
+                              .dstSubresource = layers,
+                              .dstOffset      = { 0, 0, 0 },
+                              .extent         = { extent.width, extent.height, 1 } };
+        commandBuffer.copyImage(m_pResourceManager->getTexture("AccumPresentImage")->image, vk::ImageLayout::eGeneral,
+                                swapChainImage, vk::ImageLayout::eTransferDstOptimal, 1, &region);
+    }
+
+    // every eighth light bobs up and down, only their bvh nodes are refit and copied into the mapped buffers,
+    // unless the tree has degraded enough to be rebuilt
+    void animateLights() {
+        VUREN_PROFILE_ZONE("AnimateLights");
+        float phase = static_cast<float>(m_submittedFrames) * 0.05f;
+        std::vector<uint32_t> movedLights;
+        std::vector<vec3> positions;
+        for (uint32_t i = 0; i < m_lightOrigins.size(); i += 8) {
+            movedLights.push_back(i);
+            positions.push_back(m_lightOrigins[i] + vec3(0.0f, 0.5f * std::sin(phase + static_cast<float>(i)), 0.0f));
+        }
+
+        std::vector<uint32_t> updatedNodes;
+        bool rebuilt = m_pScene->moveLights(movedLights, positions, updatedNodes);
+
+        auto *mappedLights = static_cast<Light *>(m_pResourceManager->getMappedBuffer("LightBuffer"));
+        for (auto light: movedLights)
+            mappedLights[light] = m_pScene->getLights()[light];
+
+        const auto &nodes = m_pScene->getLightBvh().getNodes();
+        auto *mappedNodes = static_cast<LightBvhNode *>(m_pResourceManager->getMappedBuffer("LightBvh"));
+        if (rebuilt) {
+            memcpy(mappedNodes, nodes.data(), nodes.size() * sizeof(LightBvhNode));
+        } else {
+            for (auto node: updatedNodes)
+                mappedNodes[node] = nodes[node];
+        }
+
+        // the history was lit by the old positions, the reservoirs' weights included
+        if (m_options.restir)
+            m_restirPass.resetHistory();
+        m_accumPass.resetHistory();
+        m_svgfPass.resetHistory();
+    }
+
     void drawFrame() {
         vk::Result result;
 
         // at the start of the frame, we want to wait until the previous frame has finished
-        do {
-            result = m_vkContext.m_device.waitForFences(1, &m_inFlightFence, VK_TRUE, UINT64_MAX);
-        } while (result == vk::Result::eTimeout);
+        {
+            VUREN_PROFILE_ZONE("WaitForFence");
+            do {
+                result = m_vkContext.m_device.waitForFences(1, &m_inFlightFence, VK_TRUE, UINT64_MAX);
+            } while (result == vk::Result::eTimeout);
+        }
+
+        // with a single fence, every submitted frame has completed now
+        m_frameCapture.retire(m_submittedFrames);
+        m_videoSink.retire(m_submittedFrames);
+        m_rayStats.retire(m_submittedFrames);
+        m_accumPass.readStats();
+
+        // no submitted frame uses the pipelines now, so recompiled shaders can replace them
+        if (m_shaderHotReload.applyReloads() > 0) {
+            m_restirPass.resetHistory();
+            m_accumPass.resetHistory();
+            m_svgfPass.resetHistory();
+        }
 
         // change the descriptor sets w.r.t. updated gui (e.g., output buffer)
         if (m_vkContext.kDirty) {
-            m_finalRenderPass.updateDescriptorSets();
+            if (hasFinalPass())
+                m_finalRenderPass.updateDescriptorSets();
             m_vkContext.kDirty = false;
         }
 
@@ -286,12 +931,32 @@ public:
             throw std::runtime_error("failed to reset fence!");
         }
 
+        // the mapped light buffers are not read by any frame now
+        if (m_options.animateLights)
+            animateLights();
+
+        // the history images swap roles every submitted frame, so this waits until the frame is sure to be rendered
+        if (m_options.restir)
+            m_restirPass.updateUniformBuffer();
+        m_accumPass.updateUniformBuffer();
+        updateSvgf();
+
+        // the accumulation output is one of two images, the one written this frame
+        if (hasFinalPass() && m_vkContext.kOffscreenOutputTextureNames[m_vkContext.kCurrentItem] == "AccumOutput")
+            m_finalRenderPass.updateDescriptorSets();
+
         // currently only one command buffer is used.
-        m_commandBuffers[0].reset();
-        recordCommandBuffer(m_commandBuffers[0], imageIndex);
+        {
+            VUREN_PROFILE_ZONE("Record");
+            m_commandBuffers[0].reset();
+            recordCommandBuffer(m_commandBuffers[0], imageIndex);
+        }
 
         vk::Semaphore waitSemaphores[]      = { m_imageAvailableSemaphore };
-        vk::PipelineStageFlags waitStages[] = { vk::PipelineStageFlagBits::eColorAttachmentOutput };
+        // the fused present path copies into the swap chain image before any attachment write
+        vk::PipelineStageFlags waitStages[] = { m_options.fusedPresent
+                                                    ? vk::PipelineStageFlagBits::eTransfer
+                                                    : vk::PipelineStageFlagBits::eColorAttachmentOutput };
         vk::Semaphore signalSemaphores[]    = { m_renderFinishedSemaphore };
 
         vk::SubmitInfo submitInfo{ .waitSemaphoreCount   = 1,
@@ -302,8 +967,12 @@ public:
                                    .signalSemaphoreCount = 1,
                                    .pSignalSemaphores    = signalSemaphores };
 
-        if (m_vkContext.m_graphicsQueue.submit(1, &submitInfo, m_inFlightFence) != vk::Result::eSuccess) {
-            throw std::runtime_error("failed to submit draw command buffer!");
+        {
+            VUREN_PROFILE_ZONE("Submit");
+            if (m_vkContext.m_graphicsQueue.submit(1, &submitInfo, m_inFlightFence) != vk::Result::eSuccess) {
+                throw std::runtime_error("failed to submit draw command buffer!");
+            }
+            m_submittedFrames++;
         }
 
         vk::SwapchainKHR swapChains[]{ m_pSwapChain->getVkSwapChain() };
@@ -314,7 +983,10 @@ public:
                                         .pImageIndices      = &imageIndex,
                                         .pResults           = nullptr };
 
-        result = m_vkContext.m_presentQueue.presentKHR(&presentInfo);
+        {
+            VUREN_PROFILE_ZONE("Present");
+            result = m_vkContext.m_presentQueue.presentKHR(&presentInfo);
+        }
 
         if (result == vk::Result::eErrorOutOfDateKHR || result == vk::Result::eSuboptimalKHR || m_framebufferResized) {
             m_framebufferResized = false;
@@ -324,6 +996,467 @@ public:
         }
     }
 
+    // accumulate spp frames into "AccumOutput" and write it to the output file
+    void renderHeadlessGpu() {
+        std::vector<float> reference;
+        if (!m_options.referencePath.empty())
+            reference = readReference();
+
+        // the convergence readbacks drain the queue, their own time is left out of the render time summed here
+        std::vector<ConvergencePoint> convergence;
+        double renderMs = 0.0;
+
+        // adaptive sampling: the paths traced so far, and the frames until every pixel has converged
+        bool adaptive        = m_accumPass.isAdaptiveSamplingEnabled();
+        uint64_t tracedPaths = 0;
+        uint32_t frames      = m_options.spp;
+        auto addTracedPaths  = [&]() {
+            m_accumPass.readStats();
+            tracedPaths += m_accumPass.getActivePixelCount();
+        };
+
+        Timer timer;
+
+        for (uint32_t i = 0; i < m_options.spp; ++i) {
+            vk::Result result;
+            VUREN_PROFILE_ZONE("Frame");
+            {
+                VUREN_PROFILE_ZONE("WaitForFence");
+                do {
+                    result = m_vkContext.m_device.waitForFences(1, &m_inFlightFence, VK_TRUE, UINT64_MAX);
+                } while (result == vk::Result::eTimeout);
+            }
+            m_frameCapture.retire(m_submittedFrames);
+            m_videoSink.retire(m_submittedFrames);
+            m_rayStats.retire(m_submittedFrames);
+
+            // the last frame launched no path, so the image was already final one frame earlier
+            if (adaptive && i > 0) {
+                addTracedPaths();
+                if (m_accumPass.getActivePixelCount() == 0) {
+                    frames = i - 1;
+                    // a readback after the empty frame shows the same image, the final point replaces it
+                    if (!convergence.empty() && convergence.back().spp > frames)
+                        convergence.pop_back();
+                    break;
+                }
+            }
+
+            // uniform buffers are host coherent, so they can only be touched once the previous frame is done
+            {
+                VUREN_PROFILE_ZONE("Update");
+                m_pScene->getCamera().beginFrame();
+                m_pathTracingPass.updateUniformBuffer();
+                if (m_options.restir)
+                    m_restirPass.updateUniformBuffer();
+                m_accumPass.updateUniformBuffer();
+                updateSvgf();
+            }
+
+            if (m_vkContext.m_device.resetFences(1, &m_inFlightFence) != vk::Result::eSuccess) {
+                throw std::runtime_error("failed to reset fence!");
+            }
+
+            {
+                VUREN_PROFILE_ZONE("Record");
+                m_commandBuffers[0].reset();
+                recordCommandBuffer(m_commandBuffers[0], 0);
+            }
+
+            vk::SubmitInfo submitInfo{ .commandBufferCount = 1, .pCommandBuffers = &m_commandBuffers[0] };
+
+            {
+                VUREN_PROFILE_ZONE("Submit");
+                if (m_vkContext.m_graphicsQueue.submit(1, &submitInfo, m_inFlightFence) != vk::Result::eSuccess) {
+                    throw std::runtime_error("failed to submit draw command buffer!");
+                }
+                m_submittedFrames++;
+            }
+
+            uint32_t spp = i + 1;
+            if (!m_options.convergencePath.empty() && ((spp & (spp - 1)) == 0 || spp == m_options.spp)) {
+                m_vkContext.m_device.waitIdle();
+                renderMs += timer.elapsed();
+                std::vector<float> pixels =
+                    m_pResourceManager->readTextureRGBA32Sfloat("AccumOutput", vk::ImageLayout::eShaderReadOnlyOptimal);
+                convergence.push_back(
+                    { spp, renderMs, computeRmse(m_options.width, m_options.height, pixels, reference) });
+                timer.reset();
+            }
+        }
+
+        m_vkContext.m_device.waitIdle();
+        m_frameCapture.retire(m_submittedFrames);
+        m_videoSink.retire(m_submittedFrames);
+        m_rayStats.retire(m_submittedFrames);
+        if (adaptive && frames == m_options.spp)
+            addTracedPaths();
+        renderMs += timer.elapsed();
+        std::cout << "rendered " << frames << " spp at " << m_options.width << "x" << m_options.height << " in "
+                  << renderMs << " ms (gpu)" << std::endl;
+
+        // every pixel has either converged or has as many samples as a uniform render of the same frames
+        if (adaptive) {
+            double pixelCount   = static_cast<double>(m_options.width) * m_options.height;
+            double uniformPaths = pixelCount * frames;
+            std::cout << "adaptive sampling: " << tracedPaths << " paths (" << tracedPaths / pixelCount
+                      << " spp on average), " << (1.0 - tracedPaths / uniformPaths) * 100.0 << "% saved against "
+                      << frames << " spp everywhere"
+                      << (frames < m_options.spp ? ", every pixel converged" : ", stopped at --spp") << std::endl;
+        }
+
+        // renders of different techniques are compared at equal time through the gpu time of a frame
+        m_gpuProfiler.resolvePending();
+        std::cout << "gpu frame: " << m_gpuProfiler.getAverageMs("Frame") << " ms";
+        if (m_options.restir)
+            std::cout << " (RestirPass " << m_gpuProfiler.getAverageMs("RestirPass") << " ms, RestirShadePass "
+                      << m_gpuProfiler.getAverageMs("RestirShadePass") << " ms)" << std::endl;
+        else
+            std::cout << " (PathTracingPass " << m_gpuProfiler.getAverageMs("PathTracingPass") << " ms)" << std::endl;
+
+        // the accumulation pass leaves its output ready to be sampled by the final pass
+        std::vector<float> pixels =
+            m_pResourceManager->readTextureRGBA32Sfloat("AccumOutput", vk::ImageLayout::eShaderReadOnlyOptimal);
+        if (!m_options.referencePath.empty()) {
+            std::cout << "rmse against " << m_options.referencePath << ": "
+                      << computeRmse(m_options.width, m_options.height, pixels, reference) << std::endl;
+        }
+        if (!m_options.convergencePath.empty()) {
+            // the last point of a render that converged before spp
+            if (convergence.empty() || convergence.back().spp != frames)
+                convergence.push_back(
+                    { frames, renderMs, computeRmse(m_options.width, m_options.height, pixels, reference) });
+            writeConvergence(m_options.convergencePath, convergence);
+        }
+        writeImage(m_options.outputPath, m_options.width, m_options.height, pixels);
+        std::cout << "wrote " << m_options.outputPath << std::endl;
+    }
+
+    void runBenchmark() {
+        Timer startupTimer;
+        {
+            VUREN_PROFILE_ZONE("Startup");
+            // no cpu fallback here, the numbers would not be comparable
+            {
+                VUREN_PROFILE_ZONE("VulkanContext::init");
+                m_vkContext.init("test", nullptr);
+            }
+            initApplication();
+            initScene();
+            initRenderGraph();
+            finishRenderGraph();
+        }
+        double startupMs = startupTimer.elapsed();
+
+        CameraPath cameraPath;
+        if (!m_options.cameraPathFile.empty())
+            cameraPath.load(m_options.cameraPathFile);
+
+        // the example orbit takes 4 seconds for a full turn
+        float duration = cameraPath.empty() ? 4.0f : cameraPath.getDuration();
+        Camera &camera = m_pScene->getCamera();
+
+        m_gpuProfiler.setFrameTimingsEnabled(true);
+        m_rayStats.setFrameCountsEnabled(true);
+
+        uint32_t frameCount = m_options.warmupFrames + m_options.benchmarkFrames;
+        std::vector<double> cpuTimes;
+        std::vector<double> frameTimes;
+
+        // the history kept by the reprojection over the measured frames, read once each frame has completed
+        double effectiveSppSum = 0.0;
+        double disoccludedSum  = 0.0;
+        auto addAccumStats     = [&]() {
+            m_accumPass.readStats();
+            effectiveSppSum += m_accumPass.getEffectiveSpp();
+            disoccludedSum += m_accumPass.getDisoccludedFraction();
+        };
+
+        auto previousStart = std::chrono::steady_clock::now();
+
+        for (uint32_t i = 0; i < frameCount; ++i) {
+            VUREN_PROFILE_ZONE("Frame");
+            vk::Result result;
+            {
+                VUREN_PROFILE_ZONE("WaitForFence");
+                do {
+                    result = m_vkContext.m_device.waitForFences(1, &m_inFlightFence, VK_TRUE, UINT64_MAX);
+                } while (result == vk::Result::eTimeout);
+            }
+            m_rayStats.retire(m_submittedFrames);
+            if (i > m_options.warmupFrames)
+                addAccumStats();
+
+            // the path is sampled by frame index, not by wall clock time, so every run renders the same frames
+            auto frameStart = std::chrono::steady_clock::now();
+            bool measured   = i >= m_options.warmupFrames;
+            if (measured && i > m_options.warmupFrames)
+                frameTimes.push_back(std::chrono::duration<double, std::milli>(frameStart - previousStart).count());
+            previousStart = frameStart;
+
+            uint32_t pathFrame = measured ? i - m_options.warmupFrames : 0;
+            float time         = m_options.benchmarkFrames > 1
+                                     ? duration * pathFrame / static_cast<float>(m_options.benchmarkFrames - 1)
+                                     : 0.0f;
+
+            {
+                VUREN_PROFILE_ZONE("Update");
+                camera.beginFrame();
+                if (cameraPath.empty())
+                    camera.exampleRotationalCamera(time);
+                else
+                    cameraPath.apply(camera, time);
+                m_pathTracingPass.updateUniformBuffer();
+                if (m_options.restir)
+                    m_restirPass.updateUniformBuffer();
+                m_accumPass.updateUniformBuffer();
+                updateSvgf();
+            }
+
+            if (m_vkContext.m_device.resetFences(1, &m_inFlightFence) != vk::Result::eSuccess) {
+                throw std::runtime_error("failed to reset fence!");
+            }
+
+            {
+                VUREN_PROFILE_ZONE("Record");
+                m_commandBuffers[0].reset();
+                recordCommandBuffer(m_commandBuffers[0], 0);
+            }
+
+            vk::SubmitInfo submitInfo{ .commandBufferCount = 1, .pCommandBuffers = &m_commandBuffers[0] };
+
+            {
+                VUREN_PROFILE_ZONE("Submit");
+                if (m_vkContext.m_graphicsQueue.submit(1, &submitInfo, m_inFlightFence) != vk::Result::eSuccess) {
+                    throw std::runtime_error("failed to submit draw command buffer!");
+                }
+                m_submittedFrames++;
+            }
+
+            // cpu time: update, record and submit
+            if (measured) {
+                cpuTimes.push_back(
+                    std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count());
+            }
+        }
+
+        m_vkContext.m_device.waitIdle();
+        m_gpuProfiler.resolvePending();
+        m_rayStats.retire(m_submittedFrames);
+        if (m_options.benchmarkFrames > 0)
+            addAccumStats();
+
+        BenchmarkReport report;
+        report.addInfo("device", std::string(m_vkContext.m_physicalDevice.getProperties().deviceName.data()));
+        report.addInfo("width", m_options.width);
+        report.addInfo("height", m_options.height);
+        report.addInfo("warmupFrames", m_options.warmupFrames);
+        report.addInfo("frames", m_options.benchmarkFrames);
+        report.addInfo("seed", m_options.hasSeed ? m_options.seed : 0u);
+        report.addInfo("scene", m_options.scenePath.empty() ? "default" : m_options.scenePath);
+        report.addInfo("cameraPath", m_options.cameraPathFile.empty() ? "orbit" : m_options.cameraPathFile);
+        report.addInfo("pipelines", m_options.serialPipelines ? "serial" : "parallel");
+        report.addInfo("directLighting", m_options.restir ? "restir" : m_options.directLighting);
+        report.addInfo("maxDepth", m_options.maxDepth);
+        report.addInfo("sampler", m_options.sampler);
+        report.addInfo("adaptiveThreshold", m_options.adaptiveThreshold);
+        report.addInfo("lightCount", static_cast<uint32_t>(m_pScene->getLights().size()));
+        report.addInfo("startupMs", startupMs);
+        // the trace side of the builder preference shows in the path tracing pass timings below
+        report.addInfo("blasBuild", m_options.blasBuild);
+        report.addInfo("blasBuildMs", m_pathTracingPass.getBlasBuildMs());
+        report.addInfo("blasBytes", static_cast<double>(m_pathTracingPass.getBlasSize()));
+        if (m_options.benchmarkFrames > 0) {
+            report.addInfo("accumEffectiveSpp", effectiveSppSum / m_options.benchmarkFrames);
+            report.addInfo("accumDisoccludedFraction", disoccludedSum / m_options.benchmarkFrames);
+        }
+
+        report.addSeries("cpu", cpuTimes);
+        report.addSeries("frame", frameTimes);
+
+        // gpu timings of the measured frames, per scope (the whole frame and every pass)
+        std::vector<std::string> scopeNames = m_gpuProfiler.getScopeNames();
+        std::vector<std::vector<double>> gpuTimes(scopeNames.size());
+        for (auto &timings: m_gpuProfiler.getFrameTimings()) {
+            if (timings.frameNumber < m_options.warmupFrames)
+                continue;
+            for (size_t s = 0; s < timings.scopeMs.size(); ++s) {
+                if (timings.scopeMs[s] >= 0.0f)
+                    gpuTimes[s].push_back(timings.scopeMs[s]);
+            }
+        }
+        for (size_t s = 0; s < scopeNames.size(); ++s)
+            report.addSeries("gpu/" + scopeNames[s], gpuTimes[s]);
+
+        std::cout << "benchmark: " << m_options.benchmarkFrames << " frames (+" << m_options.warmupFrames
+                  << " warmup) at " << m_options.width << "x" << m_options.height << std::endl;
+        if (m_rayStats.isEnabled())
+            addRayStatsInfo(report);
+
+        report.write(m_options.benchmarkPath);
+        report.print(std::cout);
+        std::cout << "wrote " << m_options.benchmarkPath << std::endl;
+
+        cleanup();
+    }
+
+    // ray throughput of the measured frames: their traced rays over their path tracing pass time
+    void addRayStatsInfo(BenchmarkReport &report) {
+        std::vector<std::string> scopeNames = m_gpuProfiler.getScopeNames();
+        size_t scope = std::find(scopeNames.begin(), scopeNames.end(), "PathTracingPass") - scopeNames.begin();
+
+        // gpu profiler frame numbers start at 0, frame serials at 1
+        std::unordered_map<uint64_t, float> passMs;
+        for (auto &timings: m_gpuProfiler.getFrameTimings()) {
+            if (scope < timings.scopeMs.size() && timings.scopeMs[scope] >= 0.0f)
+                passMs[timings.frameNumber] = timings.scopeMs[scope];
+        }
+
+        uint64_t frames     = 0;
+        uint64_t rays       = 0;
+        uint64_t shadowRays = 0;
+        uint64_t paths      = 0;
+        double timedRays    = 0.0;
+        double timedMs      = 0.0;
+        for (auto &counts: m_rayStats.getFrameCounts()) {
+            uint64_t frameNumber = counts.frameSerial - 1;
+            if (frameNumber < m_options.warmupFrames)
+                continue;
+
+            uint64_t frameRays = getTracedRays(counts.stats);
+            frames++;
+            rays += frameRays;
+            shadowRays += counts.stats.shadowRays;
+            paths += counts.stats.paths;
+
+            auto it = passMs.find(frameNumber);
+            if (it != passMs.end()) {
+                timedRays += frameRays + counts.stats.shadowRays;
+                timedMs += it->second;
+            }
+        }
+        if (frames == 0)
+            return;
+
+        double mraysPerSecond = timedMs > 0.0 ? timedRays / (timedMs * 1e3) : 0.0;
+        report.addInfo("raysPerFrame", static_cast<double>(rays) / frames);
+        report.addInfo("shadowRaysPerFrame", static_cast<double>(shadowRays) / frames);
+        report.addInfo("averagePathLength", getAveragePathLength(rays, paths));
+        report.addInfo("mraysPerSecond", mraysPerSecond);
+        std::cout << "rays: " << rays / frames << " per frame, " << mraysPerSecond << " Mrays/s, average path length "
+                  << getAveragePathLength(rays, paths) << std::endl;
+    }
+
+    void renderHeadlessCpu() {
+        CpuRenderer renderer;
+
+        Camera camera;
+        camera.setExtent({ m_options.width, m_options.height });
+        camera.init();
+        applyCameraOptions(camera);
+
+        std::vector<ModelDesc> models = getSceneModels();
+        std::vector<ObjectInstance> instances;
+        for (uint32_t objId = 0; objId < models.size(); ++objId) {
+            std::vector<Vertex> vertices;
+            std::vector<uint32_t> indices;
+            loadObjMesh(models[objId].path, vertices, indices);
+            renderer.addMesh(vertices, indices, models[objId].materialId);
+
+            std::vector<ObjectInstance> modelInstances = generateInstances(objId, models[objId].instanceCount);
+            instances.insert(instances.end(), modelInstances.begin(), modelInstances.end());
+        }
+        renderer.setMaterials(getSceneMaterials());
+        renderer.setLights(getSceneLights());
+        renderer.setDirectLighting(getDirectLighting());
+        renderer.setMaxDepth(m_options.maxDepth);
+        renderer.setSampler(getSampler());
+        renderer.setBvhBuilder(m_options.bvhBuilder == "sbvh" ? Bvh::eSpatialSplits : Bvh::eBinned);
+        renderer.setBvhLayout(m_options.bvhLayout == "quantized" ? Bvh::eQuantizedNodes : Bvh::eFloatNodes);
+
+        ThreadPool threadPool;
+
+        {
+            VUREN_PROFILE_ZONE("CpuRenderer::build");
+            renderer.build(instances, threadPool);
+        }
+        // references above the triangle count are the ones the spatial splits duplicated
+        const Bvh::BuildStats &bvhStats = renderer.getBvhStats();
+        double buildTime                = bvhStats.buildMs;
+        Timer timer;
+        std::cout << "bvh: " << m_options.bvhBuilder << ", " << bvhStats.triangleCount << " triangles, "
+                  << bvhStats.referenceCount << " references, " << bvhStats.nodeCount << " nodes, sah cost "
+                  << bvhStats.sahCost << ", built in " << buildTime << " ms" << std::endl;
+        // the float layout is always built first, so its size is known for the comparison
+        double triangleCount = std::max(bvhStats.triangleCount, 1u);
+        std::cout << "bvh memory: float layout " << bvhStats.floatBytes / triangleCount << " bytes/triangle";
+        if (m_options.bvhLayout == "quantized")
+            std::cout << ", quantized layout " << bvhStats.quantizedBytes / triangleCount << " bytes/triangle ("
+                      << bvhStats.quantizedNodeCount << " nodes)";
+        std::cout << std::endl;
+
+        // every render starts over from the first sample, so each point is timed on its own
+        std::vector<ConvergencePoint> convergence;
+        if (!m_options.convergencePath.empty()) {
+            VUREN_PROFILE_ZONE("CpuRenderer::convergence");
+            std::vector<float> reference = readReference();
+            for (uint32_t spp = 1; spp < m_options.spp; spp *= 2) {
+                Timer sppTimer;
+                renderer.render(camera.getData(), m_options.width, m_options.height, spp, threadPool);
+                double ms = sppTimer.elapsed();
+                convergence.push_back(
+                    { spp, ms, computeRmse(m_options.width, m_options.height, renderer.getOutput(), reference) });
+            }
+        }
+
+        timer.reset();
+        {
+            VUREN_PROFILE_ZONE("CpuRenderer::render");
+            renderer.render(camera.getData(), m_options.width, m_options.height, m_options.spp, threadPool);
+        }
+        double renderTime = timer.elapsed();
+        std::cout << "rendered " << m_options.spp << " spp at " << m_options.width << "x" << m_options.height
+                  << " in " << renderTime << " ms (cpu, " << threadPool.getThreadCount()
+                  << " threads, bvh built in " << buildTime << " ms)" << std::endl;
+        std::cout << "traced " << renderer.getRayCount() << " rays, "
+                  << static_cast<double>(renderer.getRayCount()) / (renderTime * 1000.0) << " Mrays/s ("
+                  << m_options.bvhLayout << " bvh layout)" << std::endl;
+
+        const std::vector<float> *output = &renderer.getOutput();
+        CpuDenoiser denoiser;
+        if (m_options.denoise) {
+            VUREN_PROFILE_ZONE("CpuDenoiser::denoise");
+            Timer denoiseTimer;
+            denoiser.denoise(camera.getData(), m_options.width, m_options.height, renderer.getOutput(),
+                             renderer.getWorldPos(), renderer.getWorldNormal(), threadPool);
+            output = &denoiser.getOutput();
+            std::cout << "denoised in " << denoiseTimer.elapsed() << " ms" << std::endl;
+        }
+
+        if (!m_options.referencePath.empty()) {
+            std::vector<float> reference = readReference();
+            std::cout << "rmse against " << m_options.referencePath << ": "
+                      << computeRmse(m_options.width, m_options.height, renderer.getOutput(), reference);
+            if (m_options.denoise)
+                std::cout << " (denoised: " << computeRmse(m_options.width, m_options.height, *output, reference)
+                          << ")";
+            std::cout << std::endl;
+
+            if (!m_options.convergencePath.empty()) {
+                convergence.push_back({ m_options.spp, renderTime,
+                                        computeRmse(m_options.width, m_options.height, renderer.getOutput(),
+                                                    reference) });
+                writeConvergence(m_options.convergencePath, convergence);
+            }
+        }
+
+        writeImage(m_options.outputPath, m_options.width, m_options.height, *output);
+        std::cout << "wrote " << m_options.outputPath << std::endl;
+
+        if (!m_options.tracePath.empty())
+            Profiler::writeTrace(m_options.tracePath);
+    }
+
     void updateGUI(float deltaTime) {
         ImGui_ImplGlfw_NewFrame();
         ImGui::NewFrame();
@@ -334,8 +1467,10 @@ public:
         ImGui::Text("Statistics");
         ImGui::Text(" %.2f FPS (%.2f ms)", imguiIO.Framerate, imguiIO.DeltaTime);
 
-        if (ImGui::BeginCombo("Output", m_vkContext.kOffscreenOutputTextureNames[m_vkContext.kCurrentItem].c_str(),
-                              0)) {
+        if (m_options.fusedPresent) {
+            ImGui::Text("Output: AccumOutput (fused present)");
+        } else if (ImGui::BeginCombo("Output",
+                                     m_vkContext.kOffscreenOutputTextureNames[m_vkContext.kCurrentItem].c_str(), 0)) {
             for (int i = 0; i < m_vkContext.kOffscreenOutputTextureNames.size(); ++i) {
                 const bool isSelected = (m_vkContext.kCurrentItem == i);
                 if (ImGui::Selectable(m_vkContext.kOffscreenOutputTextureNames[i].c_str(), isSelected)) {
@@ -351,25 +1486,56 @@ public:
 
         // m_aoPass.updateGui();
         m_pathTracingPass.updateGui();
-        m_accumPass.updateGui();
+        if (m_options.restir)
+            m_restirPass.updateGui();
+        m_accumPass.updateGui(m_gpuProfiler.getAverageMs("AccumulationPass"));
+        m_svgfPass.updateGui();
+        m_gpuProfiler.updateGui();
+        m_rayStats.updateGui(m_gpuProfiler.getAverageMs("PathTracingPass"));
+        m_frameCapture.updateGui();
+        m_videoSink.updateGui();
 
         ImGui::End();
     }
 
     void cleanup() {
-        ImGui_ImplVulkan_Shutdown();
-        m_vkContext.m_device.destroyDescriptorPool(m_imguiDescriptorPool, nullptr);
+        if (!m_options.headless) {
+            ImGui_ImplVulkan_Shutdown();
+            m_vkContext.m_device.destroyDescriptorPool(m_imguiDescriptorPool, nullptr);
+        }
+
+        m_shaderHotReload.cleanup();
+        m_frameCapture.cleanup();
+        m_videoSink.cleanup();
+        m_rayStats.cleanup();
+
+        m_gpuProfiler.cleanup();
+        if (!m_options.tracePath.empty())
+            Profiler::writeTrace(m_options.tracePath, m_gpuProfiler.getTraceEvents());
 
         m_rasterGBufferPass.cleanup();
         // m_aoPass.cleanup();
         m_pathTracingPass.cleanup();
+        if (m_options.restir) {
+            m_restirPass.cleanup();
+            m_restirShadePass.cleanup();
+        }
         m_accumPass.cleanup();
-        m_finalRenderPass.cleanup();
+        m_svgfPass.cleanup();
+        if (hasFinalPass())
+            m_finalRenderPass.cleanup();
+        if (m_options.fusedPresent)
+            m_overlayPass.cleanup();
+
+        m_pipelineCache.cleanup();
+        m_bindlessTable.cleanup();
+        m_descriptorCache.cleanup();
 
         m_pResourceManager->destroyManagedTextures();
         m_pResourceManager->destroyManagedBuffers();
 
-        m_pSwapChain->cleanupSwapChain();
+        if (!m_options.headless)
+            m_pSwapChain->cleanupSwapChain();
 
         m_vkContext.m_device.destroySemaphore(m_imageAvailableSemaphore, nullptr);
         m_vkContext.m_device.destroySemaphore(m_renderFinishedSemaphore, nullptr);
@@ -379,29 +1545,44 @@ public:
 
         m_vkContext.cleanup();
 
-        glfwDestroyWindow(m_pWindow);
-        glfwTerminate();
+        if (!m_recordedCameraPath.empty()) {
+            m_recordedCameraPath.save(m_options.recordCameraPath);
+            std::cout << "wrote " << m_recordedCameraPath.size() << " camera keyframes to "
+                      << m_options.recordCameraPath << std::endl;
+        }
+
+        if (!m_options.headless) {
+            glfwDestroyWindow(m_pWindow);
+            glfwTerminate();
+        }
     }
 
-    void createRandomInstances(uint32_t objId, uint32_t instanceCount) {
+    // a model given with --scene is rendered once, as is. the default scene scatters random instances.
+    std::vector<ObjectInstance> generateInstances(uint32_t objId, uint32_t instanceCount) {
         std::vector<ObjectInstance> instances;
 
-        m_pScene->setInstanceCount(objId, instanceCount);
+        if (!m_options.scenePath.empty()) {
+            ObjectInstance instance;
+            instance.world             = glm::identity<glm::mat4>();
+            instance.invTransposeWorld = glm::identity<glm::mat4>();
+            instance.objectId          = objId;
+            instances.push_back(instance);
+            return instances;
+        }
 
-        static std::default_random_engine rng((unsigned) time(nullptr));
         std::uniform_real_distribution<float> uniformDist(0.0f, 1.0f);
         std::uniform_real_distribution<float> uniformDistPos(-2.0f, 2.0f);
         for (uint32_t i = 0; i < instanceCount; ++i) {
             ObjectInstance instance;
 
             auto pos   = glm::translate(glm::identity<glm::mat4>(),
-                                        glm::vec3(uniformDistPos(rng), uniformDistPos(rng), uniformDistPos(rng)));
+                                        glm::vec3(uniformDistPos(m_rng), uniformDistPos(m_rng), uniformDistPos(m_rng)));
             auto scale = glm::scale(glm::identity<glm::mat4>(), glm::vec3(1.0f, 1.0f, 1.0f));
-            auto rot_z = glm::rotate(glm::identity<glm::mat4>(), uniformDist(rng) * glm::radians(360.0f),
+            auto rot_z = glm::rotate(glm::identity<glm::mat4>(), uniformDist(m_rng) * glm::radians(360.0f),
                                      glm::vec3(0.0f, 0.0f, 1.0f));
-            auto rot_y = glm::rotate(glm::identity<glm::mat4>(), uniformDist(rng) * glm::radians(360.0f),
+            auto rot_y = glm::rotate(glm::identity<glm::mat4>(), uniformDist(m_rng) * glm::radians(360.0f),
                                      glm::vec3(0.0f, 1.0f, 0.0f));
-            auto rot_x = glm::rotate(glm::identity<glm::mat4>(), uniformDist(rng) * glm::radians(360.0f),
+            auto rot_x = glm::rotate(glm::identity<glm::mat4>(), uniformDist(m_rng) * glm::radians(360.0f),
                                      glm::vec3(1.0f, 0.0f, 0.0f));
 
             // glsl and glm: uses column-major order matrices of column vectors
@@ -412,6 +1593,16 @@ public:
             instances.push_back(instance);
         }
 
+        return instances;
+    }
+
+    void createInstances(uint32_t objId, uint32_t instanceCount) {
+        VUREN_PROFILE_ZONE("createInstances");
+
+        std::vector<ObjectInstance> instances = generateInstances(objId, instanceCount);
+
+        m_pScene->setInstanceCount(objId, static_cast<uint32_t>(instances.size()));
+
         vk::DeviceSize bufferSize = instances.size() * sizeof(ObjectInstance);
 
         // staging buffer
@@ -480,6 +1671,8 @@ public:
     }
 
     void initImGui() {
+        VUREN_PROFILE_ZONE("initImGui");
+
         // create descriptor pool for imgui
         vk::DescriptorPoolSize poolSizes[] = { { vk::DescriptorType::eSampler, 1000 },
                                                { vk::DescriptorType::eCombinedImageSampler, 1000 },
@@ -511,12 +1704,14 @@ public:
                                                .PhysicalDevice = m_vkContext.m_physicalDevice,
                                                .Device         = m_vkContext.m_device,
                                                .Queue          = m_vkContext.m_graphicsQueue,
+                                               .PipelineCache  = m_pipelineCache.get(),
                                                .DescriptorPool = m_imguiDescriptorPool,
                                                .MinImageCount  = m_pSwapChain->getImageCount(),
                                                .ImageCount     = m_pSwapChain->getImageCount(),
                                                .MSAASamples    = VK_SAMPLE_COUNT_1_BIT };
 
-        ImGui_ImplVulkan_Init(&initInfo, m_finalRenderPass.getRenderPass());
+        ImGui_ImplVulkan_Init(&initInfo, m_options.fusedPresent ? m_overlayPass.getRenderPass()
+                                                                : m_finalRenderPass.getRenderPass());
 
         ImGui::StyleColorsClassic();
 
@@ -534,6 +1729,24 @@ public:
 
     static void keyCallback(GLFWwindow *pWindow, int key, int scancode, int action, int mods) {
         auto app = reinterpret_cast<Application *>(glfwGetWindowUserPointer(pWindow));
+
+        if (key == GLFW_KEY_K && action == GLFW_PRESS && !app->m_options.recordCameraPath.empty())
+            app->recordCameraKeyframe();
+    }
+
+    // keyframe times are wall clock times since the first keyframe
+    void recordCameraKeyframe() {
+        auto now = std::chrono::steady_clock::now();
+        if (m_recordedCameraPath.empty())
+            m_recordStartTime = now;
+
+        Camera &camera = m_pScene->getCamera();
+        m_recordedCameraPath.addKeyframe({ .time   = std::chrono::duration<float>(now - m_recordStartTime).count(),
+                                           .eye    = camera.getEye(),
+                                           .center = camera.getCenter(),
+                                           .up     = camera.getUp(),
+                                           .fovY   = camera.getFovY() });
+        std::cout << "camera keyframe " << m_recordedCameraPath.size() << " recorded" << std::endl;
     }
 
     static void mouseCallback(GLFWwindow *pWindow, int button, int action, int mods) {
@@ -582,7 +1795,10 @@ public:
     }
 
 private:
-    GLFWwindow *m_pWindow;
+    Options m_options;
+    std::default_random_engine m_rng;
+
+    GLFWwindow *m_pWindow{ nullptr };
 
     VulkanContext m_vkContext;
     std::shared_ptr<SwapChain> m_pSwapChain{ nullptr };
@@ -595,6 +1811,8 @@ private:
     vk::Fence m_inFlightFence;
 
     bool m_framebufferResized = false;
+    uint64_t m_submittedFrames{ 0 }; // serial of the last submitted frame, used to retire frame captures
+    std::vector<vec3> m_lightOrigins; // the initial light positions, with --animate-lights
 
     std::shared_ptr<ResourceManager> m_pResourceManager{ nullptr };
 
@@ -605,25 +1823,61 @@ private:
     RayTracedGBufferPass m_rtGBufferPass;
     AmbientOcclusionPass m_aoPass;
     AccumulationPass m_accumPass;
+    SvgfPass m_svgfPass;
+    bool m_svgfRecorded{ false }; // see updateSvgf()
     PathTracingPass m_pathTracingPass;
+    RestirPass m_restirPass;
+    RestirShadePass m_restirShadePass;
 
     // for the final pass and gui
     // this pass is directly presented into swap chain framebuffers
     FinalRenderPass m_finalRenderPass;
+    OverlayRenderPass m_overlayPass; // in place of the final pass with --fused-present
     vk::DescriptorPool m_imguiDescriptorPool; // additional descriptor pool for imgui
+
+    PipelineCache m_pipelineCache;
+    DescriptorCache m_descriptorCache;
+    BindlessTable m_bindlessTable;
+    ShaderHotReload m_shaderHotReload;
+    std::unique_ptr<ThreadPool> m_pPipelineCompilePool;
+    std::vector<std::future<void>> m_pipelineJobs;
+    GpuProfiler m_gpuProfiler;
+    RayStatistics m_rayStats;
+
+    CameraPath m_recordedCameraPath;
+    std::chrono::steady_clock::time_point m_recordStartTime;
+
+    FrameCapture m_frameCapture;
+    VideoSink m_videoSink;
 };
 
 } // namespace vuren
 
-int main() {
-    vuren::Application app;
+int main(int argc, char *argv[]) {
+    vuren::Profiler::setThreadName("main");
+
+    // cout is sent to stderr while the video stream owns stdout, and given back once the application is gone
+    std::streambuf *pCoutBuffer = std::cout.rdbuf();
+    int result                  = EXIT_SUCCESS;
 
     try {
+        vuren::Options options = vuren::parseOptions(argc, argv);
+        if (options.help) {
+            vuren::printUsage();
+            return EXIT_SUCCESS;
+        }
+
+        // keep stdout clean for the video stream
+        if (options.videoPath == "-")
+            std::cout.rdbuf(std::cerr.rdbuf());
+
+        vuren::Application app(options);
         app.run();
     } catch (const std::exception &e) {
         std::cerr << e.what() << std::endl;
-        return EXIT_FAILURE;
+        result = EXIT_FAILURE;
     }
 
-    return EXIT_SUCCESS;
+    std::cout.rdbuf(pCoutBuffer);
+    return result;
 }